@@ -80,12 +80,14 @@
 		}											\
 	} while (0)
 
-#define CefC_Connection_Type_Num		5
+#define CefC_Connection_Type_Num		7
 #define CefC_Connection_Type_Udp		0
 #define CefC_Connection_Type_Tcp		1
 #define CefC_Connection_Type_Csm		2
 #define CefC_Connection_Type_Ndn		3
 #define CefC_Connection_Type_Ccr		4
+#define CefC_Connection_Type_Valid		5
+#define CefC_Connection_Type_CsmShm		6
 
 #define CefC_Connection_Type_Local		99
 
@@ -97,6 +99,19 @@
  Structures Declaration
  ****************************************************************************************/
 
+/***** Message waiting for the verification worker pool 	*****/
+typedef struct {
+	CefT_Valid_Job 	job;					/* must be the first member 				*/
+	int 			faceid;
+	int 			peer_faceid;
+	uint32_t 		face_gen;				/* generations of the Faces when queued 	*/
+	uint32_t 		peer_face_gen;
+	uint16_t 		payload_len;
+	uint16_t 		header_len;
+	char 			user_id[512];
+	unsigned char 	msg[];					/* copy of the message to verify 			*/
+} CefT_Valid_Pending;
+
 struct cef_hdr {
 	uint8_t 	version;
 	uint8_t 	type;
@@ -262,6 +277,24 @@ cefnetd_ccr_input_process (
 	int fd, 									/* FD which is polled POLLIN			*/
 	int faceid									/* Face-ID that message arrived 		*/
 );
+/*--------------------------------------------------------------------------------------
+	Handles the messages verified by the verification worker pool
+----------------------------------------------------------------------------------------*/
+static int
+cefnetd_valid_input_process (
+	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	int fd, 									/* FD which is polled POLLIN			*/
+	int faceid									/* Face-ID that message arrived 		*/
+);
+/*--------------------------------------------------------------------------------------
+	Handles the messages from csmgr in the shared memory ring
+----------------------------------------------------------------------------------------*/
+static int
+cefnetd_csm_shm_input_process (
+	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	int fd, 									/* FD which is polled POLLIN			*/
+	int faceid									/* Face-ID that message arrived 		*/
+);
 static int									/* No care now								*/
 (*cefnetd_input_process[CefC_Connection_Type_Num]) (
 	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
@@ -272,7 +305,9 @@ static int									/* No care now								*/
 	cefnetd_tcp_input_process,
 	cefnetd_csm_input_process,
 	cefnetd_ndn_input_process, 
-	cefnetd_ccr_input_process
+	cefnetd_ccr_input_process, 
+	cefnetd_valid_input_process, 
+	cefnetd_csm_shm_input_process
 };
 #ifdef CefC_Ccore
 /*--------------------------------------------------------------------------------------
@@ -414,6 +449,37 @@ cefnetd_input_message_process (
 	int msg_size,							/* size of received message(s)				*/
 	char*	user_id
 );
+/*--------------------------------------------------------------------------------------
+	Passes the signed message to the verification worker pool
+----------------------------------------------------------------------------------------*/
+static int									/* Returns a negative value if the message 	*/
+											/* must be verified in the main loop		*/
+cefnetd_valid_pool_push (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	int faceid, 							/* Face-ID where messages arrived at		*/
+	int peer_faceid, 						/* Face-ID to reply to the origin of 		*/
+											/* transmission of the message(s)			*/
+	unsigned char* msg, 					/* received message to handle				*/
+	uint16_t payload_len, 					/* Payload Length of this message			*/
+	uint16_t header_len,					/* Header Length of this message			*/
+	char*	user_id
+);
+/*--------------------------------------------------------------------------------------
+	Releases the message returned from the verification worker pool
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_valid_pending_free (
+	CefT_Valid_Job* job
+);
+/*--------------------------------------------------------------------------------------
+	Checks the Validation of the received message
+----------------------------------------------------------------------------------------*/
+static int									/* Returns 0 if the message is valid		*/
+cefnetd_valid_msg_verify (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	unsigned char* msg, 					/* received message to handle				*/
+	int msg_len								/* length of this message					*/
+);
 /*--------------------------------------------------------------------------------------
 	Seeks the top of the frame from the receive buffer
 ----------------------------------------------------------------------------------------*/
@@ -598,6 +664,23 @@ cefnetd_csmgr_messege_head_seek (
 	uint16_t* payload_len,
 	uint16_t* header_len
 );
+/*--------------------------------------------------------------------------------------
+	Handles the lookup result for the Interest held in cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_csmgr_lookup_res_process (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	unsigned char* msg, 					/* the lookup result						*/
+	uint16_t msg_len						/* length of the lookup result				*/
+);
+/*--------------------------------------------------------------------------------------
+	Forwards the held Interest which csmgrd does not answer with the Cob
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_csmgr_pending_forward (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	CefT_Csmgr_Pending* pd					/* the held Interest						*/
+);
 /*--------------------------------------------------------------------------------------
 	Handles the received Interest message
 ----------------------------------------------------------------------------------------*/
@@ -1084,6 +1167,11 @@ cefnetd_handle_create (
 	hdl->Buffer_Cache_Time		= CefC_Default_BUFFER_CACHE_TIME * 1000;
 	hdl->cefstatus_pipe_fd[0]	= -1;
 	hdl->cefstatus_pipe_fd[1]	= -1;
+	hdl->valid_worker_num		= CefC_Default_VALID_WORKER_NUM;
+	hdl->valid_pool_fd			= -1;
+	hdl->valid_verified_f		= 0;
+	hdl->valid_cache_size		= CefC_Default_VALID_CACHE_SIZE;
+	hdl->valid_cache_time		= CefC_Default_VALID_CACHE_TIME;
 
 	/* Initialize the frame module 						*/
 	cef_client_config_dir_get (conf_path);
@@ -1389,6 +1477,26 @@ cefnetd_handle_create (
 		cef_log_write (CefC_Log_Warn, "No NODE_NAME defined in cefnetd.conf; IP address is temporarily used as the node name.\n");
 	}
 
+	/* Prepares the cache of the messages whose signature was verified 	*/
+	if (cef_valid_result_cache_init (
+			hdl->valid_cache_size, hdl->valid_cache_time) < 0) {
+		cef_log_write (CefC_Log_Error, "Failed to create the verified result cache\n");
+		cefnetd_handle_destroy (hdl);
+		return (NULL);
+	}
+	
+	/* Starts the workers which verify the signature of messages 	*/
+	if (hdl->valid_worker_num > 0) {
+		hdl->valid_pool_fd = cef_valid_pool_init (hdl->valid_worker_num);
+		if (hdl->valid_pool_fd < 0) {
+			cef_log_write (CefC_Log_Error, "Failed to start the verification workers\n");
+			cefnetd_handle_destroy (hdl);
+			return (NULL);
+		}
+		cef_log_write (CefC_Log_Info, 
+			"Starting %d verification worker(s) ... OK\n", hdl->valid_worker_num);
+	}
+
 	/*#####*/
 	{	/* cefstatus_thread */
 		int flags;
@@ -1476,6 +1584,11 @@ cefnetd_handle_destroy (
 		"<STAT> Frame Size Max = "FMTU64"\n", stat_rcv_size_max);
 #endif // CefC_Debug
 
+	if (hdl->valid_pool_fd != -1) {
+		cef_valid_pool_destroy (cefnetd_valid_pending_free);
+		hdl->valid_pool_fd = -1;
+	}
+	cef_valid_result_cache_destroy ();
 	cefnetd_faces_destroy (hdl);
 	if (hdl->babel_use_f) {
 		cef_client_babel_sock_name_get (sock_path);
@@ -1645,6 +1758,16 @@ cefnetd_event_dispatch (
 		cefnetd_input_from_txque_process (hdl);
 		
 #ifdef CefC_ContentStore
+		/* Forwards the held Interests which csmgrd has not answered in time 	*/
+		if (hdl->cs_stat->pending) {
+			CefT_Csmgr_Pending* pd;
+			while ((pd = cef_csmgr_pending_expired_take (hdl->cs_stat, nowt)) != NULL) {
+				cefnetd_csmgr_pending_forward (hdl, pd);
+			}
+		}
+		if (hdl->cs_stat->cache_type == CefC_Cache_Type_Excache) {
+			cef_csmgr_upload_credit_check (hdl->cs_stat, nowt);
+		}
 		if ((hdl->cs_stat->cache_type != CefC_Cache_Type_None) &&
 			(nowt > ccninfo_push_time)) {
 			if (hdl->cs_stat->cache_type == CefC_Cache_Type_Excache) {
@@ -1893,6 +2016,14 @@ cefnetd_poll_socket_prepare (
 		faceids[res] = 0;
 		res++;
 	}
+	
+	if (hdl->cs_stat->shm != NULL) {
+		fds[res].events = POLLIN | POLLERR;
+		fds[res].fd = hdl->cs_stat->shm->ring[CefC_Csmgr_Shm_Ring_Obj].doorbell;
+		fd_type[res] = CefC_Connection_Type_CsmShm;
+		faceids[res] = 0;
+		res++;
+	}
 #endif // CefC_ContentStore
 	
 #ifdef CefC_NdnPlugin
@@ -1917,6 +2048,14 @@ cefnetd_poll_socket_prepare (
 	}
 #endif // CefC_Ccore
 
+	if (hdl->valid_pool_fd != -1) {
+		fds[res].events = POLLIN | POLLERR;
+		fds[res].fd = hdl->valid_pool_fd;
+		fd_type[res] = CefC_Connection_Type_Valid;
+		faceids[res] = 0;
+		res++;
+	}
+
 	for (i = 0 ; i < hdl->app_fds_num ; i++) {
 		if (hdl->app_fds[i] != -1) {
 			fds[res].events = POLLIN | POLLERR;
@@ -3186,6 +3325,69 @@ cefnetd_csm_input_process (
 	return (1);
 }
 
+/*--------------------------------------------------------------------------------------
+	Handles the messages from csmgr in the shared memory ring
+----------------------------------------------------------------------------------------*/
+static int
+cefnetd_csm_shm_input_process (
+	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	int fd, 									/* FD which is polled POLLIN			*/
+	int faceid									/* Face-ID that message arrived 		*/
+) {
+#ifdef CefC_ContentStore
+	CefT_Csmgr_Shm_Ring* ring;
+	unsigned char* rec;
+	uint32_t rec_len;
+	uint32_t index;
+	struct cef_hdr* chp;
+	uint16_t pkt_len;
+	uint16_t hdr_len;
+	char	user_id[512];
+	
+	if (hdl->cs_stat->shm == NULL) {
+		return (1);
+	}
+	ring = &hdl->cs_stat->shm->ring[CefC_Csmgr_Shm_Ring_Obj];
+	cef_csmgr_shm_doorbell_clear (ring);
+	
+	/* Each record holds complete message(s), so they are handled in place 	*/
+	while ((rec = cef_csmgr_shm_read (ring, &rec_len)) != NULL) {
+		index = 0;
+		
+		while (index + sizeof (struct cef_hdr) <= rec_len) {
+			chp = (struct cef_hdr*) &rec[index];
+			pkt_len = ntohs (chp->pkt_len);
+			hdr_len = chp->hdr_len;
+			
+			if ((chp->version != CefC_Version) || 
+				(hdr_len == 0) || (pkt_len < hdr_len) || 
+				(index + pkt_len > rec_len)) {
+				cef_log_write (CefC_Log_Warn, 
+					"Detects the invalid message in the ring from csmgr\n");
+				break;
+			}
+			if (chp->type == CefC_Csmgr_PT_LOOKUP_RES) {
+				cefnetd_csmgr_lookup_res_process (hdl, &rec[index], pkt_len);
+			} else if (chp->type == CefC_Csmgr_PT_UPLOAD_CREDIT) {
+				cef_csmgr_upload_credit_process (hdl->cs_stat, &rec[index], pkt_len);
+			} else if (chp->type > CefC_PT_PING_REP) {
+				cef_log_write (CefC_Log_Warn, 
+					"Detects the unknown PT_XXX=%d from csmgr\n", chp->type);
+			} else {
+				(*cefnetd_incoming_csmgr_msg_process[chp->type])
+					(hdl, 0, 0, &rec[index], pkt_len - hdr_len, hdr_len, user_id);
+			}
+			index += pkt_len;
+		}
+		cef_csmgr_shm_release (ring);
+	}
+#else
+	cef_log_write (CefC_Log_Error, "Invalid input from csmgr\n");
+	cefnetd_running_f = 0;
+#endif // CefC_ContentStore
+	
+	return (1);
+}
 /*--------------------------------------------------------------------------------------
 	Handles the input message from NDN network
 ----------------------------------------------------------------------------------------*/
@@ -4325,7 +4527,8 @@ cefnetd_input_message_process (
 			if (face->rcv_buff[1] > CefC_PT_PING_REP) {
 				cef_log_write (CefC_Log_Warn, 
 					"Detects the unknown PT_XXX=%d\n", face->rcv_buff[1]);
-			} else {
+			} else if (cefnetd_valid_pool_push (hdl, faceid, peer_faceid, 
+							face->rcv_buff, fdv_payload_len, fdv_header_len, user_id) < 0) {
 				(*cefnetd_incoming_msg_process[face->rcv_buff[1]])
 					(hdl, faceid, peer_faceid,
 							face->rcv_buff, fdv_payload_len, fdv_header_len, user_id);
@@ -4342,6 +4545,143 @@ cefnetd_input_message_process (
 	
 	return (1);
 }
+/*--------------------------------------------------------------------------------------
+	Passes the signed message to the verification worker pool
+----------------------------------------------------------------------------------------*/
+static int									/* Returns a negative value if the message 	*/
+											/* must be verified in the main loop		*/
+cefnetd_valid_pool_push (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	int faceid, 							/* Face-ID where messages arrived at		*/
+	int peer_faceid, 						/* Face-ID to reply to the origin of 		*/
+											/* transmission of the message(s)			*/
+	unsigned char* msg, 					/* received message to handle				*/
+	uint16_t payload_len, 					/* Payload Length of this message			*/
+	uint16_t header_len,					/* Header Length of this message			*/
+	char*	user_id
+) {
+	CefT_Valid_Pending* pending;
+	int msg_len = payload_len + header_len;
+	
+	if (hdl->valid_pool_fd < 0) {
+		return (-1);
+	}
+	if ((msg[1] != CefC_PT_INTEREST) && (msg[1] != CefC_PT_OBJECT)) {
+		return (-1);
+	}
+	if (msg_len > CefC_Max_Msg_Size) {
+		return (-1);
+	}
+	
+	/* Only the public key signatures are worth the hand-off, CRC32C and 	*/
+	/* unsigned messages are handled in the main loop as before 			*/
+	switch (cef_valid_alg_type_get (msg, msg_len)) {
+		case CefC_T_RSA_SHA256: 
+		case CefC_T_ECDSA_P256: 
+		case CefC_T_ED25519: {
+			break;
+		}
+		default: {
+			return (-1);
+		}
+	}
+	
+	pending = (CefT_Valid_Pending*) malloc (sizeof (CefT_Valid_Pending) + msg_len);
+	if (pending == NULL) {
+		return (-1);
+	}
+	memcpy (pending->msg, msg, msg_len);
+	pending->job.msg 		= pending->msg;
+	pending->job.msg_len 	= msg_len;
+	pending->job.res 		= -1;
+	pending->faceid 		= faceid;
+	pending->peer_faceid 	= peer_faceid;
+	pending->face_gen 		= cef_face_gen_get (faceid);
+	pending->peer_face_gen 	= cef_face_gen_get (peer_faceid);
+	pending->payload_len 	= payload_len;
+	pending->header_len 	= header_len;
+	if (user_id) {
+		strncpy (pending->user_id, user_id, sizeof (pending->user_id) - 1);
+		pending->user_id[sizeof (pending->user_id) - 1] = 0x00;
+	} else {
+		pending->user_id[0] = 0x00;
+	}
+	
+	if (cef_valid_pool_push (&pending->job) < 0) {
+		free (pending);
+		return (-1);
+	}
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Releases the message returned from the verification worker pool
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_valid_pending_free (
+	CefT_Valid_Job* job
+) {
+	free (job);
+}
+/*--------------------------------------------------------------------------------------
+	Handles the messages verified by the verification worker pool
+----------------------------------------------------------------------------------------*/
+static int
+cefnetd_valid_input_process (
+	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	int fd, 									/* FD which is polled POLLIN			*/
+	int faceid									/* Face-ID that message arrived 		*/
+) {
+	CefT_Valid_Job* job;
+	CefT_Valid_Pending* pending;
+	
+	cef_valid_pool_ack ();
+	
+	while ((job = cef_valid_pool_pop ()) != NULL) {
+		pending = (CefT_Valid_Pending*) job;
+		
+		/* The Face may be closed and its Face-ID reused by another peer 	*/
+		/* while the message is verified 									*/
+		if ((cef_face_gen_get (pending->faceid) != pending->face_gen) ||
+			(cef_face_gen_get (pending->peer_faceid) != pending->peer_face_gen)) {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Fine, 
+				"Drops the verified message from the closed Face#%d\n", 
+				pending->peer_faceid);
+#endif // CefC_Debug
+			cefnetd_valid_pending_free (job);
+			continue;
+		}
+		if (job->res == 0) {
+			hdl->valid_verified_f = 1;
+			(*cefnetd_incoming_msg_process[pending->msg[1]])
+				(hdl, pending->faceid, pending->peer_faceid, pending->msg, 
+					pending->payload_len, pending->header_len, pending->user_id);
+			hdl->valid_verified_f = 0;
+		}
+#ifdef CefC_Debug
+		else {
+			cef_dbg_write (CefC_Dbg_Fine, 
+				"Validation NG in verification worker (Face#%d)\n", pending->peer_faceid);
+		}
+#endif // CefC_Debug
+		cefnetd_valid_pending_free (job);
+	}
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Checks the Validation of the received message
+----------------------------------------------------------------------------------------*/
+static int									/* Returns 0 if the message is valid		*/
+cefnetd_valid_msg_verify (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	unsigned char* msg, 					/* received message to handle				*/
+	int msg_len								/* length of this message					*/
+) {
+	if (hdl->valid_verified_f) {
+		return (0);
+	}
+	return (cef_valid_msg_verify (msg, msg_len));
+}
 #ifdef CefC_ContentStore
 /*--------------------------------------------------------------------------------------
 	Handles the received message(s) from csmgr
@@ -4382,7 +4722,13 @@ cefnetd_input_message_from_csmgr_process (
 			}
 			
 			/* Calls the function corresponding to the type of the message 	*/
-			if (hdl->cs_stat->rcv_buff[1] > CefC_PT_PING_REP) {
+			if (hdl->cs_stat->rcv_buff[1] == CefC_Csmgr_PT_LOOKUP_RES) {
+				cefnetd_csmgr_lookup_res_process (hdl, 
+					hdl->cs_stat->rcv_buff, fdv_payload_len + fdv_header_len);
+			} else if (hdl->cs_stat->rcv_buff[1] == CefC_Csmgr_PT_UPLOAD_CREDIT) {
+				cef_csmgr_upload_credit_process (hdl->cs_stat, 
+					hdl->cs_stat->rcv_buff, fdv_payload_len + fdv_header_len);
+			} else if (hdl->cs_stat->rcv_buff[1] > CefC_PT_PING_REP) {
 				cef_log_write (CefC_Log_Warn, 
 					"Detects the unknown PT_XXX=%d from csmgr\n", 
 					hdl->cs_stat->rcv_buff[1]);
@@ -4459,7 +4805,9 @@ cefnetd_csmgr_messege_head_seek (
 			}
 		}
 
-		if (chp->type > CefC_PT_PING_REP) {
+		if ((chp->type > CefC_PT_PING_REP) && 
+			(chp->type != CefC_Csmgr_PT_LOOKUP_RES) && 
+			(chp->type != CefC_Csmgr_PT_UPLOAD_CREDIT)) {
 			cs_stat->rcv_len--;
 			index++;
 			continue;
@@ -4489,6 +4837,93 @@ cefnetd_csmgr_messege_head_seek (
 
 	return (-1);
 }
+/*--------------------------------------------------------------------------------------
+	Handles the lookup result for the Interest held in cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_csmgr_lookup_res_process (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	unsigned char* msg, 					/* the lookup result						*/
+	uint16_t msg_len						/* length of the lookup result				*/
+) {
+	CefT_Csmgr_Pending* pd;
+	
+	/* Only the miss is forwarded here, the hit is checked at the deadline 	*/
+	pd = cef_csmgr_lookup_res_process (hdl->cs_stat, msg, msg_len);
+	if (pd) {
+		cefnetd_csmgr_pending_forward (hdl, pd);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Forwards the held Interest which csmgrd does not answer with the Cob
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_csmgr_pending_forward (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	CefT_Csmgr_Pending* pd					/* the held Interest						*/
+) {
+	CefT_Parsed_Message pm;
+	CefT_Parsed_Opheader poh;
+	CefT_Pit_Entry* pe;
+	CefT_Fib_Entry* fe = NULL;
+	uint16_t faceids[CefC_Fib_UpFace_Max];
+	uint16_t face_num = 0;
+	uint16_t payload_len;
+	uint16_t header_len;
+	uint16_t name_len;
+	int res;
+	
+	header_len  = pd->msg[CefC_O_Fix_HeaderLength];
+	payload_len = pd->msg_len - header_len;
+	
+	res = cef_frame_message_parse (
+				pd->msg, payload_len, header_len, &poh, &pm, CefC_PT_INTEREST);
+	if (res < 0) {
+		cef_csmgr_pending_free (pd);
+		return;
+	}
+	
+	/* The PIT entry is gone if the Cob has arrived while the Interest was held */
+	pe = cef_pit_entry_search (hdl->pit, &pm, &poh, NULL, 0);
+	if (pe) {
+		if (pd->hit_f) {
+			hdl->cs_stat->pending_unsent++;
+		}
+#ifdef CefC_Nwproc
+		if (pm.chnk_num_f) {
+			name_len = pm.name_wo_attr_len - (CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum);
+		} else {
+			name_len = pm.name_wo_attr_len;
+		}
+		fe = cef_fib_entry_search (hdl->fib, pm.name_wo_attr, name_len);
+#else // CefC_Nwproc
+		if (pm.chnk_num_f) {
+			name_len = pm.name_len - (CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum);
+		} else {
+			name_len = pm.name_len;
+		}
+		fe = cef_fib_entry_search (hdl->fib, pm.name, name_len);
+#endif // CefC_Nwproc
+		if (fe) {
+			face_num = cef_fib_forward_faceid_select (fe, pd->faceid, faceids);
+		}
+		if (face_num > 0) {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finer, 
+				"Forward the held Interest to the next cefnetd(s)\n");
+#endif // CefC_Debug
+			cefnetd_interest_forward (
+				hdl, faceids, face_num, pd->faceid, pd->msg,
+				payload_len, header_len, &pm, &poh, pe, fe
+			);
+		}
+	}
+	if (pm.AppComp_num > 0) {
+		/* Free AppComp */
+		cef_frame_app_components_free (pm.AppComp_num, pm.AppComp);
+	}
+	cef_csmgr_pending_free (pd);
+}
 #endif // CefC_ContentStore
 /*--------------------------------------------------------------------------------------
 	Seeks the top of the frame from the receive buffer
@@ -4600,6 +5035,9 @@ cefnetd_incoming_interest_process (
 #if (defined CefC_ContentStore) || (defined CefC_Dtc)
 	unsigned int dnfaces = 0;
 	int cs_res = -1;
+#endif // CefC_ContentStore
+#ifdef CefC_ContentStore
+	int cs_hold_f = 0;
 #endif // CefC_ContentStore
 	CefT_Rx_Elem elem;
 	uint16_t faceids[CefC_Fib_UpFace_Max];
@@ -4634,7 +5072,7 @@ cefnetd_incoming_interest_process (
 	}
 
 	/* Checks the Validation 			*/
-	res = cef_valid_msg_verify (msg, payload_len + header_len);
+	res = cefnetd_valid_msg_verify (hdl, msg, payload_len + header_len);
 	if (res != 0) {
 		return (-1);
 	}
@@ -5144,7 +5582,13 @@ SKIP_BW_STAT_CHECK:;
 #endif	//CefC_Conpub
 					/* Cache does not exist in the temporary cache in cefnetd, 		*/
 					/* so inquiries to the csmgr 									*/
-					cef_csmgr_excache_lookup (hdl->cs_stat, peer_faceid, &pm, &poh, pe);
+					if ((hdl->cs_stat->pending) && (pit_res != 0) && (face_num > 0) && 
+						(tp_plugin_res & CefC_Pi_Interest_Send)) {
+						/* Inquires when the Interest is forwarded, to hold it 	*/
+						cs_hold_f = 1;
+					} else {
+						cef_csmgr_excache_lookup (hdl->cs_stat, peer_faceid, &pm, &poh, pe);
+					}
 #ifdef CefC_Debug
 					cef_dbg_write (CefC_Dbg_Finer, "Forward the Interest to csmgr\n");
 #endif // CefC_Debug
@@ -5264,6 +5708,11 @@ FORWARD_INTEREST:
 		
 #endif // CefC_Nwproc
 		if (fip) {
+#ifdef CefC_ContentStore
+			if (cs_hold_f) {
+				cef_csmgr_excache_lookup (hdl->cs_stat, peer_faceid, &pm, &poh, pe);
+			}
+#endif // CefC_ContentStore
 			if (cef_face_check_active (*fip) > 0) {
 #ifdef CefC_Debug
 				cef_dbg_write (CefC_Dbg_Finer, 
@@ -5276,6 +5725,17 @@ FORWARD_INTEREST:
 		}
 		
 		if ((forward_interest_f) && (face_num > 0)) {
+#ifdef CefC_ContentStore
+			/* Forwards the Interest after csmgrd answers that it has no Cob 	*/
+			if ((cs_hold_f) && 
+				(cef_csmgr_excache_lookup_hold (hdl->cs_stat, peer_faceid, &pm, &poh, 
+					pe, msg, payload_len + header_len, hdl->nowtus) > 0)) {
+#ifdef CefC_Debug
+				cef_dbg_write (CefC_Dbg_Finer, "Hold the Interest until csmgr answers\n");
+#endif // CefC_Debug
+				return (1);
+			}
+#endif // CefC_ContentStore
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Finer, "Forward the Interest to the next cefnetd(s)\n");
 #endif // CefC_Debug
@@ -5654,7 +6114,7 @@ cefnetd_incoming_object_process (
 	pkt_len = payload_len + header_len;	//0.8.3
 
 	/* Checks the Validation 			*/
-	res = cef_valid_msg_verify (msg, payload_len + header_len);
+	res = cefnetd_valid_msg_verify (hdl, msg, payload_len + header_len);
 	if (res != 0) {
 #ifdef	__VALID_NG__
 		fprintf( stderr, "[%s] Validation NG\n", __func__ );
@@ -8515,6 +8975,35 @@ cefnetd_config_read (
 			}
 			hdl->Buffer_Cache_Time = res * 1000;
 		}
+		else if ( strcasecmp (pname, CefC_ParamName_VALID_WORKER_NUM) == 0 ) {
+			res = atoi(ws);
+			if ( (res < 0) || (res > CefC_Valid_Pool_Worker_Max) ) {
+				cef_log_write (CefC_Log_Warn, 
+					"VALID_WORKER_NUM must be higher than or equal to 0 and lower than or equal to %d.\n"
+					, CefC_Valid_Pool_Worker_Max);
+				return (-1);
+			}
+			hdl->valid_worker_num = res;
+		}
+		else if ( strcasecmp (pname, CefC_ParamName_VALID_CACHE_SIZE) == 0 ) {
+			res = atoi(ws);
+			if ( (res < 0) || (res > CefC_Valid_Result_Cache_Max) ) {
+				cef_log_write (CefC_Log_Warn, 
+					"VALID_CACHE_SIZE must be higher than or equal to 0 and lower than or equal to %d.\n"
+					, CefC_Valid_Result_Cache_Max);
+				return (-1);
+			}
+			hdl->valid_cache_size = res;
+		}
+		else if ( strcasecmp (pname, CefC_ParamName_VALID_CACHE_TIME) == 0 ) {
+			res = atoi(ws);
+			if ( (res < 1) || (res > 86400) ) {
+				cef_log_write (CefC_Log_Warn, 
+					"VALID_CACHE_TIME must be higher than or equal to 1 and lower than or equal to 86400.\n");
+				return (-1);
+			}
+			hdl->valid_cache_time = res;
+		}
 		else {
 			/* NOP */;
 		}
@@ -8548,6 +9037,9 @@ cefnetd_config_read (
 	cef_dbg_write (CefC_Dbg_Fine, "CSMGR_ACCESS = %s\n", 
 					(hdl->Ex_Cache_Access == CefC_Default_CSMGR_ACCESS_RW) ? "RW" : "RO" );
 	cef_dbg_write (CefC_Dbg_Fine, "BUFFER_CACHE_TIME    = %d\n", hdl->Buffer_Cache_Time);
+	cef_dbg_write (CefC_Dbg_Fine, "VALID_WORKER_NUM     = %d\n", hdl->valid_worker_num);
+	cef_dbg_write (CefC_Dbg_Fine, "VALID_CACHE_SIZE     = %d\n", hdl->valid_cache_size);
+	cef_dbg_write (CefC_Dbg_Fine, "VALID_CACHE_TIME     = %d\n", hdl->valid_cache_time);
 
 #ifdef CefC_Ccninfo
 	cef_dbg_write (CefC_Dbg_Fine, "CCNINFO_ACCESS_POLICY = %d\n" 
@@ -10647,7 +11139,9 @@ cefnetd_keyid_get (
 	tlv_ptr = (struct tlv_hdr*) &msg[index];
 	alg_type = ntohs (tlv_ptr->type);
 
-	if ( alg_type != CefC_T_RSA_SHA256 ) {
+	if ( (alg_type != CefC_T_RSA_SHA256) && 
+		 (alg_type != CefC_T_ECDSA_P256) && 
+		 (alg_type != CefC_T_ED25519) ) {
 		return (-1);
 	}
 	
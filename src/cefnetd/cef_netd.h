@@ -265,6 +265,8 @@ typedef struct {
 	int					Regular_max_lifetime;
 	int					Ex_Cache_Access;		/* 0:Read/Write   1:ReadOnly			*/
 	uint32_t			Buffer_Cache_Time;		/* Buffer cahce timt					*/
+	int					valid_worker_num;		/* Number of threads verifying the 		*/
+												/* signature. 0: verify in main loop	*/
 												/* for KeyIdRestriction					*/
 												/* Private key, public key prefix		*/
 												/*   Private key name: 					*/
@@ -393,6 +395,12 @@ typedef struct {
 	/********** cefstatus pipe **********/
 	int		cefstatus_pipe_fd[2];
 
+	/********** Verification worker pool **********/
+	int		valid_pool_fd;			/* FD notified when verified messages are ready	*/
+	int		valid_verified_f;		/* Message in process was already verified		*/
+	int		valid_cache_size;		/* Number of verified results to be cached		*/
+	int		valid_cache_time;		/* Lifetime of a verified result (sec)			*/
+
 #ifdef CefC_C3
 	/* C3 Log */
 	FILE*				c3_log_fp;
@@ -54,6 +54,7 @@
 #include <cefore/cef_frame.h>
 #include <cefore/cef_print.h>
 #include <cefore/cef_plugin_com.h>
+#include <cefore/cef_valid.h>
 
 
 /****************************************************************************************
@@ -197,6 +198,97 @@ cef_status_stats_output (
 			(unsigned long long)hdl->stat_send_frames,
 			cache_type);
 	
+	/* output the public key cache statistics	*/
+	{
+		int key_num;
+		uint64_t key_hit, key_miss;
+		
+		cef_valid_pubkey_cache_stat_get (&key_num, &key_hit, &key_miss);
+		sprintf (work_str, "Key Cache  : %d keys (Hit %llu, Miss %llu)\n"
+			, key_num, (unsigned long long) key_hit, (unsigned long long) key_miss);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+	if (hdl->valid_cache_size > 0) {
+		int res_num, res_max;
+		uint64_t res_hit, res_miss;
+		
+		cef_valid_result_cache_stat_get (&res_num, &res_max, &res_hit, &res_miss);
+		sprintf (work_str, "Valid Cache: %d/%d entries (Hit %llu, Miss %llu, %.1f%%)\n"
+			, res_num, res_max, (unsigned long long) res_hit, (unsigned long long) res_miss
+			, (res_hit + res_miss) ? 
+				(double) res_hit * 100.0 / (double)(res_hit + res_miss) : 0.0);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+	if (hdl->valid_pool_fd != -1) {
+		int worker_num, inflight;
+		uint64_t verified, failed, full;
+		
+		cef_valid_pool_stat_get (&worker_num, &inflight, &verified, &failed, &full);
+		sprintf (work_str, "Verifier   : %d workers (Queued %d, OK %llu, NG %llu, Inline %llu)\n"
+			, worker_num, inflight, (unsigned long long) verified
+			, (unsigned long long) failed, (unsigned long long) full);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+	if ((hdl->cs_stat) && (hdl->cs_stat->shm) && (hdl->cs_stat->shm->summary)) {
+		CefT_Cs_Stat* cs_stat = hdl->cs_stat;
+		uint64_t skip, pass, miss;
+		
+		/* A miss of the query which passed the summary is a false positive 	*/
+		skip = cs_stat->summary_skip;
+		pass = cs_stat->summary_pass;
+		miss = cs_stat->shm->hdr->summary.misses;
+		sprintf (work_str, "Cs Summary : %s (Skipped %llu, Queried %llu, Miss %llu, "
+							"Query Reduction %.1f%%, FP Rate %.2f%%)\n"
+			, cs_stat->shm->hdr->summary.ready ? "Valid" : "Invalid"
+			, (unsigned long long) skip, (unsigned long long) pass, (unsigned long long) miss
+			, (skip + pass) ? (double) skip * 100.0 / (double)(skip + pass) : 0.0
+			, (skip + miss) ? (double) miss * 100.0 / (double)(skip + miss) : 0.0);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+	if ((hdl->cs_stat) && (hdl->cs_stat->pending)) {
+		CefT_Cs_Stat* cs_stat = hdl->cs_stat;
+		
+		sprintf (work_str, "Cs Lookup  : Held %u (Hit %llu, Unsent %llu, Miss %llu, "
+							"Timeout %llu, Full %llu, Wait %ums)\n"
+			, cs_stat->pending_num
+			, (unsigned long long) cs_stat->pending_hit
+			, (unsigned long long) cs_stat->pending_unsent
+			, (unsigned long long) cs_stat->pending_miss
+			, (unsigned long long) cs_stat->pending_timeout
+			, (unsigned long long) cs_stat->pending_full
+			, cs_stat->lookup_timeout);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+	if ((hdl->cs_stat) && 
+		(hdl->cs_stat->cache_type == CefC_Cache_Type_Excache) && 
+		(hdl->cs_stat->upload_window > 0)) {
+		CefT_Cs_Stat* cs_stat = hdl->cs_stat;
+		
+		/* In flight is what csmgrd has not received yet of the sent bytes 	*/
+		sprintf (work_str, "Cs Upload  : %s (Sent %llu bytes, In flight %llu bytes, "
+							"Credit %llu bytes, Suppressed %llu, Lost %llu bytes)\n"
+			, cs_stat->upload_credit_f ? "Granted" : "Not granted"
+			, (unsigned long long) cs_stat->upload_sent
+			, (unsigned long long)(cs_stat->upload_sent - cs_stat->upload_acked)
+			, (unsigned long long)((cs_stat->upload_limit > cs_stat->upload_sent) ? 
+				cs_stat->upload_limit - cs_stat->upload_sent : 0)
+			, (unsigned long long) cs_stat->upload_suppressed
+			, (unsigned long long) cs_stat->upload_resync);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+	
 #ifdef CefC_Ccore
 	if (hdl->rt_hdl) {
 		sprintf (work_str, "Controller : %s %s\n"
@@ -51,6 +51,10 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <sys/statvfs.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif // __linux__
 
 #include "csmgrd.h"
 #include <csmgrd/csmgrd_plugin.h>
@@ -94,10 +98,69 @@ static int xpthread_mutex_lock (const char* pname, int pline, pthread_mutex_t *m
 #define CSMGR_THRSHLD_MEM_USAGE_FOR_FILE			40
 #define CSMGR_MAXIMUM_FILE_USAGE_FOR_FILE			80
 #define CSMGR_THRSHLD_FILE_USAGE_FOR_FILE 			60
+
+#define CsmgrdC_Cob_Block_Size		1048576		/* Upload Requests in a block (bytes)	*/
+#define CsmgrdC_Cob_Block_Num		64			/* blocks passed to the process thread	*/
+#define CsmgrdC_Cob_Wait_Max		2000		/* wait for a free block (us)			*/
+#define CsmgrdC_Cob_Report_Intvl	10000000	/* interval to report the drops (us)	*/
+#define CsmgrdC_Credit_Peer_Max		(CsmgrdC_Max_Sock_Num + 1)
+#define CsmgrdC_Credit_Step			1048576		/* credit increase to grant at once		*/
+#define CsmgrdC_Credit_Intvl		1000000		/* interval to grant anyway (us)		*/
+#define CsmgrdC_Worker_Wait			100			/* epoll timeout of the workers (ms)	*/
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
 
+/********** Block of Upload Requests passed to the process thread 	**********/
+typedef struct {
+	
+	uint32_t		len;						/* length of Upload Requests in data	*/
+	unsigned char	data[CsmgrdC_Cob_Block_Size];
+	
+} CsmgrdT_Cob_Block;
+
+/********** Accounting of Upload Requests 	**********/
+typedef struct {
+	
+	uint64_t		enq_msgs;					/* passed to the process thread			*/
+	uint64_t		enq_bytes;
+	uint64_t		drop_full;					/* dropped, no free block after waiting	*/
+	uint64_t		drop_lack;					/* dropped by the lack of resources		*/
+	uint64_t		drop_invalid;				/* dropped by the frame check			*/
+	uint64_t		stall;						/* waits for a free block				*/
+	uint64_t		stall_us;					/* total time of the waits				*/
+	uint64_t		grants;						/* upload credits sent to cefnetd		*/
+	
+} CsmgrdT_Cob_Stat;
+
+/********** Upload credit granted to cefnetd 	**********/
+typedef struct {
+	
+	int				sock;						/* -1 : not used						*/
+	uint32_t		window_max;					/* window cefnetd asked for (bytes)		*/
+	uint64_t		rcvd;						/* bytes of Upload Requests received	*/
+	uint64_t		limit;						/* rcvd + window of the last grant		*/
+	uint32_t		window;						/* window of the last grant				*/
+	uint64_t		grant_t;					/* time of the last grant				*/
+	int				owner;						/* id of the thread serving the peer	*/
+	
+} CsmgrdT_Credit_Peer;
+
+/********** Thread which serves the peers 	**********/
+typedef struct {
+	
+	int				id;							/* 0 : main thread						*/
+	pthread_t		th;
+	CefT_Csmgrd_Handle*	hdl;
+	int				epfd;						/* epoll of the peers it serves			*/
+	int				evfd;						/* wakes the thread to close the peers	*/
+	int				peer_num;					/* TCP peers assigned to this thread	*/
+	CsmgrdT_Cob_Block*	cob_blk;				/* Upload Requests being filled			*/
+	uint64_t		interests;					/* Interests served						*/
+	uint64_t		hits;						/* Interests answered with the Cob		*/
+	
+} CsmgrdT_Worker;
+
 
 /****************************************************************************************
  State Variables
@@ -109,16 +172,25 @@ static char 				root_user_name[CefC_Csmgr_User_Len] = {"root"};
 static char 				csmgr_local_sock_name[PATH_MAX] = {0};
 
 static pthread_mutex_t 		csmgr_comn_buff_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t 		csmgr_main_cob_buff_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t		csmgr_comn_buff_cond = PTHREAD_COND_INITIALIZER;
 
-static unsigned char* 		csmgr_main_cob_buff 		= NULL;
-static int 					csmgr_main_cob_buff_idx 	= 0;
-static unsigned char* 		csmgr_comn_cob_buff 		= NULL;
-static int 					csmgr_comn_cob_buff_idx 	= 0;
-static unsigned char* 		csmgr_proc_cob_buff 		= NULL;
-static int 					csmgr_proc_cob_buff_idx 	= 0;
-static uint64_t				csmgr_wait_time 			= 2000000;
+/********** Upload Requests from the main thread and the workers to the process thread 	**********/
+static CsmgrdT_Cob_Block*	csmgr_cob_blks[CsmgrdC_Cob_Block_Num];
+static CefT_Mpsc_Que*		csmgr_cob_que 				= NULL;	/* filled blocks		*/
+static CefT_Mpsc_Que*		csmgr_cob_free_que 			= NULL;	/* blocks to be filled	*/
+static pthread_mutex_t 		csmgr_cob_free_mutex = PTHREAD_MUTEX_INITIALIZER;
+													/* threads pop free_que in turn	*/
+static volatile int			csmgr_cob_idle_f 			= 0;	/* process thread waits	*/
+static CsmgrdT_Cob_Stat		csmgr_cob_stat;
+static uint64_t				csmgr_cob_report_time 		= 0;
+static uint64_t				csmgr_cob_report_drops 		= 0;
+static CsmgrdT_Credit_Peer	csmgr_credit_peers[CsmgrdC_Credit_Peer_Max];
+static CsmgrdT_Worker		csmgr_workers[CsmgrdC_Max_Worker_Num + 1];	/* [0]: main	*/
+static int					csmgr_tcp_owner[CsmgrdC_Max_Sock_Num];	/* worker id		*/
+static int					csmgr_tcp_close_req[CsmgrdC_Max_Sock_Num];
+													/* 1: the owner closes the peer	*/
+static pthread_mutex_t 		csmgr_ctrl_mutex = PTHREAD_MUTEX_INITIALIZER;
+													/* messages other than Interest	*/
 static CsmgrT_Stat_Handle 	stat_hdl = CsmgrC_Invalid;
 
 static int	Lack_of_M_resources = 1;
@@ -227,6 +299,7 @@ csmgrd_poll_socket_prepare (
 static int							/* The return value is negative if an error occurs	*/
 csmgrd_input_message_process (
 	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	CsmgrdT_Worker* wk,							/* thread serving the peer				*/
 	int sock,									/* recv socket							*/
 	unsigned char* msg,							/* receive message						*/
 	int msg_len,								/* message length						*/
@@ -235,7 +308,7 @@ csmgrd_input_message_process (
 /*--------------------------------------------------------------------------------------
 	Incoming Interest Message
 ----------------------------------------------------------------------------------------*/
-static void
+static int									/* CefC_Csmgr_Cob_Exist if Cob was sent	*/
 csmgrd_incoming_interest (
 	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
 	int sock,									/* recv socket							*/
@@ -257,6 +330,16 @@ cef_csmgr_interest_msg_parse (
 	unsigned char op_data[],					/* Optional Data Field					*/
 	uint16_t* op_data_len						/* Length of Optional Data Field		*/
 );
+/*--------------------------------------------------------------------------------------
+	Sends the lookup result to cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_lookup_res_send (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock,									/* socket the Interest came from		*/
+	unsigned char id[],							/* Request ID (network byte order)		*/
+	int exist_f									/* CefC_Csmgr_Cob_Exist if Cob was sent	*/
+);
 /*--------------------------------------------------------------------------------------
 	Incoming Get Status Message
 ----------------------------------------------------------------------------------------*/
@@ -539,30 +622,171 @@ static void*
 csmgrd_expire_check_thread (
 	void* arg
 );
-/*--------------------------------------------------------------------------------------
-	function for processing buffering messages
-----------------------------------------------------------------------------------------*/
-static void* 
-push_bytes_process_thread (
-	void* arg
-);
 /*--------------------------------------------------------------------------------------
 	Get frame from received message
 ----------------------------------------------------------------------------------------*/
 static int							/* The return value is negative if an error occurs	*/
 csmgr_input_bytes_process (
 	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	CsmgrdT_Worker* wk,						/* thread serving the peer					*/
 	int peer_fd, 
 	unsigned char* buff,					/* receive message							*/
 	int buff_len							/* message length							*/
 );
 /*--------------------------------------------------------------------------------------
-	Push the buffered messages to proc thread buffer 
+	Creates the blocks and queues of Upload Requests
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgr_cob_que_create (
+	void 
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the blocks and queues of Upload Requests
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_que_destroy (
+	void 
+);
+/*--------------------------------------------------------------------------------------
+	Copies the Upload Request to the block of the thread
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_enqueue (
+	CsmgrdT_Worker* wk,						/* thread filling the block					*/
+	unsigned char* msg,						/* Upload Request							*/
+	uint16_t len							/* length of Upload Request					*/
+);
+/*--------------------------------------------------------------------------------------
+	Wakes up the process thread if it waits for the block
 ----------------------------------------------------------------------------------------*/
 static void 
-csmgr_push_bytes_process (
+csmgr_cob_wakeup (
 	void 
 );
+/*--------------------------------------------------------------------------------------
+	Passes the block being filled to the process thread
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_block_flush (
+	CsmgrdT_Worker* wk						/* thread filling the block					*/
+);
+/*--------------------------------------------------------------------------------------
+	Reports the dropped Upload Requests
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_stat_report (
+	int force_f								/* 1: reports even if nothing is dropped	*/
+);
+/*--------------------------------------------------------------------------------------
+	Looks up the peer to which the upload credit is granted
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Credit_Peer* 
+csmgr_credit_peer_get (
+	int sock								/* socket of the peer						*/
+);
+/*--------------------------------------------------------------------------------------
+	Starts granting the upload credit to the peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_credit_request (
+	CsmgrdT_Worker* wk,						/* thread serving the peer					*/
+	int sock,								/* socket of the peer						*/
+	unsigned char* msg,						/* upload credit request					*/
+	int msg_len								/* length of the request					*/
+);
+/*--------------------------------------------------------------------------------------
+	Stops granting the upload credit to the closed peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_credit_release (
+	int sock								/* socket of the peer						*/
+);
+/*--------------------------------------------------------------------------------------
+	Counts the bytes of Upload Requests received from the peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_credit_rcvd_add (
+	int sock,								/* socket of the peer						*/
+	uint64_t len							/* bytes of Upload Requests					*/
+);
+/*--------------------------------------------------------------------------------------
+	Grants the upload credit to the peers which the thread serves
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_credit_grant (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	CsmgrdT_Worker* wk						/* thread serving the peers					*/
+);
+/*--------------------------------------------------------------------------------------
+	Starts the workers which serve the TCP peers
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_worker_start (
+	CefT_Csmgrd_Handle* hdl					/* CS Manager Handle						*/
+);
+/*--------------------------------------------------------------------------------------
+	Stops the workers
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_worker_stop (
+	CefT_Csmgrd_Handle* hdl					/* CS Manager Handle						*/
+);
+/*--------------------------------------------------------------------------------------
+	Assigns the accepted TCP peer to the worker which serves the fewest peers
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_worker_assign (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	int slot								/* index of hdl->tcp_fds					*/
+);
+/*--------------------------------------------------------------------------------------
+	function for serving the TCP peers assigned to the worker
+----------------------------------------------------------------------------------------*/
+static void* 
+csmgrd_worker_thread (
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Asks the worker which owns the TCP peer to close it
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_worker_close_req (
+	int owner,								/* id of the worker serving the peer		*/
+	int slot								/* index of hdl->tcp_fds					*/
+);
+/*--------------------------------------------------------------------------------------
+	Closes the TCP peers which the main thread asked the worker to close
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_worker_close_req_process (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	CsmgrdT_Worker* wk						/* thread serving the peers					*/
+);
+/*--------------------------------------------------------------------------------------
+	Receives and handles the message(s) from the TCP peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_tcp_peer_input (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	CsmgrdT_Worker* wk,						/* thread serving the peer					*/
+	int slot,								/* index of hdl->tcp_fds					*/
+	int err_f								/* 1: error or hang up is detected			*/
+);
+/*--------------------------------------------------------------------------------------
+	Closes the TCP peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_tcp_peer_close (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	int slot								/* index of hdl->tcp_fds					*/
+);
+/*--------------------------------------------------------------------------------------
+	Closes the local peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_local_peer_close (
+	CefT_Csmgrd_Handle* hdl					/* CS Manager Handle						*/
+);
 /*---------------------------------------------------------------------------------------
 	memory/file Resource monitoring thread & functions
 ----------------------------------------------------------------------------------------*/
@@ -592,6 +816,35 @@ cef_csmgr_frame_check (
 	unsigned char* buff,						/* receive message						*/
 	int buff_len								/* message length						*/
 );
+/*--------------------------------------------------------------------------------------
+	Attaches the shared memory rings offered by local cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_shm_attach (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* recv socket							*/
+);
+/*--------------------------------------------------------------------------------------
+	Detaches the shared memory rings
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_shm_detach (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+);
+/*--------------------------------------------------------------------------------------
+	Handles the requests in the shared memory ring
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_shm_req_process (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+);
+/*--------------------------------------------------------------------------------------
+	function for processing the Upload Requests in the shared memory ring
+----------------------------------------------------------------------------------------*/
+static void* 
+csmgrd_shm_upload_thread (
+	void* arg
+);
 
 /****************************************************************************************
  ****************************************************************************************/
@@ -689,6 +942,8 @@ csmgrd_handle_create (
 	hdl->tcp_listen_fd 		= -1;
 	hdl->local_listen_fd 	= -1;
 	hdl->local_peer_sock 	= -1;
+	hdl->shm 				= NULL;
+	hdl->shm_fd_num 		= 0;
 	
 	/* Records the user which launched cefnetd 		*/
 	envp = getenv ("USER");
@@ -717,6 +972,7 @@ csmgrd_handle_create (
 		return (NULL);
 	}
 	hdl->interval = conf_param.interval;
+	hdl->worker_num = conf_param.worker_num;
 	
 #ifdef CefC_Debug
 	cef_dbg_write (CefC_Dbg_Fine, "Create the listen socket.\n");
@@ -815,32 +1071,11 @@ csmgrd_handle_create (
 	}
 	cef_log_write (CefC_Log_Info, "Loading %s ... OK\n", CefC_Csmgrd_Conf_Name);
 		
-	csmgr_main_cob_buff = 
-		(unsigned char*) malloc (sizeof (unsigned char) * CsmgrC_Buff_Size);
-	if (csmgr_main_cob_buff == NULL) {
+	if (csmgr_cob_que_create () < 0) {
 		cef_log_write (CefC_Log_Error, "Failed to allocation cob buffer\n");
 		csmgrd_handle_destroy (&hdl);
 		return (NULL);
 	}
-	csmgr_main_cob_buff_idx = 0;
-	
-	csmgr_comn_cob_buff = 
-		(unsigned char*) malloc (sizeof (unsigned char) * CsmgrC_Buff_Size);
-	if (csmgr_comn_cob_buff == NULL) {
-		cef_log_write (CefC_Log_Error, "Failed to allocation common cob buffer\n");
-		csmgrd_handle_destroy (&hdl);
-		return (NULL);
-	}
-	csmgr_comn_cob_buff_idx = 0;
-	
-	csmgr_proc_cob_buff = 
-		(unsigned char*) malloc (sizeof (unsigned char) * CsmgrC_Buff_Max);
-	if (csmgr_proc_cob_buff == NULL) {
-		cef_log_write (CefC_Log_Error, "Failed to allocation process cob buffer\n");
-		csmgrd_handle_destroy (&hdl);
-		return (NULL);
-	}
-	csmgr_proc_cob_buff_idx = 0;
 	
 #ifdef CefC_Debug
 	/* Show config value */
@@ -870,16 +1105,15 @@ static void
 csmgrd_event_dispatch (
 	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
 ) {
-	struct pollfd fds[CsmgrdC_Max_Sock_Num];
+	struct pollfd fds[CsmgrdC_Max_Sock_Num + 1];
 	int fdnum;
-	int fds_index[CsmgrdC_Max_Sock_Num];
+	int fds_index[CsmgrdC_Max_Sock_Num + 1];
 	int len;
 	int res;
 	int i;
 	
 	pthread_t		csmgrd_msg_process_th;
 	pthread_t		csmgrd_expire_check_th;
-	pthread_t		push_bytes_process_th;
 	pthread_t		csmgrd_resource_mon_th;
 	void*			status;
 		
@@ -911,21 +1145,27 @@ csmgrd_event_dispatch (
 						"Failed to create the new thread(csmgrd_expire_check_thread)\n");
 		csmgrd_running_f = 0;
 	}
-	
-		if (pthread_create (&push_bytes_process_th, NULL, push_bytes_process_thread, hdl) == -1) {
+
+	if (pthread_create (&csmgrd_resource_mon_th, NULL, csmgrd_resource_mon_thread, hdl) == -1) {
 		cef_log_write (CefC_Log_Error, 
-						"Failed to create the new thread(push_bytes_process_thread)\n");
+						"Failed to create the new thread\n");
 		csmgrd_running_f = 0;
 	}
-	if (pthread_create (&csmgrd_resource_mon_th, NULL, csmgrd_resource_mon_thread, hdl) == -1) {
+	
+	if (csmgrd_worker_start (hdl) < 0) {
 		cef_log_write (CefC_Log_Error, 
-						"Failed to create the new thread\n");
+						"Failed to create the new thread(csmgrd_worker_thread)\n");
 		csmgrd_running_f = 0;
 	}
 
 	/* Main loop */
 	while (csmgrd_running_f) {
 		
+		/* Passes Upload Requests received in the last round to the process thread */
+		csmgr_cob_block_flush (&csmgr_workers[0]);
+		csmgr_cob_stat_report (0);
+		csmgr_credit_grant (hdl, &csmgr_workers[0]);
+		
 		/* check accept */
 		csmgrd_local_sock_check (hdl);
 		
@@ -935,6 +1175,11 @@ csmgrd_event_dispatch (
 		/* Sets fds to be polled 			*/
 		fdnum = csmgrd_poll_socket_prepare (hdl, fds, fds_index);
 		res = poll (fds, fdnum, 1);
+		
+		/* Handles the requests which local cefnetd put in the shared memory 	*/
+		if (hdl->shm) {
+			csmgrd_shm_req_process (hdl);
+		}
 		if (res < 0) {
 			/* poll error */
 #ifdef CefC_Debug
@@ -948,7 +1193,22 @@ csmgrd_event_dispatch (
 		}
 		
 		/* Checks whether frame(s) arrivals from the active local faces */
-		for (i = 0 ; res > 0 && i < CsmgrdC_Max_Sock_Num - 1 ; i++) {
+		for (i = 0 ; res > 0 && i < fdnum ; i++) {
+			if (fds[i].revents == 0) {
+				continue;
+			}
+			res--;
+			if (fds_index[i] < 0) {
+				/* Doorbell of the shared memory ring, already handled 	*/
+				continue;
+			}
+			if (fds_index[i] > 0) {
+				/* TCP peer which no worker serves 	*/
+				csmgrd_tcp_peer_input (hdl, &csmgr_workers[0], fds_index[i], 
+					fds[i].revents & (POLLERR | POLLNVAL | POLLHUP));
+				continue;
+			}
+			
 			if (fds[i].revents & (POLLERR | POLLNVAL | POLLHUP)) {
 				/* Error occurs, so close this socket 	*/
 #ifdef CefC_Debug
@@ -960,104 +1220,50 @@ csmgrd_event_dispatch (
 					cef_dbg_write (CefC_Dbg_Fine, "poll events POLLHUP\n");
 				}
 #endif // CefC_Debug
-				if ((hdl->local_peer_sock != -1) && (fds[i].fd == hdl->local_peer_sock)) {
-					/* Close Local socket */
-					close (hdl->local_peer_sock);
-					hdl->local_peer_sock = -1;
-					cef_log_write (CefC_Log_Info, "Close Local peer\n");
-				} else {
-					/* Close TCP socket */
-					if (hdl->tcp_fds[fds_index[i]] != -1) {
-						close (hdl->tcp_fds[fds_index[i]]);
-						hdl->tcp_fds[fds_index[i]] = -1;
-						cef_log_write (CefC_Log_Info, "Close TCP peer: %s:%s\n",
-							hdl->peer_id_str[fds_index[i]],
-							hdl->peer_sv_str[fds_index[i]]);
-						hdl->peer_num--;
-					}
-					/* Reset buffer */
-					hdl->tcp_index[fds_index[i]] = 0;
-				}
-				res--;
+				csmgrd_local_peer_close (hdl);
 				continue;
 			}
 			
 			if (fds[i].revents & POLLIN) {
-				res--;
-				len = recv (fds[i].fd,
-					&hdl->tcp_buff[fds_index[i]][hdl->tcp_index[fds_index[i]]], 
-					CefC_Cefnetd_Buff_Max - hdl->tcp_index[fds_index[i]], 0);
+				/* cefnetd may pass the shared memory descriptors 	*/
+				len = cef_csmgr_shm_recv (fds[i].fd,
+					&hdl->tcp_buff[0][hdl->tcp_index[0]], 
+					CefC_Cefnetd_Buff_Max - hdl->tcp_index[0], 
+					hdl->shm_fds, &hdl->shm_fd_num);
 				if (len > 0) {
 					/* receive message */
-					len += hdl->tcp_index[fds_index[i]];
+					len += hdl->tcp_index[0];
 					
 					len = csmgr_input_bytes_process (
-							hdl, fds[i].fd, 
-							&hdl->tcp_buff[fds_index[i]][0], len);
+							hdl, &csmgr_workers[0], fds[i].fd, &hdl->tcp_buff[0][0], len);
 					
 					/* set index */
 					if (len > 0) {
-						hdl->tcp_index[fds_index[i]] = len;
+						hdl->tcp_index[0] = len;
 					} else {
-						hdl->tcp_index[fds_index[i]] = 0;
+						hdl->tcp_index[0] = 0;
 					}
 				} else if (len == 0) {
-					if ((hdl->local_peer_sock != -1) && 
-						(fds[i].fd == hdl->local_peer_sock)) {
-						/* Close Local socket */
-						close (hdl->local_peer_sock);
-						hdl->local_peer_sock = -1;
-						cef_log_write (CefC_Log_Info, "Close Local peer\n");
-					} else {
-						/* Close TCP socket */
-						if (hdl->tcp_fds[fds_index[i]] != -1) {
-							close (hdl->tcp_fds[fds_index[i]]);
-							hdl->tcp_fds[fds_index[i]] = -1;
-							cef_log_write (CefC_Log_Info, "Close TCP peer: %s:%s\n",
-								hdl->peer_id_str[fds_index[i]],
-								hdl->peer_sv_str[fds_index[i]]);
-							hdl->peer_num--;
-						}
-						/* Reset buffer */
-						hdl->tcp_index[fds_index[i]] = 0;
-					}
+					csmgrd_local_peer_close (hdl);
 				} else {
 					if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
 						/* Error occurs, so close this socket 	*/
-						if ((hdl->local_peer_sock != -1) && 
-							(fds[i].fd == hdl->local_peer_sock)) {
-							/* Close Local socket */
-							cef_log_write (CefC_Log_Warn,
-								"Receive error (%d) . Close Local socket\n", errno);
-							close (hdl->local_peer_sock);
-							hdl->local_peer_sock = -1;
-							cef_log_write (CefC_Log_Info, "Close Local peer\n");
-						} else {
-							/* Close TCP socket */
-							cef_log_write (CefC_Log_Warn,
-								"Receive error (%d) . Close tcp socket\n", errno);
-							cef_log_write (CefC_Log_Warn, "%s\n", strerror (errno));
-							if (hdl->tcp_fds[fds_index[i]] != -1) {
-								cef_log_write (CefC_Log_Warn, "Close TCP peer: %s:%s\n",
-									hdl->peer_id_str[fds_index[i]],
-									hdl->peer_sv_str[fds_index[i]]);
-								close (hdl->tcp_fds[fds_index[i]]);
-								hdl->tcp_fds[fds_index[i]] = -1;
-								hdl->peer_num--;
-							}
-							/* Reset buffer */
-							hdl->tcp_index[fds_index[i]] = 0;
-						}
+						cef_log_write (CefC_Log_Warn,
+							"Receive error (%d) . Close Local socket\n", errno);
+						csmgrd_local_peer_close (hdl);
 					}
 				}
 			}
 		}
 	}
+	csmgrd_worker_stop (hdl);
+	pthread_mutex_lock (&csmgr_comn_buff_mutex);
 	pthread_cond_signal (&csmgr_comn_buff_cond);		/* To avoid deadlock */
+	pthread_mutex_unlock (&csmgr_comn_buff_mutex);
 	pthread_join (csmgrd_msg_process_th, &status);
 	pthread_join (csmgrd_expire_check_th, &status);
-	pthread_join (push_bytes_process_th, &status);
 	pthread_cond_destroy (&csmgr_comn_buff_cond);
+	csmgr_cob_stat_report (1);
 	
 	/* post process */
 	csmgrd_post_process (hdl);
@@ -1076,30 +1282,31 @@ csmgrd_msg_process_thread (
 	void* arg
 ) {
 	CefT_Csmgrd_Handle* hdl = (CefT_Csmgrd_Handle*) arg;
+	CsmgrdT_Cob_Block* blk;
+	struct timespec ts;
 
 	while (csmgrd_running_f) {
-		pthread_mutex_lock (&csmgr_comn_buff_mutex);
-		pthread_cond_wait (&csmgr_comn_buff_cond, &csmgr_comn_buff_mutex);
-		
-		if (csmgr_comn_cob_buff_idx > 0) {
-			if (CsmgrC_Buff_Max - csmgr_proc_cob_buff_idx > 
-				csmgr_comn_cob_buff_idx) {
-				
-				memcpy (
-					&csmgr_proc_cob_buff[csmgr_proc_cob_buff_idx], 
-					&csmgr_comn_cob_buff[0], 
-					csmgr_comn_cob_buff_idx);
-				csmgr_proc_cob_buff_idx += csmgr_comn_cob_buff_idx;
-			} 
-			csmgr_comn_cob_buff_idx = 0;
+		/* Caches all the blocks in the queue, then returns them to the main thread */
+		while ((blk = (CsmgrdT_Cob_Block*) cef_mpsc_que_pop (csmgr_cob_que)) != NULL) {
+			hdl->cs_mod_int->cache_item_puts (blk->data, (int) blk->len);
+			blk->len = 0;
+			cef_mpsc_que_push (csmgr_cob_free_que, blk);
 		}
-		pthread_mutex_unlock (&csmgr_comn_buff_mutex);
 		
-		if (csmgr_proc_cob_buff_idx > 0) {
-			hdl->cs_mod_int->cache_item_puts (
-							csmgr_proc_cob_buff, csmgr_proc_cob_buff_idx);
-			csmgr_proc_cob_buff_idx = 0;
+		/* Waits for the block, the main thread signals only while idle_f is set */
+		pthread_mutex_lock (&csmgr_comn_buff_mutex);
+		__atomic_store_n (&csmgr_cob_idle_f, 1, __ATOMIC_SEQ_CST);
+		if ((cef_mpsc_que_num (csmgr_cob_que) == 0) && (csmgrd_running_f)) {
+			clock_gettime (CLOCK_REALTIME, &ts);
+			ts.tv_nsec += 100000000;
+			if (ts.tv_nsec >= 1000000000) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000;
+			}
+			pthread_cond_timedwait (&csmgr_comn_buff_cond, &csmgr_comn_buff_mutex, &ts);
 		}
+		__atomic_store_n (&csmgr_cob_idle_f, 0, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock (&csmgr_comn_buff_mutex);
 	}
 	
 	pthread_exit (NULL);
@@ -1138,158 +1345,776 @@ csmgrd_expire_check_thread (
 	return ((void*) NULL);
 }
 /*--------------------------------------------------------------------------------------
-	function for processing buffering messages
+	Get frame from received message
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgr_input_bytes_process (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	CsmgrdT_Worker* wk,						/* thread serving the peer					*/
+	int peer_fd, 
+	unsigned char* buff,					/* receive message							*/
+	int buff_len							/* message length							*/
+) {
+	int index = 0;
+	uint16_t len;
+	uint16_t value16;
+	int rec_buff_len = buff_len;
+	int res;
+	uint64_t up_bytes = 0;
+	
+	while (buff_len > CefC_Csmgr_Msg_HeaderLen) {
+		/* searches the top of massage 		*/
+		if ((buff[index + CefC_O_Fix_Ver] != CefC_Version) ||
+			(buff[index + CefC_O_Fix_Type] >= CefC_Csmgr_Msg_Type_Num) ||
+			(buff[index + CefC_O_Fix_Type] == CefC_Csmgr_Msg_Type_Invalid)) {
+			
+			buff_len--;
+			index++;
+			
+			while (buff_len > CefC_Csmgr_Msg_HeaderLen) {
+				
+				if ((buff[index + CefC_O_Fix_Ver] != CefC_Version) ||
+					(buff[index + CefC_O_Fix_Type] >= CefC_Csmgr_Msg_Type_Num) ||
+					(buff[index + CefC_O_Fix_Type] == CefC_Csmgr_Msg_Type_Invalid)) {
+					
+					buff_len--;
+					index++;
+				} else {
+					break;
+				}
+			}
+			if (buff_len <= CefC_Csmgr_Msg_HeaderLen) {
+				break;
+			}
+		}
+		
+		/* obtains the length of message 		*/
+		memcpy (&value16, &buff[index + CefC_O_Length], CefC_S_Length);
+		len = ntohs (value16);
+		
+		if (len > buff_len) {
+			break;
+		}
+		
+		/* check the type of message 			*/
+		if (buff[index + CefC_O_Fix_Type] == CefC_Csmgr_Msg_Type_Interest) {
+			/* The cache plugin serves the Interests from the threads at once 	*/
+			res = csmgrd_input_message_process (hdl, wk, peer_fd, 
+				&buff[index + CefC_Csmgr_Msg_HeaderLen], len - CefC_Csmgr_Msg_HeaderLen, 
+				buff[index + CefC_O_Fix_Type]);
+			if (res < 0) {
+				return (0);
+			}
+		} else if (buff[index + CefC_O_Fix_Type] != CefC_Csmgr_Msg_Type_UpReq) {
+			pthread_mutex_lock (&csmgr_ctrl_mutex);
+			res = csmgrd_input_message_process (hdl, wk, peer_fd, 
+				&buff[index + CefC_Csmgr_Msg_HeaderLen], len - CefC_Csmgr_Msg_HeaderLen, 
+				buff[index + CefC_O_Fix_Type]);
+			pthread_mutex_unlock (&csmgr_ctrl_mutex);
+			if (res < 0) {
+				return (0);
+			}
+		} else {
+			int cstat;
+			up_bytes += len;
+			cstat = cef_csmgr_frame_check (&buff[index], len);
+			if (cstat < 0) {
+				__atomic_add_fetch (&csmgr_cob_stat.drop_invalid, 1, __ATOMIC_RELAXED);
+				goto SKIP;
+			}
+			pthread_mutex_lock (&csmgr_Lack_of_resources_mutex);
+			if ((Lack_of_F_resources == 1) || (Lack_of_M_resources == 1)) {
+				pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
+				__atomic_add_fetch (&csmgr_cob_stat.drop_lack, 1, __ATOMIC_RELAXED);
+				goto SKIP;
+			}
+			pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
+			csmgr_cob_enqueue (wk, &buff[index], len);
+		}
+		
+SKIP:;
+		buff_len -= len;
+		index += len;
+	}
+	if (up_bytes > 0) {
+		csmgr_credit_rcvd_add (peer_fd, up_bytes);
+	}
+	
+	if (index < rec_buff_len) {
+		memmove (&buff[0], &buff[index], buff_len);
+	}
+	return (buff_len);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the blocks and queues of Upload Requests
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgr_cob_que_create (
+	void 
+) {
+	int i;
+	
+	csmgr_cob_que 		= cef_mpsc_que_create (CsmgrdC_Cob_Block_Num);
+	csmgr_cob_free_que 	= cef_mpsc_que_create (CsmgrdC_Cob_Block_Num);
+	if ((csmgr_cob_que == NULL) || (csmgr_cob_free_que == NULL)) {
+		return (-1);
+	}
+	for (i = 0 ; i < CsmgrdC_Cob_Block_Num ; i++) {
+		csmgr_cob_blks[i] = (CsmgrdT_Cob_Block*) malloc (sizeof (CsmgrdT_Cob_Block));
+		if (csmgr_cob_blks[i] == NULL) {
+			return (-1);
+		}
+		csmgr_cob_blks[i]->len = 0;
+		cef_mpsc_que_push (csmgr_cob_free_que, csmgr_cob_blks[i]);
+	}
+	memset (&csmgr_cob_stat, 0, sizeof (CsmgrdT_Cob_Stat));
+	for (i = 0 ; i < CsmgrdC_Credit_Peer_Max ; i++) {
+		csmgr_credit_peers[i].sock = -1;
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the blocks and queues of Upload Requests
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_que_destroy (
+	void 
+) {
+	int i;
+	
+	for (i = 0 ; i < CsmgrdC_Cob_Block_Num ; i++) {
+		if (csmgr_cob_blks[i]) {
+			free (csmgr_cob_blks[i]);
+			csmgr_cob_blks[i] = NULL;
+		}
+	}
+	for (i = 0 ; i <= CsmgrdC_Max_Worker_Num ; i++) {
+		csmgr_workers[i].cob_blk = NULL;
+	}
+	if (csmgr_cob_que) {
+		cef_mpsc_que_destroy (csmgr_cob_que);
+		csmgr_cob_que = NULL;
+	}
+	if (csmgr_cob_free_que) {
+		cef_mpsc_que_destroy (csmgr_cob_free_que);
+		csmgr_cob_free_que = NULL;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Wakes up the process thread if it waits for the block
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_wakeup (
+	void 
+) {
+	/* Pairs with the store of idle_f and the check of the queue in the thread */
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+	if (__atomic_load_n (&csmgr_cob_idle_f, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock (&csmgr_comn_buff_mutex);
+		pthread_cond_signal (&csmgr_comn_buff_cond);
+		pthread_mutex_unlock (&csmgr_comn_buff_mutex);
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Passes the block being filled to the process thread
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_block_flush (
+	CsmgrdT_Worker* wk						/* thread filling the block					*/
+) {
+	if ((wk->cob_blk == NULL) || (wk->cob_blk->len == 0)) {
+		return;
+	}
+	
+	/* The queue holds all the blocks, so the push does not fail 	*/
+	cef_mpsc_que_push (csmgr_cob_que, wk->cob_blk);
+	wk->cob_blk = NULL;
+	csmgr_cob_wakeup ();
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Copies the Upload Request to the block of the thread
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_enqueue (
+	CsmgrdT_Worker* wk,						/* thread filling the block					*/
+	unsigned char* msg,						/* Upload Request							*/
+	uint16_t len							/* length of Upload Request					*/
+) {
+	uint64_t start_t;
+	uint64_t nowt;
+	
+	if ((wk->cob_blk) && (wk->cob_blk->len + len > CsmgrdC_Cob_Block_Size)) {
+		csmgr_cob_block_flush (wk);
+	}
+	
+	if (wk->cob_blk == NULL) {
+		pthread_mutex_lock (&csmgr_cob_free_mutex);
+		wk->cob_blk = (CsmgrdT_Cob_Block*) cef_mpsc_que_pop (csmgr_cob_free_que);
+		pthread_mutex_unlock (&csmgr_cob_free_mutex);
+		
+		/* Stops reading the sockets for a while so that the senders slow down 	*/
+		if (wk->cob_blk == NULL) {
+			__atomic_add_fetch (&csmgr_cob_stat.stall, 1, __ATOMIC_RELAXED);
+			start_t = cef_client_present_timeus_calc ();
+			nowt = start_t;
+			csmgr_cob_wakeup ();
+			
+			while (nowt - start_t < CsmgrdC_Cob_Wait_Max) {
+				usleep (50);
+				pthread_mutex_lock (&csmgr_cob_free_mutex);
+				wk->cob_blk = (CsmgrdT_Cob_Block*) cef_mpsc_que_pop (csmgr_cob_free_que);
+				pthread_mutex_unlock (&csmgr_cob_free_mutex);
+				nowt = cef_client_present_timeus_calc ();
+				if (wk->cob_blk) {
+					break;
+				}
+			}
+			__atomic_add_fetch (&csmgr_cob_stat.stall_us, nowt - start_t, __ATOMIC_RELAXED);
+		}
+		if (wk->cob_blk == NULL) {
+			__atomic_add_fetch (&csmgr_cob_stat.drop_full, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	}
+	memcpy (&wk->cob_blk->data[wk->cob_blk->len], msg, len);
+	wk->cob_blk->len += len;
+	
+	__atomic_add_fetch (&csmgr_cob_stat.enq_msgs, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch (&csmgr_cob_stat.enq_bytes, len, __ATOMIC_RELAXED);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Reports the dropped Upload Requests
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_cob_stat_report (
+	int force_f								/* 1: reports even if nothing is dropped	*/
+) {
+	uint64_t nowt;
+	uint64_t drops;
+	
+	drops = csmgr_cob_stat.drop_full + 
+			csmgr_cob_stat.drop_lack + csmgr_cob_stat.drop_invalid;
+	
+	if (force_f == 0) {
+		if (drops == csmgr_cob_report_drops) {
+			return;
+		}
+		nowt = cef_client_present_timeus_calc ();
+		if (nowt < csmgr_cob_report_time) {
+			return;
+		}
+		csmgr_cob_report_time = nowt + CsmgrdC_Cob_Report_Intvl;
+	}
+	csmgr_cob_report_drops = drops;
+	
+	cef_log_write ((force_f) ? CefC_Log_Info : CefC_Log_Warn, 
+		"Upload Requests: %llu accepted (%llu bytes), %llu dropped "
+		"(No buffer %llu, Lack of resources %llu, Invalid %llu), "
+		"%llu waits for the buffer (%llu us), %llu credits granted\n", 
+		(unsigned long long) csmgr_cob_stat.enq_msgs, 
+		(unsigned long long) csmgr_cob_stat.enq_bytes, 
+		(unsigned long long) drops, 
+		(unsigned long long) csmgr_cob_stat.drop_full, 
+		(unsigned long long) csmgr_cob_stat.drop_lack, 
+		(unsigned long long) csmgr_cob_stat.drop_invalid, 
+		(unsigned long long) csmgr_cob_stat.stall, 
+		(unsigned long long) csmgr_cob_stat.stall_us, 
+		(unsigned long long) csmgr_cob_stat.grants);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Looks up the peer to which the upload credit is granted
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Credit_Peer* 
+csmgr_credit_peer_get (
+	int sock								/* socket of the peer						*/
+) {
+	int i;
+	
+	if (sock < 0) {
+		return (NULL);
+	}
+	for (i = 0 ; i < CsmgrdC_Credit_Peer_Max ; i++) {
+		if (csmgr_credit_peers[i].sock == sock) {
+			return (&csmgr_credit_peers[i]);
+		}
+	}
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Starts granting the upload credit to the peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_credit_request (
+	CsmgrdT_Worker* wk,						/* thread serving the peer					*/
+	int sock,								/* socket of the peer						*/
+	unsigned char* msg,						/* upload credit request					*/
+	int msg_len								/* length of the request					*/
+) {
+	CsmgrdT_Credit_Peer* peer;
+	uint32_t value32;
+	int i;
+	
+	if (msg_len < (int) sizeof (uint32_t)) {
+		return;
+	}
+	memcpy (&value32, msg, sizeof (uint32_t));
+	value32 = ntohl (value32);
+	if (value32 == 0) {
+		return;
+	}
+	
+	/* The peer asks again when its credit expired, it keeps the count 	*/
+	peer = csmgr_credit_peer_get (sock);
+	if (peer == NULL) {
+		for (i = 0 ; i < CsmgrdC_Credit_Peer_Max ; i++) {
+			if (csmgr_credit_peers[i].sock == -1) {
+				peer = &csmgr_credit_peers[i];
+				break;
+			}
+		}
+		if (peer == NULL) {
+			return;
+		}
+		/* The workers see the peer once the socket is stored 	*/
+		memset (peer, 0, sizeof (CsmgrdT_Credit_Peer));
+		peer->window_max = value32;
+		peer->owner 	 = wk->id;
+		__atomic_store_n (&peer->sock, sock, __ATOMIC_RELEASE);
+		return;
+	}
+	peer->window_max = value32;
+	peer->grant_t 	 = 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Stops granting the upload credit to the closed peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_credit_release (
+	int sock								/* socket of the peer						*/
+) {
+	CsmgrdT_Credit_Peer* peer;
+	
+	peer = csmgr_credit_peer_get (sock);
+	if (peer) {
+		__atomic_store_n (&peer->sock, -1, __ATOMIC_RELEASE);
+	}
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Counts the bytes of Upload Requests received from the peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_credit_rcvd_add (
+	int sock,								/* socket of the peer						*/
+	uint64_t len							/* bytes of Upload Requests					*/
+) {
+	CsmgrdT_Credit_Peer* peer;
+	
+	/* The upload thread of the shared memory ring also counts 	*/
+	peer = csmgr_credit_peer_get (sock);
+	if (peer) {
+		__atomic_add_fetch (&peer->rcvd, len, __ATOMIC_RELAXED);
+	}
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Grants the upload credit to the peers which the thread serves
+----------------------------------------------------------------------------------------*/
+static void 
+csmgr_credit_grant (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	CsmgrdT_Worker* wk						/* thread serving the peers					*/
+) {
+	CsmgrdT_Credit_Peer* peer;
+	unsigned char buff[CefC_Csmgr_Credit_Len];
+	uint64_t nowt = 0;
+	uint64_t rcvd;
+	uint64_t limit;
+	uint64_t value64;
+	uint32_t window;
+	uint32_t free_bytes;
+	uint16_t value16;
+	uint32_t value32;
+	int lack_f;
+	int i;
+	
+	if (hdl->cob_msg_send == NULL) {
+		return;
+	}
+	
+	/* Grants no credit while the Upload Requests would be dropped 	*/
+	pthread_mutex_lock (&csmgr_Lack_of_resources_mutex);
+	lack_f = Lack_of_F_resources | Lack_of_M_resources;
+	pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
+	free_bytes = (uint32_t) cef_mpsc_que_num (csmgr_cob_free_que) * CsmgrdC_Cob_Block_Size;
+	
+	for (i = 0 ; i < CsmgrdC_Credit_Peer_Max ; i++) {
+		peer = &csmgr_credit_peers[i];
+		if ((__atomic_load_n (&peer->sock, __ATOMIC_ACQUIRE) == -1) || 
+			(peer->owner != wk->id)) {
+			continue;
+		}
+		window = (lack_f) ? 0 : 
+			((free_bytes < peer->window_max) ? free_bytes : peer->window_max);
+		rcvd  = __atomic_load_n (&peer->rcvd, __ATOMIC_RELAXED);
+		limit = rcvd + window;
+		
+		/* Grants when the credit stops or restarts, grows enough, or anyway 	*/
+		/* at the interval so that cefnetd knows csmgrd is alive 				*/
+		if (nowt == 0) {
+			nowt = cef_client_present_timeus_calc ();
+		}
+		if (((window == 0) == (peer->window == 0)) && 
+			(limit < peer->limit + CsmgrdC_Credit_Step) && 
+			(nowt < peer->grant_t + CsmgrdC_Credit_Intvl)) {
+			continue;
+		}
+		peer->limit 	= limit;
+		peer->window 	= window;
+		peer->grant_t 	= nowt;
+		
+		memset (buff, 0, CefC_S_Fix_Header);
+		buff[CefC_O_Fix_Ver] 			= CefC_Version;
+		buff[CefC_O_Fix_Type] 			= CefC_Csmgr_PT_UPLOAD_CREDIT;
+		value16 = htons (CefC_Csmgr_Credit_Len);
+		memcpy (&buff[CefC_O_Fix_PacketLength], &value16, sizeof (uint16_t));
+		buff[CefC_O_Fix_HeaderLength] 	= CefC_S_Fix_Header;
+		value64 = cef_client_htonb (rcvd);
+		memcpy (&buff[CefC_S_Fix_Header], &value64, sizeof (uint64_t));
+		value32 = htonl (window);
+		memcpy (&buff[CefC_S_Fix_Header + sizeof (uint64_t)], &value32, sizeof (uint32_t));
+		
+		(*hdl->cob_msg_send)(peer->sock, buff, CefC_Csmgr_Credit_Len);
+		__atomic_add_fetch (&csmgr_cob_stat.grants, 1, __ATOMIC_RELAXED);
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Starts the workers which serve the TCP peers
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_worker_start (
+	CefT_Csmgrd_Handle* hdl					/* CS Manager Handle						*/
+) {
+#ifdef __linux__
+	struct epoll_event ev;
+#endif // __linux__
+	int i;
+	
+	/* The main thread serves the local peer and the peers with no worker 	*/
+	for (i = 0 ; i <= CsmgrdC_Max_Worker_Num ; i++) {
+		csmgr_workers[i].id 	= i;
+		csmgr_workers[i].hdl 	= hdl;
+		csmgr_workers[i].epfd 	= -1;
+		csmgr_workers[i].evfd 	= -1;
+	}
+	
+#ifdef __linux__
+	for (i = 1 ; i <= hdl->worker_num ; i++) {
+		csmgr_workers[i].epfd = epoll_create1 (EPOLL_CLOEXEC);
+		if (csmgr_workers[i].epfd < 0) {
+			cef_log_write (CefC_Log_Error,
+				"Failed to create the epoll (%s)\n", strerror (errno));
+			hdl->worker_num = i - 1;
+			return (-1);
+		}
+		/* The main thread asks the worker to close its peer through the eventfd 	*/
+		csmgr_workers[i].evfd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (csmgr_workers[i].evfd < 0) {
+			cef_log_write (CefC_Log_Error,
+				"Failed to create the eventfd (%s)\n", strerror (errno));
+			close (csmgr_workers[i].epfd);
+			csmgr_workers[i].epfd = -1;
+			hdl->worker_num = i - 1;
+			return (-1);
+		}
+		memset (&ev, 0, sizeof (struct epoll_event));
+		ev.events 	= EPOLLIN;
+		ev.data.u32 = CsmgrdC_Max_Sock_Num;
+		if ((epoll_ctl (csmgr_workers[i].epfd, 
+				EPOLL_CTL_ADD, csmgr_workers[i].evfd, &ev) < 0) ||
+			(pthread_create (&csmgr_workers[i].th,
+				NULL, csmgrd_worker_thread, &csmgr_workers[i]) != 0)) {
+			close (csmgr_workers[i].evfd);
+			csmgr_workers[i].evfd = -1;
+			close (csmgr_workers[i].epfd);
+			csmgr_workers[i].epfd = -1;
+			hdl->worker_num = i - 1;
+			return (-1);
+		}
+	}
+	if (hdl->worker_num > 0) {
+		cef_log_write (CefC_Log_Info,
+			"Start %d worker(s) serving the TCP peers\n", hdl->worker_num);
+	}
+#endif // __linux__
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Stops the workers
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_worker_stop (
+	CefT_Csmgrd_Handle* hdl					/* CS Manager Handle						*/
+) {
+	CsmgrdT_Worker* wk;
+	void* status;
+	int i;
+	
+	for (i = 0 ; i <= hdl->worker_num ; i++) {
+		wk = &csmgr_workers[i];
+		if (i > 0) {
+			pthread_join (wk->th, &status);
+			close (wk->epfd);
+			wk->epfd = -1;
+			close (wk->evfd);
+			wk->evfd = -1;
+		}
+		cef_log_write (CefC_Log_Info,
+			"%s %d : Interests %llu, hits %llu\n",
+			(i == 0) ? "Main thread" : "Worker", i,
+			(unsigned long long) wk->interests, (unsigned long long) wk->hits);
+	}
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Assigns the accepted TCP peer to the worker which serves the fewest peers
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_worker_assign (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	int slot								/* index of hdl->tcp_fds					*/
+) {
+#ifdef __linux__
+	struct epoll_event ev;
+	CsmgrdT_Worker* wk = NULL;
+	int i;
+	
+	for (i = 1 ; i <= hdl->worker_num ; i++) {
+		if ((wk == NULL) ||
+			(__atomic_load_n (&csmgr_workers[i].peer_num, __ATOMIC_RELAXED) <
+				__atomic_load_n (&wk->peer_num, __ATOMIC_RELAXED))) {
+			wk = &csmgr_workers[i];
+		}
+	}
+	if (wk == NULL) {
+		csmgr_tcp_owner[slot] = 0;
+		return;
+	}
+	
+	/* The main thread stops polling the socket from now on 	*/
+	csmgr_tcp_owner[slot] = wk->id;
+	__atomic_add_fetch (&wk->peer_num, 1, __ATOMIC_RELAXED);
+	
+	memset (&ev, 0, sizeof (struct epoll_event));
+	ev.events 	= EPOLLIN;
+	ev.data.u32 = (uint32_t) slot;
+	if (epoll_ctl (wk->epfd, EPOLL_CTL_ADD, hdl->tcp_fds[slot], &ev) < 0) {
+		cef_log_write (CefC_Log_Warn,
+			"Failed to pass TCP peer to the worker (%s)\n", strerror (errno));
+		__atomic_sub_fetch (&wk->peer_num, 1, __ATOMIC_RELAXED);
+		csmgr_tcp_owner[slot] = 0;
+	}
+#else // __linux__
+	csmgr_tcp_owner[slot] = 0;
+#endif // __linux__
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	function for serving the TCP peers assigned to the worker
 ----------------------------------------------------------------------------------------*/
 static void* 
-push_bytes_process_thread (
+csmgrd_worker_thread (
 	void* arg
 ) {
+	CsmgrdT_Worker* wk = (CsmgrdT_Worker*) arg;
+#ifdef __linux__
+	CefT_Csmgrd_Handle* hdl = wk->hdl;
+	struct epoll_event evs[CsmgrdC_Max_Sock_Num];
+	int num;
+	int i;
+	
+	while (csmgrd_running_f) {
+	
+		/* Passes Upload Requests received in the last round to the process thread */
+		csmgr_cob_block_flush (wk);
+		csmgr_credit_grant (hdl, wk);
+	
+		num = epoll_wait (wk->epfd, evs, CsmgrdC_Max_Sock_Num, CsmgrdC_Worker_Wait);
+	
+		for (i = 0 ; i < num ; i++) {
+			if (evs[i].data.u32 == CsmgrdC_Max_Sock_Num) {
+				csmgrd_worker_close_req_process (hdl, wk);
+				continue;
+			}
+			csmgrd_tcp_peer_input (hdl, wk, (int) evs[i].data.u32,
+				evs[i].events & (EPOLLERR | EPOLLHUP));
+		}
+	}
+#endif // __linux__
+	csmgr_cob_block_flush (wk);
+	
+	pthread_exit (NULL);
+	return ((void*) NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Asks the worker which owns the TCP peer to close it
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_worker_close_req (
+	int owner,								/* id of the worker serving the peer		*/
+	int slot								/* index of hdl->tcp_fds					*/
+) {
+#ifdef __linux__
+	uint64_t val = 1;
+	
+	__atomic_store_n (&csmgr_tcp_close_req[slot], 1, __ATOMIC_RELEASE);
+	if (write (csmgr_workers[owner].evfd, &val, sizeof (uint64_t)) < 0) {
+		cef_log_write (CefC_Log_Warn,
+			"Failed to wake the worker %d (%s)\n", owner, strerror (errno));
+	}
+#endif // __linux__
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Closes the TCP peers which the main thread asked the worker to close
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_worker_close_req_process (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	CsmgrdT_Worker* wk						/* thread serving the peers					*/
+) {
+#ifdef __linux__
+	uint64_t val;
+	int i;
+	
+	if (read (wk->evfd, &val, sizeof (uint64_t)) < 0) {
+		return;
+	}
+	
+	/* Only this worker clears the socket of its peer, so the socket read 	*/
+	/* here is still the one which the request was made for 				*/
+	for (i = 1 ; i < CsmgrdC_Max_Sock_Num ; i++) {
+		if ((csmgr_tcp_owner[i] != wk->id) ||
+			(__atomic_load_n (&hdl->tcp_fds[i], __ATOMIC_ACQUIRE) == -1)) {
+			continue;
+		}
+		if (__atomic_exchange_n (&csmgr_tcp_close_req[i], 0, __ATOMIC_ACQUIRE)) {
+			csmgrd_tcp_peer_close (hdl, i);
+		}
+	}
+#endif // __linux__
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Receives and handles the message(s) from the TCP peer
+----------------------------------------------------------------------------------------*/
+static void 
+csmgrd_tcp_peer_input (
+	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
+	CsmgrdT_Worker* wk,						/* thread serving the peer					*/
+	int slot,								/* index of hdl->tcp_fds					*/
+	int err_f								/* 1: error or hang up is detected			*/
+) {
+	int sock = hdl->tcp_fds[slot];
+	int len;
 	
-	while (csmgrd_running_f) {
-		usleep (csmgr_wait_time);
-		csmgr_push_bytes_process ();
+	if (sock == -1) {
+		return;
+	}
+	if (err_f) {
+		/* Error occurs, so close this socket 	*/
+		csmgrd_tcp_peer_close (hdl, slot);
+		return;
 	}
 	
-	pthread_exit (NULL);
+	len = recv (sock, &hdl->tcp_buff[slot][hdl->tcp_index[slot]],
+			CefC_Cefnetd_Buff_Max - hdl->tcp_index[slot], 0);
+	if (len > 0) {
+		/* receive message */
+		len += hdl->tcp_index[slot];
 	
-	return ((void*) NULL);
+		len = csmgr_input_bytes_process (hdl, wk, sock, &hdl->tcp_buff[slot][0], len);
+	
+		/* set index */
+		if (len > 0) {
+			hdl->tcp_index[slot] = len;
+		} else {
+			hdl->tcp_index[slot] = 0;
+		}
+	} else if (len == 0) {
+		csmgrd_tcp_peer_close (hdl, slot);
+	} else {
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+			/* Error occurs, so close this socket 	*/
+			cef_log_write (CefC_Log_Warn,
+				"Receive error (%d) . Close tcp socket\n", errno);
+			cef_log_write (CefC_Log_Warn, "%s\n", strerror (errno));
+			csmgrd_tcp_peer_close (hdl, slot);
+		}
+	}
+	return;
 }
 /*--------------------------------------------------------------------------------------
-	Get frame from received message
+	Closes the TCP peer
 ----------------------------------------------------------------------------------------*/
-static int							/* The return value is negative if an error occurs	*/
-csmgr_input_bytes_process (
+static void 
+csmgrd_tcp_peer_close (
 	CefT_Csmgrd_Handle* hdl,				/* CS Manager Handle						*/
-	int peer_fd, 
-	unsigned char* buff,					/* receive message							*/
-	int buff_len							/* message length							*/
+	int slot								/* index of hdl->tcp_fds					*/
 ) {
-	int index = 0;
-	uint16_t len;
-	uint16_t value16;
-	int rec_buff_len = buff_len;
-	int res;
+	int owner = csmgr_tcp_owner[slot];
 	
-	while (buff_len > CefC_Csmgr_Msg_HeaderLen) {
-		/* searches the top of massage 		*/
-		if ((buff[index + CefC_O_Fix_Ver] != CefC_Version) ||
-			(buff[index + CefC_O_Fix_Type] >= CefC_Csmgr_Msg_Type_Num) ||
-			(buff[index + CefC_O_Fix_Type] == CefC_Csmgr_Msg_Type_Invalid)) {
-			
-			buff_len--;
-			index++;
-			
-			while (buff_len > CefC_Csmgr_Msg_HeaderLen) {
-				
-				if ((buff[index + CefC_O_Fix_Ver] != CefC_Version) ||
-					(buff[index + CefC_O_Fix_Type] >= CefC_Csmgr_Msg_Type_Num) ||
-					(buff[index + CefC_O_Fix_Type] == CefC_Csmgr_Msg_Type_Invalid)) {
-					
-					buff_len--;
-					index++;
-				} else {
-					break;
-				}
-			}
-			if (buff_len <= CefC_Csmgr_Msg_HeaderLen) {
-				break;
-			}
-		}
-		
-		/* obtains the length of message 		*/
-		memcpy (&value16, &buff[index + CefC_O_Length], CefC_S_Length);
-		len = ntohs (value16);
-		
-		if (len > buff_len) {
-			break;
-		}
-		
-		/* check the type of message 			*/
-		if (buff[index + CefC_O_Fix_Type] != CefC_Csmgr_Msg_Type_UpReq) {
-			res = csmgrd_input_message_process (hdl, peer_fd, 
-				&buff[index + CefC_Csmgr_Msg_HeaderLen], len - CefC_Csmgr_Msg_HeaderLen, 
-				buff[index + CefC_O_Fix_Type]);
-			if (res < 0) {
-				return (0);
-			}
-		} else {
-			int cstat;
-			cstat = cef_csmgr_frame_check (&buff[index], len);
-			if (cstat < 0) {
-//@@@@@fprintf(stderr, "[%s]: [------ goto SKIP; [cstat < 0] -----\n", __FUNCTION__);
-				goto SKIP;
-			}
-			pthread_mutex_lock (&csmgr_Lack_of_resources_mutex);
-			if (Lack_of_F_resources == 1) {
-				pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
-				goto SKIP;
-			}
-			if (Lack_of_M_resources == 1) {
-				pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
-				goto SKIP;
-			}
-			pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
-			if (pthread_mutex_trylock (&csmgr_main_cob_buff_mutex) != 0) {
-				goto SKIP;
-			}
-			if (csmgr_main_cob_buff_idx + len > CsmgrC_Buff_Size) {
-				pthread_mutex_lock (&csmgr_comn_buff_mutex);
-				
-				memcpy (
-					csmgr_comn_cob_buff, 
-					csmgr_main_cob_buff, 
-					csmgr_main_cob_buff_idx);
-				csmgr_comn_cob_buff_idx = csmgr_main_cob_buff_idx;
-				csmgr_main_cob_buff_idx = 0;
-				
-				pthread_cond_signal (&csmgr_comn_buff_cond);
-				pthread_mutex_unlock (&csmgr_comn_buff_mutex);
-			}
-			memcpy (
-				&csmgr_main_cob_buff[csmgr_main_cob_buff_idx], 
-				&buff[index], len);
-			
-			csmgr_main_cob_buff_idx += len;
-			pthread_mutex_unlock (&csmgr_main_cob_buff_mutex);
-		}
-		
-SKIP:;
-		buff_len -= len;
-		index += len;
+	if (hdl->tcp_fds[slot] == -1) {
+		return;
 	}
-	
-	if (index < rec_buff_len) {
-		memmove (&buff[0], &buff[index], buff_len);
+	csmgr_credit_release (hdl->tcp_fds[slot]);
+	close (hdl->tcp_fds[slot]);
+	cef_log_write (CefC_Log_Info, "Close TCP peer: %s:%s\n",
+		hdl->peer_id_str[slot], hdl->peer_sv_str[slot]);
+	__atomic_sub_fetch (&hdl->peer_num, 1, __ATOMIC_RELAXED);
+	if (owner > 0) {
+		__atomic_sub_fetch (&csmgr_workers[owner].peer_num, 1, __ATOMIC_RELAXED);
 	}
-	return (buff_len);
+	
+	/* Reset buffer */
+	hdl->tcp_index[slot] = 0;
+	
+	/* The main thread reuses the slot once the socket is cleared 	*/
+	__atomic_store_n (&hdl->tcp_fds[slot], -1, __ATOMIC_RELEASE);
+	
+	return;
 }
 /*--------------------------------------------------------------------------------------
-	Push the buffered messages to proc thread buffer 
+	Closes the local peer
 ----------------------------------------------------------------------------------------*/
 static void 
-csmgr_push_bytes_process (
-	void 
+csmgrd_local_peer_close (
+	CefT_Csmgrd_Handle* hdl					/* CS Manager Handle						*/
 ) {
-	pthread_mutex_lock (&csmgr_main_cob_buff_mutex);
-	
-	if (csmgr_main_cob_buff_idx > 0) {
-		
-		pthread_mutex_lock (&csmgr_comn_buff_mutex);
-		
-		if (csmgr_main_cob_buff_idx  > 0) {
-			memcpy (
-				csmgr_comn_cob_buff, 
-				csmgr_main_cob_buff, 
-				csmgr_main_cob_buff_idx);
-			
-			csmgr_comn_cob_buff_idx = csmgr_main_cob_buff_idx;
-			csmgr_main_cob_buff_idx = 0;
-		}
-		
-		pthread_cond_signal (&csmgr_comn_buff_cond);
-		pthread_mutex_unlock (&csmgr_comn_buff_mutex);
+	if (hdl->local_peer_sock == -1) {
+		return;
 	}
-	pthread_mutex_unlock (&csmgr_main_cob_buff_mutex);
+	csmgrd_shm_detach (hdl);
+	csmgr_credit_release (hdl->local_peer_sock);
+	close (hdl->local_peer_sock);
+	hdl->local_peer_sock = -1;
+	cef_log_write (CefC_Log_Info, "Close Local peer\n");
 	
 	return;
 }
@@ -1381,6 +2206,8 @@ csmgrd_local_sock_check (
 			}
 		}
 		if (hdl->local_peer_sock != -1) {
+			csmgrd_shm_detach (hdl);
+			csmgr_credit_release (hdl->local_peer_sock);
 			close (hdl->local_peer_sock);
 		}
 		hdl->local_peer_sock = sock;
@@ -1412,6 +2239,7 @@ csmgrd_handle_destroy (
 		hdl->local_listen_fd = -1;
 	}
 	if (hdl->local_peer_sock != -1) {
+		csmgrd_shm_detach (hdl);
 		close (hdl->local_peer_sock);
 		hdl->local_peer_sock = -1;
 	}
@@ -1473,12 +2301,7 @@ csmgrd_handle_destroy (
 	if (strlen (csmgr_local_sock_name) != 0) {
 		unlink (csmgr_local_sock_name);
 	}
-	if (csmgr_main_cob_buff) {
-		free (csmgr_main_cob_buff);
-	}
-	if (csmgr_comn_cob_buff) {
-		free (csmgr_comn_cob_buff);
-	}
+	csmgr_cob_que_destroy ();
 	free (hdl);
 	*csmgrd_hdl = NULL;
 	
@@ -1528,6 +2351,7 @@ csmgrd_config_read (
 	strcpy (conf_param->fsc_cache_path, csmgr_conf_dir);
 	conf_param->port_num 	= CefC_Default_Tcp_Prot;
 	strcpy (conf_param->local_sock_id, "0");
+	conf_param->worker_num 	= 0;
 	
 	/* get parameter */
 	while (fgets (param_buff, sizeof (param_buff), fp) != NULL) {
@@ -1576,6 +2400,8 @@ csmgrd_config_read (
 			if (!(strcmp (conf_param->cs_mod_name, "filesystem") == 0
 				    ||
 				  strcmp (conf_param->cs_mod_name, "memory") == 0
+				    ||
+				  strcmp (conf_param->cs_mod_name, "segment") == 0
 #ifdef CefC_Db				
 				    ||
 				  strcmp (conf_param->cs_mod_name, "db") == 0
@@ -1612,12 +2438,30 @@ csmgrd_config_read (
 				return (-1);
 			}
 			strcpy (conf_param->local_sock_id, value);
+		} else if (strcmp (option, "WORKER_NUM") == 0) {
+			res = csmgrd_config_value_get (option, value);
+			if ((res < 0) || (res > CsmgrdC_Max_Worker_Num)) {
+				cef_log_write (CefC_Log_Error,
+					"WORKER_NUM must be higher than or equal to 0 and lower than "
+					"or equal to %d.\n", CsmgrdC_Max_Worker_Num);
+				fclose (fp);
+				return (-1);
+			}
+			conf_param->worker_num = res;
 		} else {
 			continue;
 		}
 	}
+#ifndef __linux__
+	if (conf_param->worker_num > 0) {
+		cef_log_write (CefC_Log_Warn, 
+			"WORKER_NUM is supported only on Linux, the main thread serves the peers.\n");
+		conf_param->worker_num = 0;
+	}
+#endif // __linux__
 
-	if (strcmp (conf_param->cs_mod_name, "filesystem") == 0) {
+	if ((strcmp (conf_param->cs_mod_name, "filesystem") == 0) ||
+		(strcmp (conf_param->cs_mod_name, "segment") == 0)) {
 		if (!(    access (conf_param->fsc_cache_path, F_OK) == 0
 			   && access (conf_param->fsc_cache_path, R_OK) == 0
 	   		   && access (conf_param->fsc_cache_path, W_OK) == 0
@@ -1714,6 +2558,10 @@ csmgrd_plugin_load (
 		dlclose (hdl->mod_lib);
 		return (-1);
 	}
+	
+	/* Replies to cefnetd in order with the Cobs which the plugin sends 	*/
+	hdl->cob_msg_send = (int (*)(int, unsigned char*, uint16_t)) 
+							dlsym (hdl->mod_lib, "csmgrd_plugin_cob_msg_send");
 
 	return (0);
 }
@@ -1955,10 +2803,18 @@ csmgrd_tcp_connect_accept (
 
 	/* Looks up the source node's information from the source table 	*/
 	for (i = 1 ; i < CsmgrdC_Max_Sock_Num ; i++) {
-		if ((strcmp (hdl->peer_id_str[i], ip_str) == 0) &&
+		if ((__atomic_load_n (&hdl->tcp_fds[i], __ATOMIC_ACQUIRE) != -1) && 
+			(strcmp (hdl->peer_id_str[i], ip_str) == 0) &&
 			(strcmp (hdl->peer_sv_str[i], port_str) == 0)) {
 			cef_log_write (CefC_Log_Info, "Close TCP peer: [%d] %s:%s\n",
 				i, hdl->peer_id_str[i], hdl->peer_sv_str[i]);
+			if (csmgr_tcp_owner[i] != 0) {
+				/* The socket is closed by the worker which owns it, because the 	*/
+				/* worker may close it and the fd may be reused at any time 		*/
+				csmgrd_worker_close_req (csmgr_tcp_owner[i], i);
+				break;
+			}
+			csmgr_credit_release (hdl->tcp_fds[i]);
 			close (hdl->tcp_fds[i]);
 			hdl->tcp_fds[i] 	= -1;
 			hdl->tcp_index[i] 	= 0;
@@ -1976,12 +2832,14 @@ csmgrd_tcp_connect_accept (
 			strcpy (hdl->peer_sv_str[i], port_str);
 			cef_log_write (CefC_Log_Info, "Open TCP peer: %s:%s, socket : %d\n",
 				hdl->peer_id_str[i], hdl->peer_sv_str[i], cs);
-			hdl->peer_num++;
-			hdl->tcp_fds[i] 	= cs;
+			__atomic_add_fetch (&hdl->peer_num, 1, __ATOMIC_RELAXED);
+			__atomic_store_n (&csmgr_tcp_close_req[i], 0, __ATOMIC_RELAXED);
 			hdl->tcp_index[i] 	= 0;
+			__atomic_store_n (&hdl->tcp_fds[i], cs, __ATOMIC_RELEASE);
 
 			cef_csmgr_send_msg (hdl->tcp_fds[i],
 				(unsigned char*) CefC_Csmgr_Cmd_ConnOK, strlen (CefC_Csmgr_Cmd_ConnOK));
+			csmgrd_worker_assign (hdl, i);
 		} else {
 			cef_log_write (CefC_Log_Warn,
 				"TCP socket num is full. Could not find the free socket.\n");
@@ -1995,6 +2853,7 @@ csmgrd_tcp_connect_accept (
 
 		cef_csmgr_send_msg (hdl->tcp_fds[i],
 			(unsigned char*) CefC_Csmgr_Cmd_ConnOK, strlen (CefC_Csmgr_Cmd_ConnOK));
+		csmgrd_worker_assign (hdl, i);
 	}
 	return;
 
@@ -2026,7 +2885,8 @@ csmgrd_poll_socket_prepare (
 	}
 	
 	for (i = 1 ; i < CsmgrdC_Max_Sock_Num ; i++) {
-		if (hdl->tcp_fds[i] != -1) {
+		/* The worker polls the socket assigned to it 	*/
+		if ((hdl->tcp_fds[i] != -1) && (csmgr_tcp_owner[i] == 0)) {
 			fds[set_num].fd     = hdl->tcp_fds[i];
 			fds[set_num].events = POLLIN | POLLERR;
 			fds_index[set_num]  = i;
@@ -2034,6 +2894,13 @@ csmgrd_poll_socket_prepare (
 		}
 	}
 	
+	if (hdl->shm) {
+		fds[set_num].fd     = hdl->shm->ring[CefC_Csmgr_Shm_Ring_Req].doorbell;
+		fds[set_num].events = POLLIN;
+		fds_index[set_num]  = CsmgrdC_Shm_Fds_Index;
+		set_num++;
+	}
+	
 	return (set_num);
 }
 /*--------------------------------------------------------------------------------------
@@ -2042,6 +2909,7 @@ csmgrd_poll_socket_prepare (
 static int							/* The return value is negative if an error occurs	*/
 csmgrd_input_message_process (
 	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	CsmgrdT_Worker* wk,							/* thread serving the peer				*/
 	int sock,									/* recv socket							*/
 	unsigned char* msg,							/* receive message						*/
 	int msg_len,								/* message length						*/
@@ -2052,7 +2920,25 @@ csmgrd_input_message_process (
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Finest, "Receive the Interest Message\n");
 #endif // CefC_Debug
-			csmgrd_incoming_interest (hdl, sock, msg, msg_len, type);
+			wk->interests++;
+			if (csmgrd_incoming_interest (
+					hdl, sock, msg, msg_len, type) == CefC_Csmgr_Cob_Exist) {
+				wk->hits++;
+			}
+			break;
+		}
+		case CefC_Csmgr_Msg_Type_ShmRing: {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finest, "Receive the Shared memory ring Message\n");
+#endif // CefC_Debug
+			csmgrd_shm_attach (hdl, sock);
+			break;
+		}
+		case CefC_Csmgr_Msg_Type_Credit: {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finest, "Receive the Upload credit request\n");
+#endif // CefC_Debug
+			csmgr_credit_request (wk, sock, msg, msg_len);
 			break;
 		}
 #ifdef CefC_Ccninfo
@@ -2174,7 +3060,7 @@ csmgrd_input_message_process (
 /*--------------------------------------------------------------------------------------
 	Incoming Interest Message
 ----------------------------------------------------------------------------------------*/
-static void
+static int									/* CefC_Csmgr_Cob_Exist if Cob was sent	*/
 csmgrd_incoming_interest (
 	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
 	int sock,									/* recv socket							*/
@@ -2198,25 +3084,40 @@ csmgrd_incoming_interest (
 #ifdef CefC_Debug
 		cef_dbg_write (CefC_Dbg_Fine, "Parse message error (interest)\n");
 #endif // CefC_Debug
-		return;
+		return (-1);
 	}
 
 	/* Checks Interest Type */
 	switch (int_type) {
-		case CefC_Csmgr_Interest_Type_Normal: {
+		case CefC_Csmgr_Interest_Type_Normal: 
+		case CefC_Csmgr_Interest_Type_Pending: {
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Fine, "Call cache plugin (cache_item_get)\n");
 #endif // CefC_Debug
 			/* Searches and sends a Cob */
-			hdl->cs_mod_int->cache_item_get (name, name_len, chnk_num, sock);
+			res = hdl->cs_mod_int->cache_item_get (name, name_len, chnk_num, sock);
+			
+			/* cefnetd holds the Interest until it receives the result 	*/
+			if (int_type == CefC_Csmgr_Interest_Type_Pending) {
+				csmgrd_lookup_res_send (hdl, sock, op_data, res);
+			}
+			
+			/* Counts the queries which passed the summary in cefnetd 	*/
+			if ((hdl->summary) && (sock == hdl->local_peer_sock)) {
+				__atomic_fetch_add (&hdl->shm->hdr->summary.queries, 1, __ATOMIC_RELAXED);
+				if (res != CefC_Csmgr_Cob_Exist) {
+					__atomic_fetch_add (&hdl->shm->hdr->summary.misses, 1, __ATOMIC_RELAXED);
+				}
+			}
 			break;
 		}
 		default: {
+			res = -1;
 			break;
 		}
 	}
 
-	return;
+	return (res);
 }
 /*--------------------------------------------------------------------------------------
 	Parse Interest message
@@ -2279,9 +3180,54 @@ cef_csmgr_interest_msg_parse (
 		*chnk_num = ntohl (value32);
 		index += CefC_S_ChunkNum;
 	}
+	
+	/* get Request ID, it is returned to cefnetd as is */
+	if (*int_type == CefC_Csmgr_Interest_Type_Pending) {
+		if ((buff_len - index - (int) sizeof (uint32_t)) < 0) {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Fine, "Request ID parse error\n");
+#endif // CefC_Debug
+			return (-1);
+		}
+		memcpy (op_data, buff + index, sizeof (uint32_t));
+		*op_data_len = sizeof (uint32_t);
+		index += sizeof (uint32_t);
+	}
 
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Sends the lookup result to cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_lookup_res_send (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock,									/* socket the Interest came from		*/
+	unsigned char id[],							/* Request ID (network byte order)		*/
+	int exist_f									/* CefC_Csmgr_Cob_Exist if Cob was sent	*/
+) {
+	unsigned char buff[CefC_Csmgr_Lookup_Res_Len];
+	uint16_t value16;
+	
+	/* cefnetd forwards the Interest at the deadline without the result 	*/
+	if (hdl->cob_msg_send == NULL) {
+		return;
+	}
+	
+	/* Uses the fixed header so that cefnetd can take it from the Cob stream	*/
+	memset (buff, 0, CefC_S_Fix_Header);
+	buff[CefC_O_Fix_Ver] 			= CefC_Version;
+	buff[CefC_O_Fix_Type] 			= CefC_Csmgr_PT_LOOKUP_RES;
+	value16 = htons (CefC_Csmgr_Lookup_Res_Len);
+	memcpy (&buff[CefC_O_Fix_PacketLength], &value16, sizeof (uint16_t));
+	buff[CefC_O_Fix_HeaderLength] 	= CefC_S_Fix_Header;
+	
+	memcpy (&buff[CefC_S_Fix_Header], id, sizeof (uint32_t));
+	buff[CefC_S_Fix_Header + sizeof (uint32_t)] = 
+		(exist_f == CefC_Csmgr_Cob_Exist) ? CefC_Csmgr_Lookup_Hit : CefC_Csmgr_Lookup_Miss;
+	
+	(*hdl->cob_msg_send)(sock, buff, CefC_Csmgr_Lookup_Res_Len);
+}
 
 /*--------------------------------------------------------------------------------------
 	Incoming Get Status Message
@@ -2305,6 +3251,8 @@ csmgrd_incoming_status_msg (
 	uint64_t value64;
 	struct CefT_Csmgr_Status_Hdr stat_hdr;
 	struct CefT_Csmgr_Status_Rep stat_rep;
+	struct CefT_Csmgr_Status_Buffer stat_buf;
+	CsmgrdT_Buffer_Stat buf_stat;
 	uint32_t value32;
 	struct pollfd fds[1];
 	uint32_t 		con_num = 0;
@@ -2360,6 +3308,27 @@ csmgrd_incoming_status_msg (
 			index += stat[i]->name_len;
 		}
 	}
+	
+	/* Appends the statistics of the pages buffered by the plugin 	*/
+	if ((hdl->cs_mod_int->buffer_stat_get != NULL) && 
+		(hdl->cs_mod_int->buffer_stat_get (&buf_stat) == 0)) {
+		if (index + sizeof (struct CefT_Csmgr_Status_Buffer) > wbuf_size) {
+			void *new = realloc (wbuf, wbuf_size+CefC_Csmgr_Stat_Mtu);
+			if (new == NULL) {
+				free (wbuf);
+				return;
+			}
+			wbuf = new;
+			wbuf_size += CefC_Csmgr_Stat_Mtu;
+		}
+		stat_buf.type 		= htons (CefC_Csmgr_Stat_Buffer);
+		stat_buf.length 	= htons (sizeof (struct CefT_Csmgr_Status_Buffer) - 2 * sizeof (uint16_t));
+		stat_buf.hits 		= cef_client_htonb (buf_stat.hits);
+		stat_buf.misses 	= cef_client_htonb (buf_stat.misses);
+		stat_buf.readaheads = cef_client_htonb (buf_stat.readaheads);
+		memcpy (&wbuf[index], &stat_buf, sizeof (struct CefT_Csmgr_Status_Buffer));
+		index += sizeof (struct CefT_Csmgr_Status_Buffer);
+	}
 	stat_hdr.node_num = htons ((uint16_t) hdl->peer_num);
 	stat_hdr.con_num  = htonl (con_num);
 	memcpy (&wbuf[CefC_Csmgr_Msg_HeaderLen+2/* To extend length from 2 bytes to 4 bytes */], &stat_hdr, sizeof (struct CefT_Csmgr_Status_Hdr));
@@ -4064,7 +5033,8 @@ csmgrd_resource_mon_thread (
 
 	if (strcmp (hdl->cs_mod_name, "memory") == 0) {
 		cs_type = 'M';
-	} else if (strcmp (hdl->cs_mod_name, "filesystem") == 0) {
+	} else if ((strcmp (hdl->cs_mod_name, "filesystem") == 0) ||
+			   (strcmp (hdl->cs_mod_name, "segment") == 0)) {
 		cs_type = 'F';
 	} else if (strcmp (hdl->cs_mod_name, "db") == 0) {
 		cs_type = 'D';
@@ -4146,7 +5116,8 @@ csmgrd_resource_mon_thread (
 				}
 			}
 		} 
-		else if (strcmp (hdl->cs_mod_name, "filesystem") == 0) {
+		else if ((strcmp (hdl->cs_mod_name, "filesystem") == 0) ||
+				 (strcmp (hdl->cs_mod_name, "segment") == 0)) {
 			if (max_cob_limit == 0) {
 				if (m_used > CSMGR_MAXIMUM_MEM_USAGE_FOR_FILE) {
 					Lack_of_M_resources = 1;
@@ -4166,7 +5137,10 @@ csmgrd_resource_mon_thread (
 				}
 			}
 
-			if (f_used > CSMGR_MAXIMUM_FILE_USAGE_FOR_FILE) {
+			/* The segment files are allocated at startup and never grow 	*/
+			if (strcmp (hdl->cs_mod_name, "segment") == 0) {
+				/* NOP */;
+			} else if (f_used > CSMGR_MAXIMUM_FILE_USAGE_FOR_FILE) {
 				Lack_of_F_resources = 1;
 				file_out = 1;
 			} else {
@@ -4452,3 +5426,194 @@ cef_csmgr_frame_check (
 	return (0);
 }
 
+/*--------------------------------------------------------------------------------------
+	Attaches the shared memory rings offered by local cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_shm_attach (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* recv socket							*/
+) {
+	void (*ring_set)(int, CefT_Csmgr_Shm_Ring*);
+	int fds[CefC_Csmgr_Shm_Fd_Num];
+	int fd_num;
+	
+	/* Only local cefnetd can pass the descriptors 	*/
+	if ((sock != hdl->local_peer_sock) || (hdl->shm_fd_num == 0)) {
+		cef_log_write (CefC_Log_Warn, 
+			"Shared memory ring message without descriptors is ignored\n");
+		return;
+	}
+	fd_num = hdl->shm_fd_num;
+	memcpy (fds, hdl->shm_fds, sizeof (int) * fd_num);
+	hdl->shm_fd_num = 0;
+	csmgrd_shm_detach (hdl);
+	
+	ring_set = (void (*)(int, CefT_Csmgr_Shm_Ring*)) 
+					dlsym (hdl->mod_lib, "csmgrd_plugin_shm_ring_set");
+	if (ring_set == NULL) {
+		for (fd_num-- ; fd_num >= 0 ; fd_num--) {
+			close (fds[fd_num]);
+		}
+		cef_log_write (CefC_Log_Warn, 
+			"Cache plugin does not support the shared memory ring\n");
+		return;
+	}
+	hdl->shm = cef_csmgr_shm_attach (fds, fd_num);
+	if (hdl->shm == NULL) {
+		cef_log_write (CefC_Log_Warn, 
+			"Failed to attach the shared memory rings, cefnetd is served by socket\n");
+		return;
+	}
+	
+	/* Replies from the plugin go through the Content Object ring 	*/
+	(*ring_set)(sock, &hdl->shm->ring[CefC_Csmgr_Shm_Ring_Obj]);
+	
+	hdl->shm_upload_run = 1;
+	if (pthread_create (&hdl->shm_upload_th, NULL, csmgrd_shm_upload_thread, hdl) != 0) {
+		cef_log_write (CefC_Log_Error, 
+			"Failed to create the new thread(csmgrd_shm_upload_thread)\n");
+		(*ring_set)(-1, NULL);
+		cef_csmgr_shm_destroy (hdl->shm);
+		hdl->shm = NULL;
+		return;
+	}
+	
+	/* cefnetd moves to the rings from here 	*/
+	cef_csmgr_shm_attached_set (hdl->shm, 1);
+	cef_log_write (CefC_Log_Info, "Shared memory rings with cefnetd : %u KB x %d\n", 
+		hdl->shm->hdr->ring_size / 1024, CefC_Csmgr_Shm_Ring_Num);
+	
+#ifndef CefC_Nwproc
+	/* Publishes the summary of the cached Cobs, so that cefnetd does not 	*/
+	/* ask for the Cobs which are not cached here 							*/
+	hdl->summary = cef_csmgr_summary_create (hdl->shm);
+	if (hdl->summary) {
+		csmgrd_stat_summary_set (stat_hdl, hdl->summary);
+		cef_csmgr_summary_ready_set (hdl->summary, 1);
+		cef_log_write (CefC_Log_Info, 
+			"Summary of the cached Cobs : %llu KB (%llu Cobs)\n", 
+			(unsigned long long)((hdl->summary->mask + 1) / 8 / 1024), 
+			(unsigned long long) hdl->summary->cob_num);
+	}
+#endif // CefC_Nwproc
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Detaches the shared memory rings
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_shm_detach (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+) {
+	void (*ring_set)(int, CefT_Csmgr_Shm_Ring*);
+	void* status;
+	
+	/* Closes the descriptors which were passed but not attached 	*/
+	for (hdl->shm_fd_num-- ; hdl->shm_fd_num >= 0 ; hdl->shm_fd_num--) {
+		close (hdl->shm_fds[hdl->shm_fd_num]);
+	}
+	hdl->shm_fd_num = 0;
+	
+	if (hdl->shm == NULL) {
+		return;
+	}
+	cef_csmgr_shm_attached_set (hdl->shm, 0);
+	
+	if (hdl->summary) {
+		cef_csmgr_summary_ready_set (hdl->summary, 0);
+		csmgrd_stat_summary_set (stat_hdl, NULL);
+		cef_csmgr_summary_destroy (hdl->summary);
+		hdl->summary = NULL;
+	}
+	hdl->shm_upload_run = 0;
+	pthread_join (hdl->shm_upload_th, &status);
+	
+	ring_set = (void (*)(int, CefT_Csmgr_Shm_Ring*)) 
+					dlsym (hdl->mod_lib, "csmgrd_plugin_shm_ring_set");
+	if (ring_set) {
+		(*ring_set)(-1, NULL);
+	}
+	cef_csmgr_shm_destroy (hdl->shm);
+	hdl->shm = NULL;
+	cef_log_write (CefC_Log_Info, "Shared memory rings with cefnetd are detached\n");
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Handles the requests in the shared memory ring
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_shm_req_process (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+) {
+	CefT_Csmgr_Shm_Ring* ring = &hdl->shm->ring[CefC_Csmgr_Shm_Ring_Req];
+	unsigned char* rec;
+	uint32_t rec_len;
+	
+	cef_csmgr_shm_doorbell_clear (ring);
+	
+	/* Each record holds one message which is handled in place 	*/
+	while ((rec = cef_csmgr_shm_read (ring, &rec_len)) != NULL) {
+		csmgr_input_bytes_process (
+			hdl, &csmgr_workers[0], hdl->local_peer_sock, rec, (int) rec_len);
+		cef_csmgr_shm_release (ring);
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	function for processing the Upload Requests in the shared memory ring
+----------------------------------------------------------------------------------------*/
+static void* 
+csmgrd_shm_upload_thread (
+	void* arg
+) {
+	CefT_Csmgrd_Handle* hdl = (CefT_Csmgrd_Handle*) arg;
+	CefT_Csmgr_Shm_Ring* ring = &hdl->shm->ring[CefC_Csmgr_Shm_Ring_Upload];
+	struct pollfd fds[1];
+	unsigned char* rec;
+	uint32_t rec_len;
+	uint32_t index;
+	uint16_t len;
+	uint16_t value16;
+	int lack_f;
+	
+	fds[0].fd 		= ring->doorbell;
+	fds[0].events 	= POLLIN;
+	
+	while (csmgrd_running_f && hdl->shm_upload_run) {
+		poll (fds, 1, 100);
+		cef_csmgr_shm_doorbell_clear (ring);
+		
+		while ((rec = cef_csmgr_shm_read (ring, &rec_len)) != NULL) {
+			pthread_mutex_lock (&csmgr_Lack_of_resources_mutex);
+			lack_f = Lack_of_F_resources | Lack_of_M_resources;
+			pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
+			
+			/* A record is a batch of Upload Requests, the valid part of which 	*/
+			/* is passed to the plugin without the copy to the cob buffers 		*/
+			index = 0;
+			while ((lack_f == 0) && (index + CefC_Csmgr_Msg_HeaderLen < rec_len)) {
+				memcpy (&value16, &rec[index + CefC_O_Length], CefC_S_Length);
+				len = ntohs (value16);
+				if ((rec[index + CefC_O_Fix_Type] != CefC_Csmgr_Msg_Type_UpReq) || 
+					(index + len > rec_len) || 
+					(cef_csmgr_frame_check (&rec[index], len) < 0)) {
+					break;
+				}
+				index += len;
+			}
+			if (index > 0) {
+				hdl->cs_mod_int->cache_item_puts (rec, (int) index);
+			}
+			csmgr_credit_rcvd_add (hdl->local_peer_sock, rec_len);
+			cef_csmgr_shm_release (ring);
+		}
+	}
+	
+	pthread_exit (NULL);
+	
+	return ((void*) NULL);
+}
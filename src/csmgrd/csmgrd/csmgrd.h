@@ -39,10 +39,12 @@
 #include <netinet/in.h>
 #include <netdb.h>
 #include <poll.h>
+#include <pthread.h>
 #include <sys/socket.h>
 
 #include <cefore/cef_define.h>
 #include <cefore/cef_csmgr.h>
+#include <cefore/cef_csmgr_shm.h>
 #include <cefore/cef_rngque.h>
 #include <csmgrd/csmgrd_plugin.h>
 
@@ -54,6 +56,8 @@
 /* Macros for csmgrd status										*/
 /*------------------------------------------------------------------*/
 #define CsmgrdC_Max_Sock_Num		32					/* Max number of TCP peer		*/
+#define CsmgrdC_Shm_Fds_Index		-1					/* fds_index of the ring doorbell	*/
+#define CsmgrdC_Max_Worker_Num		16					/* Max number of worker threads	*/
 
 /* Library name				*/
 #ifdef __APPLE__
@@ -75,6 +79,7 @@ typedef struct {
 	char			fsc_cache_path[CefC_Csmgr_File_Path_Length]; /* FSC cache path		*/
 	uint16_t 		port_num;					/* PORT_NUM in csmgrd.conf 				*/
 	char 			local_sock_id[1024];
+	int 			worker_num;					/* WORKER_NUM in csmgrd.conf 			*/
 	
 } CsmgrT_Config_Param;
 
@@ -107,17 +112,28 @@ typedef struct {
 	char				peer_id_str[CsmgrdC_Max_Sock_Num][NI_MAXHOST];
 	char				peer_sv_str[CsmgrdC_Max_Sock_Num][NI_MAXSERV];
 	int 				peer_num;
+	int 				worker_num;				/* threads serving the TCP peers		*/
 	
 	/********** Local listen socket 	***********/
 	int 				local_listen_fd;
 	char 				local_sock_name[1024];
 	int					local_peer_sock;
 	
+	/********** Shared memory rings with local cefnetd	***********/
+	CefT_Csmgr_Shm*		shm;					/* NULL while the socket is used		*/
+	int					shm_fds[CefC_Csmgr_Shm_Fd_Num];	/* received from cefnetd		*/
+	int					shm_fd_num;
+	pthread_t			shm_upload_th;
+	volatile int		shm_upload_run;
+	CefT_Csmgr_Summary*	summary;				/* summary of the cached Cobs			*/
+	
 	/********** load functions			***********/
 	CsmgrdT_Plugin_Interface* cs_mod_int;		/* plugin interface						*/
 	char			cs_mod_name[CsmgrdC_Max_Plugin_Name_Len];
 												/* plugin library name					*/
 	void*			mod_lib;					/* plugin library						*/
+	int (*cob_msg_send)(int, unsigned char*, uint16_t);
+												/* sends the message like the plugin	*/
 	char			fsc_cache_path[CefC_Csmgr_File_Path_Length]; /* FSC cache path		*/
 	
 	/********** excache Status			***********/
@@ -61,6 +61,10 @@
 #define CsmgrC_Buff_Max 				100000000
 #define CsmgrC_Buff_Num 				65536
 
+#define CsmgrdC_Aio_Min_Depth 			8
+#define CsmgrdC_Aio_Max_Depth 			4096
+#define CsmgrdC_Aio_Def_Depth 			256
+
 /****************************************************************************************
  Structure Declarations
  ****************************************************************************************/
@@ -82,6 +86,21 @@ typedef struct {
 
 } CsmgrdT_Content_Entry;
 
+typedef struct {
+
+	/********** Statistics of the pages buffered by the plugin	***********/
+	uint64_t		hits;						/* lookups served from the buffer		*/
+	uint64_t		misses;						/* lookups which read the file			*/
+	uint64_t		readaheads;					/* pages read ahead						*/
+
+} CsmgrdT_Buffer_Stat;
+
+/********** Asynchronous I/O engine shared by the disk-backed plugins	***********/
+typedef struct CsmgrdT_Aio CsmgrdT_Aio;
+
+/* Called from the completion thread with the transferred bytes or -errno 	*/
+typedef void (*CsmgrdT_Aio_Done)(void* arg, int res);
+
 typedef struct CsmgrdT_Plugin_Interface {
 	/* Initialize process */
 	int (*init)(CsmgrT_Stat_Handle);
@@ -113,6 +132,9 @@ typedef struct CsmgrdT_Plugin_Interface {
 #endif // CefC_Ccore
 	
 	int (*content_lifetime_get) (unsigned char*, uint16_t, uint32_t*, uint32_t*, uint8_t);
+	
+	/* Obtains the statistics of the buffered pages (NULL if no buffer) */
+	int (*buffer_stat_get) (CsmgrdT_Buffer_Stat*);
 
 } CsmgrdT_Plugin_Interface;
 
@@ -194,6 +216,14 @@ csmgrd_plugin_cob_msg_send (
 	unsigned char* msg,						/* send message								*/
 	uint16_t msg_len						/* message length							*/
 );
+/*--------------------------------------------------------------------------------------
+	Sets the shared memory ring used to reply to the local socket
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_shm_ring_set (
+	int fd,									/* local socket connected to cefnetd		*/
+	CefT_Csmgr_Shm_Ring* ring				/* Content Object ring, NULL to unset		*/
+);
 /*--------------------------------------------------------------------------------------
 	Sets APIs for cache algorithm library
 ----------------------------------------------------------------------------------------*/
@@ -242,6 +272,53 @@ csmgrd_cache_algo_availability_check (
 	int			cob_size,
 	char*		cs_type
 );
+/*--------------------------------------------------------------------------------------
+	Creates the asynchronous I/O engine and its completion thread
+----------------------------------------------------------------------------------------*/
+CsmgrdT_Aio*						/* NULL if the asynchronous I/O is not available	*/
+csmgrd_aio_create (
+	int depth									/* I/Os in flight at most				*/
+);
+/*--------------------------------------------------------------------------------------
+	Waits for the I/Os in flight and destroys the asynchronous I/O engine
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_aio_destroy (
+	CsmgrdT_Aio* aio
+);
+/*--------------------------------------------------------------------------------------
+	Queues the read, which is started by csmgrd_aio_submit
+----------------------------------------------------------------------------------------*/
+int									/* negative if the queue is full					*/
+csmgrd_aio_read (
+	CsmgrdT_Aio* aio,
+	int fd,
+	void* buf,
+	uint32_t len,
+	uint64_t off,
+	CsmgrdT_Aio_Done done,						/* called when the read completes		*/
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Queues the write, which is started by csmgrd_aio_submit
+----------------------------------------------------------------------------------------*/
+int									/* negative if the queue is full					*/
+csmgrd_aio_write (
+	CsmgrdT_Aio* aio,
+	int fd,
+	const void* buf,
+	uint32_t len,
+	uint64_t off,
+	CsmgrdT_Aio_Done done,						/* called when the write completes		*/
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Starts the queued I/Os with a system call
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+csmgrd_aio_submit (
+	CsmgrdT_Aio* aio
+);
 
 void
 csmgrd_log_init (
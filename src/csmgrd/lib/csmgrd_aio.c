@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2016-2021, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * csmgrd_aio.c
+ */
+
+#define __CSMGRD_AIO_SOURCE__
+
+/*
+	csmgrd_aio.c runs the reads and writes of the disk-backed plugins with io_uring.
+	The plugin queues the I/Os and starts them with a system call, and the completion
+	thread calls back the plugin as each I/O completes.
+*/
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#define CsmgrdC_Aio_Uring
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+#endif // __NR_io_uring_setup
+
+#include <csmgrd/csmgrd_plugin.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CsmgrdC_Aio_Stop_Data 		0xFFFFFFFFFFFFFFFFllu	/* stops the completion thread */
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/********** I/O queued or in flight 	**********/
+typedef struct {
+
+	CsmgrdT_Aio_Done 	done;
+	void* 				arg;
+	struct iovec 		iov;
+	int 				next;					/* next free entry, -1 if none			*/
+
+} CsmgrdT_Aio_Op;
+
+struct CsmgrdT_Aio {
+
+#ifdef CsmgrdC_Aio_Uring
+	int 				ring_fd;
+
+	/********** Submission queue shared with the kernel	**********/
+	void* 				sq_ring;
+	size_t 				sq_ring_size;
+	unsigned* 			sq_head;
+	unsigned* 			sq_tail;
+	unsigned* 			sq_mask;
+	unsigned* 			sq_array;
+	struct io_uring_sqe* sqes;
+	size_t 				sqes_size;
+	unsigned 			sq_local_tail;			/* tail of the queued entries			*/
+	unsigned 			sq_queued;				/* entries not given to the kernel yet	*/
+
+	/********** Completion queue shared with the kernel	**********/
+	void* 				cq_ring;
+	size_t 				cq_ring_size;
+	unsigned* 			cq_head;
+	unsigned* 			cq_tail;
+	unsigned* 			cq_mask;
+	struct io_uring_cqe* cqes;
+#endif // CsmgrdC_Aio_Uring
+
+	pthread_mutex_t 	mutex;
+	pthread_t 			th;
+	int 				th_f;
+	CsmgrdT_Aio_Op* 	ops;
+	int 				op_num;
+	int 				op_free;
+	int 				inflight;				/* I/Os queued or in flight				*/
+
+	uint64_t 			ios;
+	uint64_t 			submits;				/* system calls to start the I/Os		*/
+	uint64_t 			errors;
+};
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+#ifdef CsmgrdC_Aio_Uring
+/*--------------------------------------------------------------------------------------
+	Queues the I/O to the submission queue
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the queue is full					*/
+csmgrd_aio_queue (
+	CsmgrdT_Aio* aio,
+	int opcode,									/* IORING_OP_READV or IORING_OP_WRITEV	*/
+	int fd,
+	void* buf,
+	uint32_t len,
+	uint64_t off,
+	CsmgrdT_Aio_Done done,
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Gives the queued entries to the kernel, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_aio_enter (
+	CsmgrdT_Aio* aio
+);
+/*--------------------------------------------------------------------------------------
+	Calls back the plugin as each I/O completes
+----------------------------------------------------------------------------------------*/
+static void*
+csmgrd_aio_complete_thread (
+	void* arg
+);
+#endif // CsmgrdC_Aio_Uring
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the asynchronous I/O engine and its completion thread
+----------------------------------------------------------------------------------------*/
+CsmgrdT_Aio*						/* NULL if the asynchronous I/O is not available	*/
+csmgrd_aio_create (
+	int depth									/* I/Os in flight at most				*/
+) {
+#ifdef CsmgrdC_Aio_Uring
+	CsmgrdT_Aio* aio;
+	struct io_uring_params p;
+	int i;
+	
+	if (depth < CsmgrdC_Aio_Min_Depth) {
+		depth = CsmgrdC_Aio_Min_Depth;
+	}
+	if (depth > CsmgrdC_Aio_Max_Depth) {
+		depth = CsmgrdC_Aio_Max_Depth;
+	}
+	aio = (CsmgrdT_Aio*) calloc (1, sizeof (CsmgrdT_Aio));
+	if (aio == NULL) {
+		return (NULL);
+	}
+	aio->sq_ring = MAP_FAILED;
+	aio->cq_ring = MAP_FAILED;
+	aio->sqes 	 = MAP_FAILED;
+	
+	memset (&p, 0, sizeof (struct io_uring_params));
+	aio->ring_fd = (int) syscall (__NR_io_uring_setup, (unsigned) depth, &p);
+	if (aio->ring_fd < 0) {
+		csmgrd_log_write (CefC_Log_Warn,
+			"io_uring is not available (%s)\n", strerror (errno));
+		free (aio);
+		return (NULL);
+	}
+	
+	/* Maps the rings shared with the kernel 		*/
+	aio->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+	aio->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+	aio->sqes_size 	  = p.sq_entries * sizeof (struct io_uring_sqe);
+	aio->sq_ring = mmap (NULL, aio->sq_ring_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_SQ_RING);
+	aio->cq_ring = mmap (NULL, aio->cq_ring_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_CQ_RING);
+	aio->sqes 	 = mmap (NULL, aio->sqes_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_SQES);
+	if ((aio->sq_ring == MAP_FAILED) ||
+		(aio->cq_ring == MAP_FAILED) || (aio->sqes == MAP_FAILED)) {
+		csmgrd_log_write (CefC_Log_Warn,
+			"Failed to map the io_uring (%s)\n", strerror (errno));
+		goto ERROR_CREATE;
+	}
+	aio->sq_head  = (unsigned*)((char*) aio->sq_ring + p.sq_off.head);
+	aio->sq_tail  = (unsigned*)((char*) aio->sq_ring + p.sq_off.tail);
+	aio->sq_mask  = (unsigned*)((char*) aio->sq_ring + p.sq_off.ring_mask);
+	aio->sq_array = (unsigned*)((char*) aio->sq_ring + p.sq_off.array);
+	aio->cq_head  = (unsigned*)((char*) aio->cq_ring + p.cq_off.head);
+	aio->cq_tail  = (unsigned*)((char*) aio->cq_ring + p.cq_off.tail);
+	aio->cq_mask  = (unsigned*)((char*) aio->cq_ring + p.cq_off.ring_mask);
+	aio->cqes 	  = (struct io_uring_cqe*)((char*) aio->cq_ring + p.cq_off.cqes);
+	aio->sq_local_tail = *aio->sq_tail;
+	
+	/* The I/Os in flight are bounded by the submission queue, 	*/
+	/* so that the completion queue never overflows 			*/
+	aio->op_num = (int) p.sq_entries;
+	aio->ops = (CsmgrdT_Aio_Op*) calloc (aio->op_num, sizeof (CsmgrdT_Aio_Op));
+	if (aio->ops == NULL) {
+		goto ERROR_CREATE;
+	}
+	for (i = 0 ; i < aio->op_num ; i++) {
+		aio->ops[i].next = (i + 1 < aio->op_num) ? i + 1 : -1;
+	}
+	aio->op_free = 0;
+	pthread_mutex_init (&aio->mutex, NULL);
+	
+	if (pthread_create (&aio->th, NULL, csmgrd_aio_complete_thread, aio) != 0) {
+		csmgrd_log_write (CefC_Log_Warn, "Failed to create the io_uring thread\n");
+		pthread_mutex_destroy (&aio->mutex);
+		goto ERROR_CREATE;
+	}
+	aio->th_f = 1;
+	csmgrd_log_write (CefC_Log_Info,
+		"io_uring started (%u submission, %u completion entries)\n",
+		p.sq_entries, p.cq_entries);
+	
+	return (aio);
+	
+ERROR_CREATE:
+	if (aio->sqes != MAP_FAILED) {
+		munmap (aio->sqes, aio->sqes_size);
+	}
+	if (aio->cq_ring != MAP_FAILED) {
+		munmap (aio->cq_ring, aio->cq_ring_size);
+	}
+	if (aio->sq_ring != MAP_FAILED) {
+		munmap (aio->sq_ring, aio->sq_ring_size);
+	}
+	close (aio->ring_fd);
+	free (aio->ops);
+	free (aio);
+	return (NULL);
+#else // CsmgrdC_Aio_Uring
+	return (NULL);
+#endif // CsmgrdC_Aio_Uring
+}
+/*--------------------------------------------------------------------------------------
+	Waits for the I/Os in flight and destroys the asynchronous I/O engine
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_aio_destroy (
+	CsmgrdT_Aio* aio
+) {
+#ifdef CsmgrdC_Aio_Uring
+	struct io_uring_sqe* sqe;
+	void* status;
+	
+	if (aio == NULL) {
+		return;
+	}
+	
+	/* The NOP queued after the I/Os in flight stops the completion thread 	*/
+	pthread_mutex_lock (&aio->mutex);
+	csmgrd_aio_enter (aio);
+	sqe = &aio->sqes[aio->sq_local_tail & *aio->sq_mask];
+	memset (sqe, 0, sizeof (struct io_uring_sqe));
+	sqe->opcode 	= IORING_OP_NOP;
+	sqe->user_data 	= CsmgrdC_Aio_Stop_Data;
+	aio->sq_array[aio->sq_local_tail & *aio->sq_mask] = aio->sq_local_tail & *aio->sq_mask;
+	aio->sq_local_tail++;
+	aio->sq_queued++;
+	if (csmgrd_aio_enter (aio) < 0) {
+		/* The thread is not woken up, so it is left as it is 		*/
+		aio->th_f = 0;
+	}
+	pthread_mutex_unlock (&aio->mutex);
+	
+	if (aio->th_f) {
+		pthread_join (aio->th, &status);
+	}
+	csmgrd_log_write (CefC_Log_Info,
+		"io_uring stopped: "FMTU64" I/Os in "FMTU64" submissions, "FMTU64" errors\n",
+		aio->ios, aio->submits, aio->errors);
+	
+	munmap (aio->sqes, aio->sqes_size);
+	munmap (aio->cq_ring, aio->cq_ring_size);
+	munmap (aio->sq_ring, aio->sq_ring_size);
+	close (aio->ring_fd);
+	pthread_mutex_destroy (&aio->mutex);
+	free (aio->ops);
+	free (aio);
+#endif // CsmgrdC_Aio_Uring
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Queues the read, which is started by csmgrd_aio_submit
+----------------------------------------------------------------------------------------*/
+int									/* negative if the queue is full					*/
+csmgrd_aio_read (
+	CsmgrdT_Aio* aio,
+	int fd,
+	void* buf,
+	uint32_t len,
+	uint64_t off,
+	CsmgrdT_Aio_Done done,						/* called when the read completes		*/
+	void* arg
+) {
+#ifdef CsmgrdC_Aio_Uring
+	return (csmgrd_aio_queue (aio, IORING_OP_READV, fd, buf, len, off, done, arg));
+#else // CsmgrdC_Aio_Uring
+	return (-1);
+#endif // CsmgrdC_Aio_Uring
+}
+/*--------------------------------------------------------------------------------------
+	Queues the write, which is started by csmgrd_aio_submit
+----------------------------------------------------------------------------------------*/
+int									/* negative if the queue is full					*/
+csmgrd_aio_write (
+	CsmgrdT_Aio* aio,
+	int fd,
+	const void* buf,
+	uint32_t len,
+	uint64_t off,
+	CsmgrdT_Aio_Done done,						/* called when the write completes		*/
+	void* arg
+) {
+#ifdef CsmgrdC_Aio_Uring
+	return (csmgrd_aio_queue (
+		aio, IORING_OP_WRITEV, fd, (void*) buf, len, off, done, arg));
+#else // CsmgrdC_Aio_Uring
+	return (-1);
+#endif // CsmgrdC_Aio_Uring
+}
+/*--------------------------------------------------------------------------------------
+	Starts the queued I/Os with a system call
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+csmgrd_aio_submit (
+	CsmgrdT_Aio* aio
+) {
+#ifdef CsmgrdC_Aio_Uring
+	int res;
+	
+	pthread_mutex_lock (&aio->mutex);
+	res = csmgrd_aio_enter (aio);
+	pthread_mutex_unlock (&aio->mutex);
+	
+	return (res);
+#else // CsmgrdC_Aio_Uring
+	return (-1);
+#endif // CsmgrdC_Aio_Uring
+}
+#ifdef CsmgrdC_Aio_Uring
+/*--------------------------------------------------------------------------------------
+	Queues the I/O to the submission queue
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the queue is full					*/
+csmgrd_aio_queue (
+	CsmgrdT_Aio* aio,
+	int opcode,									/* IORING_OP_READV or IORING_OP_WRITEV	*/
+	int fd,
+	void* buf,
+	uint32_t len,
+	uint64_t off,
+	CsmgrdT_Aio_Done done,
+	void* arg
+) {
+	struct io_uring_sqe* sqe;
+	CsmgrdT_Aio_Op* op;
+	unsigned idx;
+	int op_idx;
+	
+	pthread_mutex_lock (&aio->mutex);
+	if (aio->op_free < 0) {
+		pthread_mutex_unlock (&aio->mutex);
+		return (-1);
+	}
+	op_idx = aio->op_free;
+	op = &aio->ops[op_idx];
+	aio->op_free = op->next;
+	aio->inflight++;
+	
+	op->done 		 = done;
+	op->arg 		 = arg;
+	op->iov.iov_base = buf;
+	op->iov.iov_len  = len;
+	
+	/* The kernel takes the entries when they are submitted, so there is room 	*/
+	/* for all the I/Os in flight 												*/
+	idx = aio->sq_local_tail & *aio->sq_mask;
+	sqe = &aio->sqes[idx];
+	memset (sqe, 0, sizeof (struct io_uring_sqe));
+	sqe->opcode 	= (uint8_t) opcode;
+	sqe->fd 		= fd;
+	sqe->off 		= off;
+	sqe->addr 		= (uint64_t)(uintptr_t) &op->iov;
+	sqe->len 		= 1;
+	sqe->user_data 	= (uint64_t) op_idx;
+	aio->sq_array[idx] = idx;
+	aio->sq_local_tail++;
+	aio->sq_queued++;
+	aio->ios++;
+	pthread_mutex_unlock (&aio->mutex);
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Gives the queued entries to the kernel, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_aio_enter (
+	CsmgrdT_Aio* aio
+) {
+	int res;
+	
+	if (aio->sq_queued == 0) {
+		return (0);
+	}
+	__atomic_store_n (aio->sq_tail, aio->sq_local_tail, __ATOMIC_RELEASE);
+	
+	while (aio->sq_queued > 0) {
+		res = (int) syscall (__NR_io_uring_enter,
+				aio->ring_fd, aio->sq_queued, 0, 0, NULL, 0);
+		if (res < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN)) {
+				continue;
+			}
+			/* The entries are taken at the next submission 		*/
+			aio->errors++;
+			csmgrd_log_write (CefC_Log_Warn,
+				"Failed to submit to the io_uring (%s)\n", strerror (errno));
+			return (-1);
+		}
+		aio->sq_queued -= (unsigned) res;
+	}
+	aio->submits++;
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Calls back the plugin as each I/O completes
+----------------------------------------------------------------------------------------*/
+static void*
+csmgrd_aio_complete_thread (
+	void* arg
+) {
+	CsmgrdT_Aio* aio = (CsmgrdT_Aio*) arg;
+	struct io_uring_cqe* cqe;
+	CsmgrdT_Aio_Done done;
+	void* done_arg;
+	uint64_t data;
+	unsigned head;
+	unsigned tail;
+	int stop_f = 0;
+	int res;
+	int inflight = 1;
+	
+	while ((stop_f == 0) || (inflight > 0)) {
+		head = *aio->cq_head;
+		tail = __atomic_load_n (aio->cq_tail, __ATOMIC_ACQUIRE);
+		if (head == tail) {
+			syscall (__NR_io_uring_enter,
+				aio->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+			continue;
+		}
+		while (head != tail) {
+			cqe  = &aio->cqes[head & *aio->cq_mask];
+			data = cqe->user_data;
+			res  = cqe->res;
+			head++;
+			__atomic_store_n (aio->cq_head, head, __ATOMIC_RELEASE);
+			if (data == CsmgrdC_Aio_Stop_Data) {
+				stop_f = 1;
+				continue;
+			}
+			done 	 = aio->ops[data].done;
+			done_arg = aio->ops[data].arg;
+	
+			pthread_mutex_lock (&aio->mutex);
+			aio->ops[data].next = aio->op_free;
+			aio->op_free = (int) data;
+			aio->inflight--;
+			pthread_mutex_unlock (&aio->mutex);
+	
+			if (done) {
+				(*done)(done_arg, res);
+			}
+		}
+		pthread_mutex_lock (&aio->mutex);
+		inflight = aio->inflight;
+		pthread_mutex_unlock (&aio->mutex);
+	}
+	
+	pthread_exit (NULL);
+	return ((void*) NULL);
+}
+#endif // CsmgrdC_Aio_Uring
@@ -47,6 +47,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include <cefore/cef_client.h>
 #include <csmgrd/csmgrd_plugin.h>
@@ -74,6 +75,11 @@ static char dbg_proc[256] = {0};
 static int 	dbg_lv = CefC_Dbg_None;
 #endif // CefC_Debug
 
+/********** Shared memory ring to reply to local cefnetd 	**********/
+static int 					shm_obj_sock = -1;
+static CefT_Csmgr_Shm_Ring* shm_obj_ring = NULL;
+static pthread_mutex_t 		shm_obj_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -115,6 +121,19 @@ csmgrd_plugin_cob_msg_send (
 	int res = 0;
 	int send_count = 0;
 
+	/* Replies to local cefnetd through the shared memory ring if it is set 	*/
+	if ((shm_obj_ring != NULL) && (fd == shm_obj_sock)) {
+		res = -1;
+		pthread_mutex_lock (&shm_obj_mutex);
+		if ((shm_obj_ring != NULL) && (fd == shm_obj_sock)) {
+			res = cef_csmgr_shm_write (shm_obj_ring, msg, msg_len);
+		}
+		pthread_mutex_unlock (&shm_obj_mutex);
+		if (res == 0) {
+			return (0);
+		}
+		/* The ring is full, so the message goes through the socket 	*/
+	}
 
    	res = send (fd, p, len,  MSG_DONTWAIT);
 	if ( res <= 0 ) {
@@ -173,6 +192,21 @@ csmgrd_plugin_cob_msg_send (
 	return (0);
 }
 
+/*--------------------------------------------------------------------------------------
+	Sets the shared memory ring used to reply to the local socket
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_shm_ring_set (
+	int fd,									/* local socket connected to cefnetd		*/
+	CefT_Csmgr_Shm_Ring* ring				/* Content Object ring, NULL to unset		*/
+) {
+	pthread_mutex_lock (&shm_obj_mutex);
+	shm_obj_sock = (ring != NULL) ? fd : -1;
+	shm_obj_ring = ring;
+	pthread_mutex_unlock (&shm_obj_mutex);
+	
+	return;
+}
 /*--------------------------------------------------------------------------------------
 	Sets APIs for cache algorithm library
 ----------------------------------------------------------------------------------------*/
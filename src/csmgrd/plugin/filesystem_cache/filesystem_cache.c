@@ -31,6 +31,12 @@
  */
 #define __CSMGRD_FILE_SYSTEM_CACHE_SOURCE__
 
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // _GNU_SOURCE
+#endif // __linux__
+
 /*
 	fsc_cache.c is a primitive filesystem cache implementation.
 */
@@ -48,9 +54,11 @@
 #include <stdio.h>
 #include <signal.h>
 #include <sys/types.h>
+#include <sys/file.h>
 #include <sys/ipc.h> 
 #include <sys/shm.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <arpa/inet.h>
@@ -64,6 +72,7 @@
 #include <cefore/cef_client.h>
 #include <cefore/cef_csmgr.h>
 #include <cefore/cef_frame.h>
+#include <cefore/cef_valid.h>
 #include <csmgrd/csmgrd_plugin.h>
 
 /****************************************************************************************
@@ -94,10 +103,204 @@
 
 #define FSC_RECORD_CORRECT_SIZE		CefC_Max_Header_Size
 
+#define FscC_Fd_Cache_Num		64				/* page files kept open for the reads	*/
+
+#define FscC_Buf_Page_Size		0x20000			/* bytes read from a page file at once	*/
+#define FscC_Buf_Shard_Num		16				/* shards of the page buffer			*/
+#define FscC_Buf_Min_Capacity	(FscC_Buf_Page_Size * FscC_Buf_Shard_Num)
+#define FscC_Buf_Def_Capacity	0x4000000		/* 64MB									*/
+#define FscC_Buf_Max_Readahead	16
+
+#define FscC_Wb_Iov_Num			1020			/* within IOV_MAX, 3 for a record		*/
+#define FscC_Wb_Rcd_Num			(FscC_Wb_Iov_Num / 2)
+
+#define FscC_Index_Dir_Name		"csmgr_fsc_persist"		/* directory kept across restarts	*/
+#define FscC_Index_Id			FscC_Max_Node_Inf_Num	/* FSCID of the directory			*/
+#define FscC_Index_File_Name	"index"
+#define FscC_Index_Magic		"CEFFSCI1"
+#define FscC_Jnl_File_Name		"journal"				/* followed by the generation		*/
+#define FscC_Jnl_Magic			"CEFFSCJ1"
+#define FscC_Name_File_Name		"name"					/* name of the content in its dir	*/
+#define FscC_Jnl_Buff_Size		0x20000					/* holds an entry of the max name	*/
+#define FscC_Jnl_Ckpt_Size		0x4000000				/* 64MB, the checkpoint is taken	*/
+														/* when the journal exceeds it		*/
+#define FscC_Jnl_Add			1						/* the Cobs are written				*/
+#define FscC_Jnl_Remove			2						/* the Cob is removed				*/
+#define FscC_Jnl_Delete			3						/* the content is deleted			*/
+#define FscC_Jnl_Lifetime		4						/* the lifetime is changed			*/
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
 
+/********** Page file kept open for the reads 	**********/
+typedef struct {
+	
+	int 			open_f;
+	int 			stale_f;					/* closed when the last reader leaves	*/
+	int 			con_index;					/* index of the content					*/
+	int 			page_index;					/* index of the page file				*/
+	int 			fd;
+	int 			ref;						/* readers using the descriptor			*/
+	uint64_t 		used;						/* for the LRU replacement				*/
+	
+} FscT_Page_Fd;
+
+/********** Page of a page file held in the buffer 	**********/
+typedef struct FscT_Buf_Page {
+	
+	struct FscT_Buf_Page* next;					/* next page in the hash chain			*/
+	int 			con_index;					/* index of the content					*/
+	int 			page_index;					/* index of the page file				*/
+	uint32_t 		blk;						/* index of the page in the page file	*/
+	int 			rcdsize;					/* record size the page is split by		*/
+	int 			len;						/* bytes read							*/
+	int 			pin;						/* readers using the page				*/
+	uint8_t 		valid_f;					/* 1: linked to the hash table			*/
+	uint8_t 		ref_f;						/* referenced since the last sweep		*/
+	uint8_t 		ra_f;						/* read ahead and not referenced yet	*/
+	unsigned char* 	data;
+	
+} FscT_Buf_Page;
+
+/********** Shard of the page buffer 	**********/
+typedef struct {
+	
+	pthread_mutex_t mutex;
+	FscT_Buf_Page** tbl;						/* hash table							*/
+	uint32_t 		tbl_mask;
+	FscT_Buf_Page* 	pages;
+	int 			page_max;					/* pages the memory budget allows		*/
+	int 			page_num;					/* pages allocated so far				*/
+	int 			hand;						/* CLOCK hand							*/
+	uint64_t 		epoch;						/* counts the invalidations				*/
+	uint64_t 		hits;
+	uint64_t 		misses;
+	uint64_t 		readaheads;
+	
+} FscT_Buf_Shard;
+
+/********** Page read asynchronously, the Cobs in it are sent when it is read 	**********/
+typedef struct {
+	
+	int 			sock;						/* socket to send the Cobs				*/
+	int 			fd;							/* descriptor held until the completion	*/
+	int 			fd_slot;
+	FscT_Buf_Page* 	bp;							/* NULL if read into data				*/
+	unsigned char* 	data;
+	uint64_t 		epoch;						/* epoch of the shard at the start		*/
+	int 			ra_f;						/* 1: the page is read ahead			*/
+	int 			rcdsize;					/* record size							*/
+	uint32_t 		file_msglen;				/* max length of the Cob message		*/
+	int 			tx_cnt;
+	int 			tx_pos[FscC_Tx_Cob_Num];	/* records to send in data				*/
+	
+} FscT_Aio_Req;
+
+/********** Records written back to the page file at once 	**********/
+typedef struct {
+	
+	int 			fd;							/* page file being written, -1 if none	*/
+	int 			con_index;					/* index of the content					*/
+	int 			page_index;					/* index of the page file				*/
+	uint64_t 		purge_gen;					/* fsc_fd_purge_gen when fd is opened	*/
+	uint16_t 		name_len;					/* content which fd is opened for		*/
+	unsigned char 	name[CsmgrT_Name_Max];
+	off_t 			alloc_end;					/* the page file is reserved up to		*/
+	int 			rcdsize;					/* record size							*/
+	off_t 			off;						/* offset of the buffered records		*/
+	int 			len;						/* bytes of the buffered records		*/
+	int 			rcd_num;					/* buffered records						*/
+	int 			idxs[FscC_Wb_Rcd_Num];		/* indexes of the records in the cobs	*/
+	int 			iov_num;
+	struct iovec 	iov[FscC_Wb_Iov_Num];
+	
+} FscT_Write_Back;
+
+/********** Header of the index file and the journal 	**********/
+typedef struct {
+	
+	char 			magic[8];
+	uint32_t 		rec_size;					/* to detect the other layout			*/
+	uint32_t 		reserved;
+	uint64_t 		gen;						/* generation of the checkpoint			*/
+	uint64_t 		saved_time;
+	
+} FscT_Index_Header;
+
+/********** Content recorded in the index file 	**********/
+typedef struct {
+	
+	uint64_t 		expiry;
+	uint64_t 		cached_time;
+	uint32_t 		con_index;					/* name of the content directory		*/
+	uint32_t 		file_msglen;
+	uint32_t 		detect_chnkno;
+	uint32_t 		cob_size;
+	uint32_t 		last_cob_size;
+	uint32_t 		last_chnk_num;
+	uint32_t 		map_num;					/* words of the cob_map					*/
+	struct in_addr 	node;
+	uint16_t 		name_len;
+	uint16_t 		reserved;
+	uint32_t 		reserved2;
+	
+} FscT_Index_Rec;				/* the name padded to 8 bytes and the cob_map follow 	*/
+
+/********** Entry of the journal 	**********/
+typedef struct {
+	
+	uint32_t 		crc;						/* of the entry following this field	*/
+	uint32_t 		len;						/* bytes of the entry					*/
+	uint16_t 		type;						/* FscC_Jnl_XXX							*/
+	uint16_t 		name_len;
+	uint32_t 		con_index;					/* index of the content					*/
+	uint64_t 		expiry;
+	uint64_t 		cached_time;
+	uint32_t 		chunk_num;					/* first chunk of the entry				*/
+	uint32_t 		cob_num;					/* Cobs written from chunk_num			*/
+	uint32_t 		file_msglen;
+	uint32_t 		detect_chnkno;
+	struct in_addr 	node;
+	uint32_t 		reserved;
+	
+} FscT_Jnl_Entry;		/* Add: the name and the payload lengths follow, padded to 8 bytes */
+
+/********** Content restored from the index file and the journal 	**********/
+typedef struct {
+	
+	FscT_Index_Rec 	rec;
+	unsigned char* 	name;
+	uint64_t* 		cob_map;
+	uint32_t 		map_max;
+	uint32_t 		cob_num;
+	
+} FscT_Index_Slot;
+
+/********** Image of the index file taken holding the lock 	**********/
+typedef struct {
+	
+	unsigned char* 	buf;
+	size_t 			len;
+	size_t 			size;
+	uint32_t 		con_num;
+	int 			err_f;						/* 1: failed to get memory				*/
+	
+} FscT_Index_Image;
+
+/********** Index of the contents kept across restarts 	**********/
+typedef struct {
+	
+	int 			dir_fd;						/* locked cache directory, -1 if not kept */
+	int 			jnl_fd;						/* journal being appended, -1 if none	*/
+	uint64_t 		gen;						/* generation of the journal			*/
+	uint64_t 		old_gen;					/* oldest journal which may remain		*/
+	uint64_t 		jnl_size;					/* bytes written to the journal			*/
+	int 			buf_len;
+	unsigned char 	buf[FscC_Jnl_Buff_Size];	/* entries not written yet				*/
+	
+} FscT_Index;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
@@ -116,6 +319,17 @@ static int 						fsc_proc_cob_buff_idx[FscC_Max_Buff] 	= {0};
 static CsmgrT_Stat_Handle 		csmgr_stat_hdl;
 static pthread_mutex_t 			fsc_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static FscT_Page_Fd 			fsc_page_fds[FscC_Fd_Cache_Num];
+static uint64_t 				fsc_fd_tick = 0;
+static uint64_t 				fsc_fd_purge_gen = 0;	/* counts fsc_page_fd_purge		*/
+static pthread_mutex_t 			fsc_fd_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static FscT_Buf_Shard* 			fsc_buf_shards = NULL;
+static CsmgrdT_Aio* 			fsc_aio = NULL;			/* NULL if the reads are synchronous	*/
+static FscT_Write_Back 			fsc_wb;					/* used by the process thread only		*/
+static unsigned char 			fsc_wb_zero[CefC_Max_Msg_Size];	/* padding of the records	*/
+static FscT_Index 				fsc_idx = {.dir_fd = -1, .jnl_fd = -1};	/* under fsc_cs_mutex	*/
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -151,6 +365,16 @@ fsc_cache_item_get (
 	uint32_t seqno,								/* chunk num							*/
 	int sock									/* received socket						*/
 );
+/*--------------------------------------------------------------------------------------
+	Removes the Cob whose record cannot be read, so that it is cached again
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cob_damaged_remove (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seqno,								/* chunk num							*/
+	int con_index								/* index of the content which was read	*/
+);
 /*--------------------------------------------------------------------------------------
 	Upload content byte steream
 ----------------------------------------------------------------------------------------*/
@@ -189,6 +413,60 @@ fsc_cache_cob_write (
 	CsmgrdT_Content_Entry* cobs, 
 	int cob_num
 );
+/*--------------------------------------------------------------------------------------
+	Checks whether the record is buffered to be written back
+----------------------------------------------------------------------------------------*/
+static int							/* 1 if the record is buffered						*/
+fsc_wb_buffered (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	int rcdsize,								/* record size							*/
+	off_t off									/* offset of the record in the file		*/
+);
+/*--------------------------------------------------------------------------------------
+	Buffers the record, the buffered ones are written back first if it does not follow them
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the page file cannot be opened		*/
+fsc_wb_add (
+	CsmgrdT_Content_Entry* cobs, 
+	int index,									/* index of the record in cobs			*/
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	int rcdsize,								/* record size							*/
+	off_t off,									/* offset of the record in the file		*/
+	uint64_t nowt
+);
+/*--------------------------------------------------------------------------------------
+	Writes back the buffered records to the page file
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the records cannot be written		*/
+fsc_wb_write (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Updates the content information of the written records, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_commit (
+	CsmgrdT_Content_Entry* cobs, 
+	uint64_t nowt,
+	int res										/* result of fsc_wb_write				*/
+);
+/*--------------------------------------------------------------------------------------
+	Writes back the buffered records and updates the content information
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_flush (
+	CsmgrdT_Content_Entry* cobs, 
+	uint64_t nowt
+);
+/*--------------------------------------------------------------------------------------
+	Closes the page file being written
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_close (
+	void
+);
 /*--------------------------------------------------------------------------------------
 	Read config file
 ----------------------------------------------------------------------------------------*/
@@ -283,6 +561,272 @@ static int							/* The return value is negative if an error occurs	*/
 fsc_recursive_dir_clear (
 	char* filepath								/* file path							*/
 );
+/*--------------------------------------------------------------------------------------
+	Obtains the descriptor of the page file from the cache of the opened files
+----------------------------------------------------------------------------------------*/
+static int							/* descriptor, or -1 if the file cannot be opened	*/
+fsc_page_fd_get (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	int* slot									/* -1 if the caller closes the fd		*/
+);
+/*--------------------------------------------------------------------------------------
+	Holds the cached descriptor once more for the asynchronous read
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_fd_hold (
+	int slot
+);
+/*--------------------------------------------------------------------------------------
+	Releases the descriptor obtained by fsc_page_fd_get
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_fd_release (
+	int fd,
+	int slot
+);
+/*--------------------------------------------------------------------------------------
+	Closes the cached descriptors of the files under the path to be deleted
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_fd_purge (
+	const char* filepath						/* file or directory path				*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the page buffer
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_buf_init (
+	uint64_t capacity							/* bytes of the buffered pages			*/
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the page buffer
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_destroy (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the page which holds the specified block of the page file
+----------------------------------------------------------------------------------------*/
+static FscT_Buf_Page*				/* pinned page, or NULL if the page is not buffered	*/
+fsc_buf_page_get (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	uint32_t blk,								/* index of the page in the page file	*/
+	int rcdsize,								/* record size							*/
+	int fd,										/* descriptor of the page file, or -1 	*/
+												/* not to read the page on miss			*/
+	int* seq_f									/* set to 1 on sequential access		*/
+);
+/*--------------------------------------------------------------------------------------
+	Releases the page obtained by fsc_buf_page_get
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_page_release (
+	FscT_Buf_Page* bp
+);
+/*--------------------------------------------------------------------------------------
+	Reads the specified page into the buffer before it is requested
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the page is beyond the end of file	*/
+fsc_buf_page_readahead (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	uint32_t blk,								/* index of the page in the page file	*/
+	int rcdsize,								/* record size							*/
+	int fd,										/* descriptor of the page file			*/
+	int fd_slot									/* slot of the cached descriptor		*/
+);
+/*--------------------------------------------------------------------------------------
+	Drops the buffered page which holds the written record
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_page_invalidate (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	int rcd_index,								/* index of the record in the page file	*/
+	int rcdsize									/* record size							*/
+);
+/*--------------------------------------------------------------------------------------
+	Drops the buffered pages of the files under the path to be deleted
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_page_purge (
+	const char* filepath						/* file or directory path				*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the page buffer
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_buf_stat_get (
+	CsmgrdT_Buffer_Stat* stat
+);
+/*--------------------------------------------------------------------------------------
+	Queues the read of the page, and the Cobs listed in it are sent when it is read
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the read cannot be queued			*/
+fsc_aio_page_read (
+	int sock,									/* socket to send the Cobs				*/
+	int fd,										/* descriptor of the page file			*/
+	int fd_slot,								/* slot of the cached descriptor		*/
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	uint32_t blk,								/* index of the page in the page file	*/
+	int rcdsize,								/* record size							*/
+	uint32_t file_msglen,						/* max length of the Cob message		*/
+	int base,									/* record index of tx_pos[] 0			*/
+	const int* tx_pos,							/* records to send						*/
+	int tx_cnt,									/* 0 if the page is read ahead			*/
+	int ra_f									/* 1: the page is read ahead			*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the Cobs in the page read asynchronously
+----------------------------------------------------------------------------------------*/
+static void
+fsc_aio_page_done (
+	void* arg,
+	int res										/* bytes read or -errno					*/
+);
+/*--------------------------------------------------------------------------------------
+	Locks the cache directory and restores the contents recorded in the index
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_idx_open (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Writes the last checkpoint and unlocks the cache directory
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_close (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Writes the contents to the index file, and starts the journal of the next generation
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_idx_checkpoint (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Appends the content information to the image of the index file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_image_add (
+	CsmgrT_Stat* rcd,
+	void* arg									/* FscT_Index_Image						*/
+);
+/*--------------------------------------------------------------------------------------
+	Reads the index file and the journals following it
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_load (
+	FscT_Index_Slot** slots						/* contents indexed by the directory	*/
+);
+/*--------------------------------------------------------------------------------------
+	Applies the entries in the journal to the contents
+----------------------------------------------------------------------------------------*/
+static int							/* 0 if the journal is read to the end				*/
+fsc_idx_replay (
+	FscT_Index_Slot** slots,
+	uint64_t gen								/* generation of the journal			*/
+);
+/*--------------------------------------------------------------------------------------
+	Registers the contents restored from the index with the cache
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_restore (
+	FscT_Index_Slot** slots,
+	uint64_t start_t							/* time when the restore started		*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the slot of the content, the other content in it is dropped
+----------------------------------------------------------------------------------------*/
+static FscT_Index_Slot*
+fsc_idx_slot_set (
+	FscT_Index_Slot** slots,
+	uint32_t con_index,							/* index of the content					*/
+	const unsigned char* name,
+	uint16_t name_len
+);
+/*--------------------------------------------------------------------------------------
+	Frees the slot of the content
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_slot_free (
+	FscT_Index_Slot** slots,
+	uint32_t con_index							/* index of the content					*/
+);
+/*--------------------------------------------------------------------------------------
+	Records the Cob in the slot
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_idx_slot_cob_set (
+	FscT_Index_Slot* slot,
+	uint32_t seq,
+	uint32_t cob_size
+);
+/*--------------------------------------------------------------------------------------
+	Writes the name of the content to its directory
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_name_write (
+	const char* cont_path,						/* directory of the content				*/
+	const unsigned char* name,
+	uint16_t name_len
+);
+/*--------------------------------------------------------------------------------------
+	Checks the directory holds the files of the content
+----------------------------------------------------------------------------------------*/
+static int							/* 1 if the name in the directory matches			*/
+fsc_idx_name_check (
+	const char* cont_path,						/* directory of the content				*/
+	const unsigned char* name,
+	uint16_t name_len
+);
+/*--------------------------------------------------------------------------------------
+	Creates the journal of the generation, the current one is closed
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_jnl_open (
+	uint64_t gen
+);
+/*--------------------------------------------------------------------------------------
+	Writes the buffered entries to the journal
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_flush (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Buffers the journal entry, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_append (
+	FscT_Jnl_Entry* ent,
+	const unsigned char* name,					/* ent->name_len bytes					*/
+	const void* tail,							/* follows the name						*/
+	int tail_len
+);
+/*--------------------------------------------------------------------------------------
+	Records the removal or the lifetime of the content, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_put (
+	int type,									/* FscC_Jnl_XXX							*/
+	CsmgrT_Stat* rcd,
+	uint32_t chunk_num							/* chunk of FscC_Jnl_Remove				*/
+);
+/*--------------------------------------------------------------------------------------
+	Records the Cobs written back, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_run_put (
+	CsmgrT_Stat* rcd,
+	CsmgrdT_Content_Entry* cobs,
+	uint64_t nowt
+);
 
 /****************************************************************************************
  ****************************************************************************************/
@@ -304,6 +848,7 @@ csmgrd_filesystem_plugin_load (
 	cs_in->content_lifetime_set = fsc_cache_set_lifetime;
 	cs_in->content_cache_del	= fsc_cache_del;
 #endif // CefC_Ccore
+	cs_in->buffer_stat_get 		= fsc_buf_stat_get;
 	
 	if (config_dir) {
 		strcpy (csmgr_conf_dir, config_dir);
@@ -354,6 +899,11 @@ fsc_cs_create (
 	hdl->algo_cob_size = conf_param.algo_cob_size;
 	hdl->cache_cobs = 0;
 	strcpy (hdl->fsc_root_path, conf_param.fsc_root_path);
+	hdl->buf_capacity = conf_param.buf_capacity;
+	hdl->buf_readahead = conf_param.buf_readahead;
+	hdl->io_depth = conf_param.io_depth;
+	hdl->index_f = conf_param.index_f;
+	csmgr_stat_hdl = stat_hdl;
 	
 	/* Check for excessive or insufficient memory resources for cache algorithm library */
 	if (strcmp (hdl->algo_name, "None") != 0) {
@@ -429,24 +979,52 @@ fsc_cs_create (
 	}
 	csmgrd_log_write (CefC_Log_Info, "Inits rx buffer ... OK\n");
 	
-	/* Creates the threads 		*/
-	if (pthread_create (&fsc_rcv_thread, NULL, fsc_cob_process_thread, hdl) == -1) {
-		csmgrd_log_write (CefC_Log_Error, "Failed to create the new thread\n");
+	/* Creates the buffer of the pages read from the cache files 	*/
+	if (fsc_buf_init (hdl->buf_capacity) < 0) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to create the page buffer\n");
 		return (-1);
 	}
-
+	
+	/* Creates the io_uring to read the cache files asynchronously 	*/
+	if (hdl->io_depth > 0) {
+		fsc_aio = csmgrd_aio_create (hdl->io_depth);
+		if (fsc_aio == NULL) {
+			csmgrd_log_write (CefC_Log_Warn, 
+				"io_uring is not available, so the cache files are read synchronously\n");
+		}
+	}
+	
+	/* Restores the contents cached before csmgrd stopped, the capacity 	*/
+	/* is set first since updating it clears the content information 		*/
+	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
+	if (hdl->index_f) {
+		if (fsc_idx_open () < 0) {
+			csmgrd_log_write (CefC_Log_Error, "Failed to restore the index of the cache\n");
+			return (-1);
+		}
+	}
+	
+	/* Creates the threads, which run while fsc_thread_f is set 		*/
+	fsc_wb.fd = -1;
 	fsc_thread_f = 1;
+	if (pthread_create (&fsc_rcv_thread, NULL, fsc_cob_process_thread, hdl) != 0) {
+		fsc_thread_f = 0;
+		csmgrd_log_write (CefC_Log_Error, "Failed to create the new thread\n");
+		return (-1);
+	}
 	csmgrd_log_write (CefC_Log_Info, "Inits rx thread ... OK\n");
 	
 	csmgrd_log_write (CefC_Log_Info, "Start\n");
 	csmgrd_log_write (CefC_Log_Info, "Cache Capacity : "FMTU64"\n", hdl->cache_capacity);
+	csmgrd_log_write (CefC_Log_Info, "Page Buffer    : "FMTU64" bytes (read ahead %d pages)\n", 
+		hdl->buf_capacity, hdl->buf_readahead);
+	csmgrd_log_write (CefC_Log_Info, "I/O Depth      : %d\n", (fsc_aio) ? hdl->io_depth : 0);
+	csmgrd_log_write (CefC_Log_Info, "Persistent     : %s\n", (hdl->index_f) ? "Yes" : "No");
 	if (strcmp (conf_param.algo_name, "None")) {
 		csmgrd_log_write (CefC_Log_Info, "Library  : %s ... OK\n", hdl->algo_name);
 	} else {
 		csmgrd_log_write (CefC_Log_Info, "Library  : Not Specified\n");
 	}
-	csmgr_stat_hdl = stat_hdl;
-	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
@@ -574,6 +1152,7 @@ fsc_cs_remove (
 						sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
 						fsc_recursive_dir_clear (file_path);
 					}
+					fsc_jnl_put (FscC_Jnl_Remove, rcd, chunk_num);
 					csmgrd_stat_cob_remove (
 						csmgr_stat_hdl, &key[0], key_len - 8, chunk_num, 0);
 			
@@ -595,7 +1174,11 @@ fsc_cs_destroy (
 	int i = 0;
 	void* status;
 	
-	pthread_mutex_destroy (&fsc_cs_mutex);
+	/* Waits for the reads in flight, which refer to the files and the pages 	*/
+	if (fsc_aio) {
+		csmgrd_aio_destroy (fsc_aio);
+		fsc_aio = NULL;
+	}
 	
 	/* Destory the threads 		*/
 	if (fsc_thread_f) {
@@ -619,9 +1202,14 @@ fsc_cs_destroy (
 		return;
 	}
 	
-	if (hdl->fsc_cache_path[0] != 0x00) {
+	/* The contents are kept in the cache directory if the index is written 	*/
+	if (fsc_idx.dir_fd >= 0) {
+		fsc_idx_close ();
+	} else if (hdl->fsc_cache_path[0] != 0x00) {
 		fsc_recursive_dir_clear (hdl->fsc_cache_path);
 	}
+	fsc_buf_destroy ();
+	pthread_mutex_destroy (&fsc_cs_mutex);
 	
 	/* Close the loaded cache algorithm library */
 	if (hdl->algo_lib) {
@@ -656,6 +1244,7 @@ fsc_cs_expire_check (
 	int 			trg_key_len = 0;
 	int 			name_len;
 	uint64_t		cob_cnt;
+	int 			ckpt_f;
 	
 	if (pthread_mutex_trylock (&fsc_cs_mutex) != 0) {
 		return;
@@ -669,6 +1258,7 @@ fsc_cs_expire_check (
 		
 		sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
 		fsc_recursive_dir_clear (file_path);
+		fsc_jnl_put (FscC_Jnl_Delete, rcd, 0);
 
 		cob_cnt = rcd->cob_num;
 		if (hdl->algo_apis.erase) {
@@ -713,8 +1303,15 @@ fsc_cs_expire_check (
 LOOP_END:;
 		
 	}
+	fsc_jnl_flush ();
+	ckpt_f = (fsc_idx.jnl_fd >= 0) && (fsc_idx.jnl_size > FscC_Jnl_Ckpt_Size);
 	pthread_mutex_unlock (&fsc_cs_mutex);
 	
+	/* Takes the checkpoint so that the journal to be replayed is kept short 	*/
+	if (ckpt_f) {
+		fsc_idx_checkpoint ();
+	}
+	
 	return;
 	
 }
@@ -734,23 +1331,38 @@ fsc_cache_item_get (
 	uint64_t 	mask;
 	uint32_t 	x;
 	char		file_path[PATH_MAX];
-	static char	red_file_path[PATH_MAX] = {0};
 	int 		cob_block_index;
-	static int  red_cob_block_index = -1;
-	int			rtc;
 	int 		page_index;
 	int 		pos_index;
-	FILE*		fp = NULL;
+	int 		con_index;
 	int 		i;
-	int 		tx_cnt = 0;
 	int			resend_1cob_f = 0;
 	int			send_cob_f = 0;
 	unsigned char 	trg_key[CsmgrdC_Key_Max];
 	int 			trg_key_len;
 	uint64_t nowt;
 	struct timeval tv;
-	static unsigned char*	page_cob_buf = NULL;
 	int				rcdsize;
+	int 		tx_pos[FscC_Tx_Cob_Num];
+	int 		tx_cnt = 0;
+	int 		fd;
+	int 		fd_slot;
+	unsigned char	rbuf[FscC_Buf_Page_Size];
+	unsigned char*	data;
+	FscT_Buf_Page*	bp;
+	uint32_t 	blk = 0;
+	int 		seq_f = 0;
+	int 		base;
+	int 		rcd_num;
+	int 		top;
+	int 		n;
+	ssize_t 	len;
+	uint16_t 	mlen;
+	uint64_t 	seq_max;
+	uint32_t 	blk_max;
+	int 		aio_f;
+	int 		aio_num = 0;
+	int 		sent_f = 0;
 	
 #ifdef CefC_Debug
 	csmgrd_dbg_write (CefC_Dbg_Finest, "Incoming Interest : seqno = %u\n", seqno);
@@ -759,6 +1371,10 @@ fsc_cache_item_get (
 	/* Obtain the information of the specified content 		*/
 	rcd = csmgrd_stat_content_info_access (csmgr_stat_hdl, key, key_size);
 	if (!rcd) {
+		if (hdl->algo_apis.miss) {
+			trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
+			(*(hdl->algo_apis.miss))(trg_key, trg_key_len);
+		}
 		pthread_mutex_unlock (&fsc_cs_mutex);
 		return (CefC_Csmgr_Cob_NotExist);
 	}
@@ -768,8 +1384,9 @@ fsc_cache_item_get (
 		csmgrd_dbg_write (CefC_Dbg_Fine, "Delete the expired content = %s\n", file_path);
 #endif // CefC_Debug
 		fsc_recursive_dir_clear (file_path);
-		csmgrd_stat_content_info_delete (csmgr_stat_hdl, key, key_size);
+		fsc_jnl_put (FscC_Jnl_Delete, rcd, 0);
 		hdl->cache_cobs -= rcd->cob_num;
+		csmgrd_stat_content_info_delete (csmgr_stat_hdl, key, key_size);
 		pthread_mutex_unlock (&fsc_cs_mutex);
 		return (CefC_Csmgr_Cob_NotExist);
 	}
@@ -823,102 +1440,173 @@ fsc_cache_item_get (
 		rcd->tx_time = nowt + FscC_Sent_Reset_Time;
 	}
 	
-	/* Open the file that specified cob is cached 		*/
+	/* Lists the cached cobs to send from the same block 		*/
 	cob_block_index = (int)(seqno / FscC_Page_Cob_Num) % FscC_File_Page_Num;
 	page_index = (int)(seqno / FscC_Page_Cob_Num/FscC_File_Page_Num);
-	sprintf (file_path, "%s/%d/%d", hdl->fsc_cache_path, (int) rcd->index, page_index);
-	
-	if (strcmp (red_file_path, file_path) != 0 || cob_block_index != red_cob_block_index) {
-		if (page_cob_buf != NULL) {
-			free (page_cob_buf);
-			page_cob_buf = NULL;
-		}
-
-		fp = fopen (file_path, "rb");
-		if (fp == NULL) {
-			csmgrd_log_write (CefC_Log_Error, "Failed to open the cache file (%s)\n", file_path);
-			goto ItemGetPost;
-		}
-		strcpy (red_file_path, file_path);
-		red_cob_block_index = cob_block_index;
-		page_cob_buf = calloc (FscC_Page_Cob_Num, rcdsize);
-		fseek (fp, (int64_t)cob_block_index * (int64_t)rcdsize * FscC_Page_Cob_Num, SEEK_SET);
-		for (int i=0; i<FscC_Page_Cob_Num; i++) {
-			rtc = fread (&page_cob_buf[i*rcdsize], rcdsize, 1, fp);
-			if (rtc != 1) {
-				break;
-			}
-		}
-	} else {
-		fp = NULL;
-	}
-	
-	/* Send the cobs 		*/
 	pos_index = (int)(seqno % FscC_Page_Cob_Num);
-#ifdef CefC_Debug
-	{
-		uint16_t mlen;
-		memcpy (&mlen, &page_cob_buf[pos_index*rcdsize], sizeof (uint16_t));
-		csmgrd_dbg_write (CefC_Dbg_Finest, "send seqno = %u (%u bytes)\n", seqno, mlen);
-	}
-#endif // CefC_Debug
-	csmgrd_stat_access_count_update (
-			csmgr_stat_hdl, key, key_size);
-	
-	/* Send Cob to cefnetd */
-	uint16_t mlen;
-	memcpy (&mlen, &page_cob_buf[pos_index*rcdsize], sizeof (uint16_t));
-	csmgrd_plugin_cob_msg_send (
-						sock, &page_cob_buf[pos_index*rcdsize+sizeof (uint16_t)], mlen);
-	if (resend_1cob_f == 1) {
-		if (fp != NULL) {
-			fclose (fp);
-		}
-		pthread_mutex_unlock (&fsc_cs_mutex);
-		return (CefC_Csmgr_Cob_Exist);
-	}
-	tx_cnt++;
-	seqno++;
+	con_index = (int) rcd->index;
 	
-	for (i = pos_index + 1 ; i < FscC_Page_Cob_Num ; i++) {
-		if (tx_cnt < FscC_Tx_Cob_Num) {
+	tx_pos[tx_cnt++] = pos_index;
+	if (resend_1cob_f == 0) {
+		for (i = pos_index + 1 ; 
+			(i < FscC_Page_Cob_Num) && (tx_cnt < FscC_Tx_Cob_Num) ; i++) {
 			mask = 1;
-			x = seqno / 64;
-			mask <<= (seqno % 64);
+			x = (seqno + (i - pos_index)) / 64;
+			mask <<= ((seqno + (i - pos_index)) % 64);
 			
 			if ((rcd->map_max-1) < x || !(rcd->cob_map[x] & mask)) {
-				seqno++;
 				continue;
 			}
-#ifdef CefC_Debug
-			{
-				uint16_t mlen;
-				memcpy (&mlen, &page_cob_buf[i*rcdsize], sizeof (uint16_t));
-				csmgrd_dbg_write (CefC_Dbg_Finest, "send seqno = %u (%u bytes)\n", seqno, mlen);
-			}
-#endif // CefC_Debug
-			uint16_t mlen;
-			memcpy (&mlen, &page_cob_buf[i*rcdsize], sizeof (uint16_t));
-			if (mlen != 0) {
-				csmgrd_plugin_cob_msg_send (
-					sock, &page_cob_buf[i*rcdsize+sizeof (uint16_t)], mlen);
-			}
-			tx_cnt++;
-			seqno++;
-		} else {
-			break;
+			tx_pos[tx_cnt++] = i;
 		}
 	}
+	csmgrd_stat_access_count_update (
+			csmgr_stat_hdl, key, key_size);
+	seq_max = (uint64_t) rcd->map_max * 64;
 	
-ItemGetPost:
-	if (fp != NULL) {
-		fclose (fp);
-	}
+	/* The file is read without the lock, so that the other workers 	*/
+	/* are not kept waiting for the disk 								*/
 	pthread_mutex_unlock (&fsc_cs_mutex);
-	return (CefC_Csmgr_Cob_Exist);
-}
-/*--------------------------------------------------------------------------------------
-	Upload content byte steream
+	
+	fd = fsc_page_fd_get (con_index, page_index, &fd_slot);
+	if (fd < 0) {
+		sprintf (file_path, "%s/%d/%d", hdl->fsc_cache_path, con_index, page_index);
+		csmgrd_log_write (CefC_Log_Error, "Failed to open the cache file (%s)\n", file_path);
+		return (CefC_Csmgr_Cob_NotExist);
+	}
+	
+	/* Reads the records of the listed cobs page by page, from the buffer if possible */
+	rcd_num = FscC_Buf_Page_Size / rcdsize;
+	base = cob_block_index * FscC_Page_Cob_Num;
+	aio_f = (fsc_aio && (fd_slot >= 0)) ? 1 : 0;
+	i = 0;
+	while (i < tx_cnt) {
+		blk = (uint32_t)((base + tx_pos[i]) / rcd_num);
+		top = (int) blk * rcd_num - base;
+		for (n = i + 1 ; (n < tx_cnt) && (tx_pos[n] - top < rcd_num) ; n++) {
+			/* NOP */;
+		}
+		bp = fsc_buf_page_get (
+				con_index, page_index, blk, rcdsize, (aio_f) ? -1 : fd, &seq_f);
+		if ((bp == NULL) && aio_f && 
+			(fsc_aio_page_read (sock, fd, fd_slot, con_index, page_index, blk, 
+				rcdsize, file_msglen, base, &tx_pos[i], n - i, 0) == 0)) {
+			/* The Cobs are sent by the completion thread when the page is read 	*/
+			if (i == 0) {
+				sent_f = 1;
+			}
+			aio_num++;
+			i = n;
+			continue;
+		}
+		if (bp) {
+			data = bp->data;
+			len = bp->len;
+		} else {
+			/* Reads only the listed records when the page cannot be buffered 	*/
+			top = tx_pos[i];
+			len = pread (fd, rbuf, (size_t)(tx_pos[n - 1] - top + 1) * rcdsize, 
+					((off_t) base + top) * rcdsize);
+			data = rbuf;
+		}
+		
+		/* Send Cobs to cefnetd */
+		for (; i < n ; i++) {
+			if (len < (ssize_t)(tx_pos[i] - top + 1) * rcdsize) {
+				break;
+			}
+			memcpy (&mlen, &data[(tx_pos[i] - top) * rcdsize], sizeof (uint16_t));
+#ifdef CefC_Debug
+			csmgrd_dbg_write (CefC_Dbg_Finest, "send seqno = %u (%u bytes)\n", 
+				seqno + (tx_pos[i] - pos_index), mlen);
+#endif // CefC_Debug
+			if ((mlen != 0) && (mlen <= file_msglen)) {
+				csmgrd_plugin_cob_msg_send (sock, 
+					&data[(tx_pos[i] - top) * rcdsize + sizeof (uint16_t)], mlen);
+				if (i == 0) {
+					sent_f = 1;
+				}
+			}
+		}
+		if (bp) {
+			fsc_buf_page_release (bp);
+		}
+		i = n;
+	}
+	
+	/* Reads ahead the pages following the last sent one on sequential access 	*/
+	if (seq_f) {
+		/* No page after the one which holds the last cached record is read 	*/
+		seq_max -= (uint64_t) page_index * FscC_File_Page_Num * FscC_Page_Cob_Num;
+		blk_max = (uint32_t)((seq_max + rcd_num - 1) / rcd_num);
+		for (n = 1 ; (n <= hdl->buf_readahead) && (blk + n < blk_max) ; n++) {
+			if (fsc_buf_page_readahead (
+					con_index, page_index, blk + n, rcdsize, fd, fd_slot) < 0) {
+				break;
+			}
+			aio_num += aio_f;
+		}
+	}
+	if (aio_num > 0) {
+		/* Submits the reads for the Interest at once 	*/
+		csmgrd_aio_submit (fsc_aio);
+	}
+	fsc_page_fd_release (fd, fd_slot);
+	
+	/* Exist is answered only when the requested Cob was sent, otherwise cefnetd 	*/
+	/* would drop the Interest held for the lookup 								*/
+	if (sent_f == 0) {
+		csmgrd_log_write (CefC_Log_Warn, 
+			"Failed to read the cached Cob (seqno = %u), it is removed\n", seqno);
+		fsc_cob_damaged_remove (key, key_size, seqno, con_index);
+		return (CefC_Csmgr_Cob_NotExist);
+	}
+	return (CefC_Csmgr_Cob_Exist);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the Cob whose record cannot be read, so that it is cached again
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cob_damaged_remove (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seqno,								/* chunk num							*/
+	int con_index								/* index of the content which was read	*/
+) {
+	CsmgrT_Stat* rcd;
+	unsigned char 	trg_key[CsmgrdC_Key_Max];
+	int 			trg_key_len;
+	char 			file_path[PATH_MAX];
+	uint64_t 		mask = 1;
+	uint32_t 		x = seqno / 64;
+	
+	mask <<= (seqno % 64);
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	
+	/* The content may be replaced while the record is read 	*/
+	rcd = csmgrd_stat_content_info_is_exist (csmgr_stat_hdl, key, key_size);
+	if ((rcd == NULL) || ((int) rcd->index != con_index) || 
+		((rcd->map_max-1) < x) || !(rcd->cob_map[x] & mask)) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return;
+	}
+	if (hdl->algo_apis.erase) {
+		trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
+		(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
+	}
+	if (rcd->cob_num == 1) {
+		sprintf (file_path, "%s/%d", hdl->fsc_cache_path, con_index);
+		fsc_recursive_dir_clear (file_path);
+	}
+	fsc_jnl_put (FscC_Jnl_Remove, rcd, seqno);
+	csmgrd_stat_cob_remove (csmgr_stat_hdl, key, key_size, seqno, 0);
+	hdl->cache_cobs--;
+	
+	pthread_mutex_unlock (&fsc_cs_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Upload content byte steream
 ----------------------------------------------------------------------------------------*/
 static int							/* The return value is negative if an error occurs	*/
 fsc_cache_item_puts (
@@ -1014,23 +1702,20 @@ fsc_cache_cob_write (
 	unsigned char 	name[CsmgrT_Name_Max];
 	uint16_t 		name_len = 0;
 	int				work_con_index = -1;
-	int 			prev_page_index = -1;
 	int 			work_page_index;
-	char			file_path[PATH_MAX];
 	int  			cob_block_index;
 	int 			rcdsize;
 	char			cont_path[PATH_MAX];
-	FILE*			fp = NULL;
 	uint64_t 		mask;
 	uint32_t 		x;
 	int*			indxs = NULL;
 	int				cnt = 0;
-	int				rbpflag = 0;
-	int				swindx[FscC_Page_Cob_Num];
 	uint32_t		file_msglen;
 	unsigned char 	del_name[CsmgrT_Name_Max];
 	uint16_t 		del_name_len = 0;
 	uint32_t 		del_chunk_num = 0;
+	int 			new_f;
+	off_t 			off;
 	
 #define COBS_SORT
 
@@ -1066,15 +1751,22 @@ fsc_cache_cob_write (
 			goto NEXTCOB;
 		}
 		if (!(hdl->algo_apis.insert)) {
-			if (hdl->cache_cobs >= hdl->cache_capacity) {
+			if (hdl->cache_cobs + fsc_wb.rcd_num >= hdl->cache_capacity) {
 				goto NEXTCOB;
 			}
 		}
 		/* Update the directory to write the received cob 		*/
 		if ((cobs[index].name_len != name_len) ||
 			(memcmp (cobs[index].name, name, cobs[index].name_len))) {
+			/* The records of the previous content are written before it is looked up 	*/
+			if (fsc_wb.rcd_num > 0) {
+				pthread_mutex_unlock (&fsc_cs_mutex);
+				fsc_wb_flush (cobs, nowt);
+				pthread_mutex_lock (&fsc_cs_mutex);
+			}
 			rcd = csmgrd_stat_content_info_access (
 					csmgr_stat_hdl, cobs[index].name, cobs[index].name_len);
+			new_f = 0;
 			
 			if (!rcd) {
 				rcd = csmgrd_stat_content_info_init (
@@ -1082,14 +1774,15 @@ fsc_cache_cob_write (
 				if (!rcd) {
 					goto NEXTCOB;
 				}
+				new_f = 1;
 			}
 			work_con_index = (int) rcd->index;
-			prev_page_index = -1;
-			sprintf (cont_path, "%s/%d", hdl->fsc_cache_path, work_con_index);
 			memcpy (name, cobs[index].name, cobs[index].name_len);
 			name_len = cobs[index].name_len;
 			
-			if (mkdir (cont_path, 0766) != 0) {
+			/* The directory is created once when the content is cached first 	*/
+			sprintf (cont_path, "%s/%d", hdl->fsc_cache_path, work_con_index);
+			if (new_f && (mkdir (cont_path, 0766) != 0)) {
 				if (errno == ENOENT) {
 					csmgrd_log_write (CefC_Log_Error, 
 						"Failed to create the cache directory for the each content\n");
@@ -1100,7 +1793,10 @@ fsc_cache_cob_write (
 						"Please make sure that you have write permission for %s.\n", 
 						hdl->fsc_cache_path);
 					goto NEXTCOB;
-		}
+				}
+			}
+			if (new_f && hdl->index_f) {
+				fsc_idx_name_write (cont_path, cobs[index].name, cobs[index].name_len);
 			}
 		}
 
@@ -1139,55 +1835,14 @@ fsc_cache_cob_write (
 		if ((rcd->map_max-1) >= x && rcd->cob_map[x] & mask) {
 			goto NEXTCOB;
 		}
-		/* Update the page to write the received cob 		*/
 		work_page_index = chunk_num / FscC_Page_Cob_Num / FscC_File_Page_Num;
 		cob_block_index = (chunk_num / FscC_Page_Cob_Num) % FscC_File_Page_Num;
-		if (work_page_index != prev_page_index) {
-			if (fp != NULL) {
-#ifdef CefC_Debug
-				csmgrd_dbg_write (CefC_Dbg_Finer, 
-					"cob put thread writes the page: %s\n", cont_path);
-#endif // CefC_Debug
-				if (rbpflag == 1) {
-					fflush (fp);
-					fclose (fp);
-					fp = NULL;
-					rbpflag = 0;
-				} else {
-					fflush (fp);
-					fclose (fp);
-					fp = NULL;	
-				}
-			}
-			
-			prev_page_index = work_page_index;
-			struct stat st;
-			sprintf (file_path, 
-				"%s/%d/%d", hdl->fsc_cache_path, work_con_index, work_page_index);
-            if (stat (file_path, &st) != 0) {
-				fp = fopen (file_path, "w");
-            	fclose (fp);
-            	fp = fopen (file_path, "rb+");
-			}
-			else {
-				fp = fopen (file_path, "rb+");
-				if (!fp) {
-					csmgrd_log_write (CefC_Log_Error, 
-						"Failed to open the cache file (%s)\n", file_path);
-					goto NEXTCOB;
-				}
-				memset (swindx, 0 , sizeof (swindx));
-				rbpflag = 1;
-			}
+		off = ((off_t) cob_block_index * FscC_Page_Cob_Num 
+				+ (off_t)(chunk_num % FscC_Page_Cob_Num)) * rcdsize;
+		if (fsc_wb_buffered (work_con_index, work_page_index, rcdsize, off)) {
+			goto NEXTCOB;
 		}
 		
-		/* Updates the content information 			*/
-		if (hdl->algo_apis.insert) {
-			(*(hdl->algo_apis.insert))(&cobs[index]);
-		}
-		csmgrd_stat_cob_update (csmgr_stat_hdl, cobs[index].name, cobs[index].name_len, 
-				chunk_num, cobs[index].pay_len, cobs[index].expiry, 
-				nowt, cobs[index].node);
 		/* Delete invalid starage Cob info */
 		if (del_chunk_num != 0) {
 			if (del_name_len == cobs[index].name_len
@@ -1199,25 +1854,44 @@ fsc_cache_cob_write (
 									del_name, del_name_len, del_chunk_num, trg_key);
 					(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
 				}
+				fsc_jnl_put (FscC_Jnl_Remove, rcd, del_chunk_num);
 				csmgrd_stat_cob_remove (csmgr_stat_hdl, del_name, del_name_len, del_chunk_num, 0);
 				hdl->cache_cobs--;
 				del_chunk_num = 0;
 			}
 		}
-
-		/* Set to write buffer 							*/
-		unsigned char wbuff[sizeof (uint16_t) + UINT16_MAX];
-		int write_index = chunk_num % FscC_Page_Cob_Num;
-		fseek (fp, (int64_t)cob_block_index * FscC_Page_Cob_Num * (int64_t)rcdsize
-					+ (int64_t)write_index * (int64_t)rcdsize, SEEK_SET);
-		memcpy (wbuff, &cobs[index].msg_len, sizeof (uint16_t));
-		memcpy (&wbuff[sizeof (uint16_t)], cobs[index].msg, cobs[index].msg_len);
-		fwrite (wbuff, sizeof (uint16_t) + file_msglen, 1, fp);
-		fflush (fp);
-
-		if (!(hdl->algo_apis.insert)) {
-			hdl->cache_cobs++;
+		
+		/* The content with no cob is regarded as expired by the readers, 	*/
+		/* so its first cob is written before the lock is released 			*/
+		if ((rcd->cob_num == 0) && (fsc_wb.rcd_num == 0)) {
+			if (fsc_wb_add (cobs, index, work_con_index, work_page_index, 
+					rcdsize, off, nowt) < 0) {
+				goto NEXTCOB;
+			}
+			fsc_wb_commit (cobs, nowt, fsc_wb_write ());
+			pthread_mutex_unlock (&fsc_cs_mutex);
+#ifdef COBS_SORT
+			cnt++;
+#else
+			index++;
+#endif
+			continue;
+		}
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		
+		/* The record is written back with the following ones, and the content 	*/
+		/* information is updated after it is written								*/
+		if (fsc_wb_add (cobs, index, work_con_index, work_page_index, 
+				rcdsize, off, nowt) < 0) {
+			free (cobs[index].msg);
+			free (cobs[index].name);
 		}
+#ifdef COBS_SORT
+		cnt++;
+#else
+		index++;
+#endif
+		continue;
 		
 NEXTCOB:
 		free (cobs[index].msg);
@@ -1230,15 +1904,241 @@ NEXTCOB:
 		pthread_mutex_unlock (&fsc_cs_mutex);
 	}
 	
-	if (fp) {
-		fflush (fp);
-		fclose (fp);
+	fsc_wb_flush (cobs, nowt);
+	fsc_wb_close ();
+	if (hdl->index_f) {
+		pthread_mutex_lock (&fsc_cs_mutex);
+		fsc_jnl_flush ();
+		pthread_mutex_unlock (&fsc_cs_mutex);
 	}
 #ifdef COBS_SORT
 	free (indxs);
 #endif
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Checks whether the record is buffered to be written back
+----------------------------------------------------------------------------------------*/
+static int							/* 1 if the record is buffered						*/
+fsc_wb_buffered (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	int rcdsize,								/* record size							*/
+	off_t off									/* offset of the record in the file		*/
+) {
+	if ((fsc_wb.rcd_num > 0) && 
+		(fsc_wb.con_index == con_index) && (fsc_wb.page_index == page_index) && 
+		(fsc_wb.rcdsize == rcdsize) && 
+		(off >= fsc_wb.off) && (off < fsc_wb.off + (off_t) fsc_wb.len)) {
+		return (1);
+	}
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Buffers the record, the buffered ones are written back first if it does not follow them
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the page file cannot be opened		*/
+fsc_wb_add (
+	CsmgrdT_Content_Entry* cobs, 
+	int index,									/* index of the record in cobs			*/
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	int rcdsize,								/* record size							*/
+	off_t off,									/* offset of the record in the file		*/
+	uint64_t nowt
+) {
+	char file_path[PATH_MAX];
+	int pad;
+	int reopen_f;
+	
+	/* The page file may have been deleted and its index given to another 		*/
+	/* content since it was opened, then fd refers to the deleted file 			*/
+	pthread_mutex_lock (&fsc_fd_mutex);
+	reopen_f = (fsc_wb.purge_gen != fsc_fd_purge_gen) ? 1 : 0;
+	pthread_mutex_unlock (&fsc_fd_mutex);
+	if ((fsc_wb.con_index != con_index) || (fsc_wb.page_index != page_index) || 
+		(fsc_wb.name_len != cobs[index].name_len) || 
+		(memcmp (fsc_wb.name, cobs[index].name, fsc_wb.name_len))) {
+		reopen_f = 1;
+	}
+	
+	if ((fsc_wb.rcd_num > 0) && 
+		((reopen_f) || 
+		 (fsc_wb.rcdsize != rcdsize) || (fsc_wb.off + (off_t) fsc_wb.len != off) || 
+		 (fsc_wb.iov_num + 3 > FscC_Wb_Iov_Num))) {
+		fsc_wb_flush (cobs, nowt);
+	}
+	if ((fsc_wb.fd < 0) || (reopen_f)) {
+		fsc_wb_close ();
+		pthread_mutex_lock (&fsc_fd_mutex);
+		fsc_wb.purge_gen = fsc_fd_purge_gen;
+		pthread_mutex_unlock (&fsc_fd_mutex);
+		sprintf (file_path, "%s/%d/%d", hdl->fsc_cache_path, con_index, page_index);
+		fsc_wb.fd = open (file_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		if (fsc_wb.fd < 0) {
+			csmgrd_log_write (CefC_Log_Error, 
+				"Failed to open the cache file (%s)\n", file_path);
+			return (-1);
+		}
+		fsc_wb.con_index 	= con_index;
+		fsc_wb.page_index 	= page_index;
+		fsc_wb.alloc_end 	= 0;
+		
+		/* The longer name is not kept, so that the file is opened again 	*/
+		fsc_wb.name_len = 0;
+		if (cobs[index].name_len <= sizeof (fsc_wb.name)) {
+			memcpy (fsc_wb.name, cobs[index].name, cobs[index].name_len);
+			fsc_wb.name_len = cobs[index].name_len;
+		}
+	}
+	if (fsc_wb.rcd_num == 0) {
+		fsc_wb.rcdsize 	= rcdsize;
+		fsc_wb.off 		= off;
+	}
+	
+	/* The record is the length, the message and the padding up to the record size 	*/
+	fsc_wb.iov[fsc_wb.iov_num].iov_base = &cobs[index].msg_len;
+	fsc_wb.iov[fsc_wb.iov_num].iov_len 	= sizeof (uint16_t);
+	fsc_wb.iov_num++;
+	fsc_wb.iov[fsc_wb.iov_num].iov_base = cobs[index].msg;
+	fsc_wb.iov[fsc_wb.iov_num].iov_len 	= cobs[index].msg_len;
+	fsc_wb.iov_num++;
+	pad = rcdsize - (int) sizeof (uint16_t) - (int) cobs[index].msg_len;
+	if (pad > 0) {
+		fsc_wb.iov[fsc_wb.iov_num].iov_base = (void*) fsc_wb_zero;
+		fsc_wb.iov[fsc_wb.iov_num].iov_len 	= (size_t) pad;
+		fsc_wb.iov_num++;
+	}
+	fsc_wb.idxs[fsc_wb.rcd_num++] = index;
+	fsc_wb.len += rcdsize;
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes back the buffered records to the page file
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the records cannot be written		*/
+fsc_wb_write (
+	void
+) {
+	off_t blk_size;
+	off_t start;
+	off_t end;
+	int rcd_per_page;
+	int rcd_index;
+	
+	/* Reserves the extent of the block at once, so that the page file is not fragmented */
+	end = fsc_wb.off + (off_t) fsc_wb.len;
+	if (end > fsc_wb.alloc_end) {
+		blk_size = (off_t) FscC_Page_Cob_Num * fsc_wb.rcdsize;
+		start 	 = (fsc_wb.off / blk_size) * blk_size;
+		end 	 = ((end - 1) / blk_size + 1) * blk_size;
+		if (posix_fallocate (fsc_wb.fd, start, end - start) == 0) {
+			fsc_wb.alloc_end = end;
+		}
+	}
+	
+	/* The buffered records are contiguous in the page file 	*/
+	if (pwritev (fsc_wb.fd, fsc_wb.iov, fsc_wb.iov_num, fsc_wb.off) != (ssize_t) fsc_wb.len) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to write the cache file (%d/%d)\n", fsc_wb.con_index, fsc_wb.page_index);
+		return (-1);
+	}
+	
+	/* The journal records the Cobs after they are written, so that the index 	*/
+	/* restored after a crash does not point at the records not on the disk 	*/
+	if (hdl->index_f && (fdatasync (fsc_wb.fd) != 0)) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to sync the cache file (%d/%d)\n", fsc_wb.con_index, fsc_wb.page_index);
+		return (-1);
+	}
+	
+	/* The readers which have buffered the written pages read them again 	*/
+	rcd_per_page = FscC_Buf_Page_Size / fsc_wb.rcdsize;
+	for (rcd_index = (int)(fsc_wb.off / fsc_wb.rcdsize) ; 
+		 rcd_index < (int)((fsc_wb.off + fsc_wb.len) / fsc_wb.rcdsize) ; 
+		 rcd_index = (rcd_index / rcd_per_page + 1) * rcd_per_page) {
+		fsc_buf_page_invalidate (
+			fsc_wb.con_index, fsc_wb.page_index, rcd_index, fsc_wb.rcdsize);
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Updates the content information of the written records, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_commit (
+	CsmgrdT_Content_Entry* cobs, 
+	uint64_t nowt,
+	int res										/* result of fsc_wb_write				*/
+) {
+	CsmgrdT_Content_Entry* cob;
+	CsmgrT_Stat* rcd;
+	int i;
+	
+	/* The content may be deleted while the records are written 	*/
+	cob = &cobs[fsc_wb.idxs[0]];
+	rcd = csmgrd_stat_content_info_is_exist (csmgr_stat_hdl, cob->name, cob->name_len);
+	if ((res == 0) && fsc_thread_f && rcd && ((int) rcd->index == fsc_wb.con_index)) {
+		fsc_jnl_run_put (rcd, cobs, nowt);
+		for (i = 0 ; i < fsc_wb.rcd_num ; i++) {
+			cob = &cobs[fsc_wb.idxs[i]];
+			if (hdl->algo_apis.insert) {
+				(*(hdl->algo_apis.insert))(cob);
+			}
+			csmgrd_stat_cob_update (csmgr_stat_hdl, cob->name, cob->name_len, 
+					cob->chnk_num, cob->pay_len, cob->expiry, nowt, cob->node);
+			if (!(hdl->algo_apis.insert)) {
+				hdl->cache_cobs++;
+			}
+		}
+	}
+	
+	for (i = 0 ; i < fsc_wb.rcd_num ; i++) {
+		free (cobs[fsc_wb.idxs[i]].msg);
+		free (cobs[fsc_wb.idxs[i]].name);
+	}
+	fsc_wb.rcd_num 	= 0;
+	fsc_wb.iov_num 	= 0;
+	fsc_wb.len 		= 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Writes back the buffered records and updates the content information
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_flush (
+	CsmgrdT_Content_Entry* cobs, 
+	uint64_t nowt
+) {
+	int res;
+	
+	if (fsc_wb.rcd_num == 0) {
+		return;
+	}
+	res = fsc_wb_write ();
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fsc_wb_commit (cobs, nowt, res);
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Closes the page file being written
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_close (
+	void
+) {
+	if (fsc_wb.fd >= 0) {
+		close (fsc_wb.fd);
+		fsc_wb.fd = -1;
+	}
+	return;
+}
 /*--------------------------------------------------------------------------------------
 	Function to increment access count
 ----------------------------------------------------------------------------------------*/
@@ -1310,6 +2210,10 @@ fsc_config_read (
 	strcpy (params->algo_name, "libcsmgrd_lru");
 	params->algo_name_size = 256;
 	params->algo_cob_size = 2048;
+	params->buf_capacity = FscC_Buf_Def_Capacity;
+	params->buf_readahead = 2;
+	params->io_depth = 0;
+	params->index_f = 0;
 	
 	/* Obtains the directory path where the csmgrd's config file is located. */
 	sprintf (file_name, "%s/csmgrd.conf", csmgr_conf_dir);
@@ -1401,6 +2305,47 @@ fsc_config_read (
 				fclose (fp);
 				return (-1);
 			}
+		} else if (strcmp (option, "CACHE_BUFFER_BYTES") == 0) {
+			char *endptr = "";
+			params->buf_capacity = strtoull (value, &endptr, 0);
+			if ((strcmp (endptr, "") != 0) || 
+				((params->buf_capacity != 0) && 
+				 (params->buf_capacity < FscC_Buf_Min_Capacity))) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_BUFFER_BYTES must be 0 or higher than or equal to %d.\n", 
+					FscC_Buf_Min_Capacity);
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "CACHE_BUFFER_READAHEAD") == 0) {
+			res = atoi (value);
+			if (!(0 <= res && res <= FscC_Buf_Max_Readahead)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_BUFFER_READAHEAD must be between 0 and %d inclusive.\n", 
+					FscC_Buf_Max_Readahead);
+				fclose (fp);
+				return (-1);
+			}
+			params->buf_readahead = res;
+		} else if (strcmp (option, "CACHE_IO_DEPTH") == 0) {
+			res = atoi (value);
+			if (!((res == 0) || 
+				  ((CsmgrdC_Aio_Min_Depth <= res) && (res <= CsmgrdC_Aio_Max_Depth)))) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_IO_DEPTH must be 0 or between %d and %d inclusive.\n", 
+					CsmgrdC_Aio_Min_Depth, CsmgrdC_Aio_Max_Depth);
+				fclose (fp);
+				return (-1);
+			}
+			params->io_depth = res;
+		} else if (strcmp (option, "CACHE_PERSISTENT") == 0) {
+			res = atoi (value);
+			if (!((res == 0) || (res == 1))) {
+				csmgrd_log_write (CefC_Log_Error, "CACHE_PERSISTENT must be 0 or 1.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->index_f = res;
 		} else {
 			/* NOP */;
 		}
@@ -1480,12 +2425,18 @@ fsc_change_cap (
 	hdl->cache_capacity = cap;
 	hdl->cache_cobs = 0;
 	
+	if (fsc_idx.dir_fd >= 0) {
+		fsc_idx_close ();
+	}
 	fsc_recursive_dir_clear (hdl->fsc_cache_path);
 	hdl->fsc_id = fsc_cache_id_create (hdl);
 	if (hdl->fsc_id == 0xFFFFFFFF) {
 		csmgrd_log_write (CefC_Log_Error, "FileSystemCache init error\n");
 		return (-1);
 	}
+	if (hdl->index_f) {
+		return (fsc_idx_open ());
+	}
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
@@ -1500,13 +2451,20 @@ fsc_cache_set_lifetime (
 	uint64_t nowt;
 	struct timeval tv;
 	uint64_t new_life;
+	CsmgrT_Stat* rcd;
 	
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 	new_life = nowt + lifetime * 1000000llu;
 	
 	/* Updtes the content information */
+	pthread_mutex_lock (&fsc_cs_mutex);
 	csmgrd_stat_content_lifetime_update (csmgr_stat_hdl, name, name_len, new_life);
+	rcd = csmgrd_stat_content_info_is_exist (csmgr_stat_hdl, name, name_len);
+	if (rcd) {
+		fsc_jnl_put (FscC_Jnl_Lifetime, rcd, 0);
+	}
+	pthread_mutex_unlock (&fsc_cs_mutex);
 	
 	return (0);
 }
@@ -1557,6 +2515,7 @@ fsc_cache_del (
 				sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
 				fsc_recursive_dir_clear (file_path);
 			}
+			fsc_jnl_put (FscC_Jnl_Remove, rcd, chunk_num);
 			csmgrd_stat_cob_remove (csmgr_stat_hdl, rcd->name, name_len, chunk_num, 0);
 			hdl->cache_cobs--;
 		}
@@ -1660,11 +2619,25 @@ fsc_cache_id_create (
 		csmgrd_log_write (CefC_Log_Error, "Failed to cache_path name create\n");
 		return (0xFFFFFFFF);
 	}
+	/* The directory kept across restarts has the fixed name 	*/
+	if (hdl->index_f) {
+		cache_id = FscC_Index_Id;
+		rc = snprintf (cache_path, sizeof (cache_path), 
+				"%s/%s", hdl->fsc_root_path, FscC_Index_Dir_Name);
+		if ( rc < 0 ) {
+			csmgrd_log_write (CefC_Log_Error, "Failed to cache_path name create\n");
+			return (0xFFFFFFFF);
+		}
+	}
 	cache_dir = opendir (cache_path);
 	
 	if (cache_dir) {
 		closedir (cache_dir);
 		
+		if (hdl->index_f) {
+			strcpy (hdl->fsc_cache_path, cache_path);
+			return ((uint32_t) cache_id);
+		}
 		if (fsc_recursive_dir_clear (cache_path) != 0) {
 			csmgrd_log_write (CefC_Log_Error, "Failed to remove the cache directory\n");
 			return (fsc_id);
@@ -1762,25 +2735,1706 @@ fsc_recursive_dir_clear (
 ) {
 	int rc = 0;
 
+	/* The readers do not see the files to be deleted any more 	*/
+	fsc_page_fd_purge (filepath);
+	fsc_buf_page_purge (filepath);
+	
 	rc = fsc_is_file_delete (filepath);
 	if (rc == 1) {
-		return (0);
+		rc = 0;
+	} else if (rc != 0) {
+		rc = -1;
+	} else if (fsc_dir_clear (filepath) != 0) {
+		rc = -1;
+	} else if (rmdir (filepath) < 0) {
+		csmgrd_log_write (
+			CefC_Log_Error, "fsc_recursive_dir_clear(rmdir(%s))", filepath );
+		rc = -1;
 	}
-	if (rc != 0) {
-		return (-1);
+	
+	/* The reader which opened the file before it was deleted does not cache it 	*/
+	fsc_page_fd_purge (filepath);
+	
+	return (rc);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the descriptor of the page file from the cache of the opened files
+----------------------------------------------------------------------------------------*/
+static int							/* descriptor, or -1 if the file cannot be opened	*/
+fsc_page_fd_get (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	int* slot									/* -1 if the caller closes the fd		*/
+) {
+	FscT_Page_Fd* pfd;
+	FscT_Page_Fd* victim = NULL;
+	char file_path[PATH_MAX];
+	uint64_t gen;
+	int retry_f = 0;
+	int fd;
+	int i;
+	
+	*slot = -1;
+	
+RETRY:
+	pthread_mutex_lock (&fsc_fd_mutex);
+	for (i = 0 ; i < FscC_Fd_Cache_Num ; i++) {
+		pfd = &fsc_page_fds[i];
+		if (pfd->open_f && !pfd->stale_f && 
+			(pfd->con_index == con_index) && (pfd->page_index == page_index)) {
+			pfd->ref++;
+			pfd->used = ++fsc_fd_tick;
+			*slot = i;
+			pthread_mutex_unlock (&fsc_fd_mutex);
+			return (pfd->fd);
+		}
 	}
-
-	rc = fsc_dir_clear (filepath);
-	if (rc != 0) {
+	gen = fsc_fd_purge_gen;
+	pthread_mutex_unlock (&fsc_fd_mutex);
+	
+	sprintf (file_path, "%s/%d/%d", hdl->fsc_cache_path, con_index, page_index);
+	fd = open (file_path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
 		return (-1);
 	}
-
-	rc = rmdir (filepath);
-	if (rc < 0) {
-		csmgrd_log_write (
-			CefC_Log_Error, "fsc_recursive_dir_clear(rmdir(%s))", filepath );
-		return (-1);
+	
+	pthread_mutex_lock (&fsc_fd_mutex);
+	
+	/* The file may have been deleted and created again while it was opened, 	*/
+	/* so the descriptor is not cached and is opened once more 					*/
+	if (gen != fsc_fd_purge_gen) {
+		pthread_mutex_unlock (&fsc_fd_mutex);
+		if (retry_f == 0) {
+			retry_f = 1;
+			close (fd);
+			goto RETRY;
+		}
+		return (fd);
 	}
-
-	return (0);
+	
+	/* Replaces the least recently used file which no one is reading 	*/
+	for (i = 0 ; i < FscC_Fd_Cache_Num ; i++) {
+		pfd = &fsc_page_fds[i];
+		if (!pfd->open_f) {
+			victim = pfd;
+			break;
+		}
+		if ((pfd->ref == 0) && ((victim == NULL) || (pfd->used < victim->used))) {
+			victim = pfd;
+		}
+	}
+	if (victim) {
+		if (victim->open_f) {
+			close (victim->fd);
+		}
+		victim->open_f 		= 1;
+		victim->stale_f 	= 0;
+		victim->con_index 	= con_index;
+		victim->page_index 	= page_index;
+		victim->fd 			= fd;
+		victim->ref 		= 1;
+		victim->used 		= ++fsc_fd_tick;
+		*slot = (int)(victim - fsc_page_fds);
+	}
+	pthread_mutex_unlock (&fsc_fd_mutex);
+	
+	return (fd);
+}
+/*--------------------------------------------------------------------------------------
+	Holds the cached descriptor once more for the asynchronous read
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_fd_hold (
+	int slot
+) {
+	pthread_mutex_lock (&fsc_fd_mutex);
+	fsc_page_fds[slot].ref++;
+	pthread_mutex_unlock (&fsc_fd_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Releases the descriptor obtained by fsc_page_fd_get
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_fd_release (
+	int fd,
+	int slot
+) {
+	FscT_Page_Fd* pfd;
+	
+	if (slot < 0) {
+		close (fd);
+		return;
+	}
+	pthread_mutex_lock (&fsc_fd_mutex);
+	pfd = &fsc_page_fds[slot];
+	pfd->ref--;
+	if ((pfd->ref == 0) && pfd->stale_f) {
+		close (pfd->fd);
+		pfd->open_f = 0;
+	}
+	pthread_mutex_unlock (&fsc_fd_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Closes the cached descriptors of the files under the path to be deleted
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_fd_purge (
+	const char* filepath						/* file or directory path				*/
+) {
+	FscT_Page_Fd* pfd;
+	char file_path[PATH_MAX];
+	size_t len = strlen (filepath);
+	int i;
+	
+	pthread_mutex_lock (&fsc_fd_mutex);
+	fsc_fd_purge_gen++;
+	for (i = 0 ; i < FscC_Fd_Cache_Num ; i++) {
+		pfd = &fsc_page_fds[i];
+		if (!pfd->open_f || pfd->stale_f) {
+			continue;
+		}
+		sprintf (file_path, "%s/%d/%d", 
+			hdl->fsc_cache_path, pfd->con_index, pfd->page_index);
+		if ((strncmp (file_path, filepath, len) != 0) || 
+			((file_path[len] != 0x00) && (file_path[len] != '/'))) {
+			continue;
+		}
+		/* The readers keep the deleted file until they release it 	*/
+		if (pfd->ref > 0) {
+			pfd->stale_f = 1;
+		} else {
+			close (pfd->fd);
+			pfd->open_f = 0;
+		}
+	}
+	pthread_mutex_unlock (&fsc_fd_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Creates the page buffer
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_buf_init (
+	uint64_t capacity							/* bytes of the buffered pages			*/
+) {
+	FscT_Buf_Shard* sh;
+	uint32_t tbl_size;
+	int i;
+	
+	if (capacity == 0) {
+		return (0);
+	}
+	fsc_buf_shards = (FscT_Buf_Shard*) calloc (FscC_Buf_Shard_Num, sizeof (FscT_Buf_Shard));
+	if (fsc_buf_shards == NULL) {
+		return (-1);
+	}
+	for (i = 0 ; i < FscC_Buf_Shard_Num ; i++) {
+		sh = &fsc_buf_shards[i];
+		pthread_mutex_init (&sh->mutex, NULL);
+		sh->page_max = (int)(capacity / FscC_Buf_Page_Size / FscC_Buf_Shard_Num);
+		
+		for (tbl_size = 16 ; tbl_size < (uint32_t) sh->page_max * 2 ; tbl_size <<= 1) {
+			/* NOP */;
+		}
+		sh->tbl_mask = tbl_size - 1;
+		sh->tbl = (FscT_Buf_Page**) calloc (tbl_size, sizeof (FscT_Buf_Page*));
+		sh->pages = (FscT_Buf_Page*) calloc (sh->page_max, sizeof (FscT_Buf_Page));
+		if ((sh->tbl == NULL) || (sh->pages == NULL)) {
+			fsc_buf_destroy ();
+			return (-1);
+		}
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the page buffer
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_destroy (
+	void
+) {
+	FscT_Buf_Shard* sh;
+	int i, n;
+	
+	if (fsc_buf_shards == NULL) {
+		return;
+	}
+	for (i = 0 ; i < FscC_Buf_Shard_Num ; i++) {
+		sh = &fsc_buf_shards[i];
+		for (n = 0 ; n < sh->page_num ; n++) {
+			free (sh->pages[n].data);
+		}
+		free (sh->pages);
+		free (sh->tbl);
+		pthread_mutex_destroy (&sh->mutex);
+	}
+	free (fsc_buf_shards);
+	fsc_buf_shards = NULL;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Hash of the page, the lower bits select the shard
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_buf_hash (
+	int con_index,
+	int page_index,
+	uint32_t blk
+) {
+	uint32_t h;
+	
+	h = (uint32_t) con_index * 0x9E3779B1 + (uint32_t) page_index * 0x85EBCA77 
+			+ blk * 0xC2B2AE3D;
+	h ^= h >> 16;
+	h *= 0x7FEB352D;
+	h ^= h >> 15;
+	
+	return (h);
+}
+/*--------------------------------------------------------------------------------------
+	Looks up the page in the shard, the caller holds the lock of the shard
+----------------------------------------------------------------------------------------*/
+static FscT_Buf_Page*
+fsc_buf_lookup (
+	FscT_Buf_Shard* sh,
+	uint32_t h,
+	int con_index,
+	int page_index,
+	uint32_t blk,
+	int rcdsize
+) {
+	FscT_Buf_Page* bp;
+	
+	for (bp = sh->tbl[(h / FscC_Buf_Shard_Num) & sh->tbl_mask] ; bp ; bp = bp->next) {
+		if ((bp->blk == blk) && (bp->con_index == con_index) && 
+			(bp->page_index == page_index) && (bp->rcdsize == rcdsize)) {
+			return (bp);
+		}
+	}
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Unlinks the page from the hash table, the caller holds the lock of the shard
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_unlink (
+	FscT_Buf_Shard* sh,
+	FscT_Buf_Page* bp
+) {
+	FscT_Buf_Page** pp;
+	uint32_t h;
+	
+	h = fsc_buf_hash (bp->con_index, bp->page_index, bp->blk);
+	for (pp = &sh->tbl[(h / FscC_Buf_Shard_Num) & sh->tbl_mask] ; *pp ; pp = &(*pp)->next) {
+		if (*pp == bp) {
+			*pp = bp->next;
+			break;
+		}
+	}
+	bp->next 	= NULL;
+	bp->valid_f = 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Selects the page to be reused by the CLOCK sweep, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static FscT_Buf_Page*				/* pinned page, or NULL if all pages are in use		*/
+fsc_buf_page_reserve (
+	FscT_Buf_Shard* sh
+) {
+	FscT_Buf_Page* bp = NULL;
+	int i;
+	
+	/* Allocates the pages as needed until the memory budget is reached 	*/
+	if (sh->page_num < sh->page_max) {
+		bp = &sh->pages[sh->page_num];
+		bp->data = (unsigned char*) malloc (FscC_Buf_Page_Size);
+		if (bp->data) {
+			sh->page_num++;
+			goto RESERVED;
+		}
+		sh->page_max = sh->page_num;
+	}
+	if (sh->page_num == 0) {
+		return (NULL);
+	}
+	for (i = 0 ; i < sh->page_num * 2 ; i++) {
+		bp = &sh->pages[sh->hand];
+		sh->hand = (sh->hand + 1) % sh->page_num;
+		
+		if (bp->pin) {
+			continue;
+		}
+		if (bp->valid_f && bp->ref_f) {
+			bp->ref_f = 0;
+			continue;
+		}
+		goto RESERVED;
+	}
+	return (NULL);
+	
+RESERVED:
+	if (bp->valid_f) {
+		fsc_buf_unlink (sh, bp);
+	}
+	bp->pin 	= 1;
+	bp->ref_f 	= 0;
+	bp->ra_f 	= 0;
+	
+	return (bp);
+}
+/*--------------------------------------------------------------------------------------
+	Reserves the page to hold the specified block of the page file
+----------------------------------------------------------------------------------------*/
+static FscT_Buf_Page*				/* pinned page, or NULL if all pages are in use		*/
+fsc_buf_page_alloc (
+	FscT_Buf_Shard* sh,
+	int con_index,
+	int page_index,
+	uint32_t blk,
+	int rcdsize,
+	uint64_t* epoch								/* epoch of the shard at the reservation	*/
+) {
+	FscT_Buf_Page* bp;
+	
+	pthread_mutex_lock (&sh->mutex);
+	bp = fsc_buf_page_reserve (sh);
+	*epoch = sh->epoch;
+	pthread_mutex_unlock (&sh->mutex);
+	if (bp == NULL) {
+		return (NULL);
+	}
+	
+	/* The page is out of the hash table and pinned, so only this thread sees it 	*/
+	bp->con_index 	= con_index;
+	bp->page_index 	= page_index;
+	bp->blk 		= blk;
+	bp->rcdsize 	= rcdsize;
+	bp->len 		= 0;
+	
+	return (bp);
+}
+/*--------------------------------------------------------------------------------------
+	Links the page read from the page file to the shard
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_page_link (
+	FscT_Buf_Page* bp,
+	uint64_t epoch,								/* epoch of the shard at the reservation	*/
+	int ra_f									/* 1: the page is read ahead			*/
+) {
+	FscT_Buf_Shard* sh;
+	uint32_t h;
+	
+	h = fsc_buf_hash (bp->con_index, bp->page_index, bp->blk);
+	sh = &fsc_buf_shards[h % FscC_Buf_Shard_Num];
+	
+	/* The page read while a record is written in it is used only by this reader 	*/
+	pthread_mutex_lock (&sh->mutex);
+	if ((bp->len > 0) && (epoch == sh->epoch) && 
+		(fsc_buf_lookup (sh, h, 
+			bp->con_index, bp->page_index, bp->blk, bp->rcdsize) == NULL)) {
+		bp->next = sh->tbl[(h / FscC_Buf_Shard_Num) & sh->tbl_mask];
+		sh->tbl[(h / FscC_Buf_Shard_Num) & sh->tbl_mask] = bp;
+		bp->valid_f = 1;
+		bp->ref_f 	= 1;
+		bp->ra_f 	= (uint8_t) ra_f;
+		if (ra_f) {
+			sh->readaheads++;
+		}
+	}
+	pthread_mutex_unlock (&sh->mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Reads the page from the page file and links it to the shard
+----------------------------------------------------------------------------------------*/
+static FscT_Buf_Page*				/* pinned page, or NULL if all pages are in use		*/
+fsc_buf_page_load (
+	FscT_Buf_Shard* sh,
+	int con_index,
+	int page_index,
+	uint32_t blk,
+	int rcdsize,
+	int fd,
+	int ra_f									/* 1: the page is read ahead			*/
+) {
+	FscT_Buf_Page* bp;
+	uint64_t epoch;
+	size_t size;
+	ssize_t len;
+	
+	bp = fsc_buf_page_alloc (sh, con_index, page_index, blk, rcdsize, &epoch);
+	if (bp == NULL) {
+		return (NULL);
+	}
+	size = (size_t)(FscC_Buf_Page_Size / rcdsize) * rcdsize;
+	len = pread (fd, bp->data, size, (off_t) blk * size);
+	bp->len = (len > 0) ? (int) len : 0;
+	fsc_buf_page_link (bp, epoch, ra_f);
+	
+	return (bp);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the page which holds the specified block of the page file
+----------------------------------------------------------------------------------------*/
+static FscT_Buf_Page*				/* pinned page, or NULL if the page is not buffered	*/
+fsc_buf_page_get (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	uint32_t blk,								/* index of the page in the page file	*/
+	int rcdsize,								/* record size							*/
+	int fd,										/* descriptor of the page file, or -1 	*/
+												/* not to read the page on miss			*/
+	int* seq_f									/* set to 1 on sequential access		*/
+) {
+	FscT_Buf_Shard* sh;
+	FscT_Buf_Shard* prev_sh;
+	FscT_Buf_Page* bp;
+	uint32_t h;
+	uint32_t prev_h;
+	
+	if (fsc_buf_shards == NULL) {
+		return (NULL);
+	}
+	h = fsc_buf_hash (con_index, page_index, blk);
+	sh = &fsc_buf_shards[h % FscC_Buf_Shard_Num];
+	
+	pthread_mutex_lock (&sh->mutex);
+	bp = fsc_buf_lookup (sh, h, con_index, page_index, blk, rcdsize);
+	if (bp) {
+		bp->pin++;
+		bp->ref_f = 1;
+		if (bp->ra_f) {
+			/* The read ahead page is reached, so the next ones are read ahead 	*/
+			bp->ra_f = 0;
+			*seq_f = 1;
+		}
+		sh->hits++;
+		pthread_mutex_unlock (&sh->mutex);
+		return (bp);
+	}
+	sh->misses++;
+	pthread_mutex_unlock (&sh->mutex);
+	
+	/* The access is sequential if the previous page has been buffered 	*/
+	if (blk > 0) {
+		prev_h = fsc_buf_hash (con_index, page_index, blk - 1);
+		prev_sh = &fsc_buf_shards[prev_h % FscC_Buf_Shard_Num];
+		pthread_mutex_lock (&prev_sh->mutex);
+		if (fsc_buf_lookup (prev_sh, prev_h, con_index, page_index, blk - 1, rcdsize)) {
+			*seq_f = 1;
+		}
+		pthread_mutex_unlock (&prev_sh->mutex);
+	}
+	if (fd < 0) {
+		return (NULL);
+	}
+	
+	return (fsc_buf_page_load (sh, con_index, page_index, blk, rcdsize, fd, 0));
+}
+/*--------------------------------------------------------------------------------------
+	Releases the page obtained by fsc_buf_page_get
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_page_release (
+	FscT_Buf_Page* bp
+) {
+	FscT_Buf_Shard* sh;
+	
+	sh = &fsc_buf_shards[
+		fsc_buf_hash (bp->con_index, bp->page_index, bp->blk) % FscC_Buf_Shard_Num];
+	pthread_mutex_lock (&sh->mutex);
+	bp->pin--;
+	pthread_mutex_unlock (&sh->mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Reads the specified page into the buffer before it is requested
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the page is beyond the end of file	*/
+fsc_buf_page_readahead (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	uint32_t blk,								/* index of the page in the page file	*/
+	int rcdsize,								/* record size							*/
+	int fd,										/* descriptor of the page file			*/
+	int fd_slot									/* slot of the cached descriptor		*/
+) {
+	FscT_Buf_Shard* sh;
+	FscT_Buf_Page* bp;
+	uint32_t h;
+	int len;
+	
+	h = fsc_buf_hash (con_index, page_index, blk);
+	sh = &fsc_buf_shards[h % FscC_Buf_Shard_Num];
+	
+	pthread_mutex_lock (&sh->mutex);
+	bp = fsc_buf_lookup (sh, h, con_index, page_index, blk, rcdsize);
+	pthread_mutex_unlock (&sh->mutex);
+	if (bp) {
+		return (0);
+	}
+	if (fsc_aio && (fd_slot >= 0)) {
+		/* The caller bounds the pages to read ahead by the cached records 	*/
+		fsc_aio_page_read (-1, fd, fd_slot, 
+			con_index, page_index, blk, rcdsize, 0, 0, NULL, 0, 1);
+		return (0);
+	}
+	
+	bp = fsc_buf_page_load (sh, con_index, page_index, blk, rcdsize, fd, 1);
+	if (bp == NULL) {
+		return (0);
+	}
+	len = bp->len;
+	fsc_buf_page_release (bp);
+	
+	return ((len > 0) ? 0 : -1);
+}
+/*--------------------------------------------------------------------------------------
+	Drops the buffered page which holds the written record
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_page_invalidate (
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	int rcd_index,								/* index of the record in the page file	*/
+	int rcdsize									/* record size							*/
+) {
+	FscT_Buf_Shard* sh;
+	FscT_Buf_Page* bp;
+	uint32_t blk;
+	uint32_t h;
+	
+	if (fsc_buf_shards == NULL) {
+		return;
+	}
+	blk = (uint32_t)(rcd_index / (FscC_Buf_Page_Size / rcdsize));
+	h = fsc_buf_hash (con_index, page_index, blk);
+	sh = &fsc_buf_shards[h % FscC_Buf_Shard_Num];
+	
+	/* The readers which have read the page before the write do not link it 	*/
+	pthread_mutex_lock (&sh->mutex);
+	sh->epoch++;
+	bp = fsc_buf_lookup (sh, h, con_index, page_index, blk, rcdsize);
+	if (bp) {
+		fsc_buf_unlink (sh, bp);
+	}
+	pthread_mutex_unlock (&sh->mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Drops the buffered pages of the files under the path to be deleted
+----------------------------------------------------------------------------------------*/
+static void
+fsc_buf_page_purge (
+	const char* filepath						/* file or directory path				*/
+) {
+	FscT_Buf_Shard* sh;
+	FscT_Buf_Page* bp;
+	char file_path[PATH_MAX];
+	size_t len = strlen (filepath);
+	int i, n;
+	
+	if (fsc_buf_shards == NULL) {
+		return;
+	}
+	for (i = 0 ; i < FscC_Buf_Shard_Num ; i++) {
+		sh = &fsc_buf_shards[i];
+		pthread_mutex_lock (&sh->mutex);
+		sh->epoch++;
+		for (n = 0 ; n < sh->page_num ; n++) {
+			bp = &sh->pages[n];
+			if (!bp->valid_f) {
+				continue;
+			}
+			sprintf (file_path, "%s/%d/%d", 
+				hdl->fsc_cache_path, bp->con_index, bp->page_index);
+			if ((strncmp (file_path, filepath, len) != 0) || 
+				((file_path[len] != 0x00) && (file_path[len] != '/'))) {
+				continue;
+			}
+			fsc_buf_unlink (sh, bp);
+		}
+		pthread_mutex_unlock (&sh->mutex);
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the page buffer
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_buf_stat_get (
+	CsmgrdT_Buffer_Stat* stat
+) {
+	FscT_Buf_Shard* sh;
+	int i;
+	
+	if (fsc_buf_shards == NULL) {
+		return (-1);
+	}
+	memset (stat, 0, sizeof (CsmgrdT_Buffer_Stat));
+	for (i = 0 ; i < FscC_Buf_Shard_Num ; i++) {
+		sh = &fsc_buf_shards[i];
+		pthread_mutex_lock (&sh->mutex);
+		stat->hits 			+= sh->hits;
+		stat->misses 		+= sh->misses;
+		stat->readaheads 	+= sh->readaheads;
+		pthread_mutex_unlock (&sh->mutex);
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Queues the read of the page, and the Cobs listed in it are sent when it is read
+----------------------------------------------------------------------------------------*/
+static int							/* negative if the read cannot be queued			*/
+fsc_aio_page_read (
+	int sock,									/* socket to send the Cobs				*/
+	int fd,										/* descriptor of the page file			*/
+	int fd_slot,								/* slot of the cached descriptor		*/
+	int con_index,								/* index of the content					*/
+	int page_index,								/* index of the page file				*/
+	uint32_t blk,								/* index of the page in the page file	*/
+	int rcdsize,								/* record size							*/
+	uint32_t file_msglen,						/* max length of the Cob message		*/
+	int base,									/* record index of tx_pos[] 0			*/
+	const int* tx_pos,							/* records to send						*/
+	int tx_cnt,									/* 0 if the page is read ahead			*/
+	int ra_f									/* 1: the page is read ahead			*/
+) {
+	FscT_Aio_Req* req;
+	size_t size;
+	off_t off;
+	int top;
+	int i;
+	
+	req = (FscT_Aio_Req*) malloc (sizeof (FscT_Aio_Req));
+	if (req == NULL) {
+		return (-1);
+	}
+	req->sock 			= sock;
+	req->fd 			= fd;
+	req->fd_slot 		= fd_slot;
+	req->bp 			= NULL;
+	req->data 			= NULL;
+	req->epoch 			= 0;
+	req->ra_f 			= ra_f;
+	req->rcdsize 		= rcdsize;
+	req->file_msglen 	= file_msglen;
+	req->tx_cnt 		= tx_cnt;
+	
+	/* Reads the whole page into the buffer if possible 	*/
+	if (fsc_buf_shards) {
+		req->bp = fsc_buf_page_alloc (
+			&fsc_buf_shards[fsc_buf_hash (con_index, page_index, blk) % FscC_Buf_Shard_Num], 
+			con_index, page_index, blk, rcdsize, &req->epoch);
+	}
+	if (req->bp) {
+		size = (size_t)(FscC_Buf_Page_Size / rcdsize) * rcdsize;
+		off  = (off_t) blk * size;
+		top  = (int) blk * (FscC_Buf_Page_Size / rcdsize) - base;
+		req->data = req->bp->data;
+	} else {
+		if (tx_cnt == 0) {
+			free (req);
+			return (-1);
+		}
+		/* Reads only the listed records when the page cannot be buffered 	*/
+		top  = tx_pos[0];
+		size = (size_t)(tx_pos[tx_cnt - 1] - top + 1) * rcdsize;
+		off  = ((off_t) base + top) * rcdsize;
+		req->data = (unsigned char*) malloc (size);
+		if (req->data == NULL) {
+			free (req);
+			return (-1);
+		}
+	}
+	for (i = 0 ; i < tx_cnt ; i++) {
+		req->tx_pos[i] = tx_pos[i] - top;
+	}
+	
+	/* The descriptor is kept open until the completion 	*/
+	fsc_page_fd_hold (fd_slot);
+	if (csmgrd_aio_read (fsc_aio, fd, req->data, 
+			(uint32_t) size, (uint64_t) off, fsc_aio_page_done, req) < 0) {
+		fsc_page_fd_release (fd, fd_slot);
+		if (req->bp) {
+			fsc_buf_page_release (req->bp);
+		} else {
+			free (req->data);
+		}
+		free (req);
+		return (-1);
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the Cobs in the page read asynchronously
+----------------------------------------------------------------------------------------*/
+static void
+fsc_aio_page_done (
+	void* arg,
+	int res										/* bytes read or -errno					*/
+) {
+	FscT_Aio_Req* req = (FscT_Aio_Req*) arg;
+	uint16_t mlen;
+	int i;
+	
+	if (req->bp) {
+		req->bp->len = (res > 0) ? res : 0;
+		fsc_buf_page_link (req->bp, req->epoch, req->ra_f);
+	}
+	
+	/* Send Cobs to cefnetd */
+	for (i = 0 ; i < req->tx_cnt ; i++) {
+		if (res < (req->tx_pos[i] + 1) * req->rcdsize) {
+			break;
+		}
+		memcpy (&mlen, &req->data[req->tx_pos[i] * req->rcdsize], sizeof (uint16_t));
+		if ((mlen != 0) && (mlen <= req->file_msglen)) {
+			csmgrd_plugin_cob_msg_send (req->sock, 
+				&req->data[req->tx_pos[i] * req->rcdsize + sizeof (uint16_t)], mlen);
+		}
+	}
+	
+	if (req->bp) {
+		fsc_buf_page_release (req->bp);
+	} else {
+		free (req->data);
+	}
+	fsc_page_fd_release (req->fd, req->fd_slot);
+	free (req);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Locks the cache directory and restores the contents recorded in the index
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_idx_open (
+	void
+) {
+	FscT_Index_Slot** slots;
+	struct timeval tv;
+	uint64_t start_t;
+	
+	gettimeofday (&tv, NULL);
+	start_t = tv.tv_sec * 1000000llu + tv.tv_usec;
+	
+	fsc_idx.dir_fd = open (hdl->fsc_cache_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fsc_idx.dir_fd < 0) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to open %s (%s)\n", hdl->fsc_cache_path, strerror (errno));
+		return (-1);
+	}
+	/* Another csmgrd does not use the cache directory at the same time 	*/
+	if (flock (fsc_idx.dir_fd, LOCK_EX | LOCK_NB) != 0) {
+		csmgrd_log_write (CefC_Log_Error,
+			"%s is used by another csmgrd\n", hdl->fsc_cache_path);
+		close (fsc_idx.dir_fd);
+		fsc_idx.dir_fd = -1;
+		return (-1);
+	}
+	
+	slots = (FscT_Index_Slot**) calloc (CsmgrT_Stat_Max, sizeof (FscT_Index_Slot*));
+	if (slots == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to get memory to restore the index\n");
+		close (fsc_idx.dir_fd);
+		fsc_idx.dir_fd = -1;
+		return (-1);
+	}
+	fsc_idx_load (slots);
+	fsc_idx_restore (slots, start_t);
+	free (slots);
+	
+	/* The restored contents are recorded in the checkpoint of the next generation 	*/
+	return (fsc_idx_checkpoint ());
+}
+/*--------------------------------------------------------------------------------------
+	Writes the last checkpoint and unlocks the cache directory
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_close (
+	void
+) {
+	if (fsc_idx.dir_fd < 0) {
+		return;
+	}
+	fsc_idx_checkpoint ();
+	
+	if (fsc_idx.jnl_fd >= 0) {
+		close (fsc_idx.jnl_fd);
+		fsc_idx.jnl_fd = -1;
+	}
+	close (fsc_idx.dir_fd);
+	fsc_idx.dir_fd = -1;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Writes the contents to the index file, and starts the journal of the next generation
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_idx_checkpoint (
+	void
+) {
+	FscT_Index_Header head;
+	FscT_Index_Image img;
+	char path[PATH_MAX];
+	char tmp_path[PATH_MAX + 8];
+	struct timeval tv;
+	uint64_t gen;
+	uint64_t g;
+	size_t off;
+	ssize_t len;
+	int fd;
+	int res = 0;
+	
+	memset (&img, 0, sizeof (FscT_Index_Image));
+	
+	/* The contents are taken and the journal is switched at once, 	*/
+	/* so that the entries of the new journal follow the checkpoint 	*/
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fsc_jnl_flush ();
+	csmgrd_stat_content_info_walk (csmgr_stat_hdl, fsc_idx_image_add, &img);
+	gen = fsc_idx.gen + 1;
+	res = fsc_jnl_open (gen);
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	if ((res < 0) || img.err_f) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to take the checkpoint of the index\n");
+		free (img.buf);
+		return (-1);
+	}
+	
+	/* The cache files which the checkpoint refers to reach the disk first 	*/
+#ifdef __linux__
+	syncfs (fsc_idx.dir_fd);
+#else // __linux__
+	sync ();
+#endif // __linux__
+	
+	/* Writes to the temporary file, which replaces the index file when completed 	*/
+	snprintf (path, sizeof (path), "%s/%s", hdl->fsc_cache_path, FscC_Index_File_Name);
+	snprintf (tmp_path, sizeof (tmp_path), "%s.tmp", path);
+	fd = open (tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to open %s (%s)\n", tmp_path, strerror (errno));
+		free (img.buf);
+		return (-1);
+	}
+	gettimeofday (&tv, NULL);
+	
+	memset (&head, 0, sizeof (FscT_Index_Header));
+	memcpy (head.magic, FscC_Index_Magic, sizeof (head.magic));
+	head.rec_size 	= sizeof (FscT_Index_Rec);
+	head.gen 		= gen;
+	head.saved_time = tv.tv_sec * 1000000llu + tv.tv_usec;
+	if (write (fd, &head, sizeof (FscT_Index_Header)) != (ssize_t) sizeof (FscT_Index_Header)) {
+		res = -1;
+	}
+	for (off = 0 ; (res == 0) && (off < img.len) ; off += (size_t) len) {
+		len = write (fd, img.buf + off, img.len - off);
+		if (len <= 0) {
+			res = -1;
+			break;
+		}
+	}
+	if ((res == 0) && (fsync (fd) != 0)) {
+		res = -1;
+	}
+	close (fd);
+	free (img.buf);
+	
+	if ((res < 0) || (rename (tmp_path, path) != 0)) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to write %s (%s)\n", path, strerror (errno));
+		unlink (tmp_path);
+		return (-1);
+	}
+	fsync (fsc_idx.dir_fd);
+	
+	/* The journals before the checkpoint are not replayed any more 	*/
+	for (g = fsc_idx.old_gen ; g < gen ; g++) {
+		snprintf (path, sizeof (path),
+			"%s/%s."FMTU64, hdl->fsc_cache_path, FscC_Jnl_File_Name, g);
+		unlink (path);
+	}
+	fsc_idx.old_gen = gen;
+	
+#ifdef CefC_Debug
+	csmgrd_dbg_write (CefC_Dbg_Fine,
+		"Checkpoint "FMTU64" : %u contents\n", gen, img.con_num);
+#endif // CefC_Debug
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Appends the content information to the image of the index file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_image_add (
+	CsmgrT_Stat* rcd,
+	void* arg									/* FscT_Index_Image						*/
+) {
+	FscT_Index_Image* img = (FscT_Index_Image*) arg;
+	FscT_Index_Rec rec;
+	unsigned char* buf;
+	uint32_t map_num;
+	size_t name_size;
+	size_t size;
+	size_t new_size;
+	
+	if ((rcd->cob_num == 0) || img->err_f) {
+		return;
+	}
+	
+	/* The words after the last cached Cob are not written 	*/
+	for (map_num = rcd->map_max ; map_num > 0 ; map_num--) {
+		if (rcd->cob_map[map_num - 1]) {
+			break;
+		}
+	}
+	name_size = ((size_t) rcd->name_len + 0x07) & ~((size_t) 0x07);
+	size = sizeof (FscT_Index_Rec) + name_size + sizeof (uint64_t) * map_num;
+	
+	if (img->len + size > img->size) {
+		new_size = (img->size) ? img->size * 2 : FscC_Jnl_Buff_Size;
+		while (img->len + size > new_size) {
+			new_size *= 2;
+		}
+		buf = (unsigned char*) realloc (img->buf, new_size);
+		if (buf == NULL) {
+			img->err_f = 1;
+			return;
+		}
+		img->buf  = buf;
+		img->size = new_size;
+	}
+	
+	memset (&rec, 0, sizeof (FscT_Index_Rec));
+	rec.expiry 			= rcd->expiry;
+	rec.cached_time 	= rcd->cached_time;
+	rec.con_index 		= rcd->index;
+	rec.file_msglen 	= rcd->file_msglen;
+	rec.detect_chnkno 	= rcd->detect_chnkno;
+	rec.cob_size 		= rcd->cob_size;
+	rec.last_cob_size 	= rcd->last_cob_size;
+	rec.last_chnk_num 	= rcd->last_chnk_num;
+	rec.map_num 		= map_num;
+	rec.node 			= rcd->node;
+	rec.name_len 		= rcd->name_len;
+	
+	buf = img->buf + img->len;
+	memcpy (buf, &rec, sizeof (FscT_Index_Rec));
+	memset (buf + sizeof (FscT_Index_Rec), 0, name_size);
+	memcpy (buf + sizeof (FscT_Index_Rec), rcd->name, rcd->name_len);
+	memcpy (buf + sizeof (FscT_Index_Rec) + name_size,
+		rcd->cob_map, sizeof (uint64_t) * map_num);
+	img->len += size;
+	img->con_num++;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Reads the index file and the journals following it
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_load (
+	FscT_Index_Slot** slots						/* contents indexed by the directory	*/
+) {
+	FscT_Index_Header* head;
+	FscT_Index_Rec* rec;
+	FscT_Index_Slot* slot;
+	char path[PATH_MAX];
+	unsigned char* map = NULL;
+	size_t map_len = 0;
+	size_t offset;
+	size_t name_size;
+	size_t size;
+	struct stat st;
+	uint64_t gen;
+	uint32_t i;
+	int fd;
+	
+	fsc_idx.gen 	= 0;
+	fsc_idx.old_gen = 0;
+	
+	/* The cache starts empty if the index file does not exist 	*/
+	snprintf (path, sizeof (path), "%s/%s", hdl->fsc_cache_path, FscC_Index_File_Name);
+	fd = open (path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	if ((fstat (fd, &st) == 0) && (st.st_size >= (off_t) sizeof (FscT_Index_Header))) {
+		map_len = (size_t) st.st_size;
+		map = (unsigned char*) mmap (NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED) {
+			map = NULL;
+		}
+	}
+	close (fd);
+	if (map == NULL) {
+		csmgrd_log_write (CefC_Log_Warn, "Failed to read %s\n", path);
+		return;
+	}
+	madvise (map, map_len, MADV_SEQUENTIAL);
+	
+	head = (FscT_Index_Header*) map;
+	if ((memcmp (head->magic, FscC_Index_Magic, sizeof (head->magic)) != 0) ||
+		(head->rec_size != sizeof (FscT_Index_Rec))) {
+		csmgrd_log_write (CefC_Log_Warn,
+			"%s is not an index of the filesystem cache\n", path);
+		munmap (map, map_len);
+		return;
+	}
+	gen = head->gen;
+	
+	offset = sizeof (FscT_Index_Header);
+	while (offset + sizeof (FscT_Index_Rec) <= map_len) {
+		rec = (FscT_Index_Rec*)(map + offset);
+		name_size = ((size_t) rec->name_len + 0x07) & ~((size_t) 0x07);
+		size = sizeof (FscT_Index_Rec) + name_size + sizeof (uint64_t) * rec->map_num;
+		if ((rec->con_index >= CsmgrT_Stat_Max) || (offset + size > map_len)) {
+			break;
+		}
+		slot = fsc_idx_slot_set (slots, rec->con_index,
+					map + offset + sizeof (FscT_Index_Rec), rec->name_len);
+		if (slot == NULL) {
+			break;
+		}
+		slot->cob_map = (uint64_t*) calloc (rec->map_num + 1, sizeof (uint64_t));
+		if (slot->cob_map == NULL) {
+			fsc_idx_slot_free (slots, rec->con_index);
+			break;
+		}
+		memcpy (slot->cob_map,
+			map + offset + sizeof (FscT_Index_Rec) + name_size,
+			sizeof (uint64_t) * rec->map_num);
+		slot->map_max = rec->map_num;
+		for (i = 0 ; i < rec->map_num ; i++) {
+			slot->cob_num += (uint32_t) __builtin_popcountll (slot->cob_map[i]);
+		}
+		memcpy (&slot->rec, rec, sizeof (FscT_Index_Rec));
+		offset += size;
+	}
+	munmap (map, map_len);
+	
+	/* The journal of the generation and the later ones follow the checkpoint, 	*/
+	/* the journal before it may remain if csmgrd stopped while removing it 		*/
+	fsc_idx.gen 	= gen;
+	fsc_idx.old_gen = (gen > 0) ? gen - 1 : 0;
+	while (fsc_idx_replay (slots, gen) == 0) {
+		fsc_idx.gen = gen;
+		gen++;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Applies the entries in the journal to the contents
+----------------------------------------------------------------------------------------*/
+static int							/* 0 if the journal is read to the end				*/
+fsc_idx_replay (
+	FscT_Index_Slot** slots,
+	uint64_t gen								/* generation of the journal			*/
+) {
+	FscT_Index_Header* head;
+	FscT_Jnl_Entry* ent;
+	FscT_Index_Slot* slot;
+	char path[PATH_MAX];
+	unsigned char* map;
+	unsigned char* data;
+	size_t map_len;
+	size_t offset;
+	struct stat st;
+	uint64_t mask;
+	uint16_t pay_len;
+	uint32_t x;
+	uint32_t i;
+	int fd;
+	int res = 1;
+	
+	snprintf (path, sizeof (path),
+		"%s/%s."FMTU64, hdl->fsc_cache_path, FscC_Jnl_File_Name, gen);
+	fd = open (path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return (-1);
+	}
+	if ((fstat (fd, &st) < 0) || (st.st_size < (off_t) sizeof (FscT_Index_Header))) {
+		close (fd);
+		return (1);
+	}
+	map_len = (size_t) st.st_size;
+	map = (unsigned char*) mmap (NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (map == MAP_FAILED) {
+		return (1);
+	}
+	madvise (map, map_len, MADV_SEQUENTIAL);
+	
+	head = (FscT_Index_Header*) map;
+	if ((memcmp (head->magic, FscC_Jnl_Magic, sizeof (head->magic)) != 0) ||
+		(head->rec_size != sizeof (FscT_Jnl_Entry)) || (head->gen != gen)) {
+		munmap (map, map_len);
+		return (1);
+	}
+	
+	/* The entries are applied up to the one written partially 	*/
+	offset = sizeof (FscT_Index_Header);
+	while (offset + sizeof (FscT_Jnl_Entry) <= map_len) {
+		ent = (FscT_Jnl_Entry*)(map + offset);
+		if ((ent->len < sizeof (FscT_Jnl_Entry)) || (ent->len > map_len - offset) ||
+			(ent->con_index >= CsmgrT_Stat_Max) ||
+			(sizeof (FscT_Jnl_Entry) + ent->name_len +
+				sizeof (uint16_t) * (size_t) ent->cob_num > ent->len) ||
+			(cef_valid_crc32_calc (map + offset + sizeof (uint32_t),
+				ent->len - sizeof (uint32_t)) != ent->crc)) {
+			break;
+		}
+		data = map + offset + sizeof (FscT_Jnl_Entry);
+		offset += ent->len;
+		slot = slots[ent->con_index];
+	
+		if (ent->type == FscC_Jnl_Add) {
+			slot = fsc_idx_slot_set (slots, ent->con_index, data, ent->name_len);
+			if (slot == NULL) {
+				continue;
+			}
+			/* The records written with the other size are not read any more 	*/
+			if ((slot->cob_num > 0) && (slot->rec.file_msglen != ent->file_msglen)) {
+				memset (slot->cob_map, 0, sizeof (uint64_t) * slot->map_max);
+				slot->cob_num 		= 0;
+				slot->rec.cob_size 	= 0;
+			}
+			if (slot->cob_num == 0) {
+				slot->rec.cached_time 	= ent->cached_time;
+				slot->rec.node 			= ent->node;
+			}
+			if (slot->rec.expiry < ent->expiry) {
+				slot->rec.expiry = ent->expiry;
+			}
+			slot->rec.file_msglen 	= ent->file_msglen;
+			slot->rec.detect_chnkno = ent->detect_chnkno;
+			for (i = 0 ; i < ent->cob_num ; i++) {
+				memcpy (&pay_len,
+					data + ent->name_len + sizeof (uint16_t) * i, sizeof (uint16_t));
+				fsc_idx_slot_cob_set (slot, ent->chunk_num + i, pay_len);
+			}
+		} else if (ent->type == FscC_Jnl_Remove) {
+			if (slot == NULL) {
+				continue;
+			}
+			x = ent->chunk_num / 64;
+			mask = 1llu << (ent->chunk_num % 64);
+			if ((x < slot->map_max) && (slot->cob_map[x] & mask)) {
+				slot->cob_map[x] &= ~mask;
+				slot->cob_num--;
+				if (slot->cob_num == 0) {
+					fsc_idx_slot_free (slots, ent->con_index);
+				}
+			}
+		} else if (ent->type == FscC_Jnl_Delete) {
+			fsc_idx_slot_free (slots, ent->con_index);
+		} else if (ent->type == FscC_Jnl_Lifetime) {
+			if (slot) {
+				slot->rec.expiry = ent->expiry;
+			}
+		}
+	}
+	if (offset == map_len) {
+		res = 0;
+	}
+	munmap (map, map_len);
+	
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Registers the contents restored from the index with the cache
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_restore (
+	FscT_Index_Slot** slots,
+	uint64_t start_t							/* time when the restore started		*/
+) {
+	FscT_Index_Slot* slot;
+	CsmgrT_Stat* rcd;
+	CsmgrdT_Content_Entry entry;
+	char old_path[PATH_MAX];
+	char new_path[PATH_MAX];
+	char path[PATH_MAX + 256];
+	unsigned char* kept;
+	DIR* dir;
+	struct dirent* dent;
+	struct stat sb;
+	struct timeval tv;
+	uint64_t nowt;
+	uint64_t cob_num = 0;
+	uint32_t con_num = 0;
+	uint32_t dropped = 0;
+	uint32_t seq;
+	uint32_t i, n;
+	char* endp;
+	long index;
+	
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	kept = (unsigned char*) calloc (CsmgrT_Stat_Max, sizeof (unsigned char));
+	
+	/* The contents obtain the indexes in ascending order, so that each directory 	*/
+	/* is renamed to the smaller index, which no restored content uses 				*/
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		slot = slots[i];
+		if (slot == NULL) {
+			continue;
+		}
+		sprintf (old_path, "%s/%u", hdl->fsc_cache_path, i);
+	
+		/* Drops the content which expired while csmgrd was stopped, the ones after	*/
+		/* the capacity is filled and the one whose directory does not hold its files	*/
+		if ((slot->cob_num == 0) || (slot->rec.expiry <= nowt) ||
+			(cob_num >= hdl->cache_capacity) ||
+			(fsc_idx_name_check (old_path, slot->name, slot->rec.name_len) != 1)) {
+			fsc_idx_slot_free (slots, i);
+			dropped++;
+			continue;
+		}
+		rcd = csmgrd_stat_content_info_init (
+				csmgr_stat_hdl, slot->name, slot->rec.name_len);
+		if (rcd == NULL) {
+			fsc_idx_slot_free (slots, i);
+			dropped++;
+			continue;
+		}
+		if (rcd->index != i) {
+			sprintf (new_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
+			if (lstat (new_path, &sb) == 0) {
+				fsc_recursive_dir_clear (new_path);
+			}
+			if (rename (old_path, new_path) != 0) {
+				csmgrd_log_write (CefC_Log_Error,
+					"Failed to rename %s (%s)\n", old_path, strerror (errno));
+				csmgrd_stat_content_info_delete (
+					csmgr_stat_hdl, slot->name, slot->rec.name_len);
+				fsc_idx_slot_free (slots, i);
+				dropped++;
+				continue;
+			}
+		}
+		rcd->file_msglen 	= slot->rec.file_msglen;
+		rcd->detect_chnkno 	= slot->rec.detect_chnkno;
+		if (kept) {
+			kept[rcd->index] = 1;
+		}
+	
+		/* The Cobs beyond the capacity are not restored 	*/
+		for (n = 0 ; (n < slot->map_max) && (cob_num < hdl->cache_capacity) ; n++) {
+			if (slot->cob_map[n] == 0) {
+				continue;
+			}
+			for (seq = n * 64 ; 
+				(seq < (n + 1) * 64) && (cob_num < hdl->cache_capacity) ; seq++) {
+				if (!(slot->cob_map[n] & (1llu << (seq % 64)))) {
+					continue;
+				}
+				if (hdl->algo_apis.insert) {
+					memset (&entry, 0, sizeof (CsmgrdT_Content_Entry));
+					entry.name 		= slot->name;
+					entry.name_len 	= slot->rec.name_len;
+					entry.chnk_num 	= seq;
+					entry.expiry 	= slot->rec.expiry;
+					entry.node 		= slot->rec.node;
+					(*(hdl->algo_apis.insert))(&entry);
+				}
+				csmgrd_stat_cob_update (csmgr_stat_hdl,
+					slot->name, slot->rec.name_len, seq,
+					(seq == slot->rec.last_chnk_num) ?
+						slot->rec.last_cob_size : slot->rec.cob_size,
+					slot->rec.expiry, slot->rec.cached_time, slot->rec.node);
+				if (!(hdl->algo_apis.insert)) {
+					hdl->cache_cobs++;
+				}
+				cob_num++;
+			}
+		}
+		con_num++;
+		fsc_idx_slot_free (slots, i);
+	}
+	
+	/* Clears the directories which no restored content refers to 	*/
+	dir = opendir (hdl->fsc_cache_path);
+	if (dir && kept) {
+		while ((dent = readdir (dir)) != NULL) {
+			if ((dent->d_name[0] < '0') || (dent->d_name[0] > '9')) {
+				continue;
+			}
+			index = strtol (dent->d_name, &endp, 10);
+			if ((*endp != 0x00) || ((index < CsmgrT_Stat_Max) && kept[index])) {
+				continue;
+			}
+			snprintf (path, sizeof (path), "%s/%s", hdl->fsc_cache_path, dent->d_name);
+			fsc_recursive_dir_clear (path);
+		}
+	}
+	if (dir) {
+		closedir (dir);
+	}
+	free (kept);
+	snprintf (path, sizeof (path),
+		"%s/%s.tmp", hdl->fsc_cache_path, FscC_Index_File_Name);
+	unlink (path);
+	
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	csmgrd_log_write (CefC_Log_Info,
+		"Restored %u contents ("FMTU64" Cobs) in "FMTU64" ms, %u dropped\n",
+		con_num, cob_num, (nowt - start_t) / 1000, dropped);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the slot of the content, the other content in it is dropped
+----------------------------------------------------------------------------------------*/
+static FscT_Index_Slot*
+fsc_idx_slot_set (
+	FscT_Index_Slot** slots,
+	uint32_t con_index,							/* index of the content					*/
+	const unsigned char* name,
+	uint16_t name_len
+) {
+	FscT_Index_Slot* slot = slots[con_index];
+	
+	/* The index was given to the other content after the content was deleted 	*/
+	if (slot && ((slot->rec.name_len != name_len) ||
+				 (memcmp (slot->name, name, name_len) != 0))) {
+		fsc_idx_slot_free (slots, con_index);
+		slot = NULL;
+	}
+	if (slot == NULL) {
+		slot = (FscT_Index_Slot*) calloc (1, sizeof (FscT_Index_Slot) + name_len);
+		if (slot == NULL) {
+			return (NULL);
+		}
+		slot->name = (unsigned char*)(slot + 1);
+		memcpy (slot->name, name, name_len);
+		slot->rec.con_index = con_index;
+		slot->rec.name_len 	= name_len;
+		slots[con_index] = slot;
+	}
+	
+	return (slot);
+}
+/*--------------------------------------------------------------------------------------
+	Frees the slot of the content
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_slot_free (
+	FscT_Index_Slot** slots,
+	uint32_t con_index							/* index of the content					*/
+) {
+	if (slots[con_index]) {
+		free (slots[con_index]->cob_map);
+		free (slots[con_index]);
+		slots[con_index] = NULL;
+	}
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Records the Cob in the slot
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_idx_slot_cob_set (
+	FscT_Index_Slot* slot,
+	uint32_t seq,
+	uint32_t cob_size
+) {
+	uint64_t* cob_map;
+	uint64_t mask;
+	uint32_t map_max;
+	uint32_t x;
+	
+	x = seq / 64;
+	mask = 1llu << (seq % 64);
+	if (x >= slot->map_max) {
+		map_max = (x / CsmgrT_Add_Maps + 1) * CsmgrT_Add_Maps;
+		cob_map = (uint64_t*) realloc (slot->cob_map, sizeof (uint64_t) * map_max);
+		if (cob_map == NULL) {
+			return (-1);
+		}
+		memset (&cob_map[slot->map_max], 0, sizeof (uint64_t) * (map_max - slot->map_max));
+		slot->cob_map = cob_map;
+		slot->map_max = map_max;
+	}
+	if (slot->cob_map[x] & mask) {
+		return (0);
+	}
+	slot->cob_map[x] |= mask;
+	slot->cob_num++;
+	
+	/* Follows the Cob size recorded by csmgrd_stat_cob_update 	*/
+	if (slot->rec.cob_size == 0) {
+		slot->rec.cob_size 		= cob_size;
+		slot->rec.last_cob_size = cob_size;
+		slot->rec.last_chnk_num = seq;
+	}
+	if (slot->rec.cob_size > cob_size) {
+		slot->rec.last_cob_size = cob_size;
+		slot->rec.last_chnk_num = seq;
+	} else if (slot->rec.cob_size < cob_size) {
+		slot->rec.cob_size = cob_size;
+	}
+	if (slot->rec.last_chnk_num < seq) {
+		slot->rec.last_chnk_num = seq;
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the name of the content to its directory
+----------------------------------------------------------------------------------------*/
+static void
+fsc_idx_name_write (
+	const char* cont_path,						/* directory of the content				*/
+	const unsigned char* name,
+	uint16_t name_len
+) {
+	char path[PATH_MAX + 8];
+	int fd;
+	
+	snprintf (path, sizeof (path), "%s/%s", cont_path, FscC_Name_File_Name);
+	fd = open (path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		csmgrd_log_write (CefC_Log_Warn,
+			"Failed to open %s (%s)\n", path, strerror (errno));
+		return;
+	}
+	if (write (fd, name, name_len) != (ssize_t) name_len) {
+		csmgrd_log_write (CefC_Log_Warn,
+			"Failed to write %s (%s)\n", path, strerror (errno));
+	}
+	close (fd);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Checks the directory holds the files of the content
+----------------------------------------------------------------------------------------*/
+static int							/* 1 if the name in the directory matches			*/
+fsc_idx_name_check (
+	const char* cont_path,						/* directory of the content				*/
+	const unsigned char* name,
+	uint16_t name_len
+) {
+	char path[PATH_MAX + 8];
+	unsigned char buf[CsmgrT_Name_Max + 1];
+	ssize_t len;
+	int fd;
+	
+	snprintf (path, sizeof (path), "%s/%s", cont_path, FscC_Name_File_Name);
+	fd = open (path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return (0);
+	}
+	len = read (fd, buf, (size_t) name_len + 1);
+	close (fd);
+	
+	if ((len != (ssize_t) name_len) || (memcmp (buf, name, name_len) != 0)) {
+		return (0);
+	}
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the journal of the generation, the current one is closed
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_jnl_open (
+	uint64_t gen
+) {
+	FscT_Index_Header head;
+	char path[PATH_MAX];
+	struct timeval tv;
+	
+	if (fsc_idx.jnl_fd >= 0) {
+		close (fsc_idx.jnl_fd);
+		fsc_idx.jnl_fd = -1;
+	}
+	snprintf (path, sizeof (path),
+		"%s/%s."FMTU64, hdl->fsc_cache_path, FscC_Jnl_File_Name, gen);
+	fsc_idx.jnl_fd = open (path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+	if (fsc_idx.jnl_fd < 0) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to open %s (%s)\n", path, strerror (errno));
+		return (-1);
+	}
+	gettimeofday (&tv, NULL);
+	
+	memset (&head, 0, sizeof (FscT_Index_Header));
+	memcpy (head.magic, FscC_Jnl_Magic, sizeof (head.magic));
+	head.rec_size 	= sizeof (FscT_Jnl_Entry);
+	head.gen 		= gen;
+	head.saved_time = tv.tv_sec * 1000000llu + tv.tv_usec;
+	if (write (fsc_idx.jnl_fd, &head, sizeof (FscT_Index_Header))
+			!= (ssize_t) sizeof (FscT_Index_Header)) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to write %s (%s)\n", path, strerror (errno));
+		close (fsc_idx.jnl_fd);
+		fsc_idx.jnl_fd = -1;
+		return (-1);
+	}
+	fsc_idx.gen 		= gen;
+	fsc_idx.jnl_size 	= sizeof (FscT_Index_Header);
+	fsc_idx.buf_len 	= 0;
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the buffered entries to the journal
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_flush (
+	void
+) {
+	ssize_t len;
+	int off = 0;
+	
+	if (fsc_idx.jnl_fd < 0) {
+		fsc_idx.buf_len = 0;
+		return;
+	}
+	while (off < fsc_idx.buf_len) {
+		len = write (fsc_idx.jnl_fd, &fsc_idx.buf[off], fsc_idx.buf_len - off);
+		if (len <= 0) {
+			if ((len < 0) && (errno == EINTR)) {
+				continue;
+			}
+			csmgrd_log_write (CefC_Log_Error,
+				"Failed to write the journal (%s)\n", strerror (errno));
+			break;
+		}
+		off += (int) len;
+	}
+	if ((off > 0) && (fdatasync (fsc_idx.jnl_fd) != 0)) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to sync the journal (%s)\n", strerror (errno));
+	}
+	fsc_idx.jnl_size += (uint64_t) off;
+	fsc_idx.buf_len = 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Buffers the journal entry, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_append (
+	FscT_Jnl_Entry* ent,
+	const unsigned char* name,					/* ent->name_len bytes					*/
+	const void* tail,							/* follows the name						*/
+	int tail_len
+) {
+	unsigned char* p;
+	uint32_t crc;
+	int len;
+	
+	len = (int) sizeof (FscT_Jnl_Entry) + ent->name_len + tail_len;
+	ent->len = (uint32_t)((len + 0x07) & ~0x07);
+	
+	if (fsc_idx.buf_len + (int) ent->len > FscC_Jnl_Buff_Size) {
+		fsc_jnl_flush ();
+	}
+	p = &fsc_idx.buf[fsc_idx.buf_len];
+	memcpy (p, ent, sizeof (FscT_Jnl_Entry));
+	if (ent->name_len > 0) {
+		memcpy (p + sizeof (FscT_Jnl_Entry), name, ent->name_len);
+	}
+	if (tail_len > 0) {
+		memcpy (p + sizeof (FscT_Jnl_Entry) + ent->name_len, tail, tail_len);
+	}
+	memset (p + len, 0, ent->len - len);
+	
+	/* The entry written partially is detected by the checksum 	*/
+	crc = cef_valid_crc32_calc (p + sizeof (uint32_t), ent->len - sizeof (uint32_t));
+	memcpy (p, &crc, sizeof (uint32_t));
+	fsc_idx.buf_len += (int) ent->len;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Records the removal or the lifetime of the content, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_put (
+	int type,									/* FscC_Jnl_XXX							*/
+	CsmgrT_Stat* rcd,
+	uint32_t chunk_num							/* chunk of FscC_Jnl_Remove				*/
+) {
+	FscT_Jnl_Entry ent;
+	
+	if (fsc_idx.jnl_fd < 0) {
+		return;
+	}
+	memset (&ent, 0, sizeof (FscT_Jnl_Entry));
+	ent.type 		= (uint16_t) type;
+	ent.con_index 	= rcd->index;
+	ent.chunk_num 	= chunk_num;
+	ent.expiry 		= rcd->expiry;
+	fsc_jnl_append (&ent, NULL, NULL, 0);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Records the Cobs written back, the caller holds the lock
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_run_put (
+	CsmgrT_Stat* rcd,
+	CsmgrdT_Content_Entry* cobs,
+	uint64_t nowt
+) {
+	FscT_Jnl_Entry ent;
+	CsmgrdT_Content_Entry* cob;
+	uint16_t pay_lens[FscC_Wb_Rcd_Num];
+	int i;
+	
+	if (fsc_idx.jnl_fd < 0) {
+		return;
+	}
+	
+	/* The records written at once hold the consecutive chunks 	*/
+	cob = &cobs[fsc_wb.idxs[0]];
+	memset (&ent, 0, sizeof (FscT_Jnl_Entry));
+	ent.type 			= FscC_Jnl_Add;
+	ent.name_len 		= rcd->name_len;
+	ent.con_index 		= rcd->index;
+	ent.cached_time 	= nowt;
+	ent.chunk_num 		= cob->chnk_num;
+	ent.cob_num 		= (uint32_t) fsc_wb.rcd_num;
+	ent.file_msglen 	= rcd->file_msglen;
+	ent.detect_chnkno 	= rcd->detect_chnkno;
+	ent.node 			= cob->node;
+	for (i = 0 ; i < fsc_wb.rcd_num ; i++) {
+		cob = &cobs[fsc_wb.idxs[i]];
+		pay_lens[i] = cob->pay_len;
+		if (ent.expiry < cob->expiry) {
+			ent.expiry = cob->expiry;
+		}
+	}
+	fsc_jnl_append (&ent, rcd->name, pay_lens, (int) sizeof (uint16_t) * fsc_wb.rcd_num);
+	
+	return;
 }
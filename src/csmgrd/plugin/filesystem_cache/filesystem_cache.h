@@ -75,6 +75,16 @@ typedef struct {
 
 	uint64_t 		cache_capacity;				/* size of cache capacity 				*/
 	
+	/********** page buffer **********/
+	uint64_t 		buf_capacity;				/* bytes of the buffered pages			*/
+	int 			buf_readahead;				/* pages read ahead on sequential access */
+	
+	/********** asynchronous reads **********/
+	int 			io_depth;					/* depth of the io_uring, 0: pread		*/
+	
+	/********** index kept across restarts **********/
+	int 			index_f;					/* 1: the cached contents are kept		*/
+	
 } FscT_Config_Param;
 
 typedef struct {
@@ -106,6 +116,16 @@ typedef struct {
 	uint64_t 		cache_cobs;
 	uint64_t		cache_capacity;
 	CefT_Mp_Handle	mem_rm_key;
+	
+	/********** page buffer **********/
+	uint64_t 		buf_capacity;				/* bytes of the buffered pages			*/
+	int 			buf_readahead;				/* pages read ahead on sequential access */
+	
+	/********** asynchronous reads **********/
+	int 			io_depth;					/* depth of the io_uring, 0: pread		*/
+	
+	/********** index kept across restarts **********/
+	int 			index_f;					/* 1: the cached contents are kept		*/
 
 } FscT_Cache_Handle;
 
@@ -0,0 +1,534 @@
+/*
+ * Copyright (c) 2016-2021, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * arc.c
+ */
+
+/*
+	arc.c is an ARC (Adaptive Replacement Cache) implementation.
+
+	The cached entries are listed in T1 if they are requested once since they
+	are cached, or in T2 if they are requested again. The entries removed from
+	T1 and T2 are remembered in the ghost lists B1 and B2, which hold only the
+	hashes of their keys. When an entry in B1 is cached again, the target size
+	of T1 is increased since the recent entries were removed too early, and
+	when an entry in B2 is cached again, it is decreased. So the cache adapts
+	between the recency and the frequency of the requests.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+#include "cache_replace_lib.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define ArcC_T1 				0		/* cached entries requested once 			*/
+#define ArcC_T2 				1		/* cached entries requested again 			*/
+#define ArcC_B1 				2		/* ghosts of the entries removed from T1 	*/
+#define ArcC_B2 				3		/* ghosts of the entries removed from T2 	*/
+#define ArcC_List_Num 			4
+
+#define ArcC_Bucket_Min 		64		/* minimum number of buckets of the ghosts 	*/
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/***** structure for linking the entry or the ghost in a list *****/
+typedef struct {
+	int 			list;					/* ArcC_T1, T2, B1 or B2 					*/
+	int 			next;					/* towards the LRU side 					*/
+	int 			prev;					/* towards the MRU side 					*/
+} ArcT_Link;
+
+/***** structure for listing content entries *****/
+typedef struct {
+	unsigned char 	*key;					/* key of content entry 					*/
+	int 			key_len;				/* length of key 							*/
+	uint32_t 		hash;					/* hash of the key kept by the ghost 		*/
+} ArcT_Entry;
+
+/***** structure for the ghost of the removed entry *****/
+typedef struct {
+	uint32_t 		hash;					/* hash of the key 							*/
+	int 			chain;					/* next ghost in the same bucket 			*/
+} ArcT_Ghost;
+
+/***** structure for the LRU list *****/
+typedef struct {
+	int 			mru;
+	int 			lru;
+	int 			count;					/* number of listed entries or ghosts 		*/
+} ArcT_List;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+
+/* pointers of functions which stores and removes the content entry into/from the cache */
+/* table (implementation of the functions are in a plugin which uses this library) 		*/
+static int (*store_api)(CsmgrdT_Content_Entry*);
+static void (*remove_api)(unsigned char*, int);
+
+static int              cache_count;        /* number of cache entries                  */
+static ArcT_Entry*      cache_entry_list;   /* list for cache entry                     */
+static ArcT_Link*       cache_entry_link;   /* links of the cache entries               */
+static int*             empty_entry_list;   /* list for empty cache entry               */
+
+static int              ghost_count;        /* number of ghosts in B1 and B2            */
+static ArcT_Ghost*      ghost_list;         /* list for ghost                           */
+static ArcT_Link*       ghost_link;         /* links of the ghosts                      */
+static int*             empty_ghost_list;   /* list for empty ghost                     */
+static int*             ghost_bucket;       /* first ghost of each bucket               */
+static uint32_t         ghost_mask;         /* number of buckets - 1                    */
+
+static ArcT_List        lists[ArcC_List_Num];
+static int              t1_target;          /* target number of the entries in T1       */
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static void arc_store_entry(CsmgrdT_Content_Entry* entry, unsigned char* key,
+							int key_len, uint32_t hash, int list);
+static void arc_remove_entry(int index, int is_removed);
+static void arc_replace(int in_b2);
+static void arc_ghost_add(int list, uint32_t hash);
+static void arc_ghost_remove(int gindex);
+static int  arc_ghost_search(uint32_t hash);
+static void arc_list_push(ArcT_Link* links, int list, int index);
+static void arc_list_unlink(ArcT_Link* links, int index);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+init (
+	int capacity, 							/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+	int (*store)(CsmgrdT_Content_Entry*), 	/* store a content entry API 				*/
+	void (*remove)(unsigned char*, int)		/* remove a content entry API 				*/
+) {
+	uint64_t width;
+	int i;
+
+	cache_count = 0;
+	ghost_count = 0;
+	t1_target 	= 0;
+
+	/* Records the capacity of cache		*/
+	if (capacity < 1) {
+		fprintf (stderr, "[ARC LIB] Invalid Cacacity\n");
+		return (-1);
+	}
+	cache_cap = capacity;
+
+	/* Records store and remove APIs 		*/
+	if ((store == NULL) || (remove == NULL)) {
+		fprintf (stderr, "[ARC LIB] Not specified store or remove API\n");
+		return (-1);
+	}
+	store_api 	= store;
+	remove_api 	= remove;
+
+	/* Creates the entries and the ghosts, B1 and B2 remember as many 	*/
+	/* entries as the capacity in total 								*/
+	for (width = ArcC_Bucket_Min ; width < (uint64_t) cache_cap ; width <<= 1) {
+		;
+	}
+	cache_entry_list = (ArcT_Entry*) calloc (cache_cap, sizeof (ArcT_Entry));
+	cache_entry_link = (ArcT_Link*) calloc (cache_cap, sizeof (ArcT_Link));
+	empty_entry_list = (int*) calloc (cache_cap, sizeof (int));
+	ghost_list 		 = (ArcT_Ghost*) calloc (cache_cap, sizeof (ArcT_Ghost));
+	ghost_link 		 = (ArcT_Link*) calloc (cache_cap, sizeof (ArcT_Link));
+	empty_ghost_list = (int*) calloc (cache_cap, sizeof (int));
+	ghost_bucket 	 = (int*) malloc (width * sizeof (int));
+
+	if ((cache_entry_list == NULL) || (cache_entry_link == NULL) ||
+		(empty_entry_list == NULL) || (ghost_list == NULL) || (ghost_link == NULL) ||
+		(empty_ghost_list == NULL) || (ghost_bucket == NULL)) {
+		fprintf (stderr, "[ARC LIB] Failed to allocate the entries\n");
+		free (cache_entry_list);
+		free (cache_entry_link);
+		free (empty_entry_list);
+		free (ghost_list);
+		free (ghost_link);
+		free (empty_ghost_list);
+		free (ghost_bucket);
+		cache_entry_list = NULL;
+		cache_entry_link = NULL;
+		empty_entry_list = NULL;
+		ghost_list 		 = NULL;
+		ghost_link 		 = NULL;
+		empty_ghost_list = NULL;
+		ghost_bucket 	 = NULL;
+		return (-1);
+	}
+	for (i = 0; i < cache_cap; i++) {
+		empty_entry_list[i] = i;
+		cache_entry_link[i].next = -1;
+		cache_entry_link[i].prev = -1;
+		empty_ghost_list[i] = i;
+		ghost_link[i].next = -1;
+		ghost_link[i].prev = -1;
+	}
+	for (i = 0; i < (int) width; i++) {
+		ghost_bucket[i] = -1;
+	}
+	ghost_mask = (uint32_t)(width - 1);
+
+	for (i = 0; i < ArcC_List_Num; i++) {
+		lists[i].mru 	= -1;
+		lists[i].lru 	= -1;
+		lists[i].count 	= 0;
+	}
+
+	/* Creates lookup table */
+	crlib_lookup_table_init(capacity);
+
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+void
+destroy (
+	void
+) {
+	int i;
+
+	if (cache_entry_list) {
+		for (i = 0; i < cache_cap; i++) {
+			if (cache_entry_list[i].key != NULL) {
+				free (cache_entry_list[i].key);
+			}
+		}
+		free (cache_entry_list);
+		cache_entry_list = NULL;
+		crlib_lookup_table_destroy();
+	}
+	free (cache_entry_link);
+	free (empty_entry_list);
+	free (ghost_list);
+	free (ghost_link);
+	free (empty_ghost_list);
+	free (ghost_bucket);
+	cache_entry_link 	= NULL;
+	empty_entry_list 	= NULL;
+	ghost_list 			= NULL;
+	ghost_link 			= NULL;
+	empty_ghost_list 	= NULL;
+	ghost_bucket 		= NULL;
+	cache_count 		= 0;
+	ghost_count 		= 0;
+	cache_cap 			= 0;
+	store_api 			= NULL;
+	remove_api 			= NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+	Insert API
+----------------------------------------------------------------------------------------*/
+void
+insert (
+	CsmgrdT_Content_Entry* entry			/* content entry 							*/
+) {
+	unsigned char 	key[CsmgrdC_Key_Max];
+	int 			key_len;
+	uint32_t 		hash;
+	int 			gindex;
+	int 			delta;
+
+	key_len = csmgrd_name_chunknum_concatenate (
+					entry->name, entry->name_len, entry->chnk_num, key);
+	hash   = crlib_xhash_get_str (key, key_len, 0);
+	gindex = arc_ghost_search (hash);
+
+	if ((gindex >= 0) && (ghost_link[gindex].list == ArcC_B1)) {
+		/* The entry was removed from T1 too early, so T1 is enlarged 	*/
+		delta = lists[ArcC_B2].count / lists[ArcC_B1].count;
+		t1_target += (delta > 1) ? delta : 1;
+		if (t1_target > cache_cap) {
+			t1_target = cache_cap;
+		}
+		arc_ghost_remove (gindex);
+		if (cache_count >= cache_cap) {
+			arc_replace (0);
+		}
+		arc_store_entry (entry, key, key_len, hash, ArcC_T2);
+		return;
+	}
+	if (gindex >= 0) {
+		/* The entry was removed from T2 too early, so T2 is enlarged 	*/
+		delta = lists[ArcC_B1].count / lists[ArcC_B2].count;
+		t1_target -= (delta > 1) ? delta : 1;
+		if (t1_target < 0) {
+			t1_target = 0;
+		}
+		arc_ghost_remove (gindex);
+		if (cache_count >= cache_cap) {
+			arc_replace (1);
+		}
+		arc_store_entry (entry, key, key_len, hash, ArcC_T2);
+		return;
+	}
+
+	/* The new entry enters T1, and T1 with B1 is kept within the capacity 	*/
+	if (lists[ArcC_T1].count + lists[ArcC_B1].count >= cache_cap) {
+		if (lists[ArcC_T1].count < cache_cap) {
+			arc_ghost_remove (lists[ArcC_B1].lru);
+			if (cache_count >= cache_cap) {
+				arc_replace (0);
+			}
+		} else {
+			arc_remove_entry (lists[ArcC_T1].lru, 0);
+		}
+	} else if (cache_count >= cache_cap) {
+		arc_replace (0);
+	}
+	arc_store_entry (entry, key, key_len, hash, ArcC_T1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Erase API
+----------------------------------------------------------------------------------------*/
+void
+erase (
+	unsigned char* key, 					/* key of content entry removed from cache 	*/
+											/* table									*/
+	int key_len								/* length of the key 						*/
+) {
+	int index = crlib_lookup_table_search(key, key_len);
+	if (index < 0) {
+		fprintf (stderr, "[ARC LIB] failed to erace\n");
+		return;
+	}
+	arc_remove_entry (index, 1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Hit API
+----------------------------------------------------------------------------------------*/
+void
+hit (
+	unsigned char* key, 					/* key of the content entry hits in the 	*/
+											/* cache table 								*/
+	int key_len								/* length of the key 						*/
+) {
+	int index = crlib_lookup_table_search(key, key_len);
+	if (index < 0) {
+		return;
+	}
+	/* The entry requested again is moved to the MRU of T2 	*/
+	arc_list_unlink (cache_entry_link, index);
+	arc_list_push (cache_entry_link, ArcC_T2, index);
+}
+
+/*--------------------------------------------------------------------------------------
+	Miss API
+----------------------------------------------------------------------------------------*/
+void
+miss (
+	unsigned char* key, 					/* key of the content entry fails to hit 	*/
+											/* in the cache table						*/
+	int key_len								/* length of the key 						*/
+) {
+	// NOTHING TO DO
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Status API
+----------------------------------------------------------------------------------------*/
+void
+status (
+	void* arg								/* state information						*/
+) {
+	// TODO
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Static Functions
+----------------------------------------------------------------------------------------*/
+static void arc_store_entry(
+	CsmgrdT_Content_Entry* entry,
+	unsigned char* key,
+	int key_len,
+	uint32_t hash,
+	int list
+) {
+	ArcT_Entry* rsentry;
+	int index = empty_entry_list[cache_count];
+	unsigned char* q;
+
+	rsentry = &cache_entry_list[index];
+	rsentry->key_len = key_len;
+	q = calloc(1, key_len);
+	memcpy(q, key, key_len);
+	rsentry->key = q;
+	rsentry->hash = hash;
+	arc_list_push (cache_entry_link, list, index);
+	crlib_lookup_table_add(rsentry->key, rsentry->key_len, index);
+	(*store_api)(entry);
+	cache_count++;
+}
+
+static void arc_remove_entry(
+	int index,
+	int is_removed
+) {
+	ArcT_Entry* rsentry;
+
+	arc_list_unlink (cache_entry_link, index);
+	rsentry = &cache_entry_list[index];
+	crlib_lookup_table_remove(rsentry->key, rsentry->key_len);
+	if (!is_removed) (*remove_api)(rsentry->key, rsentry->key_len);
+
+	free(rsentry->key);
+	memset(rsentry, 0, sizeof(ArcT_Entry));
+	cache_count--;
+	empty_entry_list[cache_count] = index;
+}
+
+static void arc_replace(int in_b2) {
+	int t1_count = lists[ArcC_T1].count;
+	int index;
+	int ghost;
+
+	/* Removes the LRU entry of T1 if T1 exceeds the target, otherwise that of T2 	*/
+	if ((t1_count > 0) &&
+		((t1_count > t1_target) || (in_b2 && (t1_count == t1_target)) ||
+		 (lists[ArcC_T2].count == 0))) {
+		index = lists[ArcC_T1].lru;
+		ghost = ArcC_B1;
+	} else {
+		index = lists[ArcC_T2].lru;
+		ghost = ArcC_B2;
+	}
+	if (index < 0) {
+		return;
+	}
+	arc_ghost_add (ghost, cache_entry_list[index].hash);
+	arc_remove_entry (index, 0);
+}
+
+static void arc_ghost_add(int list, uint32_t hash) {
+	int gindex;
+	uint32_t bucket;
+
+	/* B1 and B2 remember as many entries as the capacity, B2 is cut first 	*/
+	if (ghost_count >= cache_cap) {
+		arc_ghost_remove ((lists[ArcC_B2].count > 0) ?
+							lists[ArcC_B2].lru : lists[ArcC_B1].lru);
+	}
+	gindex = empty_ghost_list[ghost_count];
+	ghost_count++;
+
+	bucket = hash & ghost_mask;
+	ghost_list[gindex].hash  = hash;
+	ghost_list[gindex].chain = ghost_bucket[bucket];
+	ghost_bucket[bucket] = gindex;
+	arc_list_push (ghost_link, list, gindex);
+}
+
+static void arc_ghost_remove(int gindex) {
+	int* pp = &ghost_bucket[ghost_list[gindex].hash & ghost_mask];
+
+	while (*pp != gindex) {
+		pp = &ghost_list[*pp].chain;
+	}
+	*pp = ghost_list[gindex].chain;
+	arc_list_unlink (ghost_link, gindex);
+	ghost_count--;
+	empty_ghost_list[ghost_count] = gindex;
+}
+
+static int arc_ghost_search(uint32_t hash) {
+	int gindex = ghost_bucket[hash & ghost_mask];
+
+	while ((gindex >= 0) && (ghost_list[gindex].hash != hash)) {
+		gindex = ghost_list[gindex].chain;
+	}
+	return gindex;
+}
+
+static void arc_list_push(ArcT_Link* links, int list, int index) {
+	ArcT_List* lp = &lists[list];
+
+	links[index].list = list;
+	links[index].prev = -1;
+	links[index].next = lp->mru;
+	if (lp->mru >= 0) {
+		links[lp->mru].prev = index;
+	} else {
+		lp->lru = index;
+	}
+	lp->mru = index;
+	lp->count++;
+}
+
+static void arc_list_unlink(ArcT_Link* links, int index) {
+	ArcT_List* lp = &lists[links[index].list];
+	int prev_idx = links[index].prev;
+	int next_idx = links[index].next;
+
+	if (prev_idx >= 0) {
+		links[prev_idx].next = next_idx;
+	} else {
+		lp->mru = next_idx;
+	}
+	if (next_idx >= 0) {
+		links[next_idx].prev = prev_idx;
+	} else {
+		lp->lru = prev_idx;
+	}
+	links[index].prev = -1;
+	links[index].next = -1;
+	lp->count--;
+}
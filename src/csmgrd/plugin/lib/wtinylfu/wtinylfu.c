@@ -0,0 +1,496 @@
+/*
+ * Copyright (c) 2016-2021, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * wtinylfu.c
+ */
+
+/*
+	wtinylfu.c is a W-TinyLFU implementation.
+
+	The new entries are listed in the small window LRU. The entry pushed out of
+	the window enters the probation segment of the main SLRU only when its
+	frequency estimated by the count-min sketch is higher than that of the
+	probation victim, otherwise it is removed. So the entries requested once,
+	e.g. by a scan, do not push out the entries requested frequently.
+	The entry hit in the probation segment is promoted to the protected segment.
+	The counters of the sketch are halved periodically, so that the frequency
+	follows the recent requests.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+#include "cache_replace_lib.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define WtlfuC_Window_Rate 		1		/* window size (% of the capacity)			*/
+#define WtlfuC_Protected_Rate 	80		/* protected size (% of the main SLRU)		*/
+
+#define WtlfuC_Sketch_Depth 	4		/* number of rows of the count-min sketch 	*/
+#define WtlfuC_Sketch_Min 		64		/* minimum number of counters in a row 		*/
+#define WtlfuC_Counter_Max 		15		/* counters are saturated at 4 bits 		*/
+#define WtlfuC_Sample_Rate 		10		/* counters are halved after this times 	*/
+										/* the capacity of increments 				*/
+
+#define WtlfuC_Window 			0
+#define WtlfuC_Probation 		1
+#define WtlfuC_Protected 		2
+#define WtlfuC_Queue_Num 		3
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/***** structure for listing content entries *****/
+typedef struct {
+	unsigned char 	*key;					/* key of content entry 					*/
+	int 			key_len;				/* length of key 							*/
+	uint32_t 		hash;					/* hash of the key for the sketch 			*/
+	int 			queue;					/* WtlfuC_Window, Probation or Protected	*/
+	int 			next;					/* towards the LRU side 					*/
+	int 			prev;					/* towards the MRU side 					*/
+} WtlfuT_Entry;
+
+/***** structure for the LRU list of a segment *****/
+typedef struct {
+	int 			mru;
+	int 			lru;
+	int 			count;					/* number of listed entries 				*/
+	int 			cap;					/* maximum number of listed entries 		*/
+} WtlfuT_Queue;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+
+/* pointers of functions which stores and removes the content entry into/from the cache */
+/* table (implementation of the functions are in a plugin which uses this library) 		*/
+static int (*store_api)(CsmgrdT_Content_Entry*);
+static void (*remove_api)(unsigned char*, int);
+
+static int              cache_count;        /* number of cache entries                  */
+static WtlfuT_Entry*    cache_entry_list;   /* list for cache entry                     */
+static int*             empty_entry_list;   /* list for empty cache entry               */
+static WtlfuT_Queue     queues[WtlfuC_Queue_Num];
+
+static uint8_t*         sketch;             /* count-min sketch (Depth rows)            */
+static uint32_t         sketch_mask;        /* number of counters in a row - 1          */
+static uint64_t         sketch_adds;        /* increments since the counters are halved */
+static uint64_t         sketch_sample;      /* increments to halve the counters         */
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static void wtlfu_store_entry(CsmgrdT_Content_Entry* entry, int index);
+static void wtlfu_remove_entry(int index, int is_removed);
+static void wtlfu_window_evict(void);
+static void wtlfu_queue_push(int queue, int index);
+static void wtlfu_queue_unlink(int index);
+static void wtlfu_sketch_increment(uint32_t hash);
+static int  wtlfu_sketch_estimate(uint32_t hash);
+static void wtlfu_sketch_reset(void);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+init (
+	int capacity, 							/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+	int (*store)(CsmgrdT_Content_Entry*), 	/* store a content entry API 				*/
+	void (*remove)(unsigned char*, int)		/* remove a content entry API 				*/
+) {
+	uint64_t width;
+	int i;
+
+	cache_count = 0;
+
+	/* Records the capacity of cache		*/
+	if (capacity < 1) {
+		fprintf (stderr, "[W-TinyLFU LIB] Invalid Cacacity\n");
+		return (-1);
+	}
+	cache_cap = capacity;
+
+	/* Records store and remove APIs 		*/
+	if ((store == NULL) || (remove == NULL)) {
+		fprintf (stderr, "[W-TinyLFU LIB] Not specified store or remove API\n");
+		return (-1);
+	}
+	store_api 	= store;
+	remove_api 	= remove;
+
+	/* Creates the entries 					*/
+	cache_entry_list = (WtlfuT_Entry*) calloc (cache_cap, sizeof (WtlfuT_Entry));
+	empty_entry_list = (int*) calloc (cache_cap, sizeof (int));
+
+	/* Creates the sketch whose row has the counters of the power of 2 	*/
+	/* not less than the capacity 										*/
+	for (width = WtlfuC_Sketch_Min ; width < (uint64_t) cache_cap ; width <<= 1) {
+		;
+	}
+	sketch = (uint8_t*) calloc (WtlfuC_Sketch_Depth * width, sizeof (uint8_t));
+
+	if ((cache_entry_list == NULL) || (empty_entry_list == NULL) || (sketch == NULL)) {
+		fprintf (stderr, "[W-TinyLFU LIB] Failed to allocate the entries\n");
+		free (cache_entry_list);
+		free (empty_entry_list);
+		free (sketch);
+		cache_entry_list = NULL;
+		empty_entry_list = NULL;
+		sketch = NULL;
+		return (-1);
+	}
+	for (i = 0; i < cache_cap; i++) {
+		empty_entry_list[i] = i;
+		cache_entry_list[i].next = -1;
+		cache_entry_list[i].prev = -1;
+	}
+	sketch_mask 	= (uint32_t)(width - 1);
+	sketch_adds 	= 0;
+	sketch_sample 	= (uint64_t) cache_cap * WtlfuC_Sample_Rate;
+
+	/* Divides the capacity into the window and the main SLRU 	*/
+	for (i = 0; i < WtlfuC_Queue_Num; i++) {
+		queues[i].mru 	= -1;
+		queues[i].lru 	= -1;
+		queues[i].count = 0;
+	}
+	queues[WtlfuC_Window].cap = (int)((uint64_t) cache_cap * WtlfuC_Window_Rate / 100);
+	if (queues[WtlfuC_Window].cap < 1) {
+		queues[WtlfuC_Window].cap = 1;
+	}
+	queues[WtlfuC_Protected].cap = (int)((uint64_t)(cache_cap - queues[WtlfuC_Window].cap)
+										* WtlfuC_Protected_Rate / 100);
+	queues[WtlfuC_Probation].cap =
+		cache_cap - queues[WtlfuC_Window].cap - queues[WtlfuC_Protected].cap;
+
+	/* Creates lookup table */
+	crlib_lookup_table_init(capacity);
+
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+void
+destroy (
+	void
+) {
+	int i;
+
+	if (cache_entry_list) {
+		for (i = 0; i < cache_cap; i++) {
+			if (cache_entry_list[i].key != NULL) {
+				free (cache_entry_list[i].key);
+			}
+		}
+		free (cache_entry_list);
+		cache_entry_list = NULL;
+		crlib_lookup_table_destroy();
+	}
+	free (empty_entry_list);
+	free (sketch);
+	empty_entry_list 	= NULL;
+	sketch 				= NULL;
+	cache_count 		= 0;
+	cache_cap 			= 0;
+	store_api 			= NULL;
+	remove_api 			= NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+	Insert API
+----------------------------------------------------------------------------------------*/
+void
+insert (
+	CsmgrdT_Content_Entry* entry			/* content entry 							*/
+) {
+	/* The new entry always enters the window, and the entry pushed out of 	*/
+	/* the window is compared with the probation victim 					*/
+	if (queues[WtlfuC_Window].count >= queues[WtlfuC_Window].cap) {
+		wtlfu_window_evict ();
+	}
+	if (cache_count >= cache_cap) {
+		/* The main SLRU is empty if the capacity is too small to split 	*/
+		wtlfu_remove_entry (queues[WtlfuC_Window].lru, 0);
+	}
+	wtlfu_store_entry (entry, empty_entry_list[cache_count]);
+}
+
+/*--------------------------------------------------------------------------------------
+	Erase API
+----------------------------------------------------------------------------------------*/
+void
+erase (
+	unsigned char* key, 					/* key of content entry removed from cache 	*/
+											/* table									*/
+	int key_len								/* length of the key 						*/
+) {
+	int index = crlib_lookup_table_search(key, key_len);
+	if (index < 0) {
+		fprintf (stderr, "[W-TinyLFU LIB] failed to erace\n");
+		return;
+	}
+	wtlfu_remove_entry (index, 1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Hit API
+----------------------------------------------------------------------------------------*/
+void
+hit (
+	unsigned char* key, 					/* key of the content entry hits in the 	*/
+											/* cache table 								*/
+	int key_len								/* length of the key 						*/
+) {
+	WtlfuT_Entry* rsentry;
+	int index = crlib_lookup_table_search(key, key_len);
+	int demote;
+
+	if (index < 0) {
+		/* The request is counted even if the entry is not listed 	*/
+		wtlfu_sketch_increment (crlib_xhash_get_str (key, key_len, 0));
+		return;
+	}
+	rsentry = &cache_entry_list[index];
+	wtlfu_sketch_increment (rsentry->hash);
+
+	wtlfu_queue_unlink (index);
+	if (rsentry->queue == WtlfuC_Probation) {
+		/* Promotes the entry, and the protected segment demotes its LRU entry 	*/
+		wtlfu_queue_push (WtlfuC_Protected, index);
+		if (queues[WtlfuC_Protected].count > queues[WtlfuC_Protected].cap) {
+			demote = queues[WtlfuC_Protected].lru;
+			wtlfu_queue_unlink (demote);
+			wtlfu_queue_push (WtlfuC_Probation, demote);
+		}
+	} else {
+		wtlfu_queue_push (rsentry->queue, index);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Miss API
+----------------------------------------------------------------------------------------*/
+void
+miss (
+	unsigned char* key, 					/* key of the content entry fails to hit 	*/
+											/* in the cache table						*/
+	int key_len								/* length of the key 						*/
+) {
+	/* The requests to the entry not cached are counted, so that the entry 	*/
+	/* is admitted when it is cached after the requests 					*/
+	wtlfu_sketch_increment (crlib_xhash_get_str (key, key_len, 0));
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Status API
+----------------------------------------------------------------------------------------*/
+void
+status (
+	void* arg								/* state information						*/
+) {
+	// TODO
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Static Functions
+----------------------------------------------------------------------------------------*/
+static void wtlfu_store_entry(
+	CsmgrdT_Content_Entry* entry,
+	int index
+) {
+	unsigned char 	key[CsmgrdC_Key_Max];
+	int 			key_len;
+	WtlfuT_Entry*   rsentry;
+	unsigned char* q;
+
+	key_len = csmgrd_name_chunknum_concatenate (
+					entry->name, entry->name_len, entry->chnk_num, key);
+	rsentry = &cache_entry_list[index];
+	rsentry->key_len = key_len;
+	q = calloc(1, key_len);
+	memcpy(q, key, key_len);
+	rsentry->key = q;
+	rsentry->hash = crlib_xhash_get_str (key, key_len, 0);
+	wtlfu_queue_push (WtlfuC_Window, index);
+	crlib_lookup_table_add(rsentry->key, rsentry->key_len, index);
+	(*store_api)(entry);
+	cache_count++;
+}
+
+static void wtlfu_remove_entry(
+	int index,
+	int is_removed
+) {
+	WtlfuT_Entry* rsentry;
+
+	wtlfu_queue_unlink (index);
+	rsentry = &cache_entry_list[index];
+	crlib_lookup_table_remove(rsentry->key, rsentry->key_len);
+	if (!is_removed) (*remove_api)(rsentry->key, rsentry->key_len);
+
+	free(rsentry->key);
+	memset(rsentry, 0, sizeof(WtlfuT_Entry));
+	rsentry->next = -1;
+	rsentry->prev = -1;
+	cache_count--;
+	empty_entry_list[cache_count] = index;
+}
+
+static void wtlfu_window_evict(void) {
+	int cand = queues[WtlfuC_Window].lru;
+	int victim;
+	int main_cap = queues[WtlfuC_Probation].cap + queues[WtlfuC_Protected].cap;
+
+	if (cand < 0 || main_cap < 1) {
+		return;
+	}
+
+	/* The candidate enters the main SLRU without the contest until it is full */
+	if (queues[WtlfuC_Probation].count + queues[WtlfuC_Protected].count < main_cap) {
+		wtlfu_queue_unlink (cand);
+		wtlfu_queue_push (WtlfuC_Probation, cand);
+		return;
+	}
+	victim = queues[WtlfuC_Probation].lru;
+	if (victim < 0) {
+		victim = queues[WtlfuC_Protected].lru;
+	}
+
+	/* The candidate is admitted only if it is requested more than the victim */
+	if (wtlfu_sketch_estimate (cache_entry_list[cand].hash) >
+			wtlfu_sketch_estimate (cache_entry_list[victim].hash)) {
+		wtlfu_remove_entry (victim, 0);
+		wtlfu_queue_unlink (cand);
+		wtlfu_queue_push (WtlfuC_Probation, cand);
+	} else {
+		wtlfu_remove_entry (cand, 0);
+	}
+}
+
+static void wtlfu_queue_push(int queue, int index) {
+	WtlfuT_Queue* qp = &queues[queue];
+
+	cache_entry_list[index].queue = queue;
+	cache_entry_list[index].prev = -1;
+	cache_entry_list[index].next = qp->mru;
+	if (qp->mru >= 0) {
+		cache_entry_list[qp->mru].prev = index;
+	} else {
+		qp->lru = index;
+	}
+	qp->mru = index;
+	qp->count++;
+}
+
+static void wtlfu_queue_unlink(int index) {
+	WtlfuT_Queue* qp = &queues[cache_entry_list[index].queue];
+	int prev_idx = cache_entry_list[index].prev;
+	int next_idx = cache_entry_list[index].next;
+
+	if (prev_idx >= 0) {
+		cache_entry_list[prev_idx].next = next_idx;
+	} else {
+		qp->mru = next_idx;
+	}
+	if (next_idx >= 0) {
+		cache_entry_list[next_idx].prev = prev_idx;
+	} else {
+		qp->lru = prev_idx;
+	}
+	cache_entry_list[index].prev = -1;
+	cache_entry_list[index].next = -1;
+	qp->count--;
+}
+
+static void wtlfu_sketch_increment(uint32_t hash) {
+	uint8_t* row;
+	int i;
+
+	for (i = 0; i < WtlfuC_Sketch_Depth; i++) {
+		row = &sketch[(uint64_t) i * (sketch_mask + 1)];
+		row += crlib_xhash_get (hash, i + 1) & sketch_mask;
+		if (*row < WtlfuC_Counter_Max) {
+			(*row)++;
+		}
+	}
+	sketch_adds++;
+	if (sketch_adds >= sketch_sample) {
+		wtlfu_sketch_reset ();
+	}
+}
+
+static int wtlfu_sketch_estimate(uint32_t hash) {
+	uint8_t val;
+	int min = WtlfuC_Counter_Max;
+	int i;
+
+	for (i = 0; i < WtlfuC_Sketch_Depth; i++) {
+		val = sketch[(uint64_t) i * (sketch_mask + 1) + (crlib_xhash_get (hash, i + 1) & sketch_mask)];
+		if (val < min) {
+			min = val;
+		}
+	}
+	return min;
+}
+
+static void wtlfu_sketch_reset(void) {
+	uint64_t n = (uint64_t) WtlfuC_Sketch_Depth * (sketch_mask + 1);
+	uint64_t i;
+
+	/* Ages the frequencies by halving all counters 	*/
+	for (i = 0; i < n; i++) {
+		sketch[i] >>= 1;
+	}
+	sketch_adds /= 2;
+}
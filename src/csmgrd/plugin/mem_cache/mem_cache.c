@@ -51,6 +51,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -61,6 +62,7 @@
 #include <cefore/cef_client.h>
 #include <cefore/cef_csmgr.h>
 #include <cefore/cef_frame.h>
+#include <cefore/cef_valid.h>
 #include <csmgrd/csmgrd_plugin.h>
 
 
@@ -83,6 +85,25 @@
 
 #define MemC_SEMNAME					"/cefmemsem"
 
+#define MemC_Expire_Heap_Init		1024		/* initial slots of the expiry heap		*/
+#define MemC_Expire_Batch			256			/* entries removed holding the lock		*/
+
+#define MemC_Slab_Page_Size			0x100000	/* 1MB page carved into the slots		*/
+#define MemC_Slab_Min_Slot			128			/* slot size of the smallest class		*/
+#define MemC_Slab_Class_Max			64
+#define MemC_Slab_Header_Size		64			/* MemT_Slab_Page rounded up			*/
+
+#define MemC_Chunk_Page_Bits		10
+#define MemC_Chunk_Page_Num			(1 << MemC_Chunk_Page_Bits)	/* chunks in a page		*/
+#define MemC_Chunk_Page_Min			8			/* slots of a new page, doubled up to	*/
+												/* MemC_Chunk_Page_Num					*/
+#define MemC_Chunk_Page_Bytes(n)	\
+	(sizeof (MemT_Chunk_Page) + sizeof (CsmgrdT_Content_Mem_Entry*) * ((n) - 1))
+#define MemC_Chunk_Dir_Max			0x10000		/* pages of a content (64M chunks)		*/
+
+#define MemC_Snapshot_Magic			"CEFMEMS2"
+#define MemC_Snapshot_Batch			256			/* Cobs restored holding the lock		*/
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
@@ -100,8 +121,58 @@ typedef struct {
 	struct in_addr	node;						/* Node address							*/
 
 	uint64_t		ins_time;					/* Insert time							*/
+	uint64_t		expire_idx;					/* position in the expiry heap			*/
+#ifndef CefC_Nwproc
+	struct MemT_Content_Rec*	rec;			/* content which holds the name			*/
+#endif // CefC_Nwproc
 } CsmgrdT_Content_Mem_Entry;
 
+/********** Page of a slab class (the slots follow the header) 	**********/
+typedef struct MemT_Slab_Page {
+	
+	struct MemT_Slab_Page*	prev;				/* pages of the class with free slots	*/
+	struct MemT_Slab_Page*	next;
+	void*			free_slot;					/* list of the freed slots				*/
+	uint32_t		class_id;
+	uint32_t		used;						/* slots in use							*/
+	uint32_t		carved;						/* slots handed out at least once		*/
+	
+} MemT_Slab_Page;
+
+typedef struct {
+	
+	uint32_t		slot_size;
+	uint32_t		slot_num;					/* slots in a page						*/
+	MemT_Slab_Page*	partial;					/* pages which have free slots			*/
+	uint64_t		page_num;
+	
+} MemT_Slab_Class;
+
+/********** Snapshot file, the records follow the header 	**********/
+typedef struct {
+	
+	char 			magic[8];
+	uint32_t 		rec_size;					/* to detect the other layout			*/
+	uint32_t 		reserved;
+	uint64_t 		saved_time;
+	
+} MemT_Snapshot_Header;
+
+typedef struct {
+	
+	uint32_t 		crc;						/* of the record following this field	*/
+	uint32_t 		chnk_num;
+	uint64_t 		cache_time;
+	uint64_t 		expiry;
+	uint64_t 		ins_time;
+	struct in_addr 	node;
+	uint16_t 		msg_len;
+	uint16_t 		name_len;
+	uint16_t 		pay_len;
+	uint16_t 		reserved[3];
+	
+} MemT_Snapshot_Rec;				/* the name and message follow, padded to 8 bytes 	*/
+
 typedef struct CefT_Mem_Hash_Cell {
 	
 	uint32_t 					hash;
@@ -115,8 +186,36 @@ typedef struct CefT_Mem_Hash_Cell {
 	struct CefT_Mem_Hash_Cell	*next;
 } CefT_Mem_Hash_Cell;
 
+#ifndef CefC_Nwproc
+/********** Chunks of a content indexed by the chunk number 	**********/
+typedef struct {
+	
+	uint32_t 					used;				/* chunks in the page			*/
+	uint32_t 					size;				/* slots allocated in chunk[]	*/
+	CsmgrdT_Content_Mem_Entry* 	chunk[1];			/* followed by the other slots	*/
+	
+} MemT_Chunk_Page;
+
+/********** Record of a content, keyed by the name in the hash table 	**********/
+typedef struct MemT_Content_Rec {
+	
+	struct MemT_Content_Rec*	next;
+	uint32_t 					hash;
+	uint32_t 					ref;				/* entries of the content		*/
+	unsigned char* 				name;
+	uint16_t 					name_len;
+	uint32_t 					page_max;
+	MemT_Chunk_Page** 			pages;				/* chunk number >> page bits	*/
+	
+} MemT_Content_Rec;
+#endif // CefC_Nwproc
+
 typedef struct CefT_Mem_Hash {
+#ifndef CefC_Nwproc
+	MemT_Content_Rec**		tbl;
+#else // CefC_Nwproc
 	CefT_Mem_Hash_Cell**	tbl;
+#endif // CefC_Nwproc
 	uint32_t 				tabl_max;
 	uint64_t 				elem_max;
 	uint64_t 				elem_num;
@@ -139,7 +238,18 @@ static CsmgrdT_Content_Entry* 	mem_proc_cob_buff[MemC_Max_Buff]		= {0};
 static int 						mem_proc_cob_buff_idx[MemC_Max_Buff] 	= {0};
 static CsmgrT_Stat_Handle 		csmgr_stat_hdl;
 
-static pthread_mutex_t 			mem_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* The gets share the read lock, and the library keeps its lists under mem_algo_mutex 	*/
+static pthread_rwlock_t 		mem_cs_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t 			mem_algo_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/********** Entries in the order of the time to be expired 	**********/
+static CsmgrdT_Content_Mem_Entry** 	mem_expire_heap = NULL;
+static uint64_t 				mem_expire_num = 0;
+static uint64_t 				mem_expire_max = 0;
+
+/********** Slab classes which hold the entry, name and message together 	**********/
+static MemT_Slab_Class 			mem_slab_class[MemC_Slab_Class_Max];
+static int 						mem_slab_class_num = 0;
 
 #ifdef CefC_Ccore
 static uint64_t 				ORG_cache_capacity = 0;
@@ -179,6 +289,16 @@ mem_cache_item_get (
 	uint32_t seqno,								/* chunk num							*/
 	int sock									/* received socket						*/
 );
+/*--------------------------------------------------------------------------------------
+	Removes the expired entry which the get found under the read lock
+----------------------------------------------------------------------------------------*/
+static void
+mem_cache_expired_remove (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seqno,								/* chunk num							*/
+	uint64_t nowt								/* time when the get found it			*/
+);
 /*--------------------------------------------------------------------------------------
 	Upload content byte steream
 ----------------------------------------------------------------------------------------*/
@@ -268,6 +388,10 @@ static CefT_Mem_Hash*
 cef_mem_hash_tbl_create (
 	uint64_t table_size
 );
+static void 
+cef_mem_hash_tbl_destroy (
+	void
+);
 static uint32_t
 cef_mem_hash_number_create (
 	const unsigned char* key,
@@ -298,6 +422,127 @@ cef_mem_hash_tbl_item_remove (
 	const unsigned char* key,
 	uint32_t klen
 );
+#ifndef CefC_Nwproc
+static int 
+mem_key_split (
+	const unsigned char* key,
+	uint32_t klen,
+	uint32_t* chunk_num
+);
+static MemT_Content_Rec* 
+mem_content_rec_get (
+	const unsigned char* name,
+	uint16_t name_len,
+	int create_f
+);
+static void 
+mem_content_rec_release (
+	MemT_Content_Rec* rec
+);
+static MemT_Chunk_Page* 
+mem_chunk_page_get (
+	MemT_Content_Rec* rec,
+	uint32_t chunk_num
+);
+static CsmgrdT_Content_Mem_Entry* 
+mem_chunk_entry_get (
+	MemT_Content_Rec* rec,
+	uint32_t chunk_num
+);
+static uint32_t 
+mem_chunk_page_slots (
+	uint32_t cidx
+);
+#endif // CefC_Nwproc
+
+/*--------------------------------------------------------------------------------------
+	Expiry heap APIs for Memory Cahce Plugin
+----------------------------------------------------------------------------------------*/
+static int 
+mem_expire_heap_reserve (
+	void
+);
+static void 
+mem_expire_heap_push (
+	CsmgrdT_Content_Mem_Entry* entry
+);
+static void 
+mem_expire_heap_replace (
+	CsmgrdT_Content_Mem_Entry* old_entry,
+	CsmgrdT_Content_Mem_Entry* entry
+);
+static void 
+mem_expire_heap_remove (
+	CsmgrdT_Content_Mem_Entry* entry
+);
+static void 
+mem_expire_heap_sift (
+	uint64_t idx
+);
+static uint64_t 
+mem_expire_time_get (
+	CsmgrdT_Content_Mem_Entry* entry
+);
+
+/*--------------------------------------------------------------------------------------
+	Slab APIs for Memory Cahce Plugin
+----------------------------------------------------------------------------------------*/
+static void 
+mem_slab_init (
+	void
+);
+static int 
+mem_slab_class_get (
+	uint32_t size
+);
+static void* 
+mem_slab_alloc (
+	uint32_t size
+);
+static void 
+mem_slab_free (
+	void* slot
+);
+static uint32_t 
+mem_entry_size (
+	CsmgrdT_Content_Entry* cob
+);
+static uint32_t 
+mem_entry_index_size (
+	CsmgrdT_Content_Entry* cob
+);
+static CsmgrdT_Content_Mem_Entry* 
+mem_entry_create (
+	CsmgrdT_Content_Entry* cob
+);
+static void 
+mem_entry_free (
+	CsmgrdT_Content_Mem_Entry* entry
+);
+static void 
+mem_entry_erase (
+	CsmgrdT_Content_Mem_Entry* entry
+);
+static void 
+mem_entries_free (
+	void
+);
+static void 
+mem_cache_bytes_reserve (
+	CsmgrdT_Content_Entry* cob
+);
+
+/*--------------------------------------------------------------------------------------
+	Snapshot APIs for Memory Cahce Plugin
+----------------------------------------------------------------------------------------*/
+static void 
+mem_snapshot_save (
+	void
+);
+static void 
+mem_snapshot_load (
+	void
+);
 
 int
 csmgrd_key_create_by_Mem_Entry (
@@ -389,6 +634,9 @@ mem_cs_create (
 	hdl->algo_name_size = conf_param.algo_name_size;
 	hdl->algo_cob_size = conf_param.algo_cob_size;
 	hdl->cache_cobs = 0;
+	hdl->cache_capacity_bytes = conf_param.cache_capacity_bytes;
+	strcpy (hdl->snapshot_path, conf_param.snapshot_path);
+	mem_slab_init ();
 	
 	/* Check for excessive or insufficient memory resources for cache algorithm library */
 	if (strcmp (hdl->algo_name, "None") != 0) {
@@ -459,6 +707,15 @@ mem_cs_create (
 	
 	csmgrd_log_write (CefC_Log_Info, "Start\n");
 	csmgrd_log_write (CefC_Log_Info, "Cache Capacity : "FMTU64"\n", hdl->cache_capacity);
+	if (hdl->cache_capacity_bytes) {
+		csmgrd_log_write (CefC_Log_Info, 
+			"Cache Capacity : "FMTU64" bytes\n", hdl->cache_capacity_bytes);
+		if (hdl->algo_lib) {
+			csmgrd_log_write (CefC_Log_Info, 
+				"The Cobs to be expired first are removed to keep the bytes, "
+				"not by the cache algorithm\n");
+		}
+	}
 	if (strcmp (conf_param.algo_name, "None")) {
 		csmgrd_log_write (CefC_Log_Info, "Library  : %s ... OK\n", hdl->algo_name);
 	} else {
@@ -478,6 +735,9 @@ mem_cs_create (
 	csmgr_stat_hdl = stat_hdl;
 	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
 	
+	/* Restores the Cobs cached before csmgrd stopped 	*/
+	mem_snapshot_load ();
+	
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
@@ -502,9 +762,9 @@ mem_cob_process_thread (
 				csmgrd_dbg_write (CefC_Dbg_Fine, 
 					"cob put thread starts to write %d cobs\n", mem_proc_cob_buff_idx[i]);
 #endif // CefC_Debug
-				pthread_mutex_lock (&mem_cs_mutex);
+				pthread_rwlock_wrlock (&mem_cs_rwlock);
 				mem_cache_cob_write (&mem_proc_cob_buff[i][0], mem_proc_cob_buff_idx[i]);
-				pthread_mutex_unlock (&mem_cs_mutex);
+				pthread_rwlock_unlock (&mem_cs_rwlock);
 				mem_proc_cob_buff_idx[i] = 0;
 				if (i >= MemC_Min_Buff) {
 					free (mem_proc_cob_buff[i]);
@@ -541,29 +801,15 @@ mem_cs_store (
 	key_len = csmgrd_key_create (new_entry, key);
 	
 	/* Creates the entry 		*/
-	entry = 
-		(CsmgrdT_Content_Mem_Entry*) calloc (1, sizeof (CsmgrdT_Content_Mem_Entry));
+	entry = mem_entry_create (new_entry);
 	if (entry == NULL) {
 		return (-1);
 	}
 	
 	/* Inserts the cache entry 		*/
-	entry->msg 		= new_entry->msg;
-	entry->msg_len	= new_entry->msg_len;
-	entry->name		= new_entry->name;
-	entry->name_len = new_entry->name_len;
-	entry->pay_len		 = new_entry->pay_len;
-	entry->chnk_num		 = new_entry->chnk_num;
-	entry->cache_time	 = new_entry->cache_time;
-	entry->expiry		 = new_entry->expiry;
-	entry->node			 = new_entry->node;
-	entry->ins_time		 = new_entry->ins_time;
-	
 	if (cef_mem_hash_tbl_item_set (
 		key, key_len, entry, &old_entry) < 0) {
-		free (entry->msg);
-		free (entry->name);
-		free (entry);
+		mem_entry_free (entry);
 		return (-1);
 	}
 	
@@ -575,9 +821,7 @@ mem_cs_store (
 		entry->chnk_num, entry->pay_len, entry->expiry, nowt, entry->node);
 	
 	if (old_entry) {
-		free (old_entry->msg);
-		free (old_entry->name);
-		free (old_entry);
+		mem_entry_free (old_entry);
 	} else {
 		hdl->cache_cobs++;
 	}	
@@ -601,9 +845,7 @@ mem_cs_remove (
 		csmgrd_stat_cob_remove (
 			csmgr_stat_hdl, entry->name, entry->name_len, 
 			entry->chnk_num, entry->pay_len);
-		free (entry->msg);
-		free (entry->name);
-		free (entry);
+		mem_entry_free (entry);
 		hdl->cache_cobs--;
 	}
 	
@@ -620,7 +862,8 @@ mem_cs_destroy (
 	int i;
 	void* status;
 
-	pthread_mutex_destroy (&mem_cs_mutex);
+	pthread_rwlock_destroy (&mem_cs_rwlock);
+	pthread_mutex_destroy (&mem_algo_mutex);
 	
 	if (mem_thread_f) {
 		mem_thread_f = 0;
@@ -640,21 +883,17 @@ mem_cs_destroy (
 	if (hdl == NULL) {
 		return;
 	}
+	mem_snapshot_save ();
 	if (mem_hash_tbl) {
-		for (i = 0 ; i < mem_hash_tbl->tabl_max ; i++) {
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[i];
-			while (cp != NULL) {
-				wcp = cp->next;
-				free (cp->elem);
-				free (cp);
-				cp = wcp;
-			}
-		}
-		free (mem_hash_tbl->tbl);
-		free (mem_hash_tbl);
+		mem_entries_free ();
+		cef_mem_hash_tbl_destroy ();
+	}
+	if (mem_expire_heap) {
+		free (mem_expire_heap);
+		mem_expire_heap = NULL;
 	}
+	mem_expire_num = 0;
+	mem_expire_max = 0;
 	
 	if (hdl->algo_lib) {
 		if (hdl->algo_apis.destroy) {
@@ -679,51 +918,33 @@ mem_cs_expire_check (
 	void
 ) {
 	CsmgrdT_Content_Mem_Entry* entry = NULL;
-	CsmgrdT_Content_Mem_Entry* entry1 = NULL;
 	uint64_t 	nowt;
 	struct timeval tv;
 	int n;
-	unsigned char trg_key[65535];
-	int trg_key_len;
-	
-	if (pthread_mutex_trylock (&mem_cs_mutex) != 0) {
-		return;
-	}
 	
-	gettimeofday (&tv, NULL);
-	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
-
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) { 
-		if (mem_hash_tbl->tbl[n] == NULL) {
-			continue;
-		}
-		{
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[n];
-			for (; cp != NULL; cp = wcp) {
-				entry = cp->elem;
-				wcp = cp->next;
-				if ((entry->cache_time < nowt) ||
-					((entry->expiry != 0) && (entry->expiry < nowt))) {
-					/* Removes the expiry cache entry 		*/
-					trg_key_len = csmgrd_key_create_by_Mem_Entry (entry, trg_key);
-					entry1 = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
-					if (hdl->algo_apis.erase) {
-						(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
-					}
-					hdl->cache_cobs--;
-					csmgrd_stat_cob_remove (
-						csmgr_stat_hdl, entry->name, entry->name_len, 
-						entry->chnk_num, entry->pay_len);
-					free (entry1->msg);
-					free (entry1->name);
-					free (entry1);
-				}
+	/* Removes the entries from the one to be expired first, and releases 	*/
+	/* the lock after each batch so that the gets do not wait for long 		*/
+	do {
+		pthread_rwlock_wrlock (&mem_cs_rwlock);
+		
+		gettimeofday (&tv, NULL);
+		nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+		
+		for (n = 0 ; n < MemC_Expire_Batch ; n++) {
+			if (mem_expire_num == 0) {
+				break;
+			}
+			entry = mem_expire_heap[0];
+			if (mem_expire_time_get (entry) >= nowt) {
+				break;
 			}
+			
+			/* Removes the expiry cache entry 		*/
+			mem_entry_erase (entry);
 		}
-	}
-	pthread_mutex_unlock (&mem_cs_mutex);
+		pthread_rwlock_unlock (&mem_cs_rwlock);
+		
+	} while (n == MemC_Expire_Batch);
 	
 	return;
 }
@@ -749,10 +970,22 @@ mem_cache_item_get (
 #endif // CefC_Nwproc
 	CsmgrdT_Content_Mem_Entry** entry_p = NULL;
 	int exist_f = CefC_Csmgr_Cob_NotExist;
+	int expired_f = 0;
+#ifndef CefC_Nwproc
+	unsigned char 	msg[CefC_Max_Length];
+	int 			msg_len = 0;
+#endif // CefC_Nwproc
 
 	/* Creates the key 		*/
 	trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
 	
+	/* csmgrd workers look up the entries at the same time under the read lock, 	*/
+	/* and the expired entry is removed under the write lock after it 			*/
+	pthread_rwlock_rdlock (&mem_cs_rwlock);
+	
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	
 	/* Access the specified entry 	*/
 #ifndef CefC_Nwproc
 	entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
@@ -766,55 +999,99 @@ mem_cache_item_get (
 		trg_key_len = csmgrd_name_chunknum_concatenate (entry->name, entry->name_len, seqno, trg_key);
 #endif // CefC_Nwproc
 		
-		gettimeofday (&tv, NULL);
-		nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
-		
 		if (((entry->expiry == 0) || (nowt < entry->expiry)) &&
 			(nowt < entry->cache_time)) {
-			pthread_mutex_lock (&mem_cs_mutex);
 			if (hdl->algo_apis.hit) {
+				pthread_mutex_lock (&mem_algo_mutex);
 				(*(hdl->algo_apis.hit))(trg_key, trg_key_len);
+				pthread_mutex_unlock (&mem_algo_mutex);
 			}
 			
 			csmgrd_stat_access_count_update (
 					csmgr_stat_hdl, entry->name, entry->name_len);
 			
+#ifndef CefC_Nwproc
+			/* Sends the copy after the lock is released 	*/
+			msg_len = entry->msg_len;
+			memcpy (msg, entry->msg, msg_len);
+#else // CefC_Nwproc
 			/* Send Cob to cefnetd */
 			csmgrd_plugin_cob_msg_send (sock, entry->msg, entry->msg_len);
+#endif // CefC_Nwproc
 			exist_f = CefC_Csmgr_Cob_Exist;
-			pthread_mutex_unlock (&mem_cs_mutex);
  		}
 		else {
-			pthread_mutex_lock (&mem_cs_mutex);
-			/* Removes the expiry cache entry 		*/
-			entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
-			
-			if (hdl->algo_apis.erase) {
-				(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
-			}
-			hdl->cache_cobs--;
-			
-			csmgrd_stat_cob_remove (
-				csmgr_stat_hdl, entry->name, entry->name_len, 
-				entry->chnk_num, entry->pay_len);
-			
-			free (entry->msg);
-			free (entry->name);
-			free (entry);
-			pthread_mutex_unlock (&mem_cs_mutex);
+			expired_f = 1;
 		}
 	}
+	/* Reports the miss, so that the library counts the requests to the Cob 	*/
+	if ((exist_f != CefC_Csmgr_Cob_Exist) && (hdl->algo_apis.miss)) {
+		pthread_mutex_lock (&mem_algo_mutex);
+		(*(hdl->algo_apis.miss))(trg_key, trg_key_len);
+		pthread_mutex_unlock (&mem_algo_mutex);
+	}
+	pthread_rwlock_unlock (&mem_cs_rwlock);
 	
+#ifndef CefC_Nwproc
+	if (exist_f == CefC_Csmgr_Cob_Exist) {
+		/* Send Cob to cefnetd */
+		csmgrd_plugin_cob_msg_send (sock, msg, (uint16_t) msg_len);
+	}
+#endif // CefC_Nwproc
+	if (expired_f) {
+		mem_cache_expired_remove (key, key_size, seqno, nowt);
+	}
 	if (entry_p != NULL) {
 		free (entry_p);
 	}
 	return (exist_f);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the expired entry which the get found under the read lock
+----------------------------------------------------------------------------------------*/
+static void
+mem_cache_expired_remove (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seqno,								/* chunk num							*/
+	uint64_t nowt								/* time when the get found it			*/
+) {
+	CsmgrdT_Content_Mem_Entry* entry;
+	unsigned char 	trg_key[CsmgrdC_Key_Max];
+	int 			trg_key_len;
+#ifdef CefC_Nwproc
+	CsmgrdT_Content_Mem_Entry** entry_p;
+	int target_num = 0;
+	int i;
+#endif // CefC_Nwproc
 	
-	if (hdl->algo_apis.miss) {
-		(*(hdl->algo_apis.miss))(trg_key, trg_key_len);
+	trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
+	
+	/* The entry may have been removed or replaced while the lock was released 	*/
+	pthread_rwlock_wrlock (&mem_cs_rwlock);
+#ifndef CefC_Nwproc
+	entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
+	if ((entry) &&
+		(((entry->expiry != 0) && (nowt >= entry->expiry)) ||
+		 (nowt >= entry->cache_time))) {
+		mem_entry_erase (entry);
+	}
+#else // CefC_Nwproc
+	entry_p = cef_mem_hash_tbl_item_gets (trg_key, trg_key_len, &target_num);
+	for (i = 0 ; i < target_num ; i++) {
+		entry = entry_p[i];
+		if (((entry->expiry != 0) && (nowt >= entry->expiry)) ||
+			(nowt >= entry->cache_time)) {
+			mem_entry_erase (entry);
+		}
+	}
+	if (entry_p != NULL) {
+		free (entry_p);
 	}
+#endif // CefC_Nwproc
+	pthread_rwlock_unlock (&mem_cs_rwlock);
 	
-	return (CefC_Csmgr_Cob_NotExist);
+	return;
 }
 /*--------------------------------------------------------------------------------------
 	Upload content byte steream
@@ -931,6 +1208,8 @@ mem_cache_cob_write (
 			trg_key_len = csmgrd_key_create (&cobs[index], trg_key);
 			entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
 			if (entry == NULL) {
+				/* Makes room in the capacity in bytes for the Cob 	*/
+				mem_cache_bytes_reserve (&cobs[index]);
 				(*(hdl->algo_apis.insert))(&cobs[index]);
 			}
 		} else {
@@ -940,36 +1219,25 @@ mem_cache_cob_write (
 				index++;
 				continue;
 			}
-			/* Caches the content entry without the cache algorithm library 	*/
-			entry = 
-				(CsmgrdT_Content_Mem_Entry*) calloc (1, sizeof (CsmgrdT_Content_Mem_Entry));
-			if (entry == NULL) {
-				return (-1);
-			}
-			
 			/* Creates the key 				*/
 			trg_key_len = csmgrd_name_chunknum_concatenate (
 							cobs[index].name, cobs[index].name_len, 
 							cobs[index].chnk_num, trg_key);
 			
-			/* Inserts the cache entry 		*/
-			entry->msg		= cobs[index].msg;
-			entry->msg_len	= cobs[index].msg_len;
-			entry->name		= cobs[index].name;
-			entry->name_len	= cobs[index].name_len;
-			entry->pay_len		 = cobs[index].pay_len;
-			entry->chnk_num		 = cobs[index].chnk_num;
-			entry->cache_time	 = cobs[index].cache_time;
-			entry->expiry		 = cobs[index].expiry;
-			entry->node			 = cobs[index].node;
-			entry->ins_time		 = cobs[index].ins_time;
+			/* Caches the content entry without the cache algorithm library 	*/
+			mem_cache_bytes_reserve (&cobs[index]);
+			entry = mem_entry_create (&cobs[index]);
+			if (entry == NULL) {
+				index++;
+				continue;
+			}
 			
+			/* Inserts the cache entry 		*/
 			if (cef_mem_hash_tbl_item_set (
 				trg_key, trg_key_len, entry, &old_entry) < 0) {
-				free (entry->msg);
-				free (entry->name);
-				free (entry);
-				return (-1);
+				mem_entry_free (entry);
+				index++;
+				continue;
 			}
 			
 			/* Updates the content information 			*/
@@ -977,9 +1245,7 @@ mem_cache_cob_write (
 				entry->chnk_num, entry->pay_len, entry->expiry, nowt, entry->node);
 			
 			if (old_entry) {
-				free (old_entry->msg);
-				free (old_entry->name);
-				free (old_entry);
+				mem_entry_free (old_entry);
 			} else {
 				hdl->cache_cobs++;
 			}
@@ -1000,19 +1266,20 @@ mem_cs_ac_cnt_inc (
 ) {
 	CsmgrdT_Content_Mem_Entry* entry;
 	
+	pthread_rwlock_rdlock (&mem_cs_rwlock);
 	entry = cef_mem_hash_tbl_item_get (key, key_size);
 	if (!entry) {
+		pthread_rwlock_unlock (&mem_cs_rwlock);
 		return;
 	}
-	
-	pthread_mutex_lock (&mem_cs_mutex);
 	if (hdl->algo_apis.hit) {
+		pthread_mutex_lock (&mem_algo_mutex);
 		(*(hdl->algo_apis.hit))(key, key_size);
+		pthread_mutex_unlock (&mem_algo_mutex);
 	}
-	pthread_mutex_unlock (&mem_cs_mutex);
-	
 	csmgrd_stat_access_count_update (
 			csmgr_stat_hdl, entry->name, entry->name_len);
+	pthread_rwlock_unlock (&mem_cs_rwlock);
 	
 	return;
 }
@@ -1116,6 +1383,27 @@ mem_config_read (
 				fclose (fp);
 				return (-1);
 			}
+		} else if (strcmp (option, "CACHE_CAPACITY_BYTES") == 0) {
+			char *endptr = "";
+			params->cache_capacity_bytes = strtoull (value, &endptr, 0);
+			if ((strcmp (endptr, "") != 0) || 
+				((params->cache_capacity_bytes != 0) && 
+				 (params->cache_capacity_bytes < MemC_Slab_Page_Size))) {
+				csmgrd_log_write (CefC_Log_Error, 
+				"CACHE_CAPACITY_BYTES must be 0 or higher than or equal to %d.\n", 
+					MemC_Slab_Page_Size);
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "CACHE_SNAPSHOT") == 0) {
+			if (strlen (value) >= sizeof (params->snapshot_path)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_SNAPSHOT must be shorter than %d characters.\n", 
+					(int) sizeof (params->snapshot_path));
+				fclose (fp);
+				return (-1);
+			}
+			strcpy (params->snapshot_path, value);
 		} else {
 			/* NOP */;
 		}
@@ -1197,19 +1485,8 @@ mem_change_cap (
 	hdl->cache_cobs = 0; 
 	
 	/* Destroy table */
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
-		CefT_Mem_Hash_Cell* cp;
-		CefT_Mem_Hash_Cell* wcp;
-		cp = mem_hash_tbl->tbl[n];
-		while (cp != NULL) {
-			wcp = cp->next;
-			free (cp->elem);
-			free (cp);
-			cp = wcp;
-		}
-	}
-	free (mem_hash_tbl->tbl);
-	free (mem_hash_tbl);
+	mem_entries_free ();
+	cef_mem_hash_tbl_destroy ();
 	
 	/* Creates the memory cache 		*/
 	mem_hash_tbl = cef_mem_hash_tbl_create (hdl->cache_capacity);
@@ -1243,6 +1520,11 @@ mem_cache_set_lifetime (
 	struct timeval tv;
 	uint64_t new_life;
 	int n;
+#ifndef CefC_Nwproc
+	MemT_Content_Rec* rec;
+	MemT_Chunk_Page* page;
+	uint32_t i, k;
+#endif // CefC_Nwproc
 	
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
@@ -1252,6 +1534,34 @@ mem_cache_set_lifetime (
 	csmgrd_stat_content_lifetime_update (csmgr_stat_hdl, name, name_len, new_life);
 	
 	/* Check the cache entry information */
+#ifndef CefC_Nwproc
+	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
+		for (rec = mem_hash_tbl->tbl[n] ; rec != NULL ; rec = rec->next) {
+			/* The name is compared once for all chunks of the content 	*/
+			if ((rec->name_len < name_len) || 
+				(memcmp (name, rec->name, name_len))) {
+				continue;
+			}
+			for (i = 0 ; i < rec->page_max ; i++) {
+				page = rec->pages[i];
+				if (page == NULL) {
+					continue;
+				}
+				for (k = 0 ; k < page->size ; k++) {
+					entry = page->chunk[k];
+					if ((entry == NULL) ||
+						((entry->expiry != 0) && (nowt >= entry->expiry)) ||
+						(nowt >= entry->cache_time)) {
+						continue;
+					}
+					entry->expiry = new_life;
+					entry->cache_time = new_life;
+					mem_expire_heap_sift (entry->expire_idx);
+				}
+			}
+		}
+	}
+#else // CefC_Nwproc
 	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
 		if (mem_hash_tbl->tbl[n] == NULL) {
 			continue;
@@ -1269,10 +1579,12 @@ mem_cache_set_lifetime (
 					}
 					entry->expiry = new_life;
 					entry->cache_time = new_life;
+					mem_expire_heap_sift (entry->expire_idx);
 				}
 			}
 		}
 	}
+#endif // CefC_Nwproc
 	
 	return (0);
 }
@@ -1289,7 +1601,7 @@ mem_cache_del (
 	unsigned char 	trg_key[CsmgrdC_Key_Max];
 	int 			trg_key_len;
 	
-	pthread_mutex_lock (&mem_cs_mutex);
+	pthread_rwlock_wrlock (&mem_cs_rwlock);
 	/* Creates the key 				*/
 	trg_key_len = csmgrd_name_chunknum_concatenate (
 					name, name_len, chunk_num, trg_key);
@@ -1297,7 +1609,7 @@ mem_cache_del (
 	/* Removes the cache entry 		*/
 	entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
 	if (entry == NULL) {
-		pthread_mutex_unlock (&mem_cs_mutex);
+		pthread_rwlock_unlock (&mem_cs_rwlock);
 		return (0);
 	}
 	
@@ -1310,10 +1622,8 @@ mem_cache_del (
 		csmgr_stat_hdl, entry->name, entry->name_len, 
 		entry->chnk_num, entry->pay_len);
 	
-	free (entry->msg);
-	free (entry->name);
-	free (entry);
-	pthread_mutex_unlock (&mem_cs_mutex);
+	mem_entry_free (entry);
+	pthread_rwlock_unlock (&mem_cs_rwlock);
 
 	return (0);
 }
@@ -1342,8 +1652,12 @@ mem_cache_lifetime_get (
 	
 	if (partial_f != 0) {
 		uint64_t idx;
+#ifndef CefC_Nwproc
+		MemT_Content_Rec* rec;
+#else // CefC_Nwproc
 		unsigned char trg_key[65535];
 		int trg_key_len;
+#endif // CefC_Nwproc
 		uint64_t oldest_ins_time;
 		uint64_t first_expire;
 		
@@ -1355,9 +1669,20 @@ mem_cache_lifetime_get (
 		oldest_ins_time = nowt;
 		first_expire = UINT64_MAX;
 		
+#ifndef CefC_Nwproc
+		/* Looks up the content once, then its chunks by the number 	*/
+		rec = mem_content_rec_get (name, name_len, 0);
+		if (rec == NULL) {
+			return (-1);
+		}
+#endif // CefC_Nwproc
 		for (idx = rcd->min_seq; idx <= rcd->max_seq; idx++) {
+#ifndef CefC_Nwproc
+			entry = mem_chunk_entry_get (rec, (uint32_t) idx);
+#else // CefC_Nwproc
 			trg_key_len = csmgrd_name_chunknum_concatenate (name, name_len, idx, trg_key);
 			entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
+#endif // CefC_Nwproc
 			if (!entry) {
 				continue;
 			}
@@ -1427,14 +1752,14 @@ cef_mem_hash_tbl_create (
 	}
 	memset (ht, 0, sizeof (CefT_Mem_Hash));
 	
-	ht->tbl = (CefT_Mem_Hash_Cell**) calloc (sizeof (CefT_Mem_Hash_Cell*), table_size);
+	ht->tbl = calloc (sizeof (ht->tbl[0]), table_size);
 	
 	if (ht->tbl  == NULL) {
 		free (ht->tbl);
 		free (ht);
 		return (NULL);
 	}
-	memset (ht->tbl, 0, sizeof (CefT_Mem_Hash_Cell*) * table_size);
+	memset (ht->tbl, 0, sizeof (ht->tbl[0]) * table_size);
 	
 	srand ((unsigned) time (NULL));
 	ht->elem_max = capacity;
@@ -1445,62 +1770,278 @@ cef_mem_hash_tbl_create (
 	return (ht);
 }	
 
-#ifndef CefC_Nwproc
-static int 
-cef_mem_hash_tbl_item_set (
-	const unsigned char* key,
-	uint32_t klen,
-	CsmgrdT_Content_Mem_Entry* elem, 
-	CsmgrdT_Content_Mem_Entry** old_elem
+/*--------------------------------------------------------------------------------------
+	Frees the hash table, whose entries have been freed already
+----------------------------------------------------------------------------------------*/
+static void 
+cef_mem_hash_tbl_destroy (
+	void
 ) {
 	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
-	uint32_t y;
+#ifndef CefC_Nwproc
+	MemT_Content_Rec* rec;
+#else // CefC_Nwproc
 	CefT_Mem_Hash_Cell* cp;
 	CefT_Mem_Hash_Cell* wcp;
-	*old_elem = NULL;
+#endif // CefC_Nwproc
+	uint32_t i;
+	
+	if (ht == NULL) {
+		return;
+	}
+	for (i = 0 ; i < ht->tabl_max ; i++) {
+#ifndef CefC_Nwproc
+		while ((rec = ht->tbl[i]) != NULL) {
+			rec->ref = 1;
+			mem_content_rec_release (rec);
+		}
+#else // CefC_Nwproc
+		cp = ht->tbl[i];
+		while (cp != NULL) {
+			wcp = cp->next;
+			hdl->cache_bytes -= sizeof (CefT_Mem_Hash_Cell) + cp->klen;
+			free (cp);
+			cp = wcp;
+		}
+#endif // CefC_Nwproc
+	}
+	free (ht->tbl);
+	free (ht);
+	mem_hash_tbl = NULL;
+	
+	return;
+}
 
-	hash = cef_mem_hash_number_create (key, klen);
+#ifndef CefC_Nwproc
+/*--------------------------------------------------------------------------------------
+	Splits the key into the content name and the chunk number
+----------------------------------------------------------------------------------------*/
+static int							/* length of the name, or -1 if the key has no chunk */
+mem_key_split (
+	const unsigned char* key,
+	uint32_t klen,
+	uint32_t* chunk_num
+) {
+	uint32_t value32;
+	
+	if ((klen < 8) || (klen > MemC_Max_KLen) ||
+		(key[klen - 8] != 0x00) || (key[klen - 7] != 0x10) ||
+		(key[klen - 6] != 0x00) || (key[klen - 5] != 0x04)) {
+		return (-1);
+	}
+	memcpy (&value32, &key[klen - 4], sizeof (uint32_t));
+	*chunk_num = ntohl (value32);
+	
+	return ((int)(klen - 8));
+}
+/*--------------------------------------------------------------------------------------
+	Looks up the record of the content
+----------------------------------------------------------------------------------------*/
+static MemT_Content_Rec* 
+mem_content_rec_get (
+	const unsigned char* name,
+	uint16_t name_len,
+	int create_f								/* 1: creates the record if not found	*/
+) {
+	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
+	MemT_Content_Rec* rec;
+	uint32_t hash;
+	uint32_t y;
+	
+	if (ht == NULL) {
+		return (NULL);
+	}
+	hash = cef_mem_hash_number_create (name, name_len);
 	y = hash % ht->tabl_max;
+	
+	for (rec = ht->tbl[y] ; rec != NULL ; rec = rec->next) {
+		if ((rec->hash == hash) && (rec->name_len == name_len) &&
+			(memcmp (rec->name, name, name_len) == 0)) {
+			return (rec);
+		}
+	}
+	if (create_f == 0) {
+		return (NULL);
+	}
+	
+	rec = (MemT_Content_Rec*) calloc (1, sizeof (MemT_Content_Rec) + name_len);
+	if (rec == NULL) {
+		return (NULL);
+	}
+	rec->name = (unsigned char*)(rec + 1);
+	memcpy (rec->name, name, name_len);
+	rec->name_len = name_len;
+	rec->hash = hash;
+	rec->next = ht->tbl[y];
+	ht->tbl[y] = rec;
+	hdl->cache_bytes += sizeof (MemT_Content_Rec) + name_len;
+	
+	return (rec);
+}
+/*--------------------------------------------------------------------------------------
+	Drops the reference to the record, which is freed with the last entry of the content
+----------------------------------------------------------------------------------------*/
+static void 
+mem_content_rec_release (
+	MemT_Content_Rec* rec
+) {
+	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
+	MemT_Content_Rec** rpp;
+	uint32_t i;
+	
+	rec->ref--;
+	if (rec->ref > 0) {
+		return;
+	}
+	if (ht) {
+		for (rpp = &ht->tbl[rec->hash % ht->tabl_max] ; *rpp ; rpp = &(*rpp)->next) {
+			if (*rpp == rec) {
+				*rpp = rec->next;
+				break;
+			}
+		}
+	}
+	for (i = 0 ; i < rec->page_max ; i++) {
+		if (rec->pages[i]) {
+			hdl->cache_bytes -= MemC_Chunk_Page_Bytes (rec->pages[i]->size);
+			free (rec->pages[i]);
+		}
+	}
+	hdl->cache_bytes -= sizeof (MemT_Chunk_Page*) * rec->page_max;
+	hdl->cache_bytes -= sizeof (MemT_Content_Rec) + rec->name_len;
+	free (rec->pages);
+	free (rec);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the page of the chunk index which holds the chunk
+----------------------------------------------------------------------------------------*/
+static MemT_Chunk_Page* 
+mem_chunk_page_get (
+	MemT_Content_Rec* rec,
+	uint32_t chunk_num
+) {
+	uint32_t pidx = chunk_num >> MemC_Chunk_Page_Bits;
+	
+	if (pidx >= rec->page_max) {
+		return (NULL);
+	}
+	return (rec->pages[pidx]);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the entry of the chunk in the content
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Content_Mem_Entry* 
+mem_chunk_entry_get (
+	MemT_Content_Rec* rec,
+	uint32_t chunk_num
+) {
+	MemT_Chunk_Page* page;
+	uint32_t cidx = chunk_num & (MemC_Chunk_Page_Num - 1);
+	
+	page = mem_chunk_page_get (rec, chunk_num);
+	if ((page == NULL) || (cidx >= page->size)) {
+		return (NULL);
+	}
+	return (page->chunk[cidx]);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the slots of the page which holds the chunk index, most contents have 
+	fewer chunks than a page
+----------------------------------------------------------------------------------------*/
+static uint32_t 
+mem_chunk_page_slots (
+	uint32_t cidx
+) {
+	uint32_t size = MemC_Chunk_Page_Min;
+	
+	while (size <= cidx) {
+		size *= 2;
+	}
+	return (size);
+}
 
-	if (ht->tbl[y] == NULL) {
-		ht->tbl[y] = (CefT_Mem_Hash_Cell* )calloc (1, sizeof (CefT_Mem_Hash_Cell) + klen);
-		if (ht->tbl[y] == NULL) {
-			return (-1);
+static int 
+cef_mem_hash_tbl_item_set (
+	const unsigned char* key,
+	uint32_t klen,
+	CsmgrdT_Content_Mem_Entry* elem, 
+	CsmgrdT_Content_Mem_Entry** old_elem
+) {
+	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
+	MemT_Content_Rec* rec = elem->rec;
+	MemT_Chunk_Page** pages;
+	MemT_Chunk_Page* page;
+	uint32_t pidx = elem->chnk_num >> MemC_Chunk_Page_Bits;
+	uint32_t cidx = elem->chnk_num & (MemC_Chunk_Page_Num - 1);
+	uint32_t page_max;
+	uint32_t size;
+	*old_elem = NULL;
+	
+	/* The entry already refers to the record of its content, 	*/
+	/* so that the key is not hashed again 						*/
+	if (pidx >= MemC_Chunk_Dir_Max) {
+		return (-1);
+	}
+	
+	/* The entry is also put in the expiry heap 	*/
+	if (mem_expire_heap_reserve () < 0) {
+		return (-1);
+	}
+	
+	/* Grows the directory of the pages by doubling it 	*/
+	if (pidx >= rec->page_max) {
+		page_max = (rec->page_max) ? rec->page_max : 1;
+		while (page_max <= pidx) {
+			page_max *= 2;
 		}
-		ht->tbl[y]->key = ((unsigned char*)ht->tbl[y]) + sizeof (CefT_Mem_Hash_Cell);
-		cp = ht->tbl[y];
-		cp->elem = elem;
-		cp->klen = klen;
-		memcpy (cp->key, key, klen);
-		ht->elem_num++;
-		return (1);
-	} else {
-		/* exist check & replace */
-		for (cp = ht->tbl[y]; cp != NULL; cp = cp->next) {
-			if ((cp->klen == klen) &&
-			   (memcmp (cp->key, key, klen) == 0)) {
-				*old_elem = cp->elem;
-				cp->elem = elem;
-				return (1);
-		   }
+		pages = (MemT_Chunk_Page**) 
+			realloc (rec->pages, sizeof (MemT_Chunk_Page*) * page_max);
+		if (pages == NULL) {
+			return (-1);
 		}
-		/* insert */
-		wcp = ht->tbl[y];
-		ht->tbl[y] = (CefT_Mem_Hash_Cell* )calloc (1, sizeof (CefT_Mem_Hash_Cell) + klen);
-		if (ht->tbl[y] == NULL) {
+		memset (&pages[rec->page_max], 0, 
+			sizeof (MemT_Chunk_Page*) * (page_max - rec->page_max));
+		hdl->cache_bytes += sizeof (MemT_Chunk_Page*) * (page_max - rec->page_max);
+		rec->pages = pages;
+		rec->page_max = page_max;
+	}
+	
+	/* Grows the page by doubling it until it holds the chunk index 	*/
+	page = rec->pages[pidx];
+	if ((page == NULL) || (cidx >= page->size)) {
+		size = mem_chunk_page_slots (cidx);
+		page = (MemT_Chunk_Page*) realloc (page, MemC_Chunk_Page_Bytes (size));
+		if (page == NULL) {
 			return (-1);
 		}
-		ht->tbl[y]->key = ((unsigned char*)ht->tbl[y]) + sizeof (CefT_Mem_Hash_Cell);
-		cp = ht->tbl[y];
-		cp->next = wcp;
-		cp->elem = elem;
-		cp->klen = klen;
-		memcpy (cp->key, key, klen);
-		
-		ht->elem_num++;
+		if (rec->pages[pidx] == NULL) {
+			memset (page, 0, MemC_Chunk_Page_Bytes (size));
+		} else {
+			memset (&page->chunk[page->size], 0, 
+				sizeof (CsmgrdT_Content_Mem_Entry*) * (size - page->size));
+			hdl->cache_bytes -= MemC_Chunk_Page_Bytes (page->size);
+		}
+		hdl->cache_bytes += MemC_Chunk_Page_Bytes (size);
+		page->size = size;
+		rec->pages[pidx] = page;
+	}
+	
+	/* exist check & replace */
+	if (page->chunk[cidx]) {
+		*old_elem = page->chunk[cidx];
+		page->chunk[cidx] = elem;
+		mem_expire_heap_replace (*old_elem, elem);
 		return (1);
 	}
+	
+	/* insert */
+	page->chunk[cidx] = elem;
+	page->used++;
+	ht->elem_num++;
+	mem_expire_heap_push (elem);
+	return (1);
 }
 #else // CefC_Nwproc
 static int 
@@ -1521,6 +2062,11 @@ cef_mem_hash_tbl_item_set (
 	unsigned int key_wo_cid_len;
 
 	*old_elem = NULL;
+	
+	/* The entry is also put in the expiry heap 	*/
+	if (mem_expire_heap_reserve () < 0) {
+		return (-1);
+	}
 	cef_frame_separate_name_and_cid (
 				(unsigned char *)key, klen, 
 				key_wo_cid, &key_wo_cid_len, 
@@ -1535,6 +2081,7 @@ cef_mem_hash_tbl_item_set (
 			return (-1);
 		}
 		ht->tbl[y]->key = ((unsigned char*)ht->tbl[y]) + sizeof (CefT_Mem_Hash_Cell);
+		hdl->cache_bytes += sizeof (CefT_Mem_Hash_Cell) + key_wo_cid_len;
 		cp = ht->tbl[y];
 		cp->elem = elem;
 		cp->klen = key_wo_cid_len;
@@ -1543,6 +2090,7 @@ cef_mem_hash_tbl_item_set (
 		memcpy (cp->cid_key, cid_key, cid_klen);
 		cp->next = NULL;
 		ht->elem_num++;
+		mem_expire_heap_push (elem);
 		return (1);
 	} else {
 		/* exist check & replace */
@@ -1553,6 +2101,7 @@ cef_mem_hash_tbl_item_set (
 			   (memcmp (cp->cid_key, cid_key, cid_klen) == 0)) {
 				*old_elem = cp->elem;
 				cp->elem = elem;
+				mem_expire_heap_replace (*old_elem, elem);
 				return (1);
 			}
 		}
@@ -1563,6 +2112,7 @@ cef_mem_hash_tbl_item_set (
 			return (-1);
 		}
 		ht->tbl[y]->key = ((unsigned char*)ht->tbl[y]) + sizeof (CefT_Mem_Hash_Cell);
+		hdl->cache_bytes += sizeof (CefT_Mem_Hash_Cell) + key_wo_cid_len;
 		cp = ht->tbl[y];
 		cp->next = wcp;
 		cp->elem = elem;
@@ -1571,6 +2121,7 @@ cef_mem_hash_tbl_item_set (
 		cp->cid_klen = cid_klen;
 		memcpy (cp->cid_key, cid_key, cid_klen);
 		ht->elem_num++;
+		mem_expire_heap_push (elem);
 		return (1);
 	}
 }
@@ -1582,29 +2133,20 @@ cef_mem_hash_tbl_item_get (
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
-	uint32_t y;
-	CefT_Mem_Hash_Cell* cp;
-
-	if ((klen > MemC_Max_KLen) || (ht == NULL)) {
+	MemT_Content_Rec* rec;
+	uint32_t chunk_num;
+	int name_len;
+	
+	name_len = mem_key_split (key, klen, &chunk_num);
+	if (name_len < 0) {
 		return (NULL);
 	}
-	hash = cef_mem_hash_number_create (key, klen);
-	y = hash % ht->tabl_max;
-
-	cp = ht->tbl[y];
-	if (cp == NULL) {
+	rec = mem_content_rec_get (key, (uint16_t) name_len, 0);
+	if (rec == NULL) {
 		return (NULL);
-	} 
-	for (; cp != NULL; cp = cp->next) {
-		if ((cp->klen == klen) &&
-		   (memcmp (cp->key, key, klen) == 0)) {
-		   	return (cp->elem);
-		}
 	}
 	
-	return (NULL);
+	return (mem_chunk_entry_get (rec, chunk_num));
 }
 #else // CefC_Nwproc
 
@@ -1728,47 +2270,45 @@ cef_mem_hash_tbl_item_remove (
 	uint32_t klen
 ) {
 	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
-	uint32_t y;
 	CsmgrdT_Content_Mem_Entry* ret_elem;
-	CefT_Mem_Hash_Cell* cp;
-	CefT_Mem_Hash_Cell* wcp;
-	
-	if ((klen > MemC_Max_KLen) || (ht == NULL)) {
+	MemT_Content_Rec* rec;
+	MemT_Chunk_Page* page;
+	uint32_t chunk_num;
+	uint32_t cidx;
+	int name_len;
+	
+	name_len = mem_key_split (key, klen, &chunk_num);
+	if (name_len < 0) {
 		return (NULL);
 	}
-	
-	hash = cef_mem_hash_number_create (key, klen);
-	y = hash % ht->tabl_max;
-	
-	cp = ht->tbl[y];
-	if (cp == NULL) {
+	rec = mem_content_rec_get (key, (uint16_t) name_len, 0);
+	if (rec == NULL) {
 		return (NULL);
 	}
-	if (cp != NULL) {
-		if ((cp->klen == klen) &&
-		   (memcmp (cp->key, key, klen) == 0)) {
-		   	ht->tbl[y] = cp->next;
-			ht->elem_num--;
-		   	ret_elem = cp->elem;
-		   	free (cp);
-		   	return (ret_elem);
-		} else {
-			for (; cp->next != NULL; cp = cp->next) {
-				if ((cp->next->klen == klen) &&
-				   (memcmp (cp->next->key, key, klen) == 0)) {
-				   	wcp = cp->next;
-				   	cp->next = cp->next->next;
-					ht->elem_num--;
-				   	ret_elem = wcp->elem;
-		   			free (wcp);
-		   			return (ret_elem);
-				}
-			}
-		}
+	page = mem_chunk_page_get (rec, chunk_num);
+	if (page == NULL) {
+		return (NULL);
+	}
+	cidx = chunk_num & (MemC_Chunk_Page_Num - 1);
+	if (cidx >= page->size) {
+		return (NULL);
 	}
+	ret_elem = page->chunk[cidx];
+	if (ret_elem == NULL) {
+		return (NULL);
+	}
+	page->chunk[cidx] = NULL;
+	page->used--;
+	if (page->used == 0) {
+		rec->pages[chunk_num >> MemC_Chunk_Page_Bits] = NULL;
+		hdl->cache_bytes -= MemC_Chunk_Page_Bytes (page->size);
+		free (page);
+	}
+	ht->elem_num--;
+	mem_expire_heap_remove (ret_elem);
 	
-	return (NULL);
+	/* The record is freed when the entry is freed 	*/
+	return (ret_elem);
 }
 
 #else // CefC_Nwproc
@@ -1812,6 +2352,8 @@ cef_mem_hash_tbl_item_remove (
 			ht->tbl[y] = cp->next;
 			ht->elem_num--;
 			ret_elem = cp->elem;
+			mem_expire_heap_remove (ret_elem);
+			hdl->cache_bytes -= sizeof (CefT_Mem_Hash_Cell) + cp->klen;
 			free (cp);
 			return (ret_elem);
 		} else {
@@ -1824,6 +2366,8 @@ cef_mem_hash_tbl_item_remove (
 					cp->next = cp->next->next;
 					ht->elem_num--;
 					ret_elem = wcp->elem;
+					mem_expire_heap_remove (ret_elem);
+					hdl->cache_bytes -= sizeof (CefT_Mem_Hash_Cell) + wcp->klen;
 		   			free (wcp);
 		   			return (ret_elem);
 				}
@@ -1866,3 +2410,716 @@ csmgrd_key_create_by_Mem_Entry (
 
 	return (entry->name_len + 4 + sizeof (uint32_t));
 }
+
+/*--------------------------------------------------------------------------------------
+	Makes room for one more entry in the expiry heap
+----------------------------------------------------------------------------------------*/
+static int 
+mem_expire_heap_reserve (
+	void
+) {
+	CsmgrdT_Content_Mem_Entry** new_heap;
+	uint64_t new_max;
+	
+	if (mem_expire_num < mem_expire_max) {
+		return (0);
+	}
+	new_max = (mem_expire_max) ? mem_expire_max * 2 : MemC_Expire_Heap_Init;
+	new_heap = (CsmgrdT_Content_Mem_Entry**) 
+		realloc (mem_expire_heap, sizeof (CsmgrdT_Content_Mem_Entry*) * new_max);
+	if (new_heap == NULL) {
+		csmgrd_log_write (CefC_Log_Warn, "Failed to grow the expiry heap\n");
+		return (-1);
+	}
+	mem_expire_heap = new_heap;
+	mem_expire_max 	= new_max;
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Puts the entry in the expiry heap (mem_expire_heap_reserve must be called before)
+----------------------------------------------------------------------------------------*/
+static void 
+mem_expire_heap_push (
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	mem_expire_heap[mem_expire_num] = entry;
+	mem_expire_num++;
+	mem_expire_heap_sift (mem_expire_num - 1);
+	hdl->cache_bytes += sizeof (CsmgrdT_Content_Mem_Entry*);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Puts the entry in the place of the replaced one
+----------------------------------------------------------------------------------------*/
+static void 
+mem_expire_heap_replace (
+	CsmgrdT_Content_Mem_Entry* old_entry,
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	mem_expire_heap[old_entry->expire_idx] = entry;
+	mem_expire_heap_sift (old_entry->expire_idx);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes the entry from the expiry heap
+----------------------------------------------------------------------------------------*/
+static void 
+mem_expire_heap_remove (
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	uint64_t idx = entry->expire_idx;
+	
+	if ((idx >= mem_expire_num) || (mem_expire_heap[idx] != entry)) {
+		return;
+	}
+	mem_expire_num--;
+	if (idx < mem_expire_num) {
+		mem_expire_heap[idx] = mem_expire_heap[mem_expire_num];
+		mem_expire_heap_sift (idx);
+	}
+	hdl->cache_bytes -= sizeof (CsmgrdT_Content_Mem_Entry*);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Moves the entry up or down to the place of its expiry time
+----------------------------------------------------------------------------------------*/
+static void 
+mem_expire_heap_sift (
+	uint64_t idx
+) {
+	CsmgrdT_Content_Mem_Entry* entry;
+	uint64_t expire_t;
+	uint64_t parent;
+	uint64_t child;
+	
+	if (idx >= mem_expire_num) {
+		return;
+	}
+	entry 	 = mem_expire_heap[idx];
+	expire_t = mem_expire_time_get (entry);
+	
+	while (idx > 0) {
+		parent = (idx - 1) / 2;
+		if (mem_expire_time_get (mem_expire_heap[parent]) <= expire_t) {
+			break;
+		}
+		mem_expire_heap[idx] = mem_expire_heap[parent];
+		mem_expire_heap[idx]->expire_idx = idx;
+		idx = parent;
+	}
+	while ((child = idx * 2 + 1) < mem_expire_num) {
+		if ((child + 1 < mem_expire_num) && 
+			(mem_expire_time_get (mem_expire_heap[child + 1]) < 
+				mem_expire_time_get (mem_expire_heap[child]))) {
+			child++;
+		}
+		if (expire_t <= mem_expire_time_get (mem_expire_heap[child])) {
+			break;
+		}
+		mem_expire_heap[idx] = mem_expire_heap[child];
+		mem_expire_heap[idx]->expire_idx = idx;
+		idx = child;
+	}
+	mem_expire_heap[idx] = entry;
+	entry->expire_idx 	 = idx;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the time when the entry is expired
+----------------------------------------------------------------------------------------*/
+static uint64_t 
+mem_expire_time_get (
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	if ((entry->expiry != 0) && (entry->expiry < entry->cache_time)) {
+		return (entry->expiry);
+	}
+	return (entry->cache_time);
+}
+
+/*--------------------------------------------------------------------------------------
+	Builds the slab classes, each slot is about 1.25 times larger than the last
+----------------------------------------------------------------------------------------*/
+static void 
+mem_slab_init (
+	void
+) {
+	uint32_t size = MemC_Slab_Min_Slot;
+	uint32_t max_size = MemC_Slab_Page_Size - MemC_Slab_Header_Size;
+	
+	memset (mem_slab_class, 0, sizeof (mem_slab_class));
+	mem_slab_class_num = 0;
+	
+	while (mem_slab_class_num < MemC_Slab_Class_Max) {
+		if ((size >= max_size) || (mem_slab_class_num == MemC_Slab_Class_Max - 1)) {
+			size = max_size;
+		}
+		mem_slab_class[mem_slab_class_num].slot_size = size;
+		mem_slab_class[mem_slab_class_num].slot_num  = max_size / size;
+		mem_slab_class_num++;
+		
+		if (size == max_size) {
+			break;
+		}
+		size = ((size + size / 4) + 15) & ~15;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the smallest class which holds the specified bytes
+----------------------------------------------------------------------------------------*/
+static int 										/* -1 if no class holds the bytes 		*/
+mem_slab_class_get (
+	uint32_t size
+) {
+	int lo = 0;
+	int hi = mem_slab_class_num - 1;
+	int mid;
+	
+	if ((mem_slab_class_num == 0) || (size > mem_slab_class[hi].slot_size)) {
+		return (-1);
+	}
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (mem_slab_class[mid].slot_size < size) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return (lo);
+}
+/*--------------------------------------------------------------------------------------
+	Takes a slot from the class which fits the specified bytes
+----------------------------------------------------------------------------------------*/
+static void* 
+mem_slab_alloc (
+	uint32_t size
+) {
+	MemT_Slab_Class* cls;
+	MemT_Slab_Page* page;
+	void* slot;
+	int class_id;
+	
+	class_id = mem_slab_class_get (size);
+	if (class_id < 0) {
+		return (NULL);
+	}
+	cls = &mem_slab_class[class_id];
+	
+	if ((hdl->cache_capacity_bytes) && 
+		(hdl->cache_bytes + cls->slot_size > hdl->cache_capacity_bytes)) {
+		return (NULL);
+	}
+	
+	page = cls->partial;
+	if (page == NULL) {
+		/* The page is aligned so that the slot finds its page 	*/
+		if (posix_memalign ((void**) &page, MemC_Slab_Page_Size, MemC_Slab_Page_Size)) {
+			return (NULL);
+		}
+		memset (page, 0, sizeof (MemT_Slab_Page));
+		page->class_id = (uint32_t) class_id;
+		cls->partial   = page;
+		cls->page_num++;
+		hdl->slab_bytes += MemC_Slab_Page_Size;
+	}
+	
+	if (page->free_slot) {
+		slot = page->free_slot;
+		page->free_slot = *((void**) slot);
+	} else {
+		slot = (unsigned char*) page + MemC_Slab_Header_Size + 
+					(size_t) page->carved * cls->slot_size;
+		page->carved++;
+	}
+	page->used++;
+	hdl->cache_bytes += cls->slot_size;
+	
+	/* The full page leaves the list of the pages which have free slots 	*/
+	if (page->used == cls->slot_num) {
+		cls->partial = page->next;
+		if (page->next) {
+			page->next->prev = NULL;
+		}
+		page->next = NULL;
+	}
+	
+	return (slot);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the slot to its page, and the empty page to the system
+----------------------------------------------------------------------------------------*/
+static void 
+mem_slab_free (
+	void* slot
+) {
+	MemT_Slab_Page* page;
+	MemT_Slab_Class* cls;
+	int full_f;
+	
+	page = (MemT_Slab_Page*)((uintptr_t) slot & ~((uintptr_t) MemC_Slab_Page_Size - 1));
+	cls  = &mem_slab_class[page->class_id];
+	full_f = (page->used == cls->slot_num) ? 1 : 0;
+	
+	*((void**) slot) = page->free_slot;
+	page->free_slot  = slot;
+	page->used--;
+	hdl->cache_bytes -= cls->slot_size;
+	
+	if (page->used == 0) {
+		if (full_f == 0) {
+			if (page->prev) {
+				page->prev->next = page->next;
+			} else {
+				cls->partial = page->next;
+			}
+			if (page->next) {
+				page->next->prev = page->prev;
+			}
+		}
+		cls->page_num--;
+		hdl->slab_bytes -= MemC_Slab_Page_Size;
+		free (page);
+	} else if (full_f) {
+		page->prev = NULL;
+		page->next = cls->partial;
+		if (cls->partial) {
+			cls->partial->prev = page;
+		}
+		cls->partial = page;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the size of the slot which holds the entry of the Cob
+----------------------------------------------------------------------------------------*/
+static uint32_t 
+mem_entry_size (
+	CsmgrdT_Content_Entry* cob
+) {
+#ifndef CefC_Nwproc
+	/* The name is held by the record of the content 	*/
+	return (sizeof (CsmgrdT_Content_Mem_Entry) + cob->msg_len);
+#else // CefC_Nwproc
+	return (sizeof (CsmgrdT_Content_Mem_Entry) + cob->name_len + cob->msg_len);
+#endif // CefC_Nwproc
+}
+/*--------------------------------------------------------------------------------------
+	Creates the entry which holds the message (and the name) in the same slot
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Content_Mem_Entry* 				/* NULL if the cache has no room 		*/
+mem_entry_create (
+	CsmgrdT_Content_Entry* cob					/* its msg and name are freed			*/
+) {
+	CsmgrdT_Content_Mem_Entry* entry;
+#ifndef CefC_Nwproc
+	MemT_Content_Rec* rec = NULL;
+#endif // CefC_Nwproc
+	
+	entry = (CsmgrdT_Content_Mem_Entry*) mem_slab_alloc (mem_entry_size (cob));
+#ifndef CefC_Nwproc
+	if (entry) {
+		rec = mem_content_rec_get (cob->name, cob->name_len, 1);
+		if (rec == NULL) {
+			mem_slab_free (entry);
+			entry = NULL;
+		}
+	}
+#endif // CefC_Nwproc
+	
+	if (entry) {
+		memset (entry, 0, sizeof (CsmgrdT_Content_Mem_Entry));
+		entry->msg  = (unsigned char*)(entry + 1);
+#ifndef CefC_Nwproc
+		/* The entries of the content share the name in its record 	*/
+		rec->ref++;
+		entry->rec  = rec;
+		entry->name = rec->name;
+#else // CefC_Nwproc
+		entry->name = entry->msg + cob->msg_len;
+		memcpy (entry->name, cob->name, cob->name_len);
+#endif // CefC_Nwproc
+		memcpy (entry->msg, cob->msg, cob->msg_len);
+		entry->msg_len		= cob->msg_len;
+		entry->name_len		= cob->name_len;
+		entry->pay_len		= cob->pay_len;
+		entry->chnk_num		= cob->chnk_num;
+		entry->cache_time	= cob->cache_time;
+		entry->expiry		= cob->expiry;
+		entry->node			= cob->node;
+		entry->ins_time		= cob->ins_time;
+	}
+	free (cob->msg);
+	free (cob->name);
+	
+	return (entry);
+}
+/*--------------------------------------------------------------------------------------
+	Frees the entry
+----------------------------------------------------------------------------------------*/
+static void 
+mem_entry_free (
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	if (entry) {
+#ifndef CefC_Nwproc
+		mem_content_rec_release (entry->rec);
+#endif // CefC_Nwproc
+		mem_slab_free (entry);
+	}
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes the cached entry from the table, the algorithm and the status
+----------------------------------------------------------------------------------------*/
+static void 
+mem_entry_erase (
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	unsigned char trg_key[CsmgrdC_Key_Max];
+	int trg_key_len;
+	
+	trg_key_len = csmgrd_key_create_by_Mem_Entry (entry, trg_key);
+	if (cef_mem_hash_tbl_item_remove (trg_key, trg_key_len) == NULL) {
+		mem_expire_heap_remove (entry);
+		return;
+	}
+	if (hdl->algo_apis.erase) {
+		(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
+	}
+	hdl->cache_cobs--;
+	csmgrd_stat_cob_remove (
+		csmgr_stat_hdl, entry->name, entry->name_len, 
+		entry->chnk_num, entry->pay_len);
+	mem_entry_free (entry);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Frees all entries, which the expiry heap holds as well as the table
+----------------------------------------------------------------------------------------*/
+static void 
+mem_entries_free (
+	void
+) {
+	uint64_t i;
+	
+	for (i = 0 ; i < mem_expire_num ; i++) {
+		mem_entry_free (mem_expire_heap[i]);
+	}
+	hdl->cache_bytes -= mem_expire_num * sizeof (CsmgrdT_Content_Mem_Entry*);
+	mem_expire_num = 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the bytes which the index of the entries takes for the Cob
+----------------------------------------------------------------------------------------*/
+static uint32_t 
+mem_entry_index_size (
+	CsmgrdT_Content_Entry* cob
+) {
+	/* Slot of the expiry heap 	*/
+	uint32_t size = sizeof (CsmgrdT_Content_Mem_Entry*);
+#ifndef CefC_Nwproc
+	MemT_Content_Rec* rec;
+	MemT_Chunk_Page* page = NULL;
+	uint32_t pidx = cob->chnk_num >> MemC_Chunk_Page_Bits;
+	uint32_t cidx = cob->chnk_num & (MemC_Chunk_Page_Num - 1);
+	uint32_t page_max = 0;
+	uint32_t new_max;
+	
+	/* Record of the content, the directory of the pages and the page which 	*/
+	/* the Cob adds or grows 													*/
+	rec = mem_content_rec_get (cob->name, cob->name_len, 0);
+	if (rec == NULL) {
+		size += sizeof (MemT_Content_Rec) + cob->name_len;
+	} else {
+		page_max = rec->page_max;
+		page = mem_chunk_page_get (rec, cob->chnk_num);
+	}
+	if (pidx >= page_max) {
+		new_max = (page_max) ? page_max : 1;
+		while (new_max <= pidx) {
+			new_max *= 2;
+		}
+		size += sizeof (MemT_Chunk_Page*) * (new_max - page_max);
+	}
+	if (page == NULL) {
+		size += MemC_Chunk_Page_Bytes (mem_chunk_page_slots (cidx));
+	} else if (cidx >= page->size) {
+		size += MemC_Chunk_Page_Bytes (mem_chunk_page_slots (cidx)) - 
+				MemC_Chunk_Page_Bytes (page->size);
+	}
+#else // CefC_Nwproc
+	/* Cell of the hash table, whose key is the name and the chunk number 	*/
+	size += sizeof (CefT_Mem_Hash_Cell) + cob->name_len + CefC_S_TLF + sizeof (uint32_t);
+#endif // CefC_Nwproc
+	
+	return (size);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the entries to be expired first until the Cob fits in the capacity in bytes
+----------------------------------------------------------------------------------------*/
+static void 
+mem_cache_bytes_reserve (
+	CsmgrdT_Content_Entry* cob
+) {
+	int class_id;
+	uint64_t size;
+	
+	if (hdl->cache_capacity_bytes == 0) {
+		return;
+	}
+	class_id = mem_slab_class_get (mem_entry_size (cob));
+	if (class_id < 0) {
+		return;
+	}
+	size = mem_slab_class[class_id].slot_size + mem_entry_index_size (cob);
+	
+	/* The replacement library has no API to select its victim, so the 		*/
+	/* capacity in bytes removes the entries in the order of the expiry 		*/
+	/* regardless of CACHE_ALGORITHM, which only applies to CACHE_CAPACITY 		*/
+	while ((mem_expire_num > 0) && 
+		(hdl->cache_bytes + size > hdl->cache_capacity_bytes)) {
+		mem_entry_erase (mem_expire_heap[0]);
+	}
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Writes the cached Cobs to the snapshot file
+----------------------------------------------------------------------------------------*/
+static void 
+mem_snapshot_save (
+	void
+) {
+	MemT_Snapshot_Header head;
+	MemT_Snapshot_Rec* rec;
+	unsigned char* buf;
+	CsmgrdT_Content_Mem_Entry* entry;
+	char tmp_path[PATH_MAX + 8];
+	FILE* fp;
+	uint64_t nowt;
+	struct timeval tv;
+	uint64_t saved = 0;
+	uint64_t i;
+	size_t len;
+	size_t rec_len;
+	int res = 0;
+	
+	if ((hdl->snapshot_path[0] == 0x00) || (mem_hash_tbl == NULL)) {
+		return;
+	}
+	buf = (unsigned char*) malloc (
+			sizeof (MemT_Snapshot_Rec) + CsmgrdC_Key_Max + CefC_Max_Length + 8);
+	if (buf == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to get memory for the snapshot\n");
+		return;
+	}
+	rec = (MemT_Snapshot_Rec*) buf;
+	
+	/* Writes to the temporary file, which replaces the snapshot when completed 	*/
+	snprintf (tmp_path, sizeof (tmp_path), "%s.tmp", hdl->snapshot_path);
+	fp = fopen (tmp_path, "w");
+	if (fp == NULL) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to open %s (%s)\n", tmp_path, strerror (errno));
+		free (buf);
+		return;
+	}
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	
+	memset (&head, 0, sizeof (MemT_Snapshot_Header));
+	memcpy (head.magic, MemC_Snapshot_Magic, sizeof (head.magic));
+	head.rec_size 	= sizeof (MemT_Snapshot_Rec);
+	head.saved_time = nowt;
+	if (fwrite (&head, sizeof (MemT_Snapshot_Header), 1, fp) != 1) {
+		res = -1;
+	}
+	
+	/* The expiry heap holds every cached entry 	*/
+	for (i = 0 ; (i < mem_expire_num) && (res == 0) ; i++) {
+		entry = mem_expire_heap[i];
+		if (mem_expire_time_get (entry) <= nowt) {
+			continue;
+		}
+		memset (rec, 0, sizeof (MemT_Snapshot_Rec));
+		rec->cache_time = entry->cache_time;
+		rec->expiry 	= entry->expiry;
+		rec->ins_time 	= entry->ins_time;
+		rec->chnk_num 	= entry->chnk_num;
+		rec->node 		= entry->node;
+		rec->msg_len 	= entry->msg_len;
+		rec->name_len 	= entry->name_len;
+		rec->pay_len 	= entry->pay_len;
+		memcpy (buf + sizeof (MemT_Snapshot_Rec), entry->name, entry->name_len);
+		memcpy (buf + sizeof (MemT_Snapshot_Rec) + entry->name_len, 
+			entry->msg, entry->msg_len);
+		len = sizeof (MemT_Snapshot_Rec) + entry->name_len + entry->msg_len;
+		rec_len = (len + 0x07) & ~((size_t) 0x07);
+		memset (buf + len, 0, rec_len - len);
+		
+		/* The record damaged on the disk is detected by the checksum 	*/
+		rec->crc = cef_valid_crc32_calc (
+			buf + sizeof (uint32_t), rec_len - sizeof (uint32_t));
+	
+		if (fwrite (buf, 1, rec_len, fp) != rec_len) {
+			res = -1;
+			break;
+		}
+		saved++;
+	}
+	if ((res == 0) && ((fflush (fp) != 0) || (fsync (fileno (fp)) != 0))) {
+		res = -1;
+	}
+	fclose (fp);
+	free (buf);
+	
+	if ((res < 0) || (rename (tmp_path, hdl->snapshot_path) != 0)) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to write %s (%s)\n", hdl->snapshot_path, strerror (errno));
+		unlink (tmp_path);
+		return;
+	}
+	csmgrd_log_write (CefC_Log_Info, 
+		"Saved "FMTU64" Cobs to %s\n", saved, hdl->snapshot_path);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Restores the Cobs from the snapshot file
+----------------------------------------------------------------------------------------*/
+static void 
+mem_snapshot_load (
+	void
+) {
+	MemT_Snapshot_Header* head;
+	MemT_Snapshot_Rec* rec;
+	CsmgrdT_Content_Entry* cob;
+	CsmgrdT_Content_Entry cobs[MemC_Snapshot_Batch];
+	unsigned char* map;
+	unsigned char* data;
+	size_t map_len;
+	size_t offset;
+	size_t len;
+	struct stat st;
+	uint64_t nowt;
+	struct timeval tv;
+	uint64_t expired = 0;
+	size_t rec_len;
+	int cob_num = 0;
+	int fd;
+	
+	if (hdl->snapshot_path[0] == 0x00) {
+		return;
+	}
+	fd = open (hdl->snapshot_path, O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	if ((fstat (fd, &st) < 0) || 
+		(st.st_size < (off_t) sizeof (MemT_Snapshot_Header))) {
+		close (fd);
+		return;
+	}
+	map_len = (size_t) st.st_size;
+	map = (unsigned char*) mmap (NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (map == MAP_FAILED) {
+		csmgrd_log_write (CefC_Log_Warn, 
+			"Failed to map %s (%s)\n", hdl->snapshot_path, strerror (errno));
+		return;
+	}
+	madvise (map, map_len, MADV_SEQUENTIAL);
+	
+	head = (MemT_Snapshot_Header*) map;
+	if ((memcmp (head->magic, MemC_Snapshot_Magic, sizeof (head->magic)) != 0) ||
+		(head->rec_size != sizeof (MemT_Snapshot_Rec))) {
+		csmgrd_log_write (CefC_Log_Warn, 
+			"%s is not a snapshot of the memory cache\n", hdl->snapshot_path);
+		munmap (map, map_len);
+		return;
+	}
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	
+	offset = sizeof (MemT_Snapshot_Header);
+	while (offset + sizeof (MemT_Snapshot_Rec) <= map_len) {
+		rec  = (MemT_Snapshot_Rec*)(map + offset);
+		data = map + offset + sizeof (MemT_Snapshot_Rec);
+		len  = rec->name_len + rec->msg_len;
+		rec_len = (sizeof (MemT_Snapshot_Rec) + len + 0x07) & ~((size_t) 0x07);
+		
+		/* The records are restored up to the one which is damaged 	*/
+		if ((rec->name_len == 0) || (rec->msg_len == 0) || 
+			(rec->name_len + 8 > CsmgrdC_Key_Max) || (rec->msg_len > CefC_Max_Length) ||
+			(rec->pay_len > rec->msg_len) ||
+			(rec_len > map_len - offset) ||
+			(cef_valid_crc32_calc (map + offset + sizeof (uint32_t), 
+				rec_len - sizeof (uint32_t)) != rec->crc)) {
+			csmgrd_log_write (CefC_Log_Warn, 
+				"%s is damaged at %zu, the following Cobs are dropped\n", 
+				hdl->snapshot_path, offset);
+			break;
+		}
+		offset += rec_len;
+	
+		/* Drops the Cobs which expired while csmgrd was stopped 	*/
+		if (((rec->expiry != 0) && (rec->expiry <= nowt)) || (rec->cache_time <= nowt)) {
+			expired++;
+			continue;
+		}
+		cob = &cobs[cob_num];
+		cob->name = (unsigned char*) malloc (rec->name_len);
+		cob->msg  = (unsigned char*) malloc (rec->msg_len);
+		if ((cob->name == NULL) || (cob->msg == NULL)) {
+			free (cob->name);
+			free (cob->msg);
+			break;
+		}
+		memcpy (cob->name, data, rec->name_len);
+		memcpy (cob->msg, data + rec->name_len, rec->msg_len);
+		cob->name_len 	= rec->name_len;
+		cob->msg_len 	= rec->msg_len;
+		cob->pay_len 	= rec->pay_len;
+		cob->chnk_num 	= rec->chnk_num;
+		cob->cache_time = rec->cache_time;
+		cob->expiry 	= rec->expiry;
+		cob->node 		= rec->node;
+		cob->ins_time 	= rec->ins_time;
+		cob_num++;
+	
+		if (cob_num == MemC_Snapshot_Batch) {
+			pthread_rwlock_wrlock (&mem_cs_rwlock);
+			mem_cache_cob_write (cobs, cob_num);
+			pthread_rwlock_unlock (&mem_cs_rwlock);
+			cob_num = 0;
+		}
+	}
+	if (cob_num > 0) {
+		pthread_rwlock_wrlock (&mem_cs_rwlock);
+		mem_cache_cob_write (cobs, cob_num);
+		pthread_rwlock_unlock (&mem_cs_rwlock);
+	}
+	munmap (map, map_len);
+	
+	/* The snapshot is consumed, so that a later crash does not bring back 	*/
+	/* the Cobs which have been replaced or removed since 					*/
+	unlink (hdl->snapshot_path);
+	
+	csmgrd_log_write (CefC_Log_Info, 
+		"Restored "FMTU64" Cobs from %s ("FMTU64" expired)\n", 
+		hdl->cache_cobs, hdl->snapshot_path, expired);
+	
+	return;
+}
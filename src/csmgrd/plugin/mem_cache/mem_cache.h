@@ -66,6 +66,8 @@ typedef struct {
 	int				algo_cob_size;				/* average Cob size of Cob processed 	*/
                                   				/* by algorithm							*/
 	uint64_t 	 	cache_capacity;				/* size of cache capacity				*/
+	uint64_t 	 	cache_capacity_bytes;		/* bytes the entries may use (0: any)	*/
+	char 			snapshot_path[1024];		/* file to save the Cobs at shutdown	*/
 	
 } MemT_Config_Param;
 
@@ -84,6 +86,10 @@ typedef struct {
 	CsmgrdT_Lib_Interface algo_apis;
 	
 	uint64_t 		cache_cobs;					/* cached cobs 							*/
+	uint64_t 		cache_capacity_bytes;		/* bytes the entries may use (0: any)	*/
+	uint64_t 		cache_bytes;				/* bytes of the slots and the index		*/
+	uint64_t 		slab_bytes;					/* bytes of the slab pages				*/
+	char 			snapshot_path[1024];		/* file to save the Cobs at shutdown	*/
 	
 } MemT_Cache_Handle;
 
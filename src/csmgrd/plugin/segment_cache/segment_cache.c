@@ -0,0 +1,1486 @@
+/*
+ * Copyright (c) 2016-2021, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * segment_cache.c
+ */
+#define __CSMGRD_SEGMENT_CACHE_SOURCE__
+
+/*
+	segment_cache.c appends the Cobs to the pre-allocated segment files, and finds
+	them by the index in memory. The space of the removed Cobs is reclaimed by
+	segment, by moving the live Cobs of the segment to the head (compaction), or by
+	dropping the oldest segment when most of the Cobs in it are still live.
+*/
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <dirent.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+
+#include "segment_cache.h"
+#include <cefore/cef_client.h>
+#include <cefore/cef_csmgr.h>
+#include <cefore/cef_frame.h>
+#include <csmgrd/csmgrd_plugin.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define SegC_Chunk_Page_Bits	10
+#define SegC_Chunk_Page_Num		(1 << SegC_Chunk_Page_Bits)	/* chunks in a page			*/
+#define SegC_Chunk_Dir_Max		0x10000			/* pages of a content (64M chunks)		*/
+
+#define SegC_Tx_Cob_Num 		256
+#define SegC_Sent_Reset_Time	50000			/* Reset sent info (50msec)				*/
+
+#define SegC_Write_Buff_Size	0x100000		/* bytes appended to a segment at once	*/
+#define SegC_Read_Buff_Size		0x20000			/* bytes read from a segment at once	*/
+#define SegC_Compact_Ratio		2				/* compacts the segment whose live 		*/
+												/* bytes are 1/2 of the segment or less	*/
+#define SegC_Sum_Init_Num		1024
+
+#define SegC_Seg_Free			0
+#define SegC_Seg_Active			1				/* the head where the Cobs are appended	*/
+#define SegC_Seg_Sealed			2
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/********** Location of the cached Cob 	**********/
+typedef struct {
+
+	uint32_t 		seg;						/* index of the segment					*/
+	uint32_t 		off;						/* offset in the segment				*/
+	uint16_t 		msg_len;					/* 0 if the chunk is not cached			*/
+	uint16_t 		pay_len;
+
+} SegT_Loc;
+
+/********** Locations of the consecutive chunks 	**********/
+typedef struct {
+
+	int 			used;						/* cached chunks in the page			*/
+	SegT_Loc 		loc[SegC_Chunk_Page_Num];
+
+} SegT_Chunk_Page;
+
+/********** Index of the chunks of a content 	**********/
+typedef struct {
+
+	unsigned char* 	name;
+	uint16_t 		name_len;
+	uint64_t 		cob_num;
+	uint32_t 		page_max;
+	SegT_Chunk_Page** pages;					/* indexed by (chunk >> page bits)		*/
+
+} SegT_Content;
+
+/********** Cob appended to the segment, looked up when the segment is reclaimed **/
+typedef struct {
+
+	uint32_t 		con_index;					/* content index of csmgr_stat			*/
+	uint32_t 		chnk_num;
+	uint32_t 		off;
+
+} SegT_Sum;
+
+/********** Segment file 	**********/
+typedef struct {
+
+	int 			fd;
+	int 			state;						/* SegC_Seg_XXX							*/
+	int 			ref;						/* readers using the segment			*/
+	uint32_t 		used;						/* appended bytes						*/
+	uint64_t 		live;						/* bytes of the Cobs still cached		*/
+	uint64_t 		seq;						/* order in which it became the head	*/
+	SegT_Sum* 		sum;						/* Cobs appended to the segment			*/
+	uint32_t 		sum_num;
+	uint32_t 		sum_max;
+
+} SegT_Segment;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+static SegT_Cache_Handle* hdl = NULL;						/* SegmentCache Handle		*/
+
+static char csmgr_conf_dir[PATH_MAX] = {"/usr/local/cefore"};
+
+static CsmgrT_Stat_Handle 		csmgr_stat_hdl;
+static pthread_mutex_t 			seg_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static SegT_Content** 			seg_cons = NULL;		/* by content index of csmgr_stat	*/
+static SegT_Segment* 			seg_tbl = NULL;
+static int 						seg_active = -1;		/* segment of the head				*/
+static uint64_t 				seg_seq = 0;
+
+static unsigned char* 			seg_wbuf = NULL;		/* Cobs not written to the head yet	*/
+static uint32_t 				seg_wbuf_len = 0;
+static uint32_t 				seg_wbuf_off = 0;		/* offset of seg_wbuf in the head	*/
+
+static uint64_t 				seg_compact_num = 0;
+static uint64_t 				seg_evict_num = 0;
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cs_create (
+	CsmgrT_Stat_Handle stat_hdl
+);
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+static void
+seg_cs_destroy (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Check content expire
+----------------------------------------------------------------------------------------*/
+static void
+seg_cs_expire_check (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Function to read a ContentObject from Segment Cache
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cache_item_get (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seqno,								/* chunk num							*/
+	int sock									/* received socket						*/
+);
+/*--------------------------------------------------------------------------------------
+	Upload content byte steream
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cache_item_puts (
+	unsigned char* msg,
+	int msg_len
+);
+/*--------------------------------------------------------------------------------------
+	Function to increment access count
+----------------------------------------------------------------------------------------*/
+static void
+seg_cs_ac_cnt_inc (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seq_num							/* sequence number						*/
+);
+/*--------------------------------------------------------------------------------------
+	get lifetime for ccninfo
+----------------------------------------------------------------------------------------*/
+static int										/* This value MAY be -1 if the router does not know or cannot report. */
+seg_cache_lifetime_get (
+	unsigned char* name,						/* content name							*/
+	uint16_t name_len,							/* content name Length					*/
+	uint32_t* cache_time,						/* The elapsed time (seconds) after the oldest	*/
+												/* content object of the content is cached.		*/
+	uint32_t* lifetime,							/* The lifetime (seconds) of a content object, 	*/
+												/* which is removed first among the cached content objects.*/
+	uint8_t partial_f							/* when flag is 0, exact match			*/
+												/* when flag is 1, partial match		*/
+);
+#ifdef CefC_Ccore
+/*--------------------------------------------------------------------------------------
+	Change cache capacity
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_change_cap (
+	uint64_t cap								/* New capacity to set					*/
+);
+/*--------------------------------------------------------------------------------------
+	Set content lifetime
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cache_set_lifetime (
+	unsigned char* name,						/* Content name							*/
+	uint16_t name_len,							/* Content name length					*/
+	uint64_t lifetime							/* Content Lifetime						*/
+);
+/*--------------------------------------------------------------------------------------
+	Delete content entry
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cache_del (
+	unsigned char* name,						/* Content name							*/
+	uint16_t name_len,							/* Content name length					*/
+	uint32_t chunk_num							/* ChunkNumber							*/
+);
+#endif // CefC_Ccore
+/*--------------------------------------------------------------------------------------
+	Read config file
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_config_read (
+	SegT_Config_Param* params					/* record parameters					*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the segment files
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_segments_create (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Closes and removes the segment files
+----------------------------------------------------------------------------------------*/
+static void
+seg_segments_destroy (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Stores the received Cob
+----------------------------------------------------------------------------------------*/
+static void
+seg_cob_put (
+	CsmgrdT_Content_Entry* entry,				/* received Cob							*/
+	uint64_t nowt								/* current time (usec)					*/
+);
+/*--------------------------------------------------------------------------------------
+	Makes the head segment ready to append the specified bytes
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_head_ready (
+	uint16_t len,								/* bytes to be appended					*/
+	int compact_f								/* 1: called from the compaction		*/
+);
+/*--------------------------------------------------------------------------------------
+	Appends the Cob to the head segment made ready by seg_head_ready
+----------------------------------------------------------------------------------------*/
+static void
+seg_cob_append (
+	const unsigned char* msg,					/* Cob message							*/
+	uint16_t msg_len,							/* Cob message length					*/
+	uint32_t con_index,							/* content index of csmgr_stat			*/
+	uint32_t chnk_num,							/* chunk number							*/
+	SegT_Loc* loc								/* location where the Cob is appended	*/
+);
+/*--------------------------------------------------------------------------------------
+	Writes the Cobs in the write buffer to the head segment
+----------------------------------------------------------------------------------------*/
+static void
+seg_wbuf_flush (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Reclaims a sealed segment by the compaction or the eviction
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_reclaim (
+	int evict_f									/* 0: only compacts the segment			*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the location of the chunk from the index
+----------------------------------------------------------------------------------------*/
+static SegT_Loc*
+seg_loc_get (
+	SegT_Content* con,							/* index of the content					*/
+	uint32_t chnk_num,							/* chunk number							*/
+	int create_f								/* 1: creates the page if needed		*/
+);
+/*--------------------------------------------------------------------------------------
+	Removes the cached Cob
+----------------------------------------------------------------------------------------*/
+static void
+seg_cob_remove (
+	uint32_t con_index,							/* content index of csmgr_stat			*/
+	uint32_t chnk_num							/* chunk number							*/
+);
+/*--------------------------------------------------------------------------------------
+	Removes the cached Cobs of the content and the content information
+----------------------------------------------------------------------------------------*/
+static void
+seg_content_drop (
+	CsmgrT_Stat* rcd							/* content information					*/
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Road the cache plugin
+----------------------------------------------------------------------------------------*/
+int
+csmgrd_segment_plugin_load (
+	CsmgrdT_Plugin_Interface* cs_in,
+	const char* config_dir
+) {
+	CSMGRD_SET_CALLBACKS (
+		seg_cs_create, seg_cs_destroy, seg_cs_expire_check, seg_cache_item_get,
+		seg_cache_item_puts, seg_cs_ac_cnt_inc, seg_cache_lifetime_get);
+	
+#ifdef CefC_Ccore
+	cs_in->cache_cap_set 		= seg_change_cap;
+	cs_in->content_lifetime_set = seg_cache_set_lifetime;
+	cs_in->content_cache_del	= seg_cache_del;
+#endif // CefC_Ccore
+	
+	if (config_dir) {
+		strcpy (csmgr_conf_dir, config_dir);
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cs_create (
+	CsmgrT_Stat_Handle stat_hdl
+) {
+	SegT_Config_Param conf_param;
+	
+	/* Check handle */
+	if (hdl) {
+		free (hdl);
+		hdl = NULL;
+	}
+	
+	/* Init logging 	*/
+	csmgrd_log_init ("segment", 1);
+	csmgrd_log_init2 (csmgr_conf_dir);
+#ifdef CefC_Debug
+	csmgrd_dbg_init ("segment", csmgr_conf_dir);
+#endif // CefC_Debug
+	
+	/* Create handle */
+	hdl = (SegT_Cache_Handle*) malloc (sizeof (SegT_Cache_Handle));
+	if (hdl == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to get memory required for startup.\n");
+		return (-1);
+	}
+	memset (hdl, 0, sizeof (SegT_Cache_Handle));
+	
+	/* Read config */
+	if (seg_config_read (&conf_param) < 0) {
+		csmgrd_log_write (CefC_Log_Error, "[%s] Read config error\n", __func__);
+		return (-1);
+	}
+	strcpy (hdl->seg_root_path, conf_param.seg_root_path);
+	hdl->cache_capacity = conf_param.cache_capacity;
+	hdl->segment_size 	= conf_param.segment_size;
+	hdl->segment_num 	= conf_param.segment_num;
+	hdl->cache_cobs 	= 0;
+	
+	/* Creates the index and the segment files 		*/
+	seg_cons = (SegT_Content**) calloc (CsmgrT_Stat_Max, sizeof (SegT_Content*));
+	seg_wbuf = (unsigned char*) malloc (SegC_Write_Buff_Size);
+	if ((seg_cons == NULL) || (seg_wbuf == NULL)) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to get memory required for startup.\n");
+		return (-1);
+	}
+	if (seg_segments_create () < 0) {
+		return (-1);
+	}
+	csmgrd_log_write (CefC_Log_Info,
+		"Creation the segment files (%s) ... OK\n", hdl->seg_cache_path);
+	
+	csmgrd_log_write (CefC_Log_Info, "Start\n");
+	csmgrd_log_write (CefC_Log_Info, "Cache Capacity : "FMTU64"\n", hdl->cache_capacity);
+	csmgrd_log_write (CefC_Log_Info, "Segments       : %d x "FMTU64" bytes\n",
+		hdl->segment_num, hdl->segment_size);
+	
+	csmgr_stat_hdl = stat_hdl;
+	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+static void
+seg_cs_destroy (
+	void
+) {
+	SegT_Content* con;
+	uint32_t n;
+	int i;
+	
+	/* Check handle */
+	if (hdl == NULL) {
+		return;
+	}
+	csmgrd_log_write (CefC_Log_Info,
+		"Compacted "FMTU64" segments, evicted "FMTU64" segments\n",
+		seg_compact_num, seg_evict_num);
+	
+	seg_segments_destroy ();
+	
+	if (seg_cons) {
+		for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+			con = seg_cons[i];
+			if (con == NULL) {
+				continue;
+			}
+			for (n = 0 ; n < con->page_max ; n++) {
+				free (con->pages[n]);
+			}
+			free (con->pages);
+			free (con);
+		}
+		free (seg_cons);
+		seg_cons = NULL;
+	}
+	free (seg_wbuf);
+	seg_wbuf = NULL;
+	
+	/* Destroy handle */
+	free (hdl);
+	hdl = NULL;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Check content expire
+----------------------------------------------------------------------------------------*/
+static void
+seg_cs_expire_check (
+	void
+) {
+	CsmgrT_Stat* rcd;
+	int index = 0;
+	
+	if (pthread_mutex_trylock (&seg_mutex) != 0) {
+		return;
+	}
+	while (1) {
+		rcd = csmgrd_stat_expired_content_info_get (csmgr_stat_hdl, &index);
+		if (!rcd) {
+			break;
+		}
+		seg_content_drop (rcd);
+	}
+	
+	/* Compacts a segment in advance so that the Cobs can be appended without waiting */
+	seg_reclaim (0);
+	seg_wbuf_flush ();
+	
+	pthread_mutex_unlock (&seg_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Function to read a ContentObject from Segment Cache
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cache_item_get (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seqno,								/* chunk num							*/
+	int sock									/* received socket						*/
+) {
+	CsmgrT_Stat* rcd;
+	SegT_Content* con;
+	SegT_Loc* loc;
+	SegT_Loc tx_loc[SegC_Tx_Cob_Num];
+	int 		tx_cnt = 0;
+	int			resend_1cob_f = 0;
+	int			send_cob_f = 0;
+	int			sent_f = 0;
+	uint32_t	con_index;
+	uint64_t 	nowt;
+	struct timeval tv;
+	unsigned char	rbuf[SegC_Read_Buff_Size];
+	uint32_t 	top;
+	uint32_t 	end;
+	uint32_t 	n;
+	ssize_t 	len;
+	int 		sg;
+	int 		fd;
+	int 		i, k;
+	
+#ifdef CefC_Debug
+	csmgrd_dbg_write (CefC_Dbg_Finest, "Incoming Interest : seqno = %u\n", seqno);
+#endif // CefC_Debug
+	pthread_mutex_lock (&seg_mutex);
+	/* Obtain the information of the specified content 		*/
+	rcd = csmgrd_stat_content_info_access (csmgr_stat_hdl, key, key_size);
+	if (!rcd) {
+		pthread_mutex_unlock (&seg_mutex);
+		return (CefC_Csmgr_Cob_NotExist);
+	}
+	if (rcd->expire_f) {
+		seg_content_drop (rcd);
+		pthread_mutex_unlock (&seg_mutex);
+		return (CefC_Csmgr_Cob_NotExist);
+	}
+	con = seg_cons[rcd->index];
+	loc = (con) ? seg_loc_get (con, seqno, 0) : NULL;
+	if ((loc == NULL) || (loc->msg_len == 0)) {
+		pthread_mutex_unlock (&seg_mutex);
+		return (CefC_Csmgr_Cob_NotExist);
+	}
+	
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	
+	if (nowt > rcd->tx_time) {
+		rcd->tx_seq = 0;
+		rcd->tx_num = -1;
+	}
+	if (rcd->tx_num ==-1) {
+		send_cob_f = 1;
+	} else {
+		if (seqno >= rcd->tx_seq && seqno < (rcd->tx_seq + rcd->tx_num)) {
+			resend_1cob_f = 1;
+		} else {
+			send_cob_f = 1;
+		}
+	}
+	if (send_cob_f == 1) {
+		rcd->tx_seq = seqno;
+		rcd->tx_num = SegC_Tx_Cob_Num;
+		rcd->tx_time = nowt + SegC_Sent_Reset_Time;
+	}
+	
+	/* Lists the following cached Cobs in the same segment 		*/
+	con_index = rcd->index;
+	sg = (int) loc->seg;
+	tx_loc[tx_cnt++] = *loc;
+	if (resend_1cob_f == 0) {
+		for (n = 1 ; n < SegC_Tx_Cob_Num ; n++) {
+			loc = seg_loc_get (con, seqno + n, 0);
+			if ((loc == NULL) || (loc->msg_len == 0)) {
+				continue;
+			}
+			if (loc->seg != (uint32_t) sg) {
+				break;
+			}
+			tx_loc[tx_cnt++] = *loc;
+		}
+	}
+	csmgrd_stat_access_count_update (csmgr_stat_hdl, key, key_size);
+	
+	/* The segment is not reclaimed while it is read without the lock 	*/
+	seg_tbl[sg].ref++;
+	fd = seg_tbl[sg].fd;
+	pthread_mutex_unlock (&seg_mutex);
+	
+	/* Reads the Cobs appended one after another at once 	*/
+	i = 0;
+	while (i < tx_cnt) {
+		top = tx_loc[i].off;
+		end = top + tx_loc[i].msg_len;
+		for (k = i + 1 ; k < tx_cnt ; k++) {
+			if ((tx_loc[k].off != end) ||
+				(end + tx_loc[k].msg_len - top > SegC_Read_Buff_Size)) {
+				break;
+			}
+			end += tx_loc[k].msg_len;
+		}
+		len = pread (fd, rbuf, end - top, top);
+	
+		/* Send Cobs to cefnetd */
+		for (; i < k ; i++) {
+			if (len < (ssize_t)(tx_loc[i].off - top + tx_loc[i].msg_len)) {
+				break;
+			}
+			csmgrd_plugin_cob_msg_send (
+				sock, &rbuf[tx_loc[i].off - top], tx_loc[i].msg_len);
+			if (i == 0) {
+				sent_f = 1;
+			}
+		}
+		i = k;
+	}
+	
+	pthread_mutex_lock (&seg_mutex);
+	seg_tbl[sg].ref--;
+	
+	/* The requested Cob could not be read, so it is removed to be cached again 	*/
+	if (!sent_f) {
+		csmgrd_log_write (CefC_Log_Warn,
+			"Failed to read the cached Cob (seqno = %u), it is removed\n", seqno);
+		rcd = csmgrd_stat_content_info_access (csmgr_stat_hdl, key, key_size);
+		if ((rcd) && (rcd->index == con_index) && (seg_cons[con_index])) {
+			loc = seg_loc_get (seg_cons[con_index], seqno, 0);
+			if ((loc) && (loc->msg_len != 0) &&
+				(loc->seg == tx_loc[0].seg) && (loc->off == tx_loc[0].off)) {
+				seg_cob_remove (con_index, seqno);
+			}
+		}
+	}
+	pthread_mutex_unlock (&seg_mutex);
+	
+	if (!sent_f) {
+		return (CefC_Csmgr_Cob_NotExist);
+	}
+	return (CefC_Csmgr_Cob_Exist);
+}
+/*--------------------------------------------------------------------------------------
+	Upload content byte steream
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cache_item_puts (
+	unsigned char* msg,
+	int msg_len
+) {
+	CsmgrdT_Content_Entry entry;
+	uint64_t nowt;
+	struct timeval tv;
+	int index = 0;
+	int res;
+	
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	
+	/* The Cobs are appended to the head with a few writes, and they are written 	*/
+	/* before the readers find them in the index 									*/
+	pthread_mutex_lock (&seg_mutex);
+	while (index < msg_len) {
+		res = cef_csmgr_con_entry_create (&msg[index], msg_len - index, &entry);
+		if (res < 0) {
+			break;
+		}
+		index += res;
+	
+		seg_cob_put (&entry, nowt);
+		free (entry.msg);
+		free (entry.name);
+	}
+	seg_wbuf_flush ();
+	pthread_mutex_unlock (&seg_mutex);
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Stores the received Cob
+----------------------------------------------------------------------------------------*/
+static void
+seg_cob_put (
+	CsmgrdT_Content_Entry* entry,				/* received Cob							*/
+	uint64_t nowt								/* current time (usec)					*/
+) {
+	CsmgrT_Stat* rcd;
+	SegT_Content* con;
+	SegT_Loc* loc;
+	SegT_Loc new_loc;
+	
+	if (entry->expiry < nowt) {
+		return;
+	}
+	if (hdl->cache_cobs >= hdl->cache_capacity) {
+		return;
+	}
+	
+	/* Reclaims the segment first, since it may remove the Cobs of this content 	*/
+	if (seg_head_ready (entry->msg_len, 0) < 0) {
+		return;
+	}
+	
+	rcd = csmgrd_stat_content_info_access (csmgr_stat_hdl, entry->name, entry->name_len);
+	if (!rcd) {
+		rcd = csmgrd_stat_content_info_init (
+				csmgr_stat_hdl, entry->name, entry->name_len);
+		if (!rcd) {
+			return;
+		}
+	}
+	con = seg_cons[rcd->index];
+	if (con == NULL) {
+		con = (SegT_Content*) calloc (1, sizeof (SegT_Content) + entry->name_len);
+		if (con == NULL) {
+			return;
+		}
+		con->name = (unsigned char*)(con + 1);
+		memcpy (con->name, entry->name, entry->name_len);
+		con->name_len = entry->name_len;
+		seg_cons[rcd->index] = con;
+	}
+	loc = seg_loc_get (con, entry->chnk_num, 1);
+	if ((loc == NULL) || (loc->msg_len != 0)) {
+		return;
+	}
+	
+	seg_cob_append (entry->msg, entry->msg_len, rcd->index, entry->chnk_num, &new_loc);
+	new_loc.pay_len = entry->pay_len;
+	*loc = new_loc;
+	con->pages[entry->chnk_num >> SegC_Chunk_Page_Bits]->used++;
+	con->cob_num++;
+	
+	csmgrd_stat_cob_update (csmgr_stat_hdl, entry->name, entry->name_len,
+		entry->chnk_num, entry->pay_len, entry->expiry, nowt, entry->node);
+	hdl->cache_cobs++;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Makes the head segment ready to append the specified bytes
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_head_ready (
+	uint16_t len,								/* bytes to be appended					*/
+	int compact_f								/* 1: called from the compaction		*/
+) {
+	SegT_Segment* sp;
+	int free_num;
+	int retry;
+	int sg;
+	int i;
+	
+	for (retry = 0 ; retry < 2 ; retry++) {
+		if ((seg_active >= 0) &&
+			(seg_tbl[seg_active].used + len <= hdl->segment_size)) {
+			return (0);
+		}
+	
+		/* Seals the head 		*/
+		seg_wbuf_flush ();
+		if (seg_active >= 0) {
+			seg_tbl[seg_active].state = SegC_Seg_Sealed;
+			seg_active = -1;
+		}
+	
+		/* One free segment is kept for the compaction 	*/
+		free_num = 0;
+		sg = -1;
+		for (i = 0 ; i < hdl->segment_num ; i++) {
+			if (seg_tbl[i].state == SegC_Seg_Free) {
+				free_num++;
+				sg = i;
+			}
+		}
+		if ((free_num > 1) || ((free_num == 1) && compact_f)) {
+			sp = &seg_tbl[sg];
+			sp->state 	= SegC_Seg_Active;
+			sp->used 	= 0;
+			sp->live 	= 0;
+			sp->sum_num = 0;
+			sp->seq 	= ++seg_seq;
+			seg_active 	 = sg;
+			seg_wbuf_off = 0;
+			seg_wbuf_len = 0;
+			return (0);
+		}
+		if (compact_f || (seg_reclaim (1) < 0)) {
+			break;
+		}
+	}
+	
+	return (-1);
+}
+/*--------------------------------------------------------------------------------------
+	Appends the Cob to the head segment made ready by seg_head_ready
+----------------------------------------------------------------------------------------*/
+static void
+seg_cob_append (
+	const unsigned char* msg,					/* Cob message							*/
+	uint16_t msg_len,							/* Cob message length					*/
+	uint32_t con_index,							/* content index of csmgr_stat			*/
+	uint32_t chnk_num,							/* chunk number							*/
+	SegT_Loc* loc								/* location where the Cob is appended	*/
+) {
+	SegT_Segment* sp = &seg_tbl[seg_active];
+	SegT_Sum* new_sum;
+	uint32_t new_max;
+	
+	if (seg_wbuf_len + msg_len > SegC_Write_Buff_Size) {
+		seg_wbuf_flush ();
+	}
+	memcpy (&seg_wbuf[seg_wbuf_len], msg, msg_len);
+	seg_wbuf_len += msg_len;
+	
+	loc->seg 		= (uint32_t) seg_active;
+	loc->off 		= sp->used;
+	loc->msg_len 	= msg_len;
+	loc->pay_len 	= 0;
+	sp->used += msg_len;
+	sp->live += msg_len;
+	
+	/* Records the Cob in the summary, which is looked up when the segment is reclaimed */
+	if (sp->sum_num == sp->sum_max) {
+		new_max = (sp->sum_max) ? sp->sum_max * 2 : SegC_Sum_Init_Num;
+		new_sum = (SegT_Sum*) realloc (sp->sum, sizeof (SegT_Sum) * new_max);
+		if (new_sum == NULL) {
+			/* The Cob is dropped when the segment is evicted in the worst case 	*/
+			return;
+		}
+		sp->sum 	= new_sum;
+		sp->sum_max = new_max;
+	}
+	sp->sum[sp->sum_num].con_index 	= con_index;
+	sp->sum[sp->sum_num].chnk_num 	= chnk_num;
+	sp->sum[sp->sum_num].off 		= loc->off;
+	sp->sum_num++;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Writes the Cobs in the write buffer to the head segment
+----------------------------------------------------------------------------------------*/
+static void
+seg_wbuf_flush (
+	void
+) {
+	ssize_t res;
+	uint32_t n = 0;
+	
+	if ((seg_wbuf_len == 0) || (seg_active < 0)) {
+		return;
+	}
+	while (n < seg_wbuf_len) {
+		res = pwrite (seg_tbl[seg_active].fd,
+				&seg_wbuf[n], seg_wbuf_len - n, (off_t) seg_wbuf_off + n);
+		if (res <= 0) {
+			if ((res < 0) && (errno == EINTR)) {
+				continue;
+			}
+			csmgrd_log_write (CefC_Log_Error,
+				"Failed to write the segment#%d (%s)\n", seg_active, strerror (errno));
+			break;
+		}
+		n += (uint32_t) res;
+	}
+	seg_wbuf_off += seg_wbuf_len;
+	seg_wbuf_len = 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Reclaims a sealed segment by the compaction or the eviction
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_reclaim (
+	int evict_f									/* 0: only compacts the segment			*/
+) {
+	SegT_Segment* sp;
+	SegT_Content* con;
+	SegT_Loc* loc;
+	SegT_Loc new_loc;
+	SegT_Sum* sum;
+	unsigned char buff[UINT16_MAX];
+	int compact_sg = -1;
+	int evict_sg = -1;
+	uint32_t i;
+	
+	/* Selects the segment with the fewest live bytes, and the oldest one 	*/
+	for (i = 0 ; i < (uint32_t) hdl->segment_num ; i++) {
+		sp = &seg_tbl[i];
+		if ((sp->state != SegC_Seg_Sealed) || (sp->ref > 0)) {
+			continue;
+		}
+		if ((compact_sg < 0) || (sp->live < seg_tbl[compact_sg].live)) {
+			compact_sg = (int) i;
+		}
+		if ((evict_sg < 0) || (sp->seq < seg_tbl[evict_sg].seq)) {
+			evict_sg = (int) i;
+		}
+	}
+	if (compact_sg < 0) {
+		return (-1);
+	}
+	
+	if (seg_tbl[compact_sg].live * SegC_Compact_Ratio <= hdl->segment_size) {
+		/* Moves the live Cobs to the head 		*/
+		sp = &seg_tbl[compact_sg];
+		for (i = 0 ; i < sp->sum_num ; i++) {
+			sum = &sp->sum[i];
+			con = seg_cons[sum->con_index];
+			loc = (con) ? seg_loc_get (con, sum->chnk_num, 0) : NULL;
+			if ((loc == NULL) || (loc->msg_len == 0) ||
+				(loc->seg != (uint32_t) compact_sg) || (loc->off != sum->off)) {
+				continue;
+			}
+			if (pread (sp->fd, buff, loc->msg_len, sum->off) != loc->msg_len) {
+				seg_cob_remove (sum->con_index, sum->chnk_num);
+				continue;
+			}
+			if (seg_head_ready (loc->msg_len, 1) < 0) {
+				/* The Cobs not moved yet stay in this segment 	*/
+				return (-1);
+			}
+			seg_cob_append (buff, loc->msg_len, sum->con_index, sum->chnk_num, &new_loc);
+			new_loc.pay_len = loc->pay_len;
+			sp->live -= loc->msg_len;
+			*loc = new_loc;
+		}
+		seg_wbuf_flush ();
+		seg_compact_num++;
+	} else if (evict_f) {
+		/* Most of the Cobs are live, so drops the oldest segment 		*/
+		sp = &seg_tbl[evict_sg];
+		for (i = 0 ; i < sp->sum_num ; i++) {
+			sum = &sp->sum[i];
+			con = seg_cons[sum->con_index];
+			loc = (con) ? seg_loc_get (con, sum->chnk_num, 0) : NULL;
+			if ((loc == NULL) || (loc->msg_len == 0) ||
+				(loc->seg != (uint32_t) evict_sg) || (loc->off != sum->off)) {
+				continue;
+			}
+			seg_cob_remove (sum->con_index, sum->chnk_num);
+		}
+		seg_evict_num++;
+	} else {
+		return (-1);
+	}
+	
+	sp->state 	= SegC_Seg_Free;
+	sp->used 	= 0;
+	sp->live 	= 0;
+	sp->sum_num = 0;
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the location of the chunk from the index
+----------------------------------------------------------------------------------------*/
+static SegT_Loc*
+seg_loc_get (
+	SegT_Content* con,							/* index of the content					*/
+	uint32_t chnk_num,							/* chunk number							*/
+	int create_f								/* 1: creates the page if needed		*/
+) {
+	SegT_Chunk_Page** new_pages;
+	uint32_t page = chnk_num >> SegC_Chunk_Page_Bits;
+	uint32_t new_max;
+	
+	if (page >= SegC_Chunk_Dir_Max) {
+		return (NULL);
+	}
+	if (page >= con->page_max) {
+		if (!create_f) {
+			return (NULL);
+		}
+		for (new_max = (con->page_max) ? con->page_max : 1 ;
+			new_max <= page ; new_max *= 2) {
+			/* NOP */;
+		}
+		new_pages = (SegT_Chunk_Page**)
+			realloc (con->pages, sizeof (SegT_Chunk_Page*) * new_max);
+		if (new_pages == NULL) {
+			return (NULL);
+		}
+		memset (&new_pages[con->page_max], 0,
+			sizeof (SegT_Chunk_Page*) * (new_max - con->page_max));
+		con->pages 		= new_pages;
+		con->page_max 	= new_max;
+	}
+	if (con->pages[page] == NULL) {
+		if (!create_f) {
+			return (NULL);
+		}
+		con->pages[page] = (SegT_Chunk_Page*) calloc (1, sizeof (SegT_Chunk_Page));
+		if (con->pages[page] == NULL) {
+			return (NULL);
+		}
+	}
+	
+	return (&con->pages[page]->loc[chnk_num & (SegC_Chunk_Page_Num - 1)]);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the cached Cob
+----------------------------------------------------------------------------------------*/
+static void
+seg_cob_remove (
+	uint32_t con_index,							/* content index of csmgr_stat			*/
+	uint32_t chnk_num							/* chunk number							*/
+) {
+	SegT_Content* con = seg_cons[con_index];
+	SegT_Chunk_Page* page;
+	SegT_Loc* loc;
+	uint32_t n;
+	
+	loc = (con) ? seg_loc_get (con, chnk_num, 0) : NULL;
+	if ((loc == NULL) || (loc->msg_len == 0)) {
+		return;
+	}
+	seg_tbl[loc->seg].live -= loc->msg_len;
+	csmgrd_stat_cob_remove (
+		csmgr_stat_hdl, con->name, con->name_len, chnk_num, loc->pay_len);
+	hdl->cache_cobs--;
+	loc->msg_len = 0;
+	
+	page = con->pages[chnk_num >> SegC_Chunk_Page_Bits];
+	page->used--;
+	if (page->used == 0) {
+		free (page);
+		con->pages[chnk_num >> SegC_Chunk_Page_Bits] = NULL;
+	}
+	
+	/* csmgr_stat deletes the content when its last Cob is removed 	*/
+	con->cob_num--;
+	if (con->cob_num == 0) {
+		for (n = 0 ; n < con->page_max ; n++) {
+			free (con->pages[n]);
+		}
+		free (con->pages);
+		free (con);
+		seg_cons[con_index] = NULL;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes the cached Cobs of the content and the content information
+----------------------------------------------------------------------------------------*/
+static void
+seg_content_drop (
+	CsmgrT_Stat* rcd							/* content information					*/
+) {
+	SegT_Content* con = seg_cons[rcd->index];
+	SegT_Chunk_Page* page;
+	uint32_t n, i;
+	
+	if (con) {
+		for (n = 0 ; n < con->page_max ; n++) {
+			page = con->pages[n];
+			if (page == NULL) {
+				continue;
+			}
+			for (i = 0 ; i < SegC_Chunk_Page_Num ; i++) {
+				if (page->loc[i].msg_len) {
+					seg_tbl[page->loc[i].seg].live -= page->loc[i].msg_len;
+				}
+			}
+			free (page);
+		}
+		hdl->cache_cobs -= con->cob_num;
+		free (con->pages);
+		free (con);
+		seg_cons[rcd->index] = NULL;
+	}
+	csmgrd_stat_content_info_delete (csmgr_stat_hdl, rcd->name, rcd->name_len);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Creates the segment files
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_segments_create (
+	void
+) {
+	char file_path[PATH_MAX];
+	DIR* root_dir;
+	int res;
+	int i;
+	
+	root_dir = opendir (hdl->seg_root_path);
+	if (root_dir == NULL) {
+		csmgrd_log_write (CefC_Log_Error,
+			"[%s] Root dir is not exist (%s)\n" , __func__, hdl->seg_root_path);
+		return (-1);
+	}
+	closedir (root_dir);
+	
+	res = snprintf (hdl->seg_cache_path, sizeof (hdl->seg_cache_path),
+			"%s/csmgr_seg_%d", hdl->seg_root_path, (int) getpid ());
+	if ((res < 0) || (res >= (int) sizeof (hdl->seg_cache_path))) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to cache_path name create\n");
+		return (-1);
+	}
+	if ((mkdir (hdl->seg_cache_path, 0766) != 0) && (errno != EEXIST)) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to create the cache directory in %s (%s)\n",
+			hdl->seg_root_path, strerror (errno));
+		hdl->seg_cache_path[0] = 0x00;
+		return (-1);
+	}
+	
+	seg_tbl = (SegT_Segment*) calloc (hdl->segment_num, sizeof (SegT_Segment));
+	if (seg_tbl == NULL) {
+		return (-1);
+	}
+	for (i = 0 ; i < hdl->segment_num ; i++) {
+		seg_tbl[i].fd = -1;
+	}
+	for (i = 0 ; i < hdl->segment_num ; i++) {
+		sprintf (file_path, "%s/%d", hdl->seg_cache_path, i);
+		seg_tbl[i].fd = open (file_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+		if (seg_tbl[i].fd < 0) {
+			csmgrd_log_write (CefC_Log_Error,
+				"Failed to create the segment file %s (%s)\n", file_path, strerror (errno));
+			return (-1);
+		}
+	
+		/* Allocates the blocks in advance so that the appends do not extend the file */
+		res = posix_fallocate (seg_tbl[i].fd, 0, (off_t) hdl->segment_size);
+		if (res == ENOSPC) {
+			csmgrd_log_write (CefC_Log_Error,
+				"No space left for the segment file %s\n", file_path);
+			return (-1);
+		}
+		if ((res != 0) && (ftruncate (seg_tbl[i].fd, (off_t) hdl->segment_size) != 0)) {
+			csmgrd_log_write (CefC_Log_Error,
+				"Failed to allocate the segment file %s (%s)\n", file_path, strerror (errno));
+			return (-1);
+		}
+		seg_tbl[i].state = SegC_Seg_Free;
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Closes and removes the segment files
+----------------------------------------------------------------------------------------*/
+static void
+seg_segments_destroy (
+	void
+) {
+	char file_path[PATH_MAX];
+	int i;
+	
+	if (seg_tbl) {
+		for (i = 0 ; i < hdl->segment_num ; i++) {
+			if (seg_tbl[i].fd < 0) {
+				continue;
+			}
+			close (seg_tbl[i].fd);
+			sprintf (file_path, "%s/%d", hdl->seg_cache_path, i);
+			unlink (file_path);
+			free (seg_tbl[i].sum);
+		}
+		free (seg_tbl);
+		seg_tbl = NULL;
+	}
+	seg_active = -1;
+	
+	if (hdl->seg_cache_path[0] != 0x00) {
+		rmdir (hdl->seg_cache_path);
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Function to increment access count
+----------------------------------------------------------------------------------------*/
+static void
+seg_cs_ac_cnt_inc (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seq_num							/* sequence number						*/
+) {
+	struct tlv_hdr* tlv_hdp;
+	int index = 0;
+	int find_chunk_f = 0;
+	uint16_t type;
+	uint16_t length;
+	
+	while (index < key_size) {
+		tlv_hdp = (struct tlv_hdr*) &key[index];
+		type 	= ntohs (tlv_hdp->type);
+		length 	= ntohs (tlv_hdp->length);
+	
+		if (length < 1) {
+			return;
+		}
+		if (type == CefC_T_CHUNK) {
+			find_chunk_f = 1;
+			break;
+		}
+		index += sizeof (struct tlv_hdr) + length;
+	}
+	
+	if (find_chunk_f) {
+		csmgrd_stat_access_count_update (
+				csmgr_stat_hdl, &key[0], index);
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	get lifetime for ccninfo
+----------------------------------------------------------------------------------------*/
+static int										/* This value MAY be -1 if the router does not know or cannot report. */
+seg_cache_lifetime_get (
+	unsigned char* name,						/* content name							*/
+	uint16_t name_len,							/* content name Length					*/
+	uint32_t* cache_time,						/* The elapsed time (seconds) after the oldest	*/
+												/* content object of the content is cached.		*/
+	uint32_t* lifetime,							/* The lifetime (seconds) of a content object, 	*/
+												/* which is removed first among the cached content objects.*/
+	uint8_t partial_f							/* when flag is 0, exact match			*/
+												/* when flag is 1, partial match		*/
+) {
+	CsmgrT_Stat* rcd = NULL;
+	uint64_t nowt;
+	struct timeval tv;
+	uint16_t name_len_wo_chunk;
+	uint32_t seqno = 0;
+	
+	*lifetime = 0;
+	*cache_time = 0;
+	
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	
+	pthread_mutex_lock (&seg_mutex);
+	if (partial_f != 0) {
+		rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, name, name_len);
+	} else {
+		name_len_wo_chunk = cef_frame_get_name_without_chunkno (name, name_len, &seqno);
+		if (name_len_wo_chunk == 0) {
+			pthread_mutex_unlock (&seg_mutex);
+			return (-1);
+		}
+		rcd = csmgrd_stat_content_info_access (csmgr_stat_hdl, name, name_len_wo_chunk);
+	}
+	if (!rcd || rcd->expire_f) {
+		pthread_mutex_unlock (&seg_mutex);
+		return (-1);
+	}
+	
+	*cache_time = (uint32_t)((nowt - rcd->cached_time) / 1000000);
+	if (rcd->expiry < nowt) {
+		*lifetime = 0;
+	} else {
+		*lifetime = (uint32_t)((rcd->expiry - nowt) / 1000000);
+	}
+	pthread_mutex_unlock (&seg_mutex);
+	
+	return (1);
+}
+#ifdef CefC_Ccore
+/*--------------------------------------------------------------------------------------
+	Change cache capacity
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_change_cap (
+	uint64_t cap								/* New capacity to set					*/
+) {
+	
+	if ((cap < 1) || (cap > 0xFFFFFFFFF)) {
+		csmgrd_log_write (CefC_Log_Error, "Invalid capacity\n");
+		return (-1);
+	}
+	
+	/* The cached Cobs are kept, and no Cob is added while the capacity is exceeded */
+	pthread_mutex_lock (&seg_mutex);
+	hdl->cache_capacity = cap;
+	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, cap);
+	pthread_mutex_unlock (&seg_mutex);
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Set content lifetime
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cache_set_lifetime (
+	unsigned char* name,						/* Content name							*/
+	uint16_t name_len,							/* Content name length					*/
+	uint64_t lifetime							/* Content Lifetime						*/
+) {
+	uint64_t nowt;
+	struct timeval tv;
+	uint64_t new_life;
+	
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	new_life = nowt + lifetime * 1000000llu;
+	
+	/* Updtes the content information */
+	csmgrd_stat_content_lifetime_update (csmgr_stat_hdl, name, name_len, new_life);
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Delete content entry
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_cache_del (
+	unsigned char* name,						/* Content name							*/
+	uint16_t name_len,							/* Content name length					*/
+	uint32_t chunk_num							/* ChunkNumber							*/
+) {
+	CsmgrT_Stat* rcd;
+	
+	pthread_mutex_lock (&seg_mutex);
+	rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, name, name_len);
+	if (!rcd) {
+		pthread_mutex_unlock (&seg_mutex);
+		return (-1);
+	}
+	seg_cob_remove (rcd->index, chunk_num);
+	pthread_mutex_unlock (&seg_mutex);
+	
+	return (0);
+}
+#endif // CefC_Ccore
+/*--------------------------------------------------------------------------------------
+	Read config file
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+seg_config_read (
+	SegT_Config_Param* params					/* record parameters					*/
+) {
+	FILE*	fp = NULL;								/* file pointer						*/
+	char	file_name[PATH_MAX];					/* file name						*/
+	
+	char	param[4096] = {0};						/* parameter						*/
+	char	param_buff[4096] = {0};					/* param buff						*/
+	int		len;									/* read length						*/
+	
+	char*	option;									/* deny option						*/
+	char*	value;									/* parameter						*/
+	char*	endptr;
+	
+	int 	res;
+	int		i, n;
+	
+	/* Inits parameters		*/
+	memset (params, 0, sizeof (SegT_Config_Param));
+	strcpy (params->seg_root_path, csmgr_conf_dir);
+	params->cache_capacity 	= 819200;
+	params->segment_size 	= SegC_Def_Segment_Size;
+	params->segment_num 	= SegC_Def_Segment_Num;
+	
+	/* Obtains the directory path where the csmgrd's config file is located. */
+	res = snprintf (file_name, sizeof (file_name), "%s/csmgrd.conf", csmgr_conf_dir);
+	if ((res < 0) || (res >= (int) sizeof (file_name))) {
+		csmgrd_log_write (CefC_Log_Error, "[%s] Invalid config path\n", __func__);
+		return (-1);
+	}
+	
+	/* Opens the config file. */
+	fp = fopen (file_name, "r");
+	if (fp == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "[%s] open %s\n", __func__, file_name);
+		return (-1);
+	}
+	
+	/* get parameter	*/
+	while (fgets (param_buff, sizeof (param_buff), fp) != NULL) {
+	
+		/* Trims a read line 		*/
+		len = strlen (param_buff);
+		if ((param_buff[0] == '#') || (param_buff[0] == '\n') || (len == 0)) {
+			continue;
+		}
+		if (param_buff[len - 1] == '\n') {
+			param_buff[len - 1] = '\0';
+		}
+		for (i = 0, n = 0 ; i < len ; i++) {
+			if (param_buff[i] != ' ') {
+				param[n] = param_buff[i];
+				n++;
+			}
+		}
+		param[n] = '\0';
+	
+		/* Gets option */
+		value 	= param;
+		option 	= strsep (&value, "=");
+	
+		if (value == NULL) {
+			continue;
+		}
+	
+		/* Records a parameter 			*/
+		if (strcmp (option, "CACHE_PATH") == 0) {
+			res = strlen (value);
+			if (res >= CefC_Csmgr_File_Path_Length) {
+				csmgrd_log_write (
+					CefC_Log_Error, "[%s] Invalid value %s=%s\n", __func__, option, value);
+				fclose (fp);
+				return (-1);
+			}
+			strcpy (params->seg_root_path, value);
+		} else if (strcmp (option, "CACHE_CAPACITY") == 0) {
+			endptr = "";
+			params->cache_capacity = strtoul (value, &endptr, 0);
+			if ((strcmp (endptr, "") != 0) ||
+				(params->cache_capacity < 1) || (params->cache_capacity > 0xFFFFFFFFF)) {
+				csmgrd_log_write (CefC_Log_Error,
+				"CACHE_CAPACITY must be between 1 and 68,719,476,735 (0xFFFFFFFFF) inclusive.\n");
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "CACHE_SEGMENT_SIZE") == 0) {
+			endptr = "";
+			params->segment_size = strtoull (value, &endptr, 0);
+			if ((strcmp (endptr, "") != 0) ||
+				(params->segment_size < SegC_Min_Segment_Size) ||
+				(params->segment_size > SegC_Max_Segment_Size)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"CACHE_SEGMENT_SIZE must be between %d and %d inclusive.\n",
+					SegC_Min_Segment_Size, SegC_Max_Segment_Size);
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "CACHE_SEGMENT_NUM") == 0) {
+			res = atoi (value);
+			if (!(SegC_Min_Segment_Num <= res && res <= SegC_Max_Segment_Num)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"CACHE_SEGMENT_NUM must be between %d and %d inclusive.\n",
+					SegC_Min_Segment_Num, SegC_Max_Segment_Num);
+				fclose (fp);
+				return (-1);
+			}
+			params->segment_num = res;
+		} else {
+			/* NOP */;
+		}
+	}
+	fclose (fp);
+	
+	if (!(    access (params->seg_root_path, F_OK) == 0
+		   && access (params->seg_root_path, R_OK) == 0
+   		   && access (params->seg_root_path, W_OK) == 0
+   		   && access (params->seg_root_path, X_OK) == 0)) {
+		cef_log_write (CefC_Log_Error,
+			"Invalid segment cache root path(%s) - %s\n",
+			params->seg_root_path, strerror (errno));
+		return (-1);
+	}
+#ifdef CefC_Debug
+	csmgrd_dbg_write (CefC_Dbg_Fine, "params->cache_capacity="FMTU64"\n",
+						params->cache_capacity);
+	csmgrd_dbg_write (CefC_Dbg_Fine, "params->segment_size="FMTU64"\n",
+						params->segment_size);
+	csmgrd_dbg_write (CefC_Dbg_Fine, "params->segment_num=%d\n",
+						params->segment_num);
+#endif // CefC_Debug
+	
+	return (0);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2016-2021, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * segment_cache.h
+ */
+#ifndef __CSMGRD_SEGMENT_CACHE_HEADER__
+#define __CSMGRD_SEGMENT_CACHE_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include <cefore/cef_define.h>
+#include <cefore/cef_csmgr.h>
+#include <csmgrd/csmgrd_plugin.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+/*------------------------------------------------------------------
+	Limitation
+--------------------------------------------------------------------*/
+#define SegC_Min_Segment_Size			0x100000		/* 1MB							*/
+#define SegC_Max_Segment_Size			0x40000000		/* 1GB							*/
+#define SegC_Def_Segment_Size			0x4000000		/* 64MB							*/
+#define SegC_Min_Segment_Num			3
+#define SegC_Max_Segment_Num			4096
+#define SegC_Def_Segment_Num			16
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+typedef struct {
+	
+	/********** Segment Cache Information ***********/
+	char			seg_root_path[CefC_Csmgr_File_Path_Length];
+												/* directory of the segment files		*/
+	uint64_t 		cache_capacity;				/* maximum number of cached Cobs		*/
+	uint64_t 		segment_size;				/* bytes of a segment file				*/
+	int 			segment_num;				/* number of the segment files			*/
+	
+} SegT_Config_Param;
+
+typedef struct {
+	
+	/********** Segment Cache Status ***********/
+	char			seg_root_path[CefC_Csmgr_File_Path_Length];
+	char			seg_cache_path[CefC_Csmgr_File_Path_Length];
+												/* directory of the segment files		*/
+	uint64_t 		cache_capacity;				/* maximum number of cached Cobs		*/
+	uint64_t 		cache_cobs;					/* number of cached Cobs				*/
+	uint64_t 		segment_size;				/* bytes of a segment file				*/
+	int 			segment_num;				/* number of the segment files			*/
+	
+} SegT_Cache_Handle;
+
+#endif // __CSMGRD_SEGMENT_CACHE_HEADER__
@@ -43,6 +43,7 @@
 #include <cefore/cef_rngque.h>
 #include <cefore/cef_hash.h>
 #include <cefore/cef_pit.h>
+#include <cefore/cef_csmgr_shm.h>
 
 /****************************************************************************************
  Macros
@@ -120,7 +121,9 @@
 #define CefC_Csmgr_Msg_Type_RCCH		0x12		/* Type Retrieve cache chunk		*/
 #define CefC_Csmgr_Msg_Type_SCDL		0x13		/* Type Delete cache				*/
 #define CefC_Csmgr_Msg_Type_PreCcninfo	0x14		/* Type Prepare Ccninfo message		*/
-#define CefC_Csmgr_Msg_Type_Num			0x15
+#define CefC_Csmgr_Msg_Type_ShmRing		0x15		/* Type Shared memory ring setup	*/
+#define CefC_Csmgr_Msg_Type_Credit		0x16		/* Type Upload credit request		*/
+#define CefC_Csmgr_Msg_Type_Num			0x17
 
 #define CefC_Csmgr_Cob_Exist			0x00		/* Type Content is exist			*/
 #define CefC_Csmgr_Cob_NotExist			0x01		/* Type Content is not exist		*/
@@ -137,16 +140,46 @@
 /*------------------------------------------------------------------*/
 #define CefC_Csmgr_Interest_Type_Invalid	0x00	/* Type Invalid						*/
 #define CefC_Csmgr_Interest_Type_Normal		0x01	/* Type Interest					*/
-#define CefC_Csmgr_Interest_Type_Num		0x02
+#define CefC_Csmgr_Interest_Type_Pending	0x02	/* Type Interest with Request ID	*/
+#define CefC_Csmgr_Interest_Type_Num		0x03
 
 #define CefC_Csmgr_Interest_ChunkNum_NotExist	0	/* Chunk Num Flag off				*/
 #define CefC_Csmgr_Interest_ChunkNum_Exist		1	/* Chunk Num Flag on				*/
 
+/*------------------------------------------------------------------*/
+/* Lookup result for the Interest with Request ID (csmgrd->cefnetd)	*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_PT_LOOKUP_RES		0x07		/* PT next to CefC_PT_PING_REP		*/
+#define CefC_Csmgr_Lookup_Res_Len		(CefC_S_Fix_Header + 5)
+													/* Request ID(4) + Result(1)		*/
+#define CefC_Csmgr_Lookup_Miss			0x00
+#define CefC_Csmgr_Lookup_Hit			0x01
+
+#define CefC_Csmgr_Pending_Max			4096		/* Lookups held at once (2^n)		*/
+#define CefC_Csmgr_Def_Lookup_Timeout	20			/* Default wait for the result (ms)	*/
+#define CefC_Csmgr_Max_Lookup_Timeout	1000		/* Max wait for the result (ms)		*/
+
+/*------------------------------------------------------------------*/
+/* Upload credit (csmgrd->cefnetd)									*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_PT_UPLOAD_CREDIT		0x08		/* PT next to the lookup result		*/
+#define CefC_Csmgr_Credit_Len			(CefC_S_Fix_Header + 12)
+													/* Received(8) + Window(4)			*/
+#define CefC_Csmgr_Credit_Req_Len		(CefC_Csmgr_Msg_HeaderLen + 4)
+													/* Window(4)						*/
+#define CefC_Csmgr_Def_Upload_Window	8192		/* Default window (KB)				*/
+#define CefC_Csmgr_Min_Upload_Window	1024		/* Min window (KB)					*/
+#define CefC_Csmgr_Max_Upload_Window	65536		/* Max window (KB)					*/
+#define CefC_Csmgr_Credit_Req_Intvl		1000000		/* Interval to request (us)			*/
+#define CefC_Csmgr_Credit_Stale			3000000		/* Credit without grant is stale(us)	*/
+#define CefC_Csmgr_Credit_Resync		500000		/* Bytes not received are lost (us)	*/
+
 /*------------------------------------------------------------------*/
 /* Macros for get csmgr status										*/
 /*------------------------------------------------------------------*/
 #define CefC_Csmgr_Stat_MaxUri			128
 #define CefC_Csmgr_Stat_Mtu				65535
+#define CefC_Csmgr_Stat_Buffer			0x0001		/* Statistics of the page buffer	*/
 
 /*------------------------------------------------------------------*/
 /* Macros for Massage Buffer										*/
@@ -178,6 +211,18 @@ typedef enum {
  Structure Declarations
  ****************************************************************************************/
 
+/********** Interest held until csmgrd answers the lookup 	**********/
+typedef struct {
+
+	uint32_t		id;							/* Request ID							*/
+	uint16_t		faceid;						/* Face-ID the Interest came from		*/
+	uint16_t		msg_len;
+	uint8_t			hit_f;						/* 1: csmgrd answered that it sent Cob	*/
+	uint64_t		deadline;					/* forwarded upstream after this (us)	*/
+	unsigned char*	msg;						/* the Interest (follows this structure)*/
+
+} CefT_Csmgr_Pending;
+
 typedef struct {
 
 	/********** Content Store Information	***********/
@@ -221,11 +266,41 @@ typedef struct {
 	/********** local Cache Information ***********/
 	uint32_t		local_cache_capacity;			/* Cache Capacity						*/
 	uint32_t		local_cache_interval;			/* Expired check cycle (sec)			*/
-	int 			pipe_fd[2];						/* socket of cefnetd->Local cache		*/
-													/*  0: for cefnetd						*/
-													/*  1: for Local cache				*/
 	int				to_csmgrd_pipe_fd[2];
-
+	unsigned char	local_cob[CefC_Max_Length];	/* Cob copied from the local cache		*/
+
+	/********** Shared memory rings with local csmgrd ***********/
+	uint32_t		shm_ring_size;				/* Ring size (KB), 0: disabled			*/
+	CefT_Csmgr_Shm*	shm;						/* NULL while the socket path is used	*/
+	unsigned char*	shm_upload_wp;				/* Upload record being filled			*/
+	uint32_t		shm_upload_len;				/* Bytes written in shm_upload_wp		*/
+	uint32_t		shm_summary_size;			/* Summary size (KB), 0: disabled		*/
+	uint64_t		summary_skip;				/* Lookups not sent (not cached)		*/
+	uint64_t		summary_pass;				/* Lookups sent (may be cached)			*/
+	
+	/********** Lookups held until csmgrd answers ***********/
+	uint32_t		lookup_timeout;				/* Wait for the result (ms), 0: no hold	*/
+	CefT_Csmgr_Pending** pending;				/* [CefC_Csmgr_Pending_Max]				*/
+	uint32_t		pending_next;				/* Request ID of the next lookup		*/
+	uint32_t		pending_oldest;				/* Oldest Request ID which may be held	*/
+	uint32_t		pending_num;				/* Number of the held Interests			*/
+	uint64_t		pending_hit;				/* Held Interests answered by csmgrd	*/
+	uint64_t		pending_miss;				/* forwarded on the miss result			*/
+	uint64_t		pending_timeout;			/* forwarded at the deadline			*/
+	uint64_t		pending_unsent;				/* Hits whose Cob did not arrive		*/
+	uint64_t		pending_full;				/* not held because the table is full	*/
+	
+	/********** Upload credit granted by csmgrd ***********/
+	uint32_t		upload_window;				/* Window requested (KB), 0: no credit	*/
+	int				upload_credit_f;			/* 1: upload_limit is granted by csmgrd	*/
+	uint64_t		upload_sent;				/* Bytes of Upload Requests sent		*/
+	uint64_t		upload_limit;				/* upload_sent must not exceed this		*/
+	uint64_t		upload_acked;				/* Bytes received by csmgrd				*/
+	uint64_t		upload_acked_t;				/* Time when upload_acked changed		*/
+	uint64_t		upload_grant_t;				/* Time of the last grant				*/
+	uint64_t		upload_req_t;				/* Time of the last request				*/
+	uint64_t		upload_suppressed;			/* Uploads not sent for lack of credit	*/
+	uint64_t		upload_resync;				/* Bytes regarded as lost in transit	*/
 	
 } CefT_Cs_Stat;
 
@@ -289,6 +364,18 @@ struct CefT_Csmgr_Status_Rep {
 	
 } __attribute__((__packed__));
 
+/* Follows the contents in the status response when the cache plugin buffers pages.	*/
+/* It is shorter than CefT_Csmgr_Status_Rep, so older parsers stop before it.		*/
+struct CefT_Csmgr_Status_Buffer {
+	
+	uint16_t 		type;						/* CefC_Csmgr_Stat_Buffer			*/
+	uint16_t 		length;						/* length of the following fields	*/
+	uint64_t 		hits;
+	uint64_t 		misses;
+	uint64_t 		readaheads;
+	
+} __attribute__((__packed__));
+
 struct CefT_Csmgr_CnpbStatus_TL {
 	uint16_t 	type;
 	uint16_t 	length;
@@ -399,6 +486,64 @@ cef_csmgr_excache_lookup (
 	CefT_Parsed_Opheader* poh,				/* Parsed Option Header						*/
 	CefT_Pit_Entry* pe						/* PIT entry								*/
 );
+/*--------------------------------------------------------------------------------------
+	Asks csmgrd for the Cob and holds the Interest until csmgrd answers
+----------------------------------------------------------------------------------------*/
+int											/* 1: the Interest is held, the caller must	*/
+											/* not forward it now. 0: not held			*/
+cef_csmgr_excache_lookup_hold (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int faceid,								/* Face-ID to reply to the origin of 		*/
+											/* transmission of the message(s)			*/
+	CefT_Parsed_Message* pm,				/* Parsed CEFORE message					*/
+	CefT_Parsed_Opheader* poh,				/* Parsed Option Header						*/
+	CefT_Pit_Entry* pe,						/* PIT entry								*/
+	unsigned char* msg,						/* the Interest								*/
+	uint16_t msg_len,
+	uint64_t nowt							/* present time (us)						*/
+);
+/*--------------------------------------------------------------------------------------
+	Handles the lookup result from csmgrd
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Pending*							/* Interest to be forwarded upstream, 		*/
+											/* NULL if nothing is to be forwarded		*/
+cef_csmgr_lookup_res_process (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	unsigned char* msg,						/* lookup result message					*/
+	uint16_t msg_len
+);
+/*--------------------------------------------------------------------------------------
+	Takes the held Interest whose deadline has passed
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Pending*							/* NULL if there is no such Interest		*/
+cef_csmgr_pending_expired_take (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	uint64_t nowt							/* present time (us)						*/
+);
+/*--------------------------------------------------------------------------------------
+	Frees the held Interest
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_pending_free (
+	CefT_Csmgr_Pending* pd
+);
+/*--------------------------------------------------------------------------------------
+	Handles the upload credit granted by csmgrd
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_upload_credit_process (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	unsigned char* msg,						/* upload credit message					*/
+	uint16_t msg_len
+);
+/*--------------------------------------------------------------------------------------
+	Requests the upload credit to csmgrd, and expires the credit not refreshed
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_upload_credit_check (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	uint64_t nowt							/* current time (usec)						*/
+);
 /*--------------------------------------------------------------------------------------
 	Get frame from received message
 ----------------------------------------------------------------------------------------*/
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2016-2021, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_csmgr_shm.h
+ */
+
+#ifndef __CEF_CSMGR_SHM_HEADER__
+#define __CEF_CSMGR_SHM_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+/*------------------------------------------------------------------*/
+/* Rings shared between cefnetd and csmgrd							*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_Shm_Ring_Req			0		/* Interest/Increment (cefnetd->csmgrd)	*/
+#define CefC_Csmgr_Shm_Ring_Upload		1		/* Upload Request (cefnetd->csmgrd)		*/
+#define CefC_Csmgr_Shm_Ring_Obj			2		/* Content Object (csmgrd->cefnetd)		*/
+#define CefC_Csmgr_Shm_Ring_Num			3
+
+/* memfd + one doorbell (eventfd) per ring, passed with SCM_RIGHTS 		*/
+#define CefC_Csmgr_Shm_Fd_Num			(CefC_Csmgr_Shm_Ring_Num + 1)
+
+#define CefC_Csmgr_Shm_Magic			0x63736d72	/* "csmr" 						*/
+#define CefC_Csmgr_Shm_Def_Ring_Size	4096		/* Default ring size (KB) 			*/
+#define CefC_Csmgr_Shm_Min_Ring_Size	256			/* Minimum ring size (KB) 			*/
+#define CefC_Csmgr_Shm_Max_Ring_Size	65536		/* Maximum ring size (KB) 			*/
+#define CefC_Csmgr_Shm_Batch_Max		65536		/* Max size of an upload record 	*/
+
+/*------------------------------------------------------------------*/
+/* Summary of the cached Cobs published by csmgrd					*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_Summary_Def_Size		1024		/* Default bitmap size (KB) 		*/
+#define CefC_Csmgr_Summary_Min_Size		64			/* Minimum bitmap size (KB) 		*/
+#define CefC_Csmgr_Summary_Max_Size		8192		/* Maximum bitmap size (KB) 		*/
+#define CefC_Csmgr_Summary_Hash_Num		4			/* Bits set for one Cob 			*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+/********** Ring positions in the shared segment (one cache line each) 	**********/
+typedef struct {
+
+	volatile uint64_t	head;				/* written by the producer 					*/
+	uint8_t				pad1[56];
+	volatile uint64_t	tail;				/* written by the consumer 					*/
+	uint8_t				pad2[56];
+
+} CefT_Csmgr_Shm_Ring_Ctrl;
+
+/********** Summary (Bloom filter) control in the shared segment 	**********/
+typedef struct {
+
+	uint32_t			bits_log2;			/* log2 of the bitmap size in bits (0: none)*/
+	volatile uint32_t	ready;				/* set by csmgrd when the bitmap is valid 	*/
+	volatile uint64_t	queries;			/* Interests csmgrd received while ready 	*/
+	volatile uint64_t	misses;				/* those which did not hit in csmgrd 		*/
+	uint8_t				pad[40];
+
+} CefT_Csmgr_Shm_Summary_Ctrl;
+
+/********** Top of the shared segment 	**********/
+typedef struct {
+
+	uint32_t			magic;
+	uint32_t			ring_size;			/* bytes of each ring (power of two) 		*/
+	volatile uint32_t	attached;			/* set by csmgrd when it serves the rings 	*/
+	uint8_t				pad[52];
+	CefT_Csmgr_Shm_Ring_Ctrl ctrl[CefC_Csmgr_Shm_Ring_Num];
+	CefT_Csmgr_Shm_Summary_Ctrl summary;
+
+} CefT_Csmgr_Shm_Hdr;
+
+/********** Process local view of one ring 	**********/
+typedef struct {
+
+	CefT_Csmgr_Shm_Ring_Ctrl* ctrl;
+	unsigned char*		data;
+	uint64_t			mask;
+	int					doorbell;			/* eventfd 									*/
+
+	/* producer side 	*/
+	uint64_t			rsv_pos;			/* position of the reserved record 			*/
+	uint32_t			rsv_len;			/* reserved length (0: none) 				*/
+
+	/* consumer side 	*/
+	uint64_t			rd_next;			/* position following the record read 		*/
+
+} CefT_Csmgr_Shm_Ring;
+
+typedef struct {
+
+	CefT_Csmgr_Shm_Hdr*	hdr;
+	size_t				map_len;
+	int					fds[CefC_Csmgr_Shm_Fd_Num];
+	CefT_Csmgr_Shm_Ring	ring[CefC_Csmgr_Shm_Ring_Num];
+	uint64_t*			summary;			/* bitmap (NULL: no summary) 				*/
+	uint64_t			summary_mask;		/* number of bits - 1 						*/
+
+} CefT_Csmgr_Shm;
+
+/********** Counting Bloom filter behind the bitmap (csmgrd side) 	**********/
+typedef struct {
+
+	CefT_Csmgr_Shm*		shm;
+	uint8_t*			cnt;				/* counter of each bit (saturates at 255) 	*/
+	uint64_t			mask;
+	uint64_t			cob_num;			/* number of Cobs in the filter 			*/
+	int					saturated_f;		/* 1: a cached Cob is not in the filter 	*/
+
+} CefT_Csmgr_Summary;
+
+/****************************************************************************************
+ Function Declarations
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the shared segment and the doorbells (cefnetd side)
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Shm*								/* NULL if not supported or an error occurs	*/
+cef_csmgr_shm_create (
+	uint32_t ring_kb,						/* size of each ring (KB)					*/
+	uint32_t summary_kb						/* size of the summary bitmap (KB), 0: none	*/
+);
+/*--------------------------------------------------------------------------------------
+	Maps the shared segment received from cefnetd (csmgrd side)
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Shm*								/* NULL if an error occurs					*/
+cef_csmgr_shm_attach (
+	int fds[], 								/* memfd and doorbells (ownership is taken)	*/
+	int fd_num
+);
+/*--------------------------------------------------------------------------------------
+	Unmaps the shared segment and closes the descriptors
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_destroy (
+	CefT_Csmgr_Shm* shm
+);
+/*--------------------------------------------------------------------------------------
+	Returns whether the peer serves the rings
+----------------------------------------------------------------------------------------*/
+int
+cef_csmgr_shm_ready (
+	CefT_Csmgr_Shm* shm
+);
+/*--------------------------------------------------------------------------------------
+	Sets/clears the flag which tells the peer that the rings are served
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_attached_set (
+	CefT_Csmgr_Shm* shm,
+	int attached
+);
+/*--------------------------------------------------------------------------------------
+	Sends the descriptors to csmgrd over the local socket
+----------------------------------------------------------------------------------------*/
+int											/* The return value is negative if an error occurs	*/
+cef_csmgr_shm_handshake_send (
+	int sock, 								/* local socket connected to csmgrd			*/
+	CefT_Csmgr_Shm* shm
+);
+/*--------------------------------------------------------------------------------------
+	Receives from the local socket and collects the descriptors passed with it
+----------------------------------------------------------------------------------------*/
+int											/* same as recv(2)							*/
+cef_csmgr_shm_recv (
+	int sock, 
+	unsigned char* buff, 
+	int buff_len, 
+	int fds[], 								/* [CefC_Csmgr_Shm_Fd_Num] 					*/
+	int* fd_num								/* number of descriptors held in fds		*/
+);
+/*--------------------------------------------------------------------------------------
+	Reserves a record in the ring and returns the area to write
+----------------------------------------------------------------------------------------*/
+unsigned char*								/* NULL if the ring is full					*/
+cef_csmgr_shm_reserve (
+	CefT_Csmgr_Shm_Ring* ring, 
+	uint32_t len
+);
+/*--------------------------------------------------------------------------------------
+	Publishes the reserved record with the length actually written
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_commit (
+	CefT_Csmgr_Shm_Ring* ring, 
+	uint32_t len
+);
+/*--------------------------------------------------------------------------------------
+	Copies a message into the ring
+----------------------------------------------------------------------------------------*/
+int											/* The return value is negative if full		*/
+cef_csmgr_shm_write (
+	CefT_Csmgr_Shm_Ring* ring, 
+	const unsigned char* msg, 
+	uint32_t len
+);
+/*--------------------------------------------------------------------------------------
+	Returns the oldest record in the ring
+----------------------------------------------------------------------------------------*/
+unsigned char*								/* NULL if the ring is empty				*/
+cef_csmgr_shm_read (
+	CefT_Csmgr_Shm_Ring* ring, 
+	uint32_t* len
+);
+/*--------------------------------------------------------------------------------------
+	Releases the record returned by cef_csmgr_shm_read
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_release (
+	CefT_Csmgr_Shm_Ring* ring
+);
+/*--------------------------------------------------------------------------------------
+	Clears the doorbell of the ring
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_doorbell_clear (
+	CefT_Csmgr_Shm_Ring* ring
+);
+/*--------------------------------------------------------------------------------------
+	Calculates the hash of a Cob used by the summary
+----------------------------------------------------------------------------------------*/
+uint64_t
+cef_csmgr_summary_hash (
+	const unsigned char* name, 				/* name without the chunk number			*/
+	uint16_t name_len, 
+	uint32_t chnk_num
+);
+/*--------------------------------------------------------------------------------------
+	Tests whether the summary published by csmgrd may hold the Cob
+----------------------------------------------------------------------------------------*/
+int											/* 0: not cached, 1: may be cached, 		*/
+											/* -1: no valid summary						*/
+cef_csmgr_summary_test (
+	CefT_Csmgr_Shm* shm, 
+	uint64_t hash
+);
+/*--------------------------------------------------------------------------------------
+	Creates the counting filter behind the bitmap of the segment (csmgrd side)
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Summary*							/* NULL if the segment has no summary		*/
+cef_csmgr_summary_create (
+	CefT_Csmgr_Shm* shm
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the counting filter
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_destroy (
+	CefT_Csmgr_Summary* sum
+);
+/*--------------------------------------------------------------------------------------
+	Adds/removes a Cob to/from the summary
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_add (
+	CefT_Csmgr_Summary* sum, 
+	uint64_t hash
+);
+void
+cef_csmgr_summary_remove (
+	CefT_Csmgr_Summary* sum, 
+	uint64_t hash
+);
+/*--------------------------------------------------------------------------------------
+	Sets/clears the flag which tells cefnetd that the summary is valid
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_ready_set (
+	CefT_Csmgr_Summary* sum, 
+	int ready
+);
+/*--------------------------------------------------------------------------------------
+	Invalidates the summary for good, because a cached Cob could not be added to it
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_saturate (
+	CefT_Csmgr_Summary* sum
+);
+
+#endif // __CEF_CSMGR_SHM_HEADER__
@@ -52,6 +52,7 @@
 #include <cefore/cef_define.h>
 #include <cefore/cef_ccninfo.h>
 #include <cefore/cef_log.h>
+#include <cefore/cef_csmgr_shm.h>
 
 /****************************************************************************************
  Macros
@@ -259,6 +260,15 @@ csmgr_stat_content_lifetime_update (
 	uint16_t name_len, 
 	uint64_t expiry
 );
+/*--------------------------------------------------------------------------------------
+	Calls the function for each content information holding the lock
+----------------------------------------------------------------------------------------*/
+uint32_t 
+csmgr_stat_content_info_walk (
+	CsmgrT_Stat_Handle hdl, 
+	void (*func)(CsmgrT_Stat* rcd, void* arg), 
+	void* arg
+);
 /*--------------------------------------------------------------------------------------
 	Obtains the number of cached content
 ----------------------------------------------------------------------------------------*/
@@ -326,6 +336,15 @@ csmgr_stat_cob_remove_for_pub (
 	uint32_t cob_size
 );
 
+/*--------------------------------------------------------------------------------------
+	Sets the summary which follows the cached Cobs
+----------------------------------------------------------------------------------------*/
+void 
+csmgr_stat_summary_set (
+	CsmgrT_Stat_Handle hdl, 
+	CefT_Csmgr_Summary* summary			/* NULL stops updating the summary			*/
+);
+
 /****************************************************************************************
  Function Alias Declarations
  ****************************************************************************************/
@@ -366,6 +385,10 @@ csmgr_stat_cob_remove_for_pub (
 		 csmgr_stat_cached_cob_num_get(hdl)
 #define csmgrd_stat_cache_capacity_get(hdl) \
 		 csmgr_stat_cache_capacity_get(hdl)
+#define csmgrd_stat_summary_set(hdl, summary) \
+		 csmgr_stat_summary_set(hdl, summary)
+#define csmgrd_stat_content_info_walk(hdl, func, arg) \
+		 csmgr_stat_content_info_walk(hdl, func, arg)
 
 /*--------------------------------------------------------------------------------------
 	for conpubd
@@ -137,6 +137,9 @@
 #define CefC_ParamName_CSMGR_ACCESS		"CSMGR_ACCESS"
 #define CefC_ParamName_BUFFER_CACHE_TIME	"BUFFER_CACHE_TIME"
 #define CefC_ParamName_LOCAL_CACHE_DEFAULT_RCT	"LOCAL_CACHE_DEFAULT_RCT"
+#define CefC_ParamName_VALID_WORKER_NUM	"VALID_WORKER_NUM"
+#define CefC_ParamName_VALID_CACHE_SIZE	"VALID_CACHE_SIZE"
+#define CefC_ParamName_VALID_CACHE_TIME	"VALID_CACHE_TIME"
 
 #ifdef CefC_Ser_Log
 #define CefC_ParamName_Log_Size			"SER_LOG_SIZE"
@@ -181,6 +184,9 @@
 #define CefC_Default_CSMGR_ACCESS_RW	0
 #define CefC_Default_CSMGR_ACCESS_RO	1
 #define CefC_Default_BUFFER_CACHE_TIME	10000
+#define CefC_Default_VALID_WORKER_NUM	0
+#define CefC_Default_VALID_CACHE_SIZE	4096
+#define CefC_Default_VALID_CACHE_TIME	60
 
 
 #ifdef CefC_Ccninfo
@@ -111,6 +111,7 @@ typedef struct {
 	uint32_t 		seqnum;
 	int 			ifindex;
 	int				bw_stat_i;	//0.8.3
+	uint32_t 		gen;						/* incremented when the Face is closed 	*/
 } CefT_Face;
 
 /********** Neighbor Management				**********/
@@ -223,6 +224,13 @@ int										/* Returns the value less than 1 if it fails 	*/
 cef_face_check_close (
 	int faceid								/* Face-ID									*/
 );
+/*--------------------------------------------------------------------------------------
+	Obtains the generation of the specified Face-ID, which changes when it is closed
+----------------------------------------------------------------------------------------*/
+uint32_t 
+cef_face_gen_get (
+	uint16_t 	faceid						/* Face-ID									*/
+);
 /*--------------------------------------------------------------------------------------
 	Obtains the Face structure from the specified Face-ID
 ----------------------------------------------------------------------------------------*/
@@ -204,6 +204,8 @@
 #define CefC_T_EC_SECP_256K1		0x0006
 #define CefC_T_EC_SECP_384R1		0x0007
 #define CefC_T_KEY_CHECK			0x1001
+#define CefC_T_ECDSA_P256			0x1002		/* ECDSA over NIST P-256 with SHA-256	*/
+#define CefC_T_ED25519				0x1003		/* Ed25519 (RFC 8032)					*/
 
 /*------------------------------------------------------------------*/
 /* Validation Dependent Data Type Registry							*/
@@ -150,6 +150,17 @@ void *
 cef_mem_cache_put_thread (
 	void *p
 );
+/*--------------------------------------------------------------------------------------
+	Hands the parsed content object to the put thread (called only from the 
+	forwarding thread)
+----------------------------------------------------------------------------------------*/
+int
+cef_mem_cache_item_put (
+	const unsigned char* msg,					/* Content Object message				*/
+	uint16_t msg_len,							/* length of the message				*/
+	CefT_Parsed_Message* pm,					/* Parsed message of the object			*/
+	CefT_Parsed_Opheader* poh					/* Parsed Option Header of the object	*/
+);
 /*--------------------------------------------------------------------------------------
 	Thread to clear expirly content object of local cache
 ----------------------------------------------------------------------------------------*/
@@ -167,10 +178,13 @@ cef_mem_cache_item_set (
 /*--------------------------------------------------------------------------------------
 	Function to read a ContentObject from Local Cache
 ----------------------------------------------------------------------------------------*/
-CefMemCacheT_Content_Mem_Entry*
+int 								/* Length of the ContentObject, or 0 if it is not 	*/
+									/* cached 											*/
 cef_mem_cache_item_get (
 	unsigned char* trg_key,						/* content name							*/
-	uint16_t trg_key_len						/* content name Length					*/
+	uint16_t trg_key_len,						/* content name Length					*/
+	unsigned char* msg 							/* buffer (CefC_Max_Length) which the 	*/
+												/* ContentObject is copied to, or NULL	*/
 );
 /*--------------------------------------------------------------------------------------
 	Destroy local cache resources
@@ -38,6 +38,7 @@
  ****************************************************************************************/
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <pthread.h>
 
 /****************************************************************************************
@@ -66,6 +67,26 @@ typedef struct {
 	
 } CefT_Rngque;
 
+/********** Lock-free queue with multiple producers and a single consumer 	**********/
+typedef struct {
+
+	volatile uint64_t	seq;		/* position which the cell is ready for 			*/
+	void* 				body;
+
+} CefT_Mpsc_Cell;
+
+typedef struct {
+
+	CefT_Mpsc_Cell* 	cells;		/* line buffer 										*/
+	uint64_t 			mask;		/* capacity of the queue - 1 						*/
+	char 				pad1[48];	/* producers and consumer use separate lines 		*/
+	volatile uint64_t 	tail;		/* next position to push (producers) 				*/
+	char 				pad2[56];
+	volatile uint64_t 	head;		/* next position to pop (consumer) 					*/
+	char 				pad3[56];
+
+} CefT_Mpsc_Que;
+
 /****************************************************************************************
  Global Variables
  ****************************************************************************************/
@@ -103,4 +124,38 @@ cef_rngque_read (
 	CefT_Rngque* qp							/* Ring Queue Information 					*/
 );
 
+/*--------------------------------------------------------------------------------------
+	Creates the lock-free queue with multiple producers and a single consumer
+----------------------------------------------------------------------------------------*/
+CefT_Mpsc_Que* 								/* NULL if an error occurs 					*/
+cef_mpsc_que_create (
+	int capacity							/* Capacity of the queue 					*/
+);
+void
+cef_mpsc_que_destroy (
+	CefT_Mpsc_Que* qp						/* the queue 								*/
+);
+/*--------------------------------------------------------------------------------------
+	Inserts the item to the bottom of the queue (any thread)
+----------------------------------------------------------------------------------------*/
+int											/* 1: inserted, 0: the queue is full 		*/
+cef_mpsc_que_push (
+	CefT_Mpsc_Que* qp, 						/* the queue 								*/
+	void* item
+);
+/*--------------------------------------------------------------------------------------
+	Removes the item from the top of the queue (the consumer thread only)
+----------------------------------------------------------------------------------------*/
+void*										/* NULL if the queue is empty 				*/
+cef_mpsc_que_pop (
+	CefT_Mpsc_Que* qp						/* the queue 								*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the number of items in the queue
+----------------------------------------------------------------------------------------*/
+int
+cef_mpsc_que_num (
+	CefT_Mpsc_Que* qp						/* the queue 								*/
+);
+
 #endif // __CEF_NETD_HEADER__
@@ -38,15 +38,30 @@
  ****************************************************************************************/
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 
 /****************************************************************************************
  Macros
  ****************************************************************************************/
 
+#define CefC_Valid_Pool_Worker_Max		32		/* Maximum number of verification workers	*/
+#define CefC_Valid_Result_Cache_Max		1048576	/* Maximum number of verified results		*/
+												/* held in the result cache 				*/
+
 /****************************************************************************************
  Structure Declarations
  ****************************************************************************************/
 
+/***** Verification job handed to the verification worker pool 	*****/
+/*       Callers embed this structure at the top of their own context 	*/
+typedef struct {
+	
+	unsigned char* 	msg;						/* message to verify					*/
+	int 			msg_len;					/* length of the message				*/
+	int 			res;						/* result of cef_valid_msg_verify		*/
+	
+} CefT_Valid_Job;
+
 /****************************************************************************************
  Global Variables
  ****************************************************************************************/
@@ -92,6 +107,24 @@ cef_valid_keyid_create (
 	unsigned char* pubkey, 
 	unsigned char* keyid
 );
+/*--------------------------------------------------------------------------------------
+	Obtains the signature algorithm of the key used for the specified name
+----------------------------------------------------------------------------------------*/
+int 											/* CefC_T_RSA_SHA256, CefC_T_ECDSA_P256,*/
+												/* CefC_T_ED25519, or 0 if no key 		*/
+cef_valid_key_alg_get (
+	const unsigned char* name, 
+	int name_len
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the parsed public key cache
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_pubkey_cache_stat_get (
+	int* num, 									/* number of cached public keys			*/
+	uint64_t* hit, 
+	uint64_t* miss
+);
 int
 cef_valid_dosign (
 	const unsigned char* msg, 
@@ -107,6 +140,88 @@ cef_valid_msg_verify (
 	const unsigned char* msg, 
 	int msg_len
 );
+/*--------------------------------------------------------------------------------------
+	Obtains the validation algorithm type of the specified message
+----------------------------------------------------------------------------------------*/
+int 											/* CefC_T_XXX, 0 if the message has no 	*/
+												/* validation, or -1 if it is invalid	*/
+cef_valid_alg_type_get (
+	const unsigned char* msg, 
+	int msg_len
+);
+/*--------------------------------------------------------------------------------------
+	Starts the verification worker pool
+----------------------------------------------------------------------------------------*/
+int 											/* FD which becomes readable when 		*/
+												/* verified jobs are available, or -1	*/
+cef_valid_pool_init (
+	int worker_num 								/* number of worker threads				*/
+);
+/*--------------------------------------------------------------------------------------
+	Queues the job to the verification worker pool
+----------------------------------------------------------------------------------------*/
+int 											/* Returns a negative value if the 		*/
+												/* pool is not running or is full		*/
+cef_valid_pool_push (
+	CefT_Valid_Job* job
+);
+/*--------------------------------------------------------------------------------------
+	Clears the doorbell FD returned by cef_valid_pool_init
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_pool_ack (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Takes out the job whose verification was completed
+----------------------------------------------------------------------------------------*/
+CefT_Valid_Job* 								/* NULL if there is no completed job 	*/
+cef_valid_pool_pop (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the verification worker pool
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_pool_stat_get (
+	int* worker_num, 
+	int* inflight, 								/* number of jobs in the pool			*/
+	uint64_t* verified, 						/* jobs which passed verification		*/
+	uint64_t* failed, 							/* jobs which failed verification		*/
+	uint64_t* full 								/* jobs rejected because pool is full	*/
+);
+/*--------------------------------------------------------------------------------------
+	Stops the verification worker pool
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_pool_destroy (
+	void (*release)(CefT_Valid_Job*) 			/* called for each unreturned job		*/
+);
+/*--------------------------------------------------------------------------------------
+	Enables the cache of the messages whose signature was already verified
+----------------------------------------------------------------------------------------*/
+int 											/* Returns a negative value if failed 	*/
+cef_valid_result_cache_init (
+	int max_num, 								/* number of entries, 0 disables it		*/
+	int ttl_sec 								/* lifetime of an entry (seconds)		*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the verified result cache
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_result_cache_stat_get (
+	int* num, 									/* number of cached results				*/
+	int* max_num, 
+	uint64_t* hit, 
+	uint64_t* miss
+);
+/*--------------------------------------------------------------------------------------
+	Disables the verified result cache and releases its entries
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_result_cache_destroy (
+	void
+);
 #ifdef CefC_Ccninfo
 int 
 cef_valid_keyid_create_forccninfo (
@@ -104,6 +104,33 @@ cef_csmgr_interest_msg_create (
 	CefT_Parsed_Opheader* poh,				/* Parsed Option Header						*/
 	CefT_Parsed_Message* pm					/* Parsed CEFORE message					*/
 );
+/*--------------------------------------------------------------------------------------
+	Appends the Request ID to Interest message for csmgr
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_interest_msg_id_set (
+	unsigned char buff[],					/* Interest message							*/
+	uint16_t* index,						/* Length of message						*/
+	uint32_t id								/* Request ID								*/
+);
+/*--------------------------------------------------------------------------------------
+	Checks the summary published by csmgrd
+----------------------------------------------------------------------------------------*/
+static int									/* 1: the Cob is not cached in csmgrd		*/
+cef_csmgr_summary_skip (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	CefT_Parsed_Message* pm					/* Parsed CEFORE message					*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the Interest to csmgrd
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_excache_interest_send (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	CefT_Parsed_Message* pm,				/* Parsed CEFORE message					*/
+	CefT_Parsed_Opheader* poh,				/* Parsed Option Header						*/
+	uint32_t* id							/* Request ID, NULL if no result is needed	*/
+);
 /*--------------------------------------------------------------------------------------
 	Connect csmgr local socket
 ----------------------------------------------------------------------------------------*/
@@ -114,6 +141,21 @@ cef_csmgr_csmgr_connect_local (
 /*--------------------------------------------------------------------------------------
 	Send message from cefnetd to csmgr
 ----------------------------------------------------------------------------------------*/
+/*--------------------------------------------------------------------------------------
+	Sets up the shared memory rings with local csmgrd
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_shm_setup (
+	CefT_Cs_Stat* cs_stat					/* Content Store Status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the area to write an Upload Request in the upload ring
+----------------------------------------------------------------------------------------*/
+static unsigned char*						/* NULL if the socket path is to be used	*/
+cef_csmgr_shm_upload_area_get (
+	CefT_Cs_Stat* cs_stat,					/* Content Store Status						*/
+	uint32_t len							/* maximum length to write					*/
+);
 static int							/* The return value is negative if an error occurs	*/
 cef_csmgr_send_msg_to_csmgr (
 	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
@@ -148,8 +190,6 @@ cef_csmgr_stat_create (
 	cs_stat->tx_que = NULL;
 	cs_stat->local_sock = -1;
 	cs_stat->tcp_sock 	= -1;
-	cs_stat->pipe_fd[0] = -1;
-	cs_stat->pipe_fd[1] = -1;
 	cs_stat->to_csmgrd_pipe_fd[0] = -1;
 	cs_stat->to_csmgrd_pipe_fd[1] = -1;
 	
@@ -190,6 +230,10 @@ cef_csmgr_stat_create (
 				cef_log_write (CefC_Log_Error, "%s (connect to csmgrd)\n", __func__);
 				return (NULL);
 			}
+			/* Offers the shared memory rings, csmgrd moves to them when it attaches */
+			if (cs_stat->shm_ring_size > 0) {
+				cef_csmgr_shm_setup (cs_stat);
+			}
 		}
 		/*###########*/
 		{
@@ -224,6 +268,16 @@ cef_csmgr_stat_create (
 		}
 		}
 		/*###########*/
+		
+		/* Prepares the table of Interests held until csmgrd answers the lookup */
+		if (cs_stat->lookup_timeout > 0) {
+			cs_stat->pending = (CefT_Csmgr_Pending**) calloc (
+						CefC_Csmgr_Pending_Max, sizeof (CefT_Csmgr_Pending*));
+			if (cs_stat->pending == NULL) {
+				cef_log_write (CefC_Log_Warn, 
+					"%s (calloc pending table), Interests are not held\n", __func__);
+			}
+		}
 	}
 #ifdef CefC_Conpub
 	else
@@ -250,31 +304,6 @@ cef_csmgr_stat_create (
 		}
 	}
 #endif //CefC_Conpub
-#ifdef CefC_CefnetdCache 
-	else
-	if (cs_stat->cache_type == CefC_Cache_Type_Localcache) {
-		int flags;
-		/* Create socket for communication between cednetd and memory cache */
-		if ( socketpair(AF_UNIX,SOCK_DGRAM, 0, cs_stat->pipe_fd) == -1 ) {
-			cef_csmgr_stat_destroy (&cs_stat);
-			cef_log_write (CefC_Log_Error, "%s pair socket creation error (%s)\n"
-							, __func__, strerror(errno));
-			return (NULL);
-	  	}
-		/* Set cefnetd side socket as non-blocking I/O */
-		if ( (flags = fcntl(cs_stat->pipe_fd[0], F_GETFL, 0) ) < 0) {
-			cef_log_write (CefC_Log_Error, "%s fcntl error (%s)\n"
-							, __func__, strerror(errno));
-			return (NULL);
-		}
-		flags |= O_NONBLOCK;
-		if (fcntl(cs_stat->pipe_fd[0], F_SETFL, flags) < 0) {
-			cef_log_write (CefC_Log_Error, "%s fcntl error (%s)\n"
-							, __func__, strerror(errno));
-			return (NULL);
-		}
-	}
-#endif
 		
 	/* Create memory cache */
 	if (cs_stat->cache_type != CefC_Default_Cache_Type) {
@@ -340,7 +369,7 @@ cef_csmgr_stat_create (
 				return (NULL);
 			}
 			if (pthread_create(&cef_mem_cache_put_th, NULL
-							, &cef_mem_cache_put_thread, &(cs_stat->pipe_fd[1])) == -1) {
+							, &cef_mem_cache_put_thread, NULL) == -1) {
 				cef_csmgr_stat_destroy (&cs_stat);
 				cef_log_write (CefC_Log_Error
 								, "%s Failed to create the new thread(cef_mem_cache_put_thead)\n"
@@ -456,6 +485,12 @@ cef_csmgr_config_read (
 	cs_stat->def_rct		= CefC_Default_Def_Rct;
 	cs_stat->cache_cap 		= CefC_Default_Cache_Capacity;
 	cs_stat->tcp_port_num 	= CefC_Default_Tcp_Prot;
+	cs_stat->shm_ring_size 	= CefC_Csmgr_Shm_Def_Ring_Size;
+	cs_stat->shm_summary_size = CefC_Csmgr_Summary_Def_Size;
+	cs_stat->lookup_timeout = CefC_Csmgr_Def_Lookup_Timeout;
+	cs_stat->upload_window 	= CefC_Csmgr_Def_Upload_Window;
+	/* Uploads before the first grant are limited to the min window 	*/
+	cs_stat->upload_limit 	= CefC_Csmgr_Min_Upload_Window * 1024;
 	strcpy (cs_stat->peer_id_str, CefC_Default_Node_Path);
 #ifdef CefC_CefnetdCache
 	cs_stat->local_cache_capacity = 65535;
@@ -506,6 +541,48 @@ cef_csmgr_config_read (
 				return (-1);
 			}
 			cs_stat->tcp_port_num = res;
+		} else if (strcmp (option, "CSMGR_SHM_RING_SIZE") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res != 0) && 
+				((res < CefC_Csmgr_Shm_Min_Ring_Size) || 
+				 (res > CefC_Csmgr_Shm_Max_Ring_Size))) {
+				cef_log_write (CefC_Log_Warn, 
+					"CSMGR_SHM_RING_SIZE must be 0 or from %d to %d.\n", 
+					CefC_Csmgr_Shm_Min_Ring_Size, CefC_Csmgr_Shm_Max_Ring_Size);
+				return (-1);
+			}
+			cs_stat->shm_ring_size = (uint32_t) res;
+		} else if (strcmp (option, "CSMGR_SUMMARY_SIZE") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res != 0) && 
+				((res < CefC_Csmgr_Summary_Min_Size) || 
+				 (res > CefC_Csmgr_Summary_Max_Size))) {
+				cef_log_write (CefC_Log_Warn, 
+					"CSMGR_SUMMARY_SIZE must be 0 or from %d to %d.\n", 
+					CefC_Csmgr_Summary_Min_Size, CefC_Csmgr_Summary_Max_Size);
+				return (-1);
+			}
+			cs_stat->shm_summary_size = (uint32_t) res;
+		} else if (strcmp (option, "CSMGR_LOOKUP_TIMEOUT") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res < 0) || (res > CefC_Csmgr_Max_Lookup_Timeout)) {
+				cef_log_write (CefC_Log_Warn, 
+					"CSMGR_LOOKUP_TIMEOUT must be from 0 to %d.\n", 
+					CefC_Csmgr_Max_Lookup_Timeout);
+				return (-1);
+			}
+			cs_stat->lookup_timeout = (uint32_t) res;
+		} else if (strcmp (option, "CSMGR_UPLOAD_WINDOW") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res != 0) && 
+				((res < CefC_Csmgr_Min_Upload_Window) || 
+				 (res > CefC_Csmgr_Max_Upload_Window))) {
+				cef_log_write (CefC_Log_Warn, 
+					"CSMGR_UPLOAD_WINDOW must be 0 or from %d to %d.\n", 
+					CefC_Csmgr_Min_Upload_Window, CefC_Csmgr_Max_Upload_Window);
+				return (-1);
+			}
+			cs_stat->upload_window = (uint32_t) res;
 		} else if (strcmp (option, "LOCAL_SOCK_ID") == 0) {
 			if (strlen (value) > 1024) {
 				cef_log_write (CefC_Log_Warn, 
@@ -876,15 +953,19 @@ cef_csmgr_stat_destroy (
 		if (stat->cache_type == CefC_Cache_Type_Excache) {
 			csmgr_sock_close (stat);
 		}
+		if (stat->pending) {
+			int i;
+			for (i = 0 ; i < CefC_Csmgr_Pending_Max ; i++) {
+				if (stat->pending[i]) {
+					free (stat->pending[i]);
+				}
+			}
+			free (stat->pending);
+			stat->pending = NULL;
+		}
 #ifdef CefC_CefnetdCache
 		if(stat->cache_type == CefC_Cache_Type_Localcache){
 			cef_mem_cache_destroy ();
-			if(stat->pipe_fd[0] != -1){
-				close(stat->pipe_fd[0]);
-			}
-			if(stat->pipe_fd[1] != -1){
-				close(stat->pipe_fd[1]);
-			}
 		}
 #endif //CefC_CefnetdCache
 	}
@@ -950,15 +1031,10 @@ cef_csmgr_cache_lookup (
 	}
 #ifdef CefC_CefnetdCache
 	else if (cs_stat->cache_type == CefC_Cache_Type_Localcache){
-		CefMemCacheT_Content_Mem_Entry* entry;
-		entry = cef_mem_cache_item_get (pm->name, pm->name_len);
-		if (entry) {
-			nowt = cef_client_present_timeus_get ();
-			
-			if ((nowt < entry->cache_time) && (nowt < entry->expiry)) {
-				*cob = entry->msg;
-				return (1);
-			}
+		/* The Cob is copied, since the entry may be evicted by the put thread 	*/
+		if (cef_mem_cache_item_get (pm->name, pm->name_len, cs_stat->local_cob) > 0) {
+			*cob = cs_stat->local_cob;
+			return (1);
 		}
 	}
 #endif //CefC_CefnetdCache
@@ -1020,10 +1096,8 @@ cef_csmgr_cache_insert (
 	}
 #ifdef	CefC_CefnetdCache	
 	else if (cs_stat->cache_type == CefC_Cache_Type_Localcache){
-		/* Send to Local cache write thread */
-		if (write(cs_stat->pipe_fd[0], msg, msg_len) != msg_len){
-			; /* NOP */
-		}
+		/* Hand the parsed Cob to Local cache write thread */
+		cef_mem_cache_item_put (msg, msg_len, pm, poh);
 	}
 #endif	//CefC_CefnetdCache	
 	return;
@@ -1079,6 +1153,13 @@ cef_csmgr_send_msg_to_csmgr (
 	int msg_len								/* message length							*/
 ) {
 
+	if (cef_csmgr_shm_ready (cs_stat->shm)) {
+		if (cef_csmgr_shm_write (&cs_stat->shm->ring[CefC_Csmgr_Shm_Ring_Req], 
+				msg, (uint32_t) msg_len) == 0) {
+			return (0);
+		}
+		/* The ring is full, so the message goes through the socket 	*/
+	}
 	if (write(cs_stat->to_csmgrd_pipe_fd[0], msg, msg_len) != msg_len){
 		/* NOP */
 	}
@@ -1086,6 +1167,68 @@ cef_csmgr_send_msg_to_csmgr (
 	return (0);
 
 }
+/*--------------------------------------------------------------------------------------
+	Sets up the shared memory rings with local csmgrd
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_shm_setup (
+	CefT_Cs_Stat* cs_stat					/* Content Store Status						*/
+) {
+	cs_stat->shm = cef_csmgr_shm_create (
+						cs_stat->shm_ring_size, cs_stat->shm_summary_size);
+	if (cs_stat->shm == NULL) {
+		cef_log_write (CefC_Log_Info, 
+			"Shared memory rings are not available, csmgrd is reached by socket\n");
+		return;
+	}
+	if (cef_csmgr_shm_handshake_send (cs_stat->local_sock, cs_stat->shm) < 0) {
+		cef_log_write (CefC_Log_Warn, 
+			"%s (handshake: %s)\n", __func__, strerror (errno));
+		cef_csmgr_shm_destroy (cs_stat->shm);
+		cs_stat->shm = NULL;
+		return;
+	}
+	cef_log_write (CefC_Log_Info, 
+		"Shared memory rings with csmgrd : %u KB x %d\n", 
+		cs_stat->shm->hdr->ring_size / 1024, CefC_Csmgr_Shm_Ring_Num);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the area to write an Upload Request in the upload ring
+----------------------------------------------------------------------------------------*/
+static unsigned char*						/* NULL if the socket path is to be used	*/
+cef_csmgr_shm_upload_area_get (
+	CefT_Cs_Stat* cs_stat,					/* Content Store Status						*/
+	uint32_t len							/* maximum length to write					*/
+) {
+	CefT_Csmgr_Shm_Ring* ring;
+	
+	if (!cef_csmgr_shm_ready (cs_stat->shm)) {
+		return (NULL);
+	}
+	ring = &cs_stat->shm->ring[CefC_Csmgr_Shm_Ring_Upload];
+	
+	/* Publishes the current record when the message does not fit in it 	*/
+	if ((cs_stat->shm_upload_wp) && 
+		(cs_stat->shm_upload_len + len > CefC_Csmgr_Shm_Batch_Max)) {
+		cef_csmgr_shm_commit (ring, cs_stat->shm_upload_len);
+		cs_stat->shm_upload_wp 	= NULL;
+		cs_stat->shm_upload_len = 0;
+	}
+	if (cs_stat->shm_upload_wp == NULL) {
+		if (len > CefC_Csmgr_Shm_Batch_Max) {
+			return (NULL);
+		}
+		cs_stat->shm_upload_wp = cef_csmgr_shm_reserve (ring, CefC_Csmgr_Shm_Batch_Max);
+		if (cs_stat->shm_upload_wp == NULL) {
+			return (NULL);
+		}
+		cs_stat->shm_upload_len = 0;
+	}
+	
+	return (cs_stat->shm_upload_wp + cs_stat->shm_upload_len);
+}
 /*--------------------------------------------------------------------------------------
 	Puts Content Object to excache
 ----------------------------------------------------------------------------------------*/
@@ -1098,7 +1241,9 @@ cef_csmgr_excache_item_put (
 	CefT_Parsed_Message* pm,				/* Parsed CEFORE message					*/
 	CefT_Parsed_Opheader* poh				/* Parsed Option header						*/
 ) {
-	unsigned char buff[CefC_Max_Length];
+	unsigned char work_buff[CefC_Max_Length];
+	unsigned char* buff = work_buff;
+	unsigned char* shm_area;
 	uint16_t index = 0;
 	uint16_t value16;
 	uint32_t value32;
@@ -1138,6 +1283,20 @@ cef_csmgr_excache_item_put (
 			return;
 		}
 		
+		/* csmgrd would discard the Cob which exceeds the credit 	*/
+		if ((cs_stat->upload_window) && 
+			(cs_stat->upload_sent + msg_len + pm->name_len + 64 > cs_stat->upload_limit)) {
+			cs_stat->upload_suppressed++;
+			return;
+		}
+		
+		/* Builds the message in the upload ring when csmgrd serves it 	*/
+		shm_area = cef_csmgr_shm_upload_area_get (cs_stat, 
+			CefC_Csmgr_Msg_HeaderLen + msg_len + pm->name_len + 64);
+		if (shm_area) {
+			buff = shm_area;
+		}
+		
 		/* Creates Upload Request message 		*/
 		/* set header */
 		buff[CefC_O_Fix_Ver]  = CefC_Version;
@@ -1214,6 +1373,13 @@ cef_csmgr_excache_item_put (
 		buff[index+1] = 0x6f;
 		buff[index+2] = 0x62;
 		index += 3;
+		cs_stat->upload_sent += index;
+		
+		if (shm_area) {
+			/* Published with the record by cef_csmgr_excache_item_push 	*/
+			cs_stat->shm_upload_len += index;
+			return;
+		}
 		
 		/* send message */
 	    if(cefnetd_msg_buff_index > BUFF_SIZE){	
@@ -1235,6 +1401,12 @@ cef_csmgr_excache_item_push (
 	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
 ) {
 
+	if (cs_stat->shm_upload_wp) {
+		cef_csmgr_shm_commit (
+			&cs_stat->shm->ring[CefC_Csmgr_Shm_Ring_Upload], cs_stat->shm_upload_len);
+		cs_stat->shm_upload_wp 	= NULL;
+		cs_stat->shm_upload_len = 0;
+	}
 	if (cefnetd_msg_buff_index > 0) {
 		cef_csmgr_send_msg_to_csmgr (cs_stat, cefnetd_msg_buff, cefnetd_msg_buff_index);
 		cefnetd_msg_buff_index = 0;
@@ -1255,9 +1427,6 @@ cef_csmgr_excache_lookup (
 	CefT_Parsed_Opheader* poh,				/* Parsed Option Header						*/
 	CefT_Pit_Entry* pe						/* PIT entry								*/
 ) {
-	unsigned char buff[CefC_Max_Length];
-	uint16_t index = 0;
-	int res;
 	
 	if (pm->org.longlife_f) {
 		return;
@@ -1268,8 +1437,328 @@ cef_csmgr_excache_lookup (
 	}
 #endif	//CefC_CefnetdCache
 	
+	if (cef_csmgr_summary_skip (cs_stat, pm)) {
+		return;
+	}
+	cef_csmgr_excache_interest_send (cs_stat, pm, poh, NULL);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Asks csmgrd for the Cob and holds the Interest until csmgrd answers
+----------------------------------------------------------------------------------------*/
+int											/* 1: the Interest is held, the caller must	*/
+											/* not forward it now. 0: not held			*/
+cef_csmgr_excache_lookup_hold (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int faceid,								/* Face-ID to reply to the origin of 		*/
+											/* transmission of the message(s)			*/
+	CefT_Parsed_Message* pm,				/* Parsed CEFORE message					*/
+	CefT_Parsed_Opheader* poh,				/* Parsed Option Header						*/
+	CefT_Pit_Entry* pe,						/* PIT entry								*/
+	unsigned char* msg,						/* the Interest								*/
+	uint16_t msg_len,
+	uint64_t nowt							/* present time (us)						*/
+) {
+	CefT_Csmgr_Pending* pd;
+	uint32_t id;
+	uint32_t slot;
+	
+	if (pm->org.longlife_f) {
+		return (0);
+	}
+#ifdef	CefC_CefnetdCache	
+	if (cs_stat->cache_type == CefC_Cache_Type_Localcache){
+		return (0);
+	}
+#endif	//CefC_CefnetdCache
+	
+	/* The Interest for the Cob which is not cached is forwarded at once 	*/
+	if (cef_csmgr_summary_skip (cs_stat, pm)) {
+		return (0);
+	}
+	
+	/* Holds only the Interest for a Cob, the others are looked up in parallel	*/
+	if ((cs_stat->pending == NULL) || (pm->chnk_num_f == 0)) {
+		cef_csmgr_excache_interest_send (cs_stat, pm, poh, NULL);
+		return (0);
+	}
+	id   = cs_stat->pending_next;
+	slot = id & (CefC_Csmgr_Pending_Max - 1);
+	if (cs_stat->pending[slot]) {
+		cs_stat->pending_full++;
+		cef_csmgr_excache_interest_send (cs_stat, pm, poh, NULL);
+		return (0);
+	}
+	
+	/* The Interest is copied behind the entry to be forwarded later 	*/
+	pd = (CefT_Csmgr_Pending*) malloc (sizeof (CefT_Csmgr_Pending) + msg_len);
+	if (pd == NULL) {
+		cef_csmgr_excache_interest_send (cs_stat, pm, poh, NULL);
+		return (0);
+	}
+	pd->id 			= id;
+	pd->faceid 		= (uint16_t) faceid;
+	pd->msg_len 	= msg_len;
+	pd->hit_f 		= 0;
+	pd->deadline 	= nowt + (uint64_t) cs_stat->lookup_timeout * 1000;
+	pd->msg 		= (unsigned char*)(pd + 1);
+	memcpy (pd->msg, msg, msg_len);
+	
+	if (cef_csmgr_excache_interest_send (cs_stat, pm, poh, &id) < 0) {
+		free (pd);
+		return (0);
+	}
+	cs_stat->pending[slot] = pd;
+	cs_stat->pending_next++;
+	cs_stat->pending_num++;
+	
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Handles the lookup result from csmgrd
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Pending*							/* Interest to be forwarded upstream, 		*/
+											/* NULL if nothing is to be forwarded		*/
+cef_csmgr_lookup_res_process (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	unsigned char* msg,						/* lookup result message					*/
+	uint16_t msg_len
+) {
+	CefT_Csmgr_Pending* pd;
+	uint32_t value32;
+	uint32_t slot;
+	
+	if ((cs_stat->pending == NULL) || (msg_len < CefC_Csmgr_Lookup_Res_Len)) {
+		return (NULL);
+	}
+	memcpy (&value32, &msg[CefC_S_Fix_Header], sizeof (uint32_t));
+	value32 = ntohl (value32);
+	
+	/* The Interest may have been forwarded at the deadline 	*/
+	slot = value32 & (CefC_Csmgr_Pending_Max - 1);
+	pd = cs_stat->pending[slot];
+	if ((pd == NULL) || (pd->id != value32) || (pd->hit_f)) {
+		return (NULL);
+	}
+	
+	/* The Cob is sent before the result, or is read asynchronously after it. 	*/
+	/* The Interest is kept until the deadline, and is forwarded then if the 	*/
+	/* Cob has not satisfied the PIT entry 										*/
+	if (msg[CefC_S_Fix_Header + sizeof (uint32_t)] == CefC_Csmgr_Lookup_Hit) {
+		cs_stat->pending_hit++;
+		pd->hit_f = 1;
+		return (NULL);
+	}
+	cs_stat->pending[slot] = NULL;
+	cs_stat->pending_num--;
+	cs_stat->pending_miss++;
+	
+	return (pd);
+}
+/*--------------------------------------------------------------------------------------
+	Takes the held Interest whose deadline has passed
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Pending*							/* NULL if there is no such Interest		*/
+cef_csmgr_pending_expired_take (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	uint64_t nowt							/* present time (us)						*/
+) {
+	CefT_Csmgr_Pending* pd;
+	uint32_t slot;
+	
+	if ((cs_stat->pending == NULL) || (cs_stat->pending_num == 0)) {
+		cs_stat->pending_oldest = cs_stat->pending_next;
+		return (NULL);
+	}
+	
+	/* Deadlines are in the order of Request IDs, so only the oldest is checked */
+	while (cs_stat->pending_oldest != cs_stat->pending_next) {
+		slot = cs_stat->pending_oldest & (CefC_Csmgr_Pending_Max - 1);
+		pd = cs_stat->pending[slot];
+		
+		if ((pd == NULL) || (pd->id != cs_stat->pending_oldest)) {
+			cs_stat->pending_oldest++;
+			continue;
+		}
+		if (pd->deadline > nowt) {
+			return (NULL);
+		}
+		cs_stat->pending[slot] = NULL;
+		cs_stat->pending_oldest++;
+		cs_stat->pending_num--;
+		if (pd->hit_f == 0) {
+			cs_stat->pending_timeout++;
+		}
+		
+		return (pd);
+	}
+	
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Frees the held Interest
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_pending_free (
+	CefT_Csmgr_Pending* pd
+) {
+	free (pd);
+}
+/*--------------------------------------------------------------------------------------
+	Handles the upload credit granted by csmgrd
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_upload_credit_process (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	unsigned char* msg,						/* upload credit message					*/
+	uint16_t msg_len
+) {
+	uint64_t rcvd;
+	uint32_t window;
+	uint64_t nowt;
+	
+	if ((cs_stat->upload_window == 0) || (msg_len < CefC_Csmgr_Credit_Len)) {
+		return;
+	}
+	memcpy (&rcvd, &msg[CefC_S_Fix_Header], sizeof (uint64_t));
+	rcvd = cef_client_ntohb (rcvd);
+	memcpy (&window, &msg[CefC_S_Fix_Header + sizeof (uint64_t)], sizeof (uint32_t));
+	window = ntohl (window);
+	nowt = cef_client_present_timeus_get ();
+	
+	/* csmgrd counts from 0 again when it has accepted the connection again 	*/
+	if ((cs_stat->upload_credit_f == 0) || 
+		(rcvd < cs_stat->upload_acked) || (rcvd > cs_stat->upload_sent)) {
+		cs_stat->upload_sent 	= rcvd;
+		cs_stat->upload_acked 	= rcvd;
+		cs_stat->upload_acked_t = nowt;
+	} else if (rcvd != cs_stat->upload_acked) {
+		cs_stat->upload_acked 	= rcvd;
+		cs_stat->upload_acked_t = nowt;
+	} else if ((cs_stat->upload_sent > rcvd) && 
+		(nowt > cs_stat->upload_acked_t + CefC_Csmgr_Credit_Resync)) {
+		/* Upload Requests which the pipe or the socket failed to pass to 	*/
+		/* csmgrd would consume the credit forever 							*/
+		cs_stat->upload_resync += cs_stat->upload_sent - rcvd;
+		cs_stat->upload_sent = rcvd;
+	}
+	cs_stat->upload_limit 	 = rcvd + window;
+	cs_stat->upload_grant_t  = nowt;
+	cs_stat->upload_credit_f = 1;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Requests the upload credit to csmgrd while the credit is not refreshed
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_upload_credit_check (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	uint64_t nowt							/* current time (usec)						*/
+) {
+	unsigned char buff[CefC_Csmgr_Credit_Req_Len];
+	uint16_t value16;
+	uint32_t value32;
+	
+	if ((cs_stat->upload_window == 0) || 
+		(cs_stat->csmgr_access != CefC_Default_CSMGR_ACCESS_RW)) {
+		return;
+	}
+	
+	/* csmgrd grants the credit periodically, so the credit is stale when it	*/
+	/* stopped or does not know this cefnetd (e.g. reconnected). The uploads 	*/
+	/* are kept within the last limit and the credit is requested again, a 		*/
+	/* csmgrd which can not keep up must not be flooded while it is silent 		*/
+	if ((cs_stat->upload_credit_f) && 
+		(nowt > cs_stat->upload_grant_t + CefC_Csmgr_Credit_Stale)) {
+		cs_stat->upload_credit_f = 0;
+		cef_log_write (CefC_Log_Info, 
+			"Upload credit from csmgrd is not refreshed, uploads are kept "
+			"within the last credit\n");
+	}
+	if ((cs_stat->upload_credit_f) || 
+		(nowt < cs_stat->upload_req_t + CefC_Csmgr_Credit_Req_Intvl)) {
+		return;
+	}
+	cs_stat->upload_req_t = nowt;
+	
+	/* csmgrd which does not know this message skips it 	*/
+	buff[CefC_O_Fix_Ver]  = CefC_Version;
+	buff[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_Credit;
+	value16 = htons (CefC_Csmgr_Credit_Req_Len);
+	memcpy (buff + CefC_O_Length, &value16, CefC_S_Length);
+	value32 = htonl (cs_stat->upload_window * 1024);
+	memcpy (buff + CefC_Csmgr_Msg_HeaderLen, &value32, sizeof (uint32_t));
+	
+	cef_csmgr_send_msg_to_csmgr (cs_stat, buff, CefC_Csmgr_Credit_Req_Len);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Checks the summary published by csmgrd
+----------------------------------------------------------------------------------------*/
+static int									/* 1: the Cob is not cached in csmgrd		*/
+cef_csmgr_summary_skip (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	CefT_Parsed_Message* pm					/* Parsed CEFORE message					*/
+) {
+	int res;
+	
+	if ((pm->chnk_num_f == 0) || (cef_csmgr_shm_ready (cs_stat->shm) == 0)) {
+		return (0);
+	}
+	res = cef_csmgr_summary_test (cs_stat->shm, 
+			cef_csmgr_summary_hash (pm->name, 
+				pm->name_len - (CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum), 
+				pm->chnk_num));
+	if (res == 0) {
+		cs_stat->summary_skip++;
+		return (1);
+	}
+	if (res > 0) {
+		cs_stat->summary_pass++;
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the Interest to csmgrd
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_excache_interest_send (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	CefT_Parsed_Message* pm,				/* Parsed CEFORE message					*/
+	CefT_Parsed_Opheader* poh,				/* Parsed Option Header						*/
+	uint32_t* id							/* Request ID, NULL if no result is needed	*/
+) {
+	unsigned char buff[CefC_Max_Length];
+	uint16_t index = 0;
+	int res;
+	
+	/* Creates Interest message in the request ring when csmgrd serves it 	*/
+	if (cef_csmgr_shm_ready (cs_stat->shm)) {
+		CefT_Csmgr_Shm_Ring* ring = &cs_stat->shm->ring[CefC_Csmgr_Shm_Ring_Req];
+		unsigned char* wp;
+		
+		wp = cef_csmgr_shm_reserve (ring, 
+				CefC_Csmgr_Msg_HeaderLen + CefC_S_ChunkNum + pm->name_len + 8 
+				+ sizeof (uint32_t));
+		if (wp) {
+			cef_csmgr_interest_msg_create (wp, &index, poh, pm);
+			if (id) {
+				cef_csmgr_interest_msg_id_set (wp, &index, *id);
+			}
+			cef_csmgr_shm_commit (ring, index);
+			return (0);
+		}
+	}
+	
 	/* Create Interest message 		*/
 	cef_csmgr_interest_msg_create (buff, &index, poh, pm);
+	if (id) {
+		cef_csmgr_interest_msg_id_set (buff, &index, *id);
+	}
 	
 	/* Send messages 				*/
 	res = cef_csmgr_send_msg_to_csmgr (cs_stat, buff, index);
@@ -1277,7 +1766,7 @@ cef_csmgr_excache_lookup (
 		cef_log_write (CefC_Log_Warn, "%s (%s)\n", __func__, strerror (errno));
 	}
 	
-	return;
+	return (res);
 }
 /*--------------------------------------------------------------------------------------
 	Get frame from received message
@@ -1424,6 +1913,12 @@ void
 csmgr_sock_close (
 	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
 ) {
+	if (cs_stat->shm) {
+		cef_csmgr_shm_destroy (cs_stat->shm);
+		cs_stat->shm 			= NULL;
+		cs_stat->shm_upload_wp 	= NULL;
+		cs_stat->shm_upload_len = 0;
+	}
 	if (cs_stat->local_sock != -1) {
 		close (cs_stat->local_sock);
 		cs_stat->local_sock = -1;
@@ -1778,27 +2273,21 @@ cef_csmgr_locache_info_get (
 		rep_blk.last_seq 	= htonl ((uint32_t) 0);
 	} else {
 		/* include chunk number */
-		CefMemCacheT_Content_Mem_Entry* entry;
-		uint64_t nowt;
-		entry = cef_mem_cache_item_get (name, name_len);
-		if (entry) {
-			nowt = cef_client_present_timeus_get ();
-			if ((nowt < entry->cache_time) && (nowt < entry->expiry)) {
-				res = cef_mem_cache_mstat_get (name, tmp_klen, &info_p);
-				if (res < 0) {
-					return (-1);
-				}
-				
-				if (info_p.con_size / 1024 > UINT32_MAX) {
-					rep_blk.cont_size 	= htonl (UINT32_MAX);
-				} else {
-					rep_blk.cont_size 	= htonl ((uint32_t)info_p.con_size / 1024);
-				}
-				rep_blk.cont_cnt 	= htonl ((uint32_t) 1);
-				rep_blk.rcv_int 	= htonl ((uint32_t) 0);
-				rep_blk.first_seq 	= htonl ((uint32_t) seqno);
-				rep_blk.last_seq 	= htonl ((uint32_t) seqno);
+		if (cef_mem_cache_item_get (name, name_len, NULL) > 0) {
+			res = cef_mem_cache_mstat_get (name, tmp_klen, &info_p);
+			if (res < 0) {
+				return (-1);
+			}
+			
+			if (info_p.con_size / 1024 > UINT32_MAX) {
+				rep_blk.cont_size 	= htonl (UINT32_MAX);
+			} else {
+				rep_blk.cont_size 	= htonl ((uint32_t)info_p.con_size / 1024);
 			}
+			rep_blk.cont_cnt 	= htonl ((uint32_t) 1);
+			rep_blk.rcv_int 	= htonl ((uint32_t) 0);
+			rep_blk.first_seq 	= htonl ((uint32_t) seqno);
+			rep_blk.last_seq 	= htonl ((uint32_t) seqno);
 		} else {
 			return (-1);
 		}
@@ -2537,6 +3026,32 @@ cef_csmgr_interest_msg_create (
 	
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Appends the Request ID to Interest message for csmgr
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_interest_msg_id_set (
+	unsigned char buff[],					/* Interest message							*/
+	uint16_t* index,						/* Length of message						*/
+	uint32_t id								/* Request ID								*/
+) {
+	uint16_t value16_nw;
+	uint32_t value32_nw;
+	
+	/* csmgrd answers the Interest of this type with the lookup result 	*/
+	buff[CefC_Csmgr_Msg_HeaderLen] = CefC_Csmgr_Interest_Type_Pending;
+	
+	/* Sets Request ID behind the name and chunk num 	*/
+	value32_nw = htonl (id);
+	memcpy (buff + *index, &value32_nw, sizeof (uint32_t));
+	*index += sizeof (uint32_t);
+	
+	/* set Length */
+	value16_nw = htons (*index);
+	memcpy (buff + CefC_O_Length, &value16_nw, CefC_S_Length);
+	
+	return;
+}
 /*--------------------------------------------------------------------------------------
 	Connect csmgr with TCP socket
 ----------------------------------------------------------------------------------------*/
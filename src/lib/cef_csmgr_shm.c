@@ -0,0 +1,796 @@
+/*
+ * Copyright (c) 2016-2021, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_csmgr_shm.c
+ */
+
+#define __CEF_CSMGR_SHM_SOURCE__
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // _GNU_SOURCE
+#endif // __linux__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif // __linux__
+
+#include <cefore/cef_define.h>
+#include <cefore/cef_csmgr.h>
+#include <cefore/cef_csmgr_shm.h>
+#include <cefore/cef_log.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefC_Csmgr_Shm_Rec_HeaderLen	8				/* length(4) + reserved(4)		*/
+#define CefC_Csmgr_Shm_Rec_Wrap			0xFFFFFFFF		/* rest of the lap is unused	*/
+#define CefC_Csmgr_Shm_Align(x)			(((x) + 7) & ~((uint64_t) 7))
+#define CefC_Csmgr_Shm_Hdr_Area			4096			/* page which holds the header	*/
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Sets the process local view of the rings
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_shm_rings_setup (
+	CefT_Csmgr_Shm* shm
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the shared segment and the doorbells (cefnetd side)
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Shm*								/* NULL if not supported or an error occurs	*/
+cef_csmgr_shm_create (
+	uint32_t ring_kb,						/* size of each ring (KB)					*/
+	uint32_t summary_kb						/* size of the summary bitmap (KB), 0: none	*/
+) {
+#ifdef __linux__
+	CefT_Csmgr_Shm* shm;
+	uint64_t ring_size;
+	uint64_t summary_size = 0;
+	uint32_t bits_log2 = 0;
+	void* addr;
+	int i;
+	
+	if (ring_kb < CefC_Csmgr_Shm_Min_Ring_Size) {
+		ring_kb = CefC_Csmgr_Shm_Min_Ring_Size;
+	}
+	if (ring_kb > CefC_Csmgr_Shm_Max_Ring_Size) {
+		ring_kb = CefC_Csmgr_Shm_Max_Ring_Size;
+	}
+	/* Rounds down to the power of two to index the ring with a mask 	*/
+	ring_size = 1;
+	while (ring_size * 2 <= (uint64_t) ring_kb * 1024) {
+		ring_size *= 2;
+	}
+	if (summary_kb > 0) {
+		if (summary_kb < CefC_Csmgr_Summary_Min_Size) {
+			summary_kb = CefC_Csmgr_Summary_Min_Size;
+		}
+		if (summary_kb > CefC_Csmgr_Summary_Max_Size) {
+			summary_kb = CefC_Csmgr_Summary_Max_Size;
+		}
+		summary_size = 1;
+		bits_log2 = 3;
+		while (summary_size * 2 <= (uint64_t) summary_kb * 1024) {
+			summary_size *= 2;
+			bits_log2++;
+		}
+	}
+	
+	shm = (CefT_Csmgr_Shm*) malloc (sizeof (CefT_Csmgr_Shm));
+	if (shm == NULL) {
+		cef_log_write (CefC_Log_Error, "%s (malloc)\n", __func__);
+		return (NULL);
+	}
+	memset (shm, 0, sizeof (CefT_Csmgr_Shm));
+	for (i = 0 ; i < CefC_Csmgr_Shm_Fd_Num ; i++) {
+		shm->fds[i] = -1;
+	}
+	shm->map_len = CefC_Csmgr_Shm_Hdr_Area 
+					+ ring_size * CefC_Csmgr_Shm_Ring_Num + summary_size;
+	
+	shm->fds[0] = memfd_create ("cefore_csmgr_ring", MFD_CLOEXEC);
+	if (shm->fds[0] < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (memfd_create: %s)\n", __func__, strerror (errno));
+		goto ERROR;
+	}
+	if (ftruncate (shm->fds[0], (off_t) shm->map_len) < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (ftruncate: %s)\n", __func__, strerror (errno));
+		goto ERROR;
+	}
+	for (i = 1 ; i < CefC_Csmgr_Shm_Fd_Num ; i++) {
+		shm->fds[i] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (shm->fds[i] < 0) {
+			cef_log_write (CefC_Log_Warn, "%s (eventfd: %s)\n", __func__, strerror (errno));
+			goto ERROR;
+		}
+	}
+	addr = mmap (NULL, shm->map_len, 
+				PROT_READ | PROT_WRITE, MAP_SHARED, shm->fds[0], 0);
+	if (addr == MAP_FAILED) {
+		cef_log_write (CefC_Log_Warn, "%s (mmap: %s)\n", __func__, strerror (errno));
+		goto ERROR;
+	}
+	shm->hdr = (CefT_Csmgr_Shm_Hdr*) addr;
+	shm->hdr->magic 	= CefC_Csmgr_Shm_Magic;
+	shm->hdr->ring_size = (uint32_t) ring_size;
+	shm->hdr->attached 	= 0;
+	shm->hdr->summary.bits_log2 = bits_log2;
+	cef_csmgr_shm_rings_setup (shm);
+	
+	return (shm);
+
+ERROR:
+	cef_csmgr_shm_destroy (shm);
+	return (NULL);
+#else // __linux__
+	return (NULL);
+#endif // __linux__
+}
+/*--------------------------------------------------------------------------------------
+	Maps the shared segment received from cefnetd (csmgrd side)
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Shm*								/* NULL if an error occurs					*/
+cef_csmgr_shm_attach (
+	int fds[], 								/* memfd and doorbells (ownership is taken)	*/
+	int fd_num
+) {
+	CefT_Csmgr_Shm* shm;
+	struct stat st;
+	uint64_t ring_size;
+	void* addr;
+	int i;
+	
+	shm = (CefT_Csmgr_Shm*) malloc (sizeof (CefT_Csmgr_Shm));
+	if (shm == NULL) {
+		for (i = 0 ; i < fd_num ; i++) {
+			close (fds[i]);
+		}
+		return (NULL);
+	}
+	memset (shm, 0, sizeof (CefT_Csmgr_Shm));
+	for (i = 0 ; i < CefC_Csmgr_Shm_Fd_Num ; i++) {
+		shm->fds[i] = (i < fd_num) ? fds[i] : -1;
+	}
+	for (i = CefC_Csmgr_Shm_Fd_Num ; i < fd_num ; i++) {
+		close (fds[i]);
+	}
+	if (fd_num != CefC_Csmgr_Shm_Fd_Num) {
+		cef_log_write (CefC_Log_Warn, 
+			"%s (%d descriptors are passed)\n", __func__, fd_num);
+		goto ERROR;
+	}
+	
+	if ((fstat (shm->fds[0], &st) < 0) || 
+		(st.st_size < CefC_Csmgr_Shm_Hdr_Area)) {
+		cef_log_write (CefC_Log_Warn, "%s (invalid segment)\n", __func__);
+		goto ERROR;
+	}
+	shm->map_len = (size_t) st.st_size;
+	addr = mmap (NULL, shm->map_len, 
+				PROT_READ | PROT_WRITE, MAP_SHARED, shm->fds[0], 0);
+	if (addr == MAP_FAILED) {
+		cef_log_write (CefC_Log_Warn, "%s (mmap: %s)\n", __func__, strerror (errno));
+		goto ERROR;
+	}
+	shm->hdr = (CefT_Csmgr_Shm_Hdr*) addr;
+	
+	/* Checks the layout written by cefnetd 	*/
+	ring_size = shm->hdr->ring_size;
+	if ((shm->hdr->magic != CefC_Csmgr_Shm_Magic) || 
+		(ring_size < CefC_Csmgr_Shm_Min_Ring_Size * 1024) || 
+		(ring_size & (ring_size - 1)) || 
+		(CefC_Csmgr_Shm_Hdr_Area + ring_size * CefC_Csmgr_Shm_Ring_Num > shm->map_len)) {
+		cef_log_write (CefC_Log_Warn, "%s (invalid segment header)\n", __func__);
+		goto ERROR;
+	}
+	if ((shm->hdr->summary.bits_log2 != 0) && 
+		((shm->hdr->summary.bits_log2 < 9) || 
+		 (shm->hdr->summary.bits_log2 > 40) || 
+		 (CefC_Csmgr_Shm_Hdr_Area + ring_size * CefC_Csmgr_Shm_Ring_Num 
+		 	+ ((1ULL << shm->hdr->summary.bits_log2) / 8) > shm->map_len))) {
+		cef_log_write (CefC_Log_Warn, "%s (invalid summary header)\n", __func__);
+		goto ERROR;
+	}
+	cef_csmgr_shm_rings_setup (shm);
+	
+	return (shm);
+
+ERROR:
+	cef_csmgr_shm_destroy (shm);
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Unmaps the shared segment and closes the descriptors
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_destroy (
+	CefT_Csmgr_Shm* shm
+) {
+	int i;
+	
+	if (shm == NULL) {
+		return;
+	}
+	if (shm->hdr) {
+		munmap (shm->hdr, shm->map_len);
+	}
+	for (i = 0 ; i < CefC_Csmgr_Shm_Fd_Num ; i++) {
+		if (shm->fds[i] != -1) {
+			close (shm->fds[i]);
+		}
+	}
+	free (shm);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns whether the peer serves the rings
+----------------------------------------------------------------------------------------*/
+int
+cef_csmgr_shm_ready (
+	CefT_Csmgr_Shm* shm
+) {
+	if ((shm == NULL) || (shm->hdr == NULL)) {
+		return (0);
+	}
+	return (__atomic_load_n (&shm->hdr->attached, __ATOMIC_ACQUIRE) != 0);
+}
+/*--------------------------------------------------------------------------------------
+	Sets/clears the flag which tells the peer that the rings are served
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_attached_set (
+	CefT_Csmgr_Shm* shm,
+	int attached
+) {
+	if ((shm == NULL) || (shm->hdr == NULL)) {
+		return;
+	}
+	__atomic_store_n (&shm->hdr->attached, (uint32_t) attached, __ATOMIC_RELEASE);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sends the descriptors to csmgrd over the local socket
+----------------------------------------------------------------------------------------*/
+int											/* The return value is negative if an error occurs	*/
+cef_csmgr_shm_handshake_send (
+	int sock, 								/* local socket connected to csmgrd			*/
+	CefT_Csmgr_Shm* shm
+) {
+	unsigned char buff[CefC_Csmgr_Msg_HeaderLen + sizeof (uint32_t)];
+	char cbuff[CMSG_SPACE (sizeof (int) * CefC_Csmgr_Shm_Fd_Num)];
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr* cmsg;
+	uint16_t value16;
+	uint32_t value32;
+	
+	/* Creates the ShmRing message 		*/
+	buff[CefC_O_Fix_Ver]  = CefC_Version;
+	buff[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_ShmRing;
+	value16 = htons ((uint16_t) sizeof (buff));
+	memcpy (buff + CefC_O_Length, &value16, CefC_S_Length);
+	value32 = htonl (shm->hdr->ring_size);
+	memcpy (buff + CefC_Csmgr_Msg_HeaderLen, &value32, sizeof (uint32_t));
+	
+	/* Attaches the descriptors 		*/
+	memset (&mh, 0, sizeof (mh));
+	memset (cbuff, 0, sizeof (cbuff));
+	iov.iov_base 		= buff;
+	iov.iov_len 		= sizeof (buff);
+	mh.msg_iov 			= &iov;
+	mh.msg_iovlen 		= 1;
+	mh.msg_control 		= cbuff;
+	mh.msg_controllen 	= sizeof (cbuff);
+	cmsg = CMSG_FIRSTHDR (&mh);
+	cmsg->cmsg_level 	= SOL_SOCKET;
+	cmsg->cmsg_type 	= SCM_RIGHTS;
+	cmsg->cmsg_len 		= CMSG_LEN (sizeof (int) * CefC_Csmgr_Shm_Fd_Num);
+	memcpy (CMSG_DATA (cmsg), shm->fds, sizeof (int) * CefC_Csmgr_Shm_Fd_Num);
+	
+	if (sendmsg (sock, &mh, 0) != (ssize_t) sizeof (buff)) {
+		return (-1);
+	}
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Receives from the local socket and collects the descriptors passed with it
+----------------------------------------------------------------------------------------*/
+int											/* same as recv(2)							*/
+cef_csmgr_shm_recv (
+	int sock, 
+	unsigned char* buff, 
+	int buff_len, 
+	int fds[], 								/* [CefC_Csmgr_Shm_Fd_Num] 					*/
+	int* fd_num								/* number of descriptors held in fds		*/
+) {
+	char cbuff[CMSG_SPACE (sizeof (int) * CefC_Csmgr_Shm_Fd_Num)];
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr* cmsg;
+	int* fdp;
+	int num;
+	int res;
+	int i;
+	
+	memset (&mh, 0, sizeof (mh));
+	iov.iov_base 		= buff;
+	iov.iov_len 		= buff_len;
+	mh.msg_iov 			= &iov;
+	mh.msg_iovlen 		= 1;
+	mh.msg_control 		= cbuff;
+	mh.msg_controllen 	= sizeof (cbuff);
+	
+	res = (int) recvmsg (sock, &mh, 0);
+	if (res <= 0) {
+		return (res);
+	}
+	
+	for (cmsg = CMSG_FIRSTHDR (&mh) ; cmsg ; cmsg = CMSG_NXTHDR (&mh, cmsg)) {
+		if ((cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_RIGHTS)) {
+			continue;
+		}
+		fdp = (int*) CMSG_DATA (cmsg);
+		num = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+		for (i = 0 ; i < num ; i++) {
+			if (*fd_num < CefC_Csmgr_Shm_Fd_Num) {
+				fds[*fd_num] = fdp[i];
+				(*fd_num)++;
+			} else {
+				close (fdp[i]);
+			}
+		}
+	}
+	
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Reserves a record in the ring and returns the area to write
+----------------------------------------------------------------------------------------*/
+unsigned char*								/* NULL if the ring is full					*/
+cef_csmgr_shm_reserve (
+	CefT_Csmgr_Shm_Ring* ring, 
+	uint32_t len
+) {
+	uint64_t size = ring->mask + 1;
+	uint64_t rec_len;
+	uint64_t head;
+	uint64_t tail;
+	uint64_t off;
+	uint64_t skip = 0;
+	
+	if ((len == 0) || (len > size / 4)) {
+		return (NULL);
+	}
+	rec_len = CefC_Csmgr_Shm_Rec_HeaderLen + CefC_Csmgr_Shm_Align (len);
+	
+	/* Only this process moves the head 	*/
+	head = ring->ctrl->head;
+	tail = __atomic_load_n (&ring->ctrl->tail, __ATOMIC_ACQUIRE);
+	off  = head & ring->mask;
+	
+	/* A record never straddles the end of the ring 	*/
+	if (size - off < rec_len) {
+		skip = size - off;
+	}
+	if (head + skip + rec_len - tail > size) {
+		return (NULL);
+	}
+	if (skip) {
+		*((uint32_t*)(ring->data + off)) = CefC_Csmgr_Shm_Rec_Wrap;
+	}
+	ring->rsv_pos = head + skip;
+	ring->rsv_len = len;
+	
+	return (ring->data + (ring->rsv_pos & ring->mask) + CefC_Csmgr_Shm_Rec_HeaderLen);
+}
+/*--------------------------------------------------------------------------------------
+	Publishes the reserved record with the length actually written
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_commit (
+	CefT_Csmgr_Shm_Ring* ring, 
+	uint32_t len
+) {
+	uint64_t old_head;
+	uint64_t new_head;
+	uint64_t bell = 1;
+	
+	if (ring->rsv_len == 0) {
+		return;
+	}
+	if (len > ring->rsv_len) {
+		len = ring->rsv_len;
+	}
+	ring->rsv_len = 0;
+	if (len == 0) {
+		/* Nothing was written, so the record is dropped 	*/
+		return;
+	}
+	*((uint32_t*)(ring->data + (ring->rsv_pos & ring->mask))) = len;
+	
+	old_head = ring->ctrl->head;
+	new_head = ring->rsv_pos + CefC_Csmgr_Shm_Rec_HeaderLen + CefC_Csmgr_Shm_Align (len);
+	__atomic_store_n (&ring->ctrl->head, new_head, __ATOMIC_SEQ_CST);
+	
+	/* Rings the doorbell only when the consumer may have found the ring empty 	*/
+	if (__atomic_load_n (&ring->ctrl->tail, __ATOMIC_SEQ_CST) == old_head) {
+		if (write (ring->doorbell, &bell, sizeof (bell)) < 0) {
+			/* NOP: the counter is already signaled */;
+		}
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Copies a message into the ring
+----------------------------------------------------------------------------------------*/
+int											/* The return value is negative if full		*/
+cef_csmgr_shm_write (
+	CefT_Csmgr_Shm_Ring* ring, 
+	const unsigned char* msg, 
+	uint32_t len
+) {
+	unsigned char* wp;
+	
+	wp = cef_csmgr_shm_reserve (ring, len);
+	if (wp == NULL) {
+		return (-1);
+	}
+	memcpy (wp, msg, len);
+	cef_csmgr_shm_commit (ring, len);
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the oldest record in the ring
+----------------------------------------------------------------------------------------*/
+unsigned char*								/* NULL if the ring is empty				*/
+cef_csmgr_shm_read (
+	CefT_Csmgr_Shm_Ring* ring, 
+	uint32_t* len
+) {
+	uint64_t size = ring->mask + 1;
+	uint64_t tail;
+	uint64_t head;
+	uint64_t off;
+	uint32_t rec_len;
+	
+	/* Only this process moves the tail 	*/
+	tail = ring->ctrl->tail;
+	head = __atomic_load_n (&ring->ctrl->head, __ATOMIC_SEQ_CST);
+	if (tail == head) {
+		return (NULL);
+	}
+	off = tail & ring->mask;
+	rec_len = *((uint32_t*)(ring->data + off));
+	if (rec_len == CefC_Csmgr_Shm_Rec_Wrap) {
+		tail += size - off;
+		off = 0;
+		rec_len = *((uint32_t*)(ring->data));
+	}
+	if ((tail >= head) || (rec_len == 0) || 
+		(CefC_Csmgr_Shm_Rec_HeaderLen + CefC_Csmgr_Shm_Align (rec_len) > size - off)) {
+		/* Broken ring, discards all records 	*/
+		cef_log_write (CefC_Log_Warn, "%s (broken record)\n", __func__);
+		__atomic_store_n (&ring->ctrl->tail, head, __ATOMIC_SEQ_CST);
+		return (NULL);
+	}
+	ring->rd_next = tail + CefC_Csmgr_Shm_Rec_HeaderLen + CefC_Csmgr_Shm_Align (rec_len);
+	*len = rec_len;
+	
+	return (ring->data + off + CefC_Csmgr_Shm_Rec_HeaderLen);
+}
+/*--------------------------------------------------------------------------------------
+	Releases the record returned by cef_csmgr_shm_read
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_release (
+	CefT_Csmgr_Shm_Ring* ring
+) {
+	__atomic_store_n (&ring->ctrl->tail, ring->rd_next, __ATOMIC_SEQ_CST);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Clears the doorbell of the ring
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_doorbell_clear (
+	CefT_Csmgr_Shm_Ring* ring
+) {
+	uint64_t bell;
+	
+	if (read (ring->doorbell, &bell, sizeof (bell)) < 0) {
+		/* NOP: not signaled */;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Calculates the hash of a Cob used by the summary
+----------------------------------------------------------------------------------------*/
+uint64_t
+cef_csmgr_summary_hash (
+	const unsigned char* name, 				/* name without the chunk number			*/
+	uint16_t name_len, 
+	uint32_t chnk_num
+) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	int i;
+	
+	/* FNV-1a of the name, then the chunk number is mixed in 	*/
+	for (i = 0 ; i < name_len ; i++) {
+		hash ^= name[i];
+		hash *= 0x100000001b3ULL;
+	}
+	hash ^= (uint64_t) chnk_num * 0x9e3779b97f4a7c15ULL;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	
+	return (hash);
+}
+/*--------------------------------------------------------------------------------------
+	Tests whether the summary published by csmgrd may hold the Cob
+----------------------------------------------------------------------------------------*/
+int											/* 0: not cached, 1: may be cached, 		*/
+											/* -1: no valid summary						*/
+cef_csmgr_summary_test (
+	CefT_Csmgr_Shm* shm, 
+	uint64_t hash
+) {
+	uint64_t step = (hash >> 32) | 1;
+	uint64_t pos;
+	uint64_t word;
+	int i;
+	
+	if ((shm == NULL) || (shm->summary == NULL) || 
+		(__atomic_load_n (&shm->hdr->summary.ready, __ATOMIC_ACQUIRE) == 0)) {
+		return (-1);
+	}
+	for (i = 0 ; i < CefC_Csmgr_Summary_Hash_Num ; i++) {
+		pos  = (hash + i * step) & shm->summary_mask;
+		word = __atomic_load_n (&shm->summary[pos >> 6], __ATOMIC_RELAXED);
+		if ((word & (1ULL << (pos & 63))) == 0) {
+			return (0);
+		}
+	}
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the counting filter behind the bitmap of the segment (csmgrd side)
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Summary*							/* NULL if the segment has no summary		*/
+cef_csmgr_summary_create (
+	CefT_Csmgr_Shm* shm
+) {
+	CefT_Csmgr_Summary* sum;
+	
+	if ((shm == NULL) || (shm->summary == NULL)) {
+		return (NULL);
+	}
+	sum = (CefT_Csmgr_Summary*) malloc (sizeof (CefT_Csmgr_Summary));
+	if (sum == NULL) {
+		cef_log_write (CefC_Log_Warn, "%s (malloc)\n", __func__);
+		return (NULL);
+	}
+	sum->cnt = (uint8_t*) calloc (shm->summary_mask + 1, sizeof (uint8_t));
+	if (sum->cnt == NULL) {
+		cef_log_write (CefC_Log_Warn, "%s (calloc)\n", __func__);
+		free (sum);
+		return (NULL);
+	}
+	sum->shm 		= shm;
+	sum->mask 		= shm->summary_mask;
+	sum->cob_num 	= 0;
+	sum->saturated_f = 0;
+	
+	__atomic_store_n (&shm->hdr->summary.ready, 0, __ATOMIC_RELEASE);
+	memset (shm->summary, 0, (shm->summary_mask + 1) / 8);
+	shm->hdr->summary.queries 	= 0;
+	shm->hdr->summary.misses 	= 0;
+	
+	return (sum);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the counting filter
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_destroy (
+	CefT_Csmgr_Summary* sum
+) {
+	if (sum == NULL) {
+		return;
+	}
+	cef_csmgr_summary_ready_set (sum, 0);
+	free (sum->cnt);
+	free (sum);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Adds a Cob to the summary
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_add (
+	CefT_Csmgr_Summary* sum, 
+	uint64_t hash
+) {
+	uint64_t step = (hash >> 32) | 1;
+	uint64_t pos;
+	int i;
+	
+	for (i = 0 ; i < CefC_Csmgr_Summary_Hash_Num ; i++) {
+		pos = (hash + i * step) & sum->mask;
+		if (sum->cnt[pos] == 0) {
+			__atomic_fetch_or (
+				&sum->shm->summary[pos >> 6], 1ULL << (pos & 63), __ATOMIC_RELEASE);
+		}
+		/* A saturated counter is never decremented, so the bit stays set 	*/
+		if (sum->cnt[pos] < UINT8_MAX) {
+			sum->cnt[pos]++;
+		}
+	}
+	sum->cob_num++;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes a Cob from the summary
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_remove (
+	CefT_Csmgr_Summary* sum, 
+	uint64_t hash
+) {
+	uint64_t step = (hash >> 32) | 1;
+	uint64_t pos;
+	int i;
+	
+	for (i = 0 ; i < CefC_Csmgr_Summary_Hash_Num ; i++) {
+		pos = (hash + i * step) & sum->mask;
+		if ((sum->cnt[pos] == 0) || (sum->cnt[pos] == UINT8_MAX)) {
+			continue;
+		}
+		sum->cnt[pos]--;
+		if (sum->cnt[pos] == 0) {
+			__atomic_fetch_and (
+				&sum->shm->summary[pos >> 6], ~(1ULL << (pos & 63)), __ATOMIC_RELAXED);
+		}
+	}
+	if (sum->cob_num > 0) {
+		sum->cob_num--;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sets/clears the flag which tells cefnetd that the summary is valid
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_ready_set (
+	CefT_Csmgr_Summary* sum, 
+	int ready
+) {
+	if (sum == NULL) {
+		return;
+	}
+	/* The saturated summary is never used again 	*/
+	if (ready && sum->saturated_f) {
+		return;
+	}
+	__atomic_store_n (&sum->shm->hdr->summary.ready, (uint32_t) ready, __ATOMIC_RELEASE);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Invalidates the summary for good, because a cached Cob could not be added to it
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_summary_saturate (
+	CefT_Csmgr_Summary* sum
+) {
+	if ((sum == NULL) || (sum->saturated_f)) {
+		return;
+	}
+	/* cefnetd asks csmgrd for every Cob, as it does without the summary 	*/
+	sum->saturated_f = 1;
+	__atomic_store_n (&sum->shm->hdr->summary.ready, 0, __ATOMIC_RELEASE);
+	cef_log_write (CefC_Log_Warn, 
+		"A cached Cob could not be added to the summary, so it is no longer used\n");
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sets the process local view of the rings
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_shm_rings_setup (
+	CefT_Csmgr_Shm* shm
+) {
+	uint64_t ring_size = shm->hdr->ring_size;
+	int i;
+	
+	for (i = 0 ; i < CefC_Csmgr_Shm_Ring_Num ; i++) {
+		shm->ring[i].ctrl 		= &shm->hdr->ctrl[i];
+		shm->ring[i].data 		= (unsigned char*) shm->hdr 
+									+ CefC_Csmgr_Shm_Hdr_Area + ring_size * i;
+		shm->ring[i].mask 		= ring_size - 1;
+		shm->ring[i].doorbell 	= shm->fds[i + 1];
+		shm->ring[i].rsv_len 	= 0;
+		shm->ring[i].rd_next 	= shm->hdr->ctrl[i].tail;
+	}
+	if (shm->hdr->summary.bits_log2) {
+		shm->summary 		= (uint64_t*)((unsigned char*) shm->hdr 
+								+ CefC_Csmgr_Shm_Hdr_Area + ring_size * CefC_Csmgr_Shm_Ring_Num);
+		shm->summary_mask 	= (1ULL << shm->hdr->summary.bits_log2) - 1;
+	} else {
+		shm->summary 		= NULL;
+		shm->summary_mask 	= 0;
+	}
+	
+	return;
+}
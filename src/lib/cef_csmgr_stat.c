@@ -83,6 +83,7 @@ typedef struct {
 	uint64_t			cached_cob_num;
 	CsmgrT_Stat** 		rcds;
 	pthread_mutex_t 	stat_mutex;
+	CefT_Csmgr_Summary*	summary;			/* summary published to cefnetd (or NULL)	*/
 
 } CsmgrT_Stat_Table;
 
@@ -121,6 +122,12 @@ csmgr_stat_hash_number_create (
 	const unsigned char* key, 
 	uint16_t klen
 );
+static void
+csmgr_stat_summary_update (
+	CsmgrT_Stat_Table* tbl, 
+	CsmgrT_Stat* rcd, 
+	int add_f
+);
 
 /****************************************************************************************
  ****************************************************************************************/
@@ -583,6 +590,8 @@ csmgr_stat_cob_update (
 	pthread_mutex_lock (&tbl->stat_mutex);
 	rcd = csmgr_stat_content_lookup (tbl, name, name_len, &create_f);
 	if (!rcd) {
+		/* The plugin has cached the Cob, so the summary cannot tell it is absent 	*/
+		cef_csmgr_summary_saturate (tbl->summary);
 		pthread_mutex_unlock (&tbl->stat_mutex);
 		return;
 	}
@@ -599,6 +608,7 @@ csmgr_stat_cob_update (
 		map_bsize = CsmgrT_Add_Maps + map_bsize * CsmgrT_Add_Maps;
 		ptr = calloc (1, sizeof (uint64_t) * map_bsize);
 		if (ptr == NULL) {
+			cef_csmgr_summary_saturate (tbl->summary);
 			pthread_mutex_unlock (&tbl->stat_mutex);
 			return;
 		}
@@ -650,6 +660,10 @@ csmgr_stat_cob_update (
 		rcd->cob_num++;
 		rcd->con_size += cob_size;
 		tbl->cached_cob_num++;
+		if (tbl->summary) {
+			cef_csmgr_summary_add (tbl->summary, 
+				cef_csmgr_summary_hash (name, name_len, seq));
+		}
 	}
 	rcd->cob_map[x] |= mask;
 	
@@ -709,6 +723,10 @@ csmgr_stat_cob_remove (
 		rcd->cob_num--;
 		rcd->con_size -= cob_size;
 		tbl->cached_cob_num--;
+		if (tbl->summary) {
+			cef_csmgr_summary_remove (tbl->summary, 
+				cef_csmgr_summary_hash (name, name_len, seq));
+		}
 	}
 	rcd->cob_map[x] &= ~mask;
 	
@@ -882,6 +900,7 @@ csmgr_stat_content_info_delete (
 		   (memcmp (cp->name, name, name_len) == 0)) {
 		   	tbl->rcds[index] = cp->next;
 			tbl->cached_con_num--;
+			csmgr_stat_summary_update (tbl, cp, 0);
 		   	stat_index_mngr[cp->index] = 0;
 			free (cp->cob_map);
 		   	free (cp);
@@ -895,6 +914,7 @@ csmgr_stat_content_info_delete (
 				   	wcp = cp->next;
 				   	cp->next = cp->next->next;
 					tbl->cached_con_num--;
+					csmgr_stat_summary_update (tbl, wcp, 0);
 				   	stat_index_mngr[wcp->index] = 0;
 					free (wcp->cob_map);
 				   	free (wcp);
@@ -908,6 +928,66 @@ csmgr_stat_content_info_delete (
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Sets the summary which follows the cached Cobs
+----------------------------------------------------------------------------------------*/
+void 
+csmgr_stat_summary_set (
+	CsmgrT_Stat_Handle hdl, 
+	CefT_Csmgr_Summary* summary			/* NULL stops updating the summary			*/
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* rcd;
+	int i;
+	
+	if (!tbl) {
+		return;
+	}
+	
+	pthread_mutex_lock (&tbl->stat_mutex);
+	tbl->summary = summary;
+	
+	/* Adds the Cobs cached so far, later changes follow the cob_map 	*/
+	if (summary) {
+		for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+			for (rcd = tbl->rcds[i] ; rcd != NULL ; rcd = rcd->next) {
+				csmgr_stat_summary_update (tbl, rcd, 1);
+			}
+		}
+	}
+	pthread_mutex_unlock (&tbl->stat_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Calls the function for each content information holding the lock
+----------------------------------------------------------------------------------------*/
+uint32_t 									/* number of the content information		*/
+csmgr_stat_content_info_walk (
+	CsmgrT_Stat_Handle hdl, 
+	void (*func)(CsmgrT_Stat* rcd, void* arg), 
+	void* arg
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* rcd;
+	uint32_t num = 0;
+	int i;
+	
+	if (!tbl) {
+		return (0);
+	}
+	
+	pthread_mutex_lock (&tbl->stat_mutex);
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		for (rcd = tbl->rcds[i] ; rcd != NULL ; rcd = rcd->next) {
+			(*func)(rcd, arg);
+			num++;
+		}
+	}
+	pthread_mutex_unlock (&tbl->stat_mutex);
+	
+	return (num);
+}
 /*--------------------------------------------------------------------------------------
 	Obtains the number of cached content
 ----------------------------------------------------------------------------------------*/
@@ -1331,4 +1411,38 @@ csmgr_stat_hash_number_create (
 	
 	return (hash);
 }
-
+/*--------------------------------------------------------------------------------------
+	Adds/removes all Cobs of the content to/from the summary
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_summary_update (
+	CsmgrT_Stat_Table* tbl, 
+	CsmgrT_Stat* rcd, 
+	int add_f
+) {
+	uint64_t bits;
+	uint32_t seq;
+	uint32_t x;
+	int n;
+	
+	if ((tbl->summary == NULL) || (rcd->cob_map == NULL)) {
+		return;
+	}
+	for (x = 0 ; x < rcd->map_max ; x++) {
+		bits = rcd->cob_map[x];
+		while (bits) {
+			n = __builtin_ctzll (bits);
+			bits &= bits - 1;
+			seq = x * 64 + n;
+			if (add_f) {
+				cef_csmgr_summary_add (tbl->summary, 
+					cef_csmgr_summary_hash (rcd->name, rcd->name_len, seq));
+			} else {
+				cef_csmgr_summary_remove (tbl->summary, 
+					cef_csmgr_summary_hash (rcd->name, rcd->name_len, seq));
+			}
+		}
+	}
+	
+	return;
+}
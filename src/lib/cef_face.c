@@ -476,6 +476,7 @@ cef_face_close (
 		face_tbl[faceid].protocol 	= CefC_Face_Type_Invalid;
 		face_tbl[faceid].ifindex 	= -1;	//0.8.3
 		face_tbl[faceid].bw_stat_i 	= -1;	//0.8.3
+		face_tbl[faceid].gen++;
 		close (entry->sock);
 		free (entry);
 	}
@@ -525,6 +526,7 @@ cef_face_down (
 		face_tbl[faceid].fd = 0;
 		face_tbl[faceid].ifindex 	= -1;	//0.8.3
 		face_tbl[faceid].bw_stat_i 	= -1;	//0.8.3
+		face_tbl[faceid].gen++;
 	}
 	
 	return (1);
@@ -1305,6 +1307,16 @@ cef_face_get_face_from_faceid (
 	assert (faceid >= 0 && faceid <= max_tbl_size);
 	return (&face_tbl[faceid]);
 }
+/*--------------------------------------------------------------------------------------
+	Obtains the generation of the specified Face-ID, which changes when it is closed
+----------------------------------------------------------------------------------------*/
+uint32_t 
+cef_face_gen_get (
+	uint16_t 	faceid						/* Face-ID									*/
+) {
+	assert (faceid >= 0 && faceid <= max_tbl_size);
+	return (face_tbl[faceid].gen);
+}
 /*--------------------------------------------------------------------------------------
 	Obtains the Face structure from the specified Face-ID
 ----------------------------------------------------------------------------------------*/
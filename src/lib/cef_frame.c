@@ -209,6 +209,8 @@ static uint16_t ftvh_hmac_sha256 	= CefC_T_HMAC_SHA256;
 static uint16_t ftvh_rsa_sha256 	= CefC_T_RSA_SHA256;
 static uint16_t ftvh_ecs_256 		= CefC_T_EC_SECP_256K1;
 static uint16_t ftvh_ecs_384 		= CefC_T_EC_SECP_384R1;
+static uint16_t ftvh_ecdsa_p256 	= CefC_T_ECDSA_P256;
+static uint16_t ftvh_ed25519 		= CefC_T_ED25519;
 
 static uint16_t ftvh_keyid 			= CefC_T_KEYID;
 static uint16_t ftvh_pubkeyloc		= CefC_T_PUBLICKEYLOC;
@@ -285,6 +287,8 @@ static uint16_t ftvn_hmac_sha256;
 static uint16_t ftvn_rsa_sha256;
 static uint16_t ftvn_ecs_256;
 static uint16_t ftvn_ecs_384;
+static uint16_t ftvn_ecdsa_p256;
+static uint16_t ftvn_ed25519;
 
 static uint16_t ftvn_keyid;
 static uint16_t ftvn_pubkeyloc;
@@ -733,6 +737,8 @@ cef_frame_init (
 	ftvn_rsa_sha256 	= htons (ftvh_rsa_sha256);
 	ftvn_ecs_256 		= htons (ftvh_ecs_256);
 	ftvn_ecs_384 		= htons (ftvh_ecs_384);
+	ftvn_ecdsa_p256 	= htons (ftvh_ecdsa_p256);
+	ftvn_ed25519 		= htons (ftvh_ed25519);
 
 	ftvn_keyid 			= htons (ftvh_keyid);
 	ftvn_pubkeyloc 		= htons (ftvh_pubkeyloc);
@@ -4076,6 +4082,7 @@ cef_frame_validation_alg_tlv_create (
 	unsigned char keyid[32];
 	uint16_t 		pubkey_len;
 	unsigned char 	pubkey[CefC_Max_Length];
+	int 			key_alg;
 	
 	if (tlvs->hop_by_hop_f) {
 		/* HOP-BY-HOP */
@@ -4088,15 +4095,30 @@ cef_frame_validation_alg_tlv_create (
 		index += CefC_S_TLF;
 		value_len += CefC_S_TLF;
 		
-	} else if (tlvs->valid_type == CefC_T_RSA_SHA256) {
+	} else if ((tlvs->valid_type == CefC_T_RSA_SHA256) || 
+			   (tlvs->valid_type == CefC_T_ECDSA_P256) || 
+			   (tlvs->valid_type == CefC_T_ED25519)) {
 		
+		/* The signature algorithm follows the key configured for the name, 	*/
+		/* "sha256" selects whichever public key algorithm the key is for 		*/
+		key_alg = cef_valid_key_alg_get (name, name_len);
+		if ((tlvs->valid_type != CefC_T_RSA_SHA256) && 
+			(tlvs->valid_type != key_alg)) {
+			return (0);
+		}
 		pubkey_len = (uint16_t) cef_valid_keyid_create (name, name_len, pubkey, keyid);
 		if (pubkey_len == 0) {
 			return (0);
 		}
 		index += CefC_S_TLF;
 		
-		fld_thdr.type 	= ftvn_rsa_sha256;
+		if (key_alg == CefC_T_ECDSA_P256) {
+			fld_thdr.type = ftvn_ecdsa_p256;
+		} else if (key_alg == CefC_T_ED25519) {
+			fld_thdr.type = ftvn_ed25519;
+		} else {
+			fld_thdr.type = ftvn_rsa_sha256;
+		}
 		fld_thdr.length = htons (40 + pubkey_len);
 		memcpy (&buff[index], &fld_thdr, sizeof (struct tlv_hdr));
 		index += CefC_S_TLF;
@@ -4197,7 +4219,9 @@ cef_frame_validation_pld_tlv_create (
 		memcpy (&buff[buff_len], &v32_thdr, sizeof (struct value32_tlv));
 		index = sizeof (struct value32_tlv);
 		
-	} else if (tlvs->valid_type == CefC_T_RSA_SHA256) {
+	} else if ((tlvs->valid_type == CefC_T_RSA_SHA256) || 
+			   (tlvs->valid_type == CefC_T_ECDSA_P256) || 
+			   (tlvs->valid_type == CefC_T_ED25519)) {
 		
 		res = cef_valid_dosign (buff, buff_len, name, name_len, sign, &sign_len);
 		
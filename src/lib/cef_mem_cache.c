@@ -63,6 +63,11 @@
  Macros
  ****************************************************************************************/
 #define Cef_Mstat_HashTbl_Size				1009
+#define CefMemCacheC_Put_Que_Size			4096	/* Capacity of the put queue (2^n)	*/
+#define CefMemCacheC_Put_Que_Mask			(CefMemCacheC_Put_Que_Size - 1)
+#define CefMemCacheC_Shard_Max				16		/* Maximum number of shards (2^n)	*/
+#define CefMemCacheC_Shard_Min_Cap			256		/* Minimum capacity of a shard		*/
+#define CefMemCacheC_Expire_Slice			64		/* Buckets checked per lock hold	*/
 
 /****************************************************************************************
  Structures Declaration
@@ -72,6 +77,7 @@
 typedef struct _FifoT_Entry {
 	unsigned char* 			key;
 	int 					key_len;
+	uint32_t 				hash;
     int             		valid;
 	struct _FifoT_Entry*	before;
  	struct _FifoT_Entry*	next;
@@ -97,6 +103,17 @@ typedef struct CefT_Mem_Hash {
 	
 } CefT_Mem_Hash;
 
+/*** a shard of the memory cache, the entries are assigned by the hash of the key ***/
+typedef struct CefMemCacheT_Shard {
+	pthread_mutex_t 		mutex;				/* protects all members of the shard	*/
+	CefT_Mem_Hash* 			hash_tbl;			/* caching hash table 					*/
+	FifoT_Entry*			fifo_head;
+	FifoT_Entry*			fifo_tail;
+	CefT_Hash_Handle 		lookup_table;		/* hash-table to look-up FIFO entries 	*/
+	int 					cache_count;		/* number of cache entries in the shard	*/
+	int 					cache_cap;			/* share of the capacity of the shard	*/
+} CefMemCacheT_Shard;
+
 typedef struct CefT_Mem_Hash_Stat {
 	unsigned char* 				contents_name;		/* Name of Contents					*/
 	uint32_t 					cname_len;			/* Length of Name					*/
@@ -110,29 +127,29 @@ typedef struct CefT_Mem_Hash_Stat {
  State Variables
  ****************************************************************************************/
 
-static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
-											/* listed (it is the same value as the 		*/
-											/* maximum value of the cache table) 		*/
-
-/* pointers of functions which stores and removes the content entry into/from the cache */
-/* table (implementation of the functions are in a plugin which uses this library) 		*/
-
-static int              fifo_hand;          /* position of hand                         */
-static int              cache_count;        /* number of cache entries                  */
-FifoT_Entry*			cache_entry_head;
-FifoT_Entry*			cache_entry_tail;
-static CefT_Hash_Handle lookup_table;       /* hash-table to look-up cache entries      */
-static int              count;              /* the number of entries in lookup table    */
-
-static CefT_Mem_Hash* 			mem_hash_tbl = NULL;	/* caching hash table			*/
-static uint32_t 				mem_tabl_max;			/* max size 					*/
-														/* of caching hash table		*/
-
-static pthread_mutex_t 			cef_mem_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* The cache is split into shards which have their own lock, FIFO and hash table, 	*/
+/* so that the lookup from the forwarding thread only waits for the operations on the 	*/
+/* same shard, and the expiry check never holds a lock for the whole table. 			*/
+/* The capacity is divided among the shards, each of which evicts its own entries 		*/
+static CefMemCacheT_Shard		mem_shards[CefMemCacheC_Shard_Max];
+static uint32_t 				mem_shard_num = 0;		/* number of shards in use (2^n)	*/
 
-static int	cache_cs_expire_check_stat = 0;
+static pthread_mutex_t 			cef_mem_expire_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static CefT_Mem_Hash_Stat*		mstat_tbl[Cef_Mstat_HashTbl_Size];
+static pthread_mutex_t 			mstat_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Queue of the entries handed from the forwarding thread to the put thread. 			*/
+/* It is single-producer (cef_mem_cache_item_put) / single-consumer (the put thread), 	*/
+/* so it needs no lock; put_que_sem counts the entries pushed to the queue 				*/
+static CefMemCacheT_Content_Mem_Entry*	put_que[CefMemCacheC_Put_Que_Size];
+static uint32_t 				put_que_head = 0;		/* written only by the put thread	*/
+static uint32_t 				put_que_tail = 0;		/* written only by the producer 	*/
+static sem_t 					put_que_sem;
+static sem_t 					put_exit_sem;
+static int 						put_que_init_f = 0;
+static int 						put_thread_f = 0;
+static int 						put_stop_f = 0;
 
 /****************************************************************************************
  Static Function Declaration
@@ -142,32 +159,44 @@ static CefT_Mem_Hash_Stat*		mstat_tbl[Cef_Mstat_HashTbl_Size];
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_fifo_init (
-		uint32_t		capacity
+	CefMemCacheT_Shard* sp,
+	uint32_t		capacity
 );
 static void
 cef_mem_cache_fifo_destroy (
-	void
+	CefMemCacheT_Shard* sp
 );
-static void
+static int
 cef_mem_cache_fifo_insert (
-	CefMemCacheT_Content_Entry* entry
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* entry,
+	unsigned char* key,
+	int key_len,
+	uint32_t hash
 );
 static void
 cef_mem_cache_fifo_erase (
+	CefMemCacheT_Shard* sp,
 	unsigned char* key,
 	int key_len
 );
-static void cef_mem_cache_fifo_store_entry(
-	CefMemCacheT_Content_Entry* entry
+static int cef_mem_cache_fifo_store_entry(
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* entry,
+	unsigned char* key,
+	int key_len,
+	uint32_t hash
 );
 static void cef_mem_cache_fifo_remove_entry(
+	CefMemCacheT_Shard* sp,
 	FifoT_Entry*   entry,
 	int is_removed
 );
 static FifoT_Entry* 
-cef_mem_cache_fifo_cache_entry_enqueue(unsigned char* key, int key_len);
+cef_mem_cache_fifo_cache_entry_enqueue(
+	CefMemCacheT_Shard* sp, unsigned char* key, int key_len, uint32_t hash);
 static void 
-cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p);
+cef_mem_cache_fifo_cache_entry_dequeue(CefMemCacheT_Shard* sp, FifoT_Entry* p);
 
 
 /*--------------------------------------------------------------------------------------
@@ -179,24 +208,57 @@ cef_mem_cache_cs_create (
 );
 static int 
 cef_mem_cache_cs_store (
-	CefMemCacheT_Content_Entry* new_entry
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* entry,
+	unsigned char* key,
+	int key_len,
+	uint32_t hash
 );
 static void
 cef_mem_cache_cs_remove (
+	CefMemCacheT_Shard* sp,
 	unsigned char* key, 
-	int key_len
+	int key_len,
+	uint32_t hash
 );
 static void
 cef_mem_cache_cs_destroy (
-	void
+	CefMemCacheT_Shard* sp
 );
 static void
 cef_mem_cache_cs_expire_check (
 	void
 );
 static int
+cef_mem_cache_shard_expire_check (
+	CefMemCacheT_Shard* sp,
+	uint32_t start,
+	uint64_t nowt
+);
+static void
+cef_mem_cache_shard_entry_remove (
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* entry,
+	uint32_t hash
+);
+static int
 cef_mem_cache_cob_write (
-	CefMemCacheT_Content_Entry* cob 
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* cob,
+	unsigned char* key,
+	int key_len,
+	uint32_t hash
+);
+static CefMemCacheT_Content_Mem_Entry* 
+cef_mem_cache_mem_entry_create (
+	const unsigned char* msg,
+	uint16_t msg_len,
+	const unsigned char* name,
+	uint16_t name_len
+);
+static void
+cef_mem_cache_mem_entry_write (
+	CefMemCacheT_Content_Mem_Entry* entry
 );
 /*--------------------------------------------------------------------------------------
 	Hash Functions
@@ -210,8 +272,14 @@ cef_mem_hash_number_create (
 	const unsigned char* key,
 	uint32_t klen
 );
+static CefMemCacheT_Shard* 
+cef_mem_cache_shard_get (
+	uint32_t hash
+);
 static int 
 cef_mem_cache_hash_tbl_item_set (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	CefMemCacheT_Content_Mem_Entry* elem, 
@@ -219,11 +287,15 @@ cef_mem_cache_hash_tbl_item_set (
 );
 static CefMemCacheT_Content_Mem_Entry* 
 cef_mem_cache_hash_tbl_item_get (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 );
 static CefMemCacheT_Content_Mem_Entry* 
 cef_mem_cache_hash_tbl_item_remove (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 );
@@ -232,22 +304,6 @@ cef_mem_cache_key_create_by_Mem_Entry (
 	CefMemCacheT_Content_Mem_Entry* entry,
 	unsigned char* key
 );
-static int
-cef_mem_cache_key_create (
-	CefMemCacheT_Content_Entry* entry,
-	unsigned char* key
-);
-
-/*--------------------------------------------------------------------------------------
-	MISC. Functions
-----------------------------------------------------------------------------------------*/
-static int
-cef_mem_cache_name_chunknum_concatenate (
-	const unsigned char* name,
-	uint16_t name_len,
-	uint32_t chunknum,
-	unsigned char* key
-);
 
 /*--------------------------------------------------------------------------------------
 	Stat Functions
@@ -302,6 +358,18 @@ cef_mem_cache_init(
 	rtc = cef_mem_cache_cs_create (capacity);
 	cef_mem_cache_mstat_init ();
 	
+	if ((rtc == 0) && (put_que_init_f == 0)) {
+		if ((sem_init (&put_que_sem, 0, 0) != 0) || 
+			(sem_init (&put_exit_sem, 0, 0) != 0)) {
+			cef_log_write (CefC_Log_Error, "%s sem_init (%s)\n", __func__, strerror (errno));
+			return (-1);
+		}
+		put_que_head 	= 0;
+		put_que_tail 	= 0;
+		put_stop_f 		= 0;
+		put_que_init_f 	= 1;
+	}
+	
 	return rtc;
 }
 /*--------------------------------------------------------------------------------------
@@ -311,73 +379,77 @@ void *
 cef_mem_cache_put_thread (
 	void *p
 ){
-	int 						read_fd;
-	CefMemCacheT_Content_Entry	entry;	
-	struct pollfd 				fds[1];
-	unsigned char				msg[CefC_Max_Length];
-	int							msg_len;
-	struct fixed_hdr* 			chp;
-	uint16_t					pkt_len;
-	uint16_t					hdr_len;
-	uint16_t					payload_len;
-	uint16_t					header_len;
-	CefT_Parsed_Message 		pm;
-	CefT_Parsed_Opheader 		poh;
-	int							res;
-	int 						chunk_field_len;
-
-	read_fd = *(int *)p;
+	CefMemCacheT_Content_Mem_Entry* entry;
+	uint32_t head;
 
 	pthread_t self_thread = pthread_self();
 	pthread_detach(self_thread);
 	
-	memset(&fds, 0, sizeof(fds));
-	fds[0].fd = read_fd;
-	fds[0].events = POLLIN | POLLERR;
-
-	while (1){
-	    poll(fds, 1, 1);
-	    if (fds[0].revents & POLLIN) {
-	    	
-			if((msg_len = read(read_fd, msg, sizeof(msg))) < 1){
-				continue;
-			}
-			chp = (struct fixed_hdr*) msg;
-			pkt_len = ntohs (chp->pkt_len);
-			hdr_len = chp->hdr_len;
-			payload_len = pkt_len - hdr_len;
-			header_len 	= hdr_len;
-			res = cef_frame_message_parse (
-							msg, payload_len, header_len, &poh, &pm, CefC_PT_OBJECT);
-			if ( pm.AppComp_num > 0 ) {
-				/* Free AppComp */
-				cef_frame_app_components_free ( pm.AppComp_num, pm.AppComp );
-			}
-
-			if (res < 0) {
-				continue;
-			}
-			chunk_field_len = CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum;
-			memcpy (entry.msg, msg, msg_len);
-			entry.msg_len = msg_len;
-			if (pm.chnk_num_f) {
-				memcpy (entry.name, pm.name, pm.name_len - chunk_field_len);
-				entry.name_len = pm.name_len - chunk_field_len;
-			} else {
-				continue;
-			}
-			entry.pay_len = pm.payload_len;
-			entry.chnk_num = pm.chnk_num;
-			entry.cache_time = poh.cachetime;
-			entry.expiry = pm.expiry;
-			/* entry.node does not care */
-			cef_mem_cache_item_set (&entry);
-	    }
+	put_thread_f = 1;
+	
+	while (1) {
+		if (sem_wait (&put_que_sem) != 0) {
+			continue;
+		}
+		head = put_que_head;
+		while (head != __atomic_load_n (&put_que_tail, __ATOMIC_ACQUIRE)) {
+			entry = put_que[head & CefMemCacheC_Put_Que_Mask];
+			head++;
+			__atomic_store_n (&put_que_head, head, __ATOMIC_RELEASE);
+			cef_mem_cache_mem_entry_write (entry);
+		}
+		if (__atomic_load_n (&put_stop_f, __ATOMIC_ACQUIRE)) {
+			break;
+		}
 	}
-
+	
+	sem_post (&put_exit_sem);
 	pthread_exit (NULL);
 	return 0;
 }
+/*--------------------------------------------------------------------------------------
+	Hands the parsed content object to the put thread
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if the object was 	*/
+									/* not queued 										*/
+cef_mem_cache_item_put (
+	const unsigned char* msg,					/* Content Object message				*/
+	uint16_t msg_len,							/* length of the message				*/
+	CefT_Parsed_Message* pm,					/* Parsed message of the object			*/
+	CefT_Parsed_Opheader* poh					/* Parsed Option Header of the object	*/
+) {
+	CefMemCacheT_Content_Mem_Entry* entry;
+	uint32_t tail;
+	int chunk_field_len = CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum;
+	
+	if ((put_que_init_f == 0) || (pm->chnk_num_f == 0)) {
+		return (-1);
+	}
+	
+	/* Drops the object if the put thread is behind, it is just not cached 	*/
+	tail = put_que_tail;
+	if (tail - __atomic_load_n (&put_que_head, __ATOMIC_ACQUIRE) 
+			>= CefMemCacheC_Put_Que_Size) {
+		return (-1);
+	}
+	
+	entry = cef_mem_cache_mem_entry_create (
+				msg, msg_len, pm->name, pm->name_len - chunk_field_len);
+	if (entry == NULL) {
+		return (-1);
+	}
+	entry->pay_len 		= pm->payload_len;
+	entry->chnk_num 	= pm->chnk_num;
+	entry->cache_time 	= poh->cachetime;
+	entry->expiry 		= pm->expiry;
+	/* entry->node does not care */
+	
+	put_que[tail & CefMemCacheC_Put_Que_Mask] = entry;
+	__atomic_store_n (&put_que_tail, tail + 1, __ATOMIC_RELEASE);
+	sem_post (&put_que_sem);
+	
+	return (0);
+}
 /*--------------------------------------------------------------------------------------
 	Thread to clear expirly content object of memory cache
 ----------------------------------------------------------------------------------------*/
@@ -407,11 +479,7 @@ cef_mem_cache_clear_thread (
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Fine, "Checks for expired contents.\n");
 #endif // CefC_Debug
-			if (cache_cs_expire_check_stat == 0){
-				cache_cs_expire_check_stat = 1;
-				cef_mem_cache_cs_expire_check ();
-				cache_cs_expire_check_stat = 0;
-			}
+			cef_mem_cache_cs_expire_check ();
 			/* set interval */
 			expire_check_time = nowt + interval;
 		}
@@ -420,25 +488,6 @@ cef_mem_cache_clear_thread (
 	pthread_exit (NULL);
 	return 0;
 }
-/*--------------------------------------------------------------------------------------
-	Thread to clear expirly content object of memory cache by demand
-----------------------------------------------------------------------------------------*/
-void *
-cef_mem_cache_clear_demand_thread (
-	void *p
-){
-	pthread_t self_thread = pthread_self();
-	pthread_detach(self_thread);
-
-	if (cache_cs_expire_check_stat == 0){
-		cache_cs_expire_check_stat = 1;
-		cef_mem_cache_cs_expire_check ();
-		cache_cs_expire_check_stat = 0;
-	}
-
-	pthread_exit (NULL);
-	return 0;
-}
 /*--------------------------------------------------------------------------------------
 	set the cob to memry cache 
 ----------------------------------------------------------------------------------------*/
@@ -446,26 +495,49 @@ int									/* The return value is negative if an error occurs	*/
 cef_mem_cache_item_set (
 	CefMemCacheT_Content_Entry* entry
 ) {
-	pthread_mutex_lock (&cef_mem_cs_mutex);
-	cef_mem_cache_cob_write (entry);
-	pthread_mutex_unlock (&cef_mem_cs_mutex);
+	CefMemCacheT_Content_Mem_Entry* mem_entry;
+	
+	mem_entry = cef_mem_cache_mem_entry_create (
+					entry->msg, entry->msg_len, entry->name, entry->name_len);
+	if (mem_entry == NULL) {
+		return (-1);
+	}
+	mem_entry->pay_len 		= entry->pay_len;
+	mem_entry->chnk_num 	= entry->chnk_num;
+	mem_entry->cache_time 	= entry->cache_time;
+	mem_entry->expiry 		= entry->expiry;
+	mem_entry->node 		= entry->node;
+	
+	cef_mem_cache_mem_entry_write (mem_entry);
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
 	Function to read a ContentObject from memory cache
 ----------------------------------------------------------------------------------------*/
-CefMemCacheT_Content_Mem_Entry*
+int 								/* Length of the ContentObject, or 0 if it is not 	*/
+									/* cached 											*/
 cef_mem_cache_item_get (
 	unsigned char* trg_key,						/* content name							*/
-	uint16_t trg_key_len						/* content name Length					*/
+	uint16_t trg_key_len,						/* content name Length					*/
+	unsigned char* msg 							/* buffer (CefC_Max_Length) which the 	*/
+												/* ContentObject is copied to, or NULL	*/
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry;
+	CefMemCacheT_Shard* sp;
+	uint32_t 		hash;
 	uint64_t 		nowt;
 	struct timeval 	tv;
+	int 			msg_len;
+	
+	if ((mem_shard_num == 0) || (trg_key_len > CefMemCacheC_Key_Max)) {
+		return (0);
+	}
+	hash = cef_mem_hash_number_create (trg_key, trg_key_len);
+	sp = cef_mem_cache_shard_get (hash);
 	
 	/* Access the specified entry 	*/
-	pthread_mutex_lock (&cef_mem_cs_mutex);
-	entry = cef_mem_cache_hash_tbl_item_get (trg_key, trg_key_len);
+	pthread_mutex_lock (&sp->mutex);
+	entry = cef_mem_cache_hash_tbl_item_get (sp->hash_tbl, hash, trg_key, trg_key_len);
 	
 	if (entry) {
 		
@@ -474,23 +546,25 @@ cef_mem_cache_item_get (
 		
 		if (((entry->expiry == 0) || (nowt < entry->expiry)) &&
 			(nowt < entry->cache_time)) {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
+			/* The entry is copied while the shard is locked, since the put 	*/
+			/* thread may evict it as soon as the lock is released 				*/
+			msg_len = entry->msg_len;
+			if (msg) {
+				memcpy (msg, entry->msg, msg_len);
+			}
+			pthread_mutex_unlock (&sp->mutex);
 			cef_mem_cache_mstat_ac_cnt_inc (trg_key, trg_key_len);
-			return (entry);
+			return (msg_len);
  		}
 		else {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
-			{
-				pthread_t th;
-				if (pthread_create (&th, NULL, cef_mem_cache_clear_demand_thread, NULL) == -1) {
-					cef_log_write (CefC_Log_Error, "Failed to create the new thread\n");
-				}
-			}
+			/* Removes the expired entry here, only this shard is locked 	*/
+			cef_mem_cache_shard_entry_remove (sp, entry, hash);
+			pthread_mutex_unlock (&sp->mutex);
 			return (0);
 		}
 	}
 	
-	pthread_mutex_unlock (&cef_mem_cs_mutex);
+	pthread_mutex_unlock (&sp->mutex);
 	
 	return (0);
 }
@@ -501,13 +575,41 @@ void
 cef_mem_cache_destroy (
 	void
 ) {
-pthread_mutex_lock (&cef_mem_cs_mutex);
-	cef_mem_cache_fifo_destroy ();
-	cef_mem_cache_cs_destroy ();
-pthread_mutex_unlock (&cef_mem_cs_mutex);
-	pthread_mutex_destroy (&cef_mem_cs_mutex);
+	CefMemCacheT_Content_Mem_Entry* entry;
+	uint32_t i;
+	
+	/* Stops the put thread after it stores the queued entries 	*/
+	if (put_que_init_f) {
+		__atomic_store_n (&put_stop_f, 1, __ATOMIC_RELEASE);
+		if (put_thread_f) {
+			sem_post (&put_que_sem);
+			sem_wait (&put_exit_sem);
+			put_thread_f = 0;
+		}
+		while (put_que_head != put_que_tail) {
+			entry = put_que[put_que_head & CefMemCacheC_Put_Que_Mask];
+			put_que_head++;
+			free (entry);
+		}
+		sem_destroy (&put_que_sem);
+		sem_destroy (&put_exit_sem);
+		put_que_init_f = 0;
+	}
+	
+	pthread_mutex_lock (&cef_mem_expire_mutex);
+	for (i = 0 ; i < mem_shard_num ; i++) {
+		pthread_mutex_lock (&mem_shards[i].mutex);
+		cef_mem_cache_fifo_destroy (&mem_shards[i]);
+		cef_mem_cache_cs_destroy (&mem_shards[i]);
+		pthread_mutex_unlock (&mem_shards[i].mutex);
+		pthread_mutex_destroy (&mem_shards[i].mutex);
+	}
+	mem_shard_num = 0;
+	pthread_mutex_unlock (&cef_mem_expire_mutex);
 	
+	pthread_mutex_lock (&mstat_mutex);
 	cef_mem_cache_mstat_destroy ();
+	pthread_mutex_unlock (&mstat_mutex);
 }
 
 /****************************************************************************************
@@ -518,27 +620,24 @@ pthread_mutex_unlock (&cef_mem_cs_mutex);
 ----------------------------------------------------------------------------------------*/
 static int 							/* If the error occurs, this value is a negative value	*/
 cef_mem_cache_fifo_init (
-		uint32_t		capacity
+	CefMemCacheT_Shard* sp,
+	uint32_t		capacity
 ) {
-    fifo_hand = 0;
-    cache_count = 0;
-	/* Records the capacity of cache		*/
+	sp->cache_count = 0;
 	if (capacity < 1) {
 		fprintf (stderr, "[FIFO] Invalid Cacacity\n");
 		return (-1);
 	}
-	cache_cap = capacity;
 
 	/* Initialize FIFO list management unit */
-	cache_entry_head = (FifoT_Entry*)NULL;
-	cache_entry_tail = (FifoT_Entry*)NULL;
+	sp->fifo_head = (FifoT_Entry*)NULL;
+	sp->fifo_tail = (FifoT_Entry*)NULL;
     
     /* Creates lookup table */
-    lookup_table = cef_lhash_tbl_create_u32(capacity);
-	if(lookup_table == (CefT_Hash_Handle)NULL){
+    sp->lookup_table = cef_lhash_tbl_create_u32(capacity);
+	if(sp->lookup_table == (CefT_Hash_Handle)NULL){
 		return (-1);
 	}
-    count = 0;
    
 	return (0);
 }
@@ -548,39 +647,44 @@ cef_mem_cache_fifo_init (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_destroy (
-	void
+	CefMemCacheT_Shard* sp
 ) {
-    fifo_hand = 0;
-    cache_count = 0;
-	cache_cap 		= 0;
+	sp->cache_count = 0;
 	{
 		FifoT_Entry* p;
 		FifoT_Entry* np;
-		p = cache_entry_head;
+		p = sp->fifo_head;
 		while (p != (FifoT_Entry*)NULL){
 			np = p->next;
 			free(p);
 			p = np;
 		}
-		cache_entry_head = (FifoT_Entry*)NULL;
-		cache_entry_tail = (FifoT_Entry*)NULL;
+		sp->fifo_head = (FifoT_Entry*)NULL;
+		sp->fifo_tail = (FifoT_Entry*)NULL;
+	}
+	if (sp->lookup_table) {
+		cef_lhash_tbl_destroy(sp->lookup_table);
+		sp->lookup_table = (CefT_Hash_Handle)NULL;
 	}
-    cef_lhash_tbl_destroy(lookup_table);
-    count = 0;
 }
 
 /*--------------------------------------------------------------------------------------
 	Insert API
 ----------------------------------------------------------------------------------------*/
-static void
+static int							/* The return value is negative if an error occurs	*/
 cef_mem_cache_fifo_insert (
-	CefMemCacheT_Content_Entry* entry	/* content entry 							*/
+	CefMemCacheT_Shard* sp,					/* shard which the entry belongs to 		*/
+	CefMemCacheT_Content_Mem_Entry* entry,	/* content entry 							*/
+	unsigned char* key,						/* key of the content entry 				*/
+	int key_len,							/* length of the key 						*/
+	uint32_t hash							/* hash number of the key 					*/
 ) {
-    if (cache_count == cache_cap) {
-        /* when cache is full, replace entry */
-    	cef_mem_cache_fifo_remove_entry(cache_entry_head, 0);
+    if ((sp->cache_count >= sp->cache_cap) && 
+    	(sp->fifo_head != (FifoT_Entry*)NULL)) {
+        /* when the shard is full, replace the oldest entry in this shard */
+    	cef_mem_cache_fifo_remove_entry(sp, sp->fifo_head, 0);
     }
-    cef_mem_cache_fifo_store_entry(entry);
+    return (cef_mem_cache_fifo_store_entry(sp, entry, key, key_len, hash));
 }
 
 /*--------------------------------------------------------------------------------------
@@ -588,61 +692,68 @@ cef_mem_cache_fifo_insert (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_erase (
+	CefMemCacheT_Shard* sp,					/* shard which the entry belongs to 		*/
 	unsigned char* key, 					/* key of content entry removed from cache 	*/
 											/* table									*/
 	int key_len								/* length of the key 						*/
 ) {
 	
 	FifoT_Entry*	del_entry;
-	void* val = cef_lhash_tbl_item_get(lookup_table, key, key_len);
+	void* val = cef_lhash_tbl_item_get(sp->lookup_table, key, key_len);
     if (val == NULL) {
         fprintf(stderr, "[FIFO] failed to erace\n");
         return;
     }
 	del_entry = (FifoT_Entry*) val;
-    cef_mem_cache_fifo_remove_entry(del_entry, 1);
+    cef_mem_cache_fifo_remove_entry(sp, del_entry, 1);
 }
 /*--------------------------------------------------------------------------------------
 	MISC. Functions
 ----------------------------------------------------------------------------------------*/
-static void cef_mem_cache_fifo_store_entry(
-	CefMemCacheT_Content_Entry* entry
+static int cef_mem_cache_fifo_store_entry(
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* entry,
+	unsigned char* key,
+	int key_len,
+	uint32_t hash
 ) {
-    unsigned char 	key[CefMemCacheC_Key_Max];
-    int 			key_len;
     FifoT_Entry*   	rsentry;
 	
-    
-    key_len = cef_mem_cache_name_chunknum_concatenate (
-                    entry->name, entry->name_len, entry->chnk_num, key);
-	rsentry = cef_mem_cache_fifo_cache_entry_enqueue(key, key_len);
+	rsentry = cef_mem_cache_fifo_cache_entry_enqueue(sp, key, key_len, hash);
 	if (rsentry == (FifoT_Entry*) NULL){
-		return;
+		return (-1);
 	}
-    cef_lhash_tbl_item_set(lookup_table, rsentry->key, rsentry->key_len
+	if (cef_mem_cache_cs_store(sp, entry, key, key_len, hash) < 0) {
+		cef_mem_cache_fifo_cache_entry_dequeue(sp, rsentry);
+		return (-1);
+	}
+    cef_lhash_tbl_item_set(sp->lookup_table, rsentry->key, rsentry->key_len
     	, (void*)rsentry);
-    count++;
-    cef_mem_cache_cs_store(entry);
-    cache_count++;
+    sp->cache_count++;
+    return (0);
 }
 /*-----*/
 static void cef_mem_cache_fifo_remove_entry(
+	CefMemCacheT_Shard* sp,
 	FifoT_Entry*   entry,
     int is_removed
 ) {
     FifoT_Entry* rsentry;
     rsentry = entry;
-    cef_lhash_tbl_item_remove(lookup_table, rsentry->key, rsentry->key_len);
-    count--;
+    cef_lhash_tbl_item_remove(sp->lookup_table, rsentry->key, rsentry->key_len);
 
-    if (!is_removed) cef_mem_cache_cs_remove(rsentry->key, rsentry->key_len);
-	cef_mem_cache_fifo_cache_entry_dequeue(rsentry);
+    if (!is_removed) {
+    	cef_mem_cache_cs_remove(sp, rsentry->key, rsentry->key_len, rsentry->hash);
+    }
+	cef_mem_cache_fifo_cache_entry_dequeue(sp, rsentry);
 
-	cache_count--;
+	sp->cache_count--;
 	
 }
 static FifoT_Entry* 
-cef_mem_cache_fifo_cache_entry_enqueue(unsigned char* key, int key_len) {
+cef_mem_cache_fifo_cache_entry_enqueue(
+	CefMemCacheT_Shard* sp, unsigned char* key, int key_len, uint32_t hash
+) {
 
 	FifoT_Entry*	q;
   	q = (FifoT_Entry*) calloc(1, sizeof(FifoT_Entry) + key_len);
@@ -652,27 +763,28 @@ cef_mem_cache_fifo_cache_entry_enqueue(unsigned char* key, int key_len) {
 	q->key = ((unsigned char*) q) + sizeof(FifoT_Entry);
 	memcpy (q->key, key, key_len);
 	q->key_len = key_len;
-	if(cache_entry_tail == (FifoT_Entry*)NULL){
-		cache_entry_head = q;
-		cache_entry_tail = q;
+	q->hash = hash;
+	if(sp->fifo_tail == (FifoT_Entry*)NULL){
+		sp->fifo_head = q;
+		sp->fifo_tail = q;
 	} else {
-		cache_entry_tail->next = q;
-		q->before = cache_entry_tail;
-		cache_entry_tail = q;
+		sp->fifo_tail->next = q;
+		q->before = sp->fifo_tail;
+		sp->fifo_tail = q;
 	}
   	return(q);
 }
 
 static void 
-cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p){
+cef_mem_cache_fifo_cache_entry_dequeue(CefMemCacheT_Shard* sp, FifoT_Entry* p){
 
 	 if(p->before == (FifoT_Entry*)NULL && p->next != (FifoT_Entry*)NULL){
-	 	cache_entry_head = p->next;
+	 	sp->fifo_head = p->next;
 	 	p->next->before = (FifoT_Entry*)NULL;
 	 } else 
 	 if(p->before == (FifoT_Entry*)NULL && p->next == (FifoT_Entry*)NULL){
-	 	cache_entry_head = (FifoT_Entry*)NULL;
-	 	cache_entry_tail = (FifoT_Entry*)NULL;
+	 	sp->fifo_head = (FifoT_Entry*)NULL;
+	 	sp->fifo_tail = (FifoT_Entry*)NULL;
 	 } else 
 	 if(p->before != (FifoT_Entry*)NULL && p->next != (FifoT_Entry*)NULL){
 	    p->before->next = p->next;
@@ -680,7 +792,7 @@ cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p){
 	 } else 
 	 if(p->before != (FifoT_Entry*)NULL && p->next == (FifoT_Entry*)NULL){
 	    p->before->next = p->next;
-	 	cache_entry_tail = p->before;
+	 	sp->fifo_tail = p->before;
 	 }
 	free (p);
 }
@@ -695,80 +807,70 @@ static int							/* The return value is negative if an error occurs	*/
 cef_mem_cache_cs_create (
 		uint32_t		capacity
 ) {
-
-	/* Creates the memory cache 		*/
-	mem_hash_tbl = cef_mem_hash_tbl_create (capacity);
-	if (mem_hash_tbl ==  NULL) {
-		cef_log_write (CefC_Log_Error, "create mem hash table\n");
-		return (-1);
-	}
-	if (cef_mem_cache_fifo_init (capacity) == -1) {
+	CefMemCacheT_Shard* sp;
+	uint32_t shard_cap;
+	uint32_t i;
+	
+	if (capacity < 1) {
 		cef_log_write (CefC_Log_Error, "create fifo cache\n");
 		return (-1);
 	}
+	
+	/* Decides the number of shards, a small cache is not split into tiny shards 	*/
+	mem_shard_num = CefMemCacheC_Shard_Max;
+	while ((mem_shard_num > 1) && 
+		   (capacity / mem_shard_num < CefMemCacheC_Shard_Min_Cap)) {
+		mem_shard_num >>= 1;
+	}
+	
+	/* Creates the memory cache, the shares of the shards sum up to the capacity 	*/
+	for (i = 0 ; i < mem_shard_num ; i++) {
+		sp = &mem_shards[i];
+		memset (sp, 0, sizeof (CefMemCacheT_Shard));
+		pthread_mutex_init (&sp->mutex, NULL);
+		
+		shard_cap = capacity / mem_shard_num;
+		if (i < capacity % mem_shard_num) {
+			shard_cap++;
+		}
+		sp->cache_cap = (int) shard_cap;
+		
+		sp->hash_tbl = cef_mem_hash_tbl_create (shard_cap);
+		if (sp->hash_tbl ==  NULL) {
+			cef_log_write (CefC_Log_Error, "create mem hash table\n");
+			return (-1);
+		}
+		if (cef_mem_cache_fifo_init (sp, shard_cap) == -1) {
+			cef_log_write (CefC_Log_Error, "create fifo cache\n");
+			return (-1);
+		}
+	}
 
-	cef_log_write (CefC_Log_Info, "Local cache capacity : %u\n", capacity);
+	cef_log_write (CefC_Log_Info, "Local cache capacity : %u (%u shards)\n"
+		, capacity, mem_shard_num);
 	
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
 	Store API
 ----------------------------------------------------------------------------------------*/
-static int 
+static int 							/* The return value is negative if an error occurs	*/
 cef_mem_cache_cs_store (
-	CefMemCacheT_Content_Entry* new_entry
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* entry,		/* owned by the cache once stored 		*/
+	unsigned char* key,
+	int key_len,
+	uint32_t hash
 ) {
-	CefMemCacheT_Content_Mem_Entry* entry;
 	CefMemCacheT_Content_Mem_Entry* old_entry = NULL;
-	int key_len;
-	unsigned char key[65535];
-	
-	/* Creates the key 		*/
-	key_len = cef_mem_cache_key_create (new_entry, key);
-
-	/* Creates the entry 		*/
-	entry = 
-		(CefMemCacheT_Content_Mem_Entry*) calloc (1, sizeof (CefMemCacheT_Content_Mem_Entry));
-	if (entry == NULL) {
-		return (-1);
-	}
-	entry->msg = 
-		(unsigned char*) calloc (1, new_entry->msg_len);
-	if (entry->msg == NULL) {
-		free (entry);
-		return (-1);
-	}
-	entry->name = 
-		(unsigned char*) calloc (1, new_entry->name_len);
-	if (entry->name == NULL) {
-		free (entry->msg);
-		free (entry);
-		return (-1);
-	}
 	
 	/* Inserts the cache entry 		*/
-	memcpy (entry->msg, new_entry->msg, new_entry->msg_len);
-	entry->msg_len		 = new_entry->msg_len;
-	memcpy (entry->name, new_entry->name, new_entry->name_len);
-	entry->name_len		 = new_entry->name_len;
-	entry->pay_len		 = new_entry->pay_len;
-	entry->chnk_num		 = new_entry->chnk_num;
-	entry->cache_time	 = new_entry->cache_time;
-	entry->expiry		 = new_entry->expiry;
-	entry->node			 = new_entry->node;
-	
 	if (cef_mem_cache_hash_tbl_item_set (
-		key, key_len, entry, &old_entry) < 0) {
-		free (entry->msg);
-		free (entry->name);
-		free (entry);
+		sp->hash_tbl, hash, key, key_len, entry, &old_entry) < 0) {
 		return (-1);
 	}
 	
-	
 	if (old_entry) {
-		free (old_entry->msg);
-		free (old_entry->name);
 		free (old_entry);
 	}
 	
@@ -780,18 +882,18 @@ cef_mem_cache_cs_store (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_cs_remove (
+	CefMemCacheT_Shard* sp,
 	unsigned char* key, 
-	int key_len
+	int key_len,
+	uint32_t hash
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry;
 	
 	/* Removes the specified entry 	*/
-	entry = cef_mem_cache_hash_tbl_item_remove (key, key_len);
+	entry = cef_mem_cache_hash_tbl_item_remove (sp->hash_tbl, hash, key, key_len);
 	
 	if (entry) {
 		cef_mem_cache_mstat_remove (key, key_len, entry->pay_len);
-		free (entry->msg);
-		free (entry->name);
 		free (entry);
 	}
 	
@@ -803,15 +905,16 @@ cef_mem_cache_cs_remove (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_cs_destroy (
-	void
+	CefMemCacheT_Shard* sp
 ) {
+	CefT_Mem_Hash* ht = sp->hash_tbl;
 	int i;
 	
-	if (mem_hash_tbl) {
-		for (i = 0 ; i < mem_hash_tbl->tabl_max ; i++) {
+	if (ht) {
+		for (i = 0 ; i < ht->tabl_max ; i++) {
 			CefT_Mem_Hash_Cell* cp;
 			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[i];
+			cp = ht->tbl[i];
 			while (cp != NULL) {
 				wcp = cp->next;
 				free (cp->elem);
@@ -819,8 +922,9 @@ cef_mem_cache_cs_destroy (
 				cp = wcp;
 			}
 		}
-		free (mem_hash_tbl->tbl);
-		free (mem_hash_tbl);
+		free (ht->tbl);
+		free (ht);
+		sp->hash_tbl = NULL;
 	}
 	
 	return;
@@ -833,58 +937,104 @@ static void
 cef_mem_cache_cs_expire_check (
 	void
 ) {
-	CefMemCacheT_Content_Mem_Entry* entry = NULL;
-	CefMemCacheT_Content_Mem_Entry* entry1 = NULL;
 	uint64_t 	nowt;
 	struct timeval tv;
-	int n;
-	unsigned char trg_key[65535];
-	int trg_key_len;
+	uint32_t 	i;
+	uint32_t 	n;
+	
+	/* Skips if the previous check is still running 	*/
+	if (pthread_mutex_trylock (&cef_mem_expire_mutex) != 0) {
+		return;
+	}
 	
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
-
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) { 
-		pthread_mutex_lock (&cef_mem_cs_mutex);
-		if (mem_hash_tbl->tbl[n] == NULL) {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
-			continue;
-		}
-		{
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[n];
-			for (; cp != NULL; cp = wcp) {
-				entry = cp->elem;
-				wcp = cp->next;
-				if ((entry->cache_time < nowt) ||
-					((entry->expiry != 0) && (entry->expiry < nowt))) {
-					/* Removes the expiry cache entry 		*/
-					trg_key_len = cef_mem_cache_key_create_by_Mem_Entry (entry, trg_key);
-					entry1 = cef_mem_cache_hash_tbl_item_remove (trg_key, trg_key_len);
-					cef_mem_cache_fifo_erase(trg_key, trg_key_len);
-					cef_mem_cache_mstat_remove (trg_key, trg_key_len, entry->pay_len);
-					free (entry1->msg);
-					free (entry1->name);
-					free (entry1);
-				}
+	
+	/* Checks each shard by a slice of buckets, so that a lookup on the shard 	*/
+	/* waits at most for one slice 												*/
+	for (i = 0 ; i < mem_shard_num ; i++) {
+		n = 0;
+		do {
+			pthread_mutex_lock (&mem_shards[i].mutex);
+			n = cef_mem_cache_shard_expire_check (&mem_shards[i], n, nowt);
+			pthread_mutex_unlock (&mem_shards[i].mutex);
+		} while (n > 0);
+	}
+	pthread_mutex_unlock (&cef_mem_expire_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes the expired entries in a slice of buckets of the shard (the shard must 
+	be locked)
+----------------------------------------------------------------------------------------*/
+static int							/* the next bucket to check, or 0 if the shard was 	*/
+									/* checked to the end 								*/
+cef_mem_cache_shard_expire_check (
+	CefMemCacheT_Shard* sp,
+	uint32_t start,
+	uint64_t nowt
+) {
+	CefT_Mem_Hash* ht = sp->hash_tbl;
+	CefT_Mem_Hash_Cell* cp;
+	CefT_Mem_Hash_Cell* wcp;
+	CefMemCacheT_Content_Mem_Entry* entry;
+	uint32_t n;
+	uint32_t end;
+	
+	end = start + CefMemCacheC_Expire_Slice;
+	if (end > ht->tabl_max) {
+		end = ht->tabl_max;
+	}
+	for (n = start ; n < end ; n++) {
+		for (cp = ht->tbl[n] ; cp != NULL ; cp = wcp) {
+			entry = cp->elem;
+			wcp = cp->next;
+			if ((entry->cache_time < nowt) ||
+				((entry->expiry != 0) && (entry->expiry < nowt))) {
+				/* Removes the expiry cache entry 		*/
+				cef_mem_cache_shard_entry_remove (sp, entry, cp->hash);
 			}
 		}
-		pthread_mutex_unlock (&cef_mem_cs_mutex);
 	}
 	
-	return;
+	return ((end < ht->tabl_max) ? end : 0);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the entry from the hash table and FIFO of the shard, and releases it
+	(the shard must be locked)
+----------------------------------------------------------------------------------------*/
+static void
+cef_mem_cache_shard_entry_remove (
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* entry,
+	uint32_t hash
+) {
+	unsigned char trg_key[CefMemCacheC_Key_Max];
+	int trg_key_len;
+	
+	trg_key_len = cef_mem_cache_key_create_by_Mem_Entry (entry, trg_key);
+	if (cef_mem_cache_hash_tbl_item_remove (
+			sp->hash_tbl, hash, trg_key, trg_key_len) == NULL) {
+		return;
+	}
+	cef_mem_cache_fifo_erase (sp, trg_key, trg_key_len);
+	cef_mem_cache_mstat_remove (trg_key, trg_key_len, entry->pay_len);
+	free (entry);
 }
 /*--------------------------------------------------------------------------------------
 	write the cobs to memry cache
 ----------------------------------------------------------------------------------------*/
-static int							/* The return value is negative if an error occurs	*/
+static int							/* 1 if the entry was stored in the cache, 0 if it 	*/
+									/* was not, or negative if an error occurs 			*/
 cef_mem_cache_cob_write (
-	CefMemCacheT_Content_Entry* cob 
+	CefMemCacheT_Shard* sp,
+	CefMemCacheT_Content_Mem_Entry* cob,
+	unsigned char* trg_key,
+	int trg_key_len,
+	uint32_t hash
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry;
-	unsigned char 	trg_key[CefMemCacheC_Key_Max];
-	int 			trg_key_len;
 	uint64_t nowt;
 	struct timeval tv;
 	
@@ -894,12 +1044,14 @@ cef_mem_cache_cob_write (
 		return (0);
 	}
 
-	trg_key_len = cef_mem_cache_key_create (cob, trg_key);
-	entry = cef_mem_cache_hash_tbl_item_get (trg_key, trg_key_len);
+	entry = cef_mem_cache_hash_tbl_item_get (sp->hash_tbl, hash, trg_key, trg_key_len);
 #if 1
 	if (entry == NULL) {
-		cef_mem_cache_fifo_insert(cob);
+		if (cef_mem_cache_fifo_insert(sp, cob, trg_key, trg_key_len, hash) < 0) {
+			return (-1);
+		}
 		cef_mem_cache_mstat_insert (trg_key, trg_key_len, cob->pay_len);
+		return (1);
 	}
 #else
 	/* This code (#else part) enables to overwrite the old cob kept in the Local cache  */
@@ -907,14 +1059,71 @@ cef_mem_cache_cob_write (
 	/* This is a tentative solution, because this kind of cached content control should */
 	/* be done with the version number of each cob.                                     */
 	if (entry != NULL) {
-		cef_mem_cache_fifo_erase (trg_key, trg_key_len);
-		cef_mem_cache_cs_remove (trg_key, trg_key_len);
+		cef_mem_cache_fifo_erase (sp, trg_key, trg_key_len);
+		cef_mem_cache_cs_remove (sp, trg_key, trg_key_len, hash);
+	}
+	if (cef_mem_cache_fifo_insert(sp, cob, trg_key, trg_key_len, hash) < 0) {
+		return (-1);
 	}
-	cef_mem_cache_fifo_insert(cob);
 	cef_mem_cache_mstat_insert (trg_key, trg_key_len, cob->pay_len);
+	return (1);
 #endif	
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Creates the cache entry, the message and name are held in the same allocation
+----------------------------------------------------------------------------------------*/
+static CefMemCacheT_Content_Mem_Entry* 
+cef_mem_cache_mem_entry_create (
+	const unsigned char* msg,
+	uint16_t msg_len,
+	const unsigned char* name,
+	uint16_t name_len
+) {
+	CefMemCacheT_Content_Mem_Entry* entry;
+	
+	entry = (CefMemCacheT_Content_Mem_Entry*) calloc (
+				1, sizeof (CefMemCacheT_Content_Mem_Entry) + msg_len + name_len);
+	if (entry == NULL) {
+		return (NULL);
+	}
+	entry->msg = (unsigned char*) entry + sizeof (CefMemCacheT_Content_Mem_Entry);
+	memcpy (entry->msg, msg, msg_len);
+	entry->msg_len = msg_len;
+	entry->name = entry->msg + msg_len;
+	memcpy (entry->name, name, name_len);
+	entry->name_len = name_len;
+	
+	return (entry);
+}
+/*--------------------------------------------------------------------------------------
+	Stores the entry in the memory cache, or releases it if it is not stored
+----------------------------------------------------------------------------------------*/
+static void
+cef_mem_cache_mem_entry_write (
+	CefMemCacheT_Content_Mem_Entry* entry
+) {
+	CefMemCacheT_Shard* sp;
+	unsigned char 	key[CefMemCacheC_Key_Max];
+	int 			key_len;
+	uint32_t 		hash;
+	int 			res = 0;
+	
+	if ((mem_shard_num > 0) && 
+		(entry->name_len + 4 + sizeof (uint32_t) <= CefMemCacheC_Key_Max)) {
+		key_len = cef_mem_cache_key_create_by_Mem_Entry (entry, key);
+		hash = cef_mem_hash_number_create (key, key_len);
+		sp = cef_mem_cache_shard_get (hash);
+		
+		pthread_mutex_lock (&sp->mutex);
+		res = cef_mem_cache_cob_write (sp, entry, key, key_len, hash);
+		pthread_mutex_unlock (&sp->mutex);
+	}
+	
+	if (res < 1) {
+		free (entry);
+	}
+}
 
 /****************************************************************************************
 	Hash functions
@@ -971,7 +1180,6 @@ cef_mem_hash_tbl_create (
 	srand ((unsigned) time (NULL));
 	ht->elem_max = table_size;
 	ht->tabl_max = table_size;
-	mem_tabl_max = ht->tabl_max;
 	
 	return (ht);
 }
@@ -980,20 +1188,19 @@ cef_mem_hash_tbl_create (
 ----------------------------------------------------------------------------------------*/
 static int 
 cef_mem_cache_hash_tbl_item_set (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	CefMemCacheT_Content_Mem_Entry* elem, 
 	CefMemCacheT_Content_Mem_Entry** old_elem
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefT_Mem_Hash_Cell* cp;
 	CefT_Mem_Hash_Cell* wcp;
 
 	*old_elem = NULL;
 
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	if(ht->tbl[y] == NULL){
@@ -1003,6 +1210,7 @@ cef_mem_cache_hash_tbl_item_set (
 		}
 		ht->tbl[y]->key = ((unsigned char* )ht->tbl[y]) + sizeof(CefT_Mem_Hash_Cell);
 		cp = ht->tbl[y];
+		cp->hash = hash;
 		cp->elem = elem;
 		cp->klen = klen;
 		memcpy (cp->key, key, klen);
@@ -1028,6 +1236,7 @@ cef_mem_cache_hash_tbl_item_set (
 		ht->tbl[y]->key = ((unsigned char* )ht->tbl[y]) + sizeof(CefT_Mem_Hash_Cell);
 		cp = ht->tbl[y];
 		cp->next = wcp;
+		cp->hash = hash;
 		cp->elem = elem;
 		cp->klen = klen;
 		memcpy (cp->key, key, klen);
@@ -1041,18 +1250,17 @@ cef_mem_cache_hash_tbl_item_set (
 ----------------------------------------------------------------------------------------*/
 static CefMemCacheT_Content_Mem_Entry* 
 cef_mem_cache_hash_tbl_item_get (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefT_Mem_Hash_Cell* cp;
 
 	if ((klen > CefMemCacheC_Key_Max) || (ht == NULL)) {
 		return (NULL);
 	}
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1060,7 +1268,7 @@ cef_mem_cache_hash_tbl_item_get (
 		return (NULL);
 	} 
 	for (; cp != NULL; cp = cp->next) {
-		if((cp->klen == klen) &&
+		if((cp->hash == hash) && (cp->klen == klen) &&
 		   (memcmp (cp->key, key, klen) == 0)){
 		   	return (cp->elem);
 		}
@@ -1074,11 +1282,11 @@ cef_mem_cache_hash_tbl_item_get (
 ----------------------------------------------------------------------------------------*/
 static CefMemCacheT_Content_Mem_Entry* 
 cef_mem_cache_hash_tbl_item_remove (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefMemCacheT_Content_Mem_Entry* ret_elem;
 	CefT_Mem_Hash_Cell* cp;
@@ -1088,7 +1296,6 @@ cef_mem_cache_hash_tbl_item_remove (
 		return (NULL);
 	}
 	
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 	
 	cp = ht->tbl[y];
@@ -1137,6 +1344,16 @@ cef_mem_hash_number_create (
 	
 	return (hash);
 }
+/*--------------------------------------------------------------------------------------
+	Selects the shard of the key from its hash number
+----------------------------------------------------------------------------------------*/
+static CefMemCacheT_Shard* 
+cef_mem_cache_shard_get (
+	uint32_t hash
+) {
+	/* Uses the upper bits, the bucket in the shard is selected by hash % tabl_max 	*/
+	return (&mem_shards[(hash >> 24) & (mem_shard_num - 1)]);
+}
 /*--------------------------------------------------------------------------------------
 	Create hash key
 ----------------------------------------------------------------------------------------*/
@@ -1161,48 +1378,6 @@ cef_mem_cache_key_create_by_Mem_Entry (
 /****************************************************************************************
 	MISC. Functions
  ****************************************************************************************/
-/*--------------------------------------------------------------------------------------
-	Concatenates name and chunk number
-----------------------------------------------------------------------------------------*/
-static int										/* length of the created key 			*/
-cef_mem_cache_name_chunknum_concatenate (
-	const unsigned char* name,
-	uint16_t name_len,
-	uint32_t chunknum,
-	unsigned char* key
-) {
-	uint32_t no_chunknum;
-
-	memcpy (&key[0], name, name_len);
-	key[name_len] 		= 0x00;
-	key[name_len + 1] 	= 0x10;
-	key[name_len + 2] 	= 0x00;
-	key[name_len + 3] 	= 0x04;
-	no_chunknum = htonl (chunknum);
-	memcpy (&key[name_len + 4], &no_chunknum, sizeof (uint32_t));
-
-	return (name_len + 4 + sizeof (uint32_t));
-}
-/*--------------------------------------------------------------------------------------
-	Creates tye key from name and chunk number
-----------------------------------------------------------------------------------------*/
-static int												/* length of the created key 			*/
-cef_mem_cache_key_create (
-	CefMemCacheT_Content_Entry* entry,
-	unsigned char* key
-) {
-	uint32_t chnk_num;
-
-	memcpy (&key[0], entry->name, entry->name_len);
-	key[entry->name_len] 		= 0x00;
-	key[entry->name_len + 1] 	= 0x10;
-	key[entry->name_len + 2] 	= 0x00;
-	key[entry->name_len + 3] 	= 0x04;
-	chnk_num = htonl (entry->chnk_num);
-	memcpy (&key[entry->name_len + 4], &chnk_num, sizeof (uint32_t));
-
-	return (entry->name_len + 4 + sizeof (uint32_t));
-}
 /*--------------------------------------------------------------------------------------
 	Initialize stat
 ----------------------------------------------------------------------------------------*/
@@ -1262,6 +1437,7 @@ cef_mem_cache_mstat_insert (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 	
+	pthread_mutex_lock (&mstat_mutex);
 	if(mstat_tbl[y] == NULL){
 		mstat_tbl[y] = (CefT_Mem_Hash_Stat*)malloc (sizeof (CefT_Mem_Hash_Stat));
 		mstat_p = mstat_tbl[y];
@@ -1272,6 +1448,7 @@ cef_mem_cache_mstat_insert (
 				memcmp (mstat_p->contents_name, key, tmp_klen) == 0) {
 				mstat_p->contents_size += pay_len;
 				mstat_p->cob_num++;
+				pthread_mutex_unlock (&mstat_mutex);
 				return;
 			}
 			if (mstat_p->next == NULL)
@@ -1288,6 +1465,7 @@ cef_mem_cache_mstat_insert (
 	mstat_p->cob_num       = 1;
 	mstat_p->ac_cnt        = 0;
 	mstat_p->next          = NULL;
+	pthread_mutex_unlock (&mstat_mutex);
 	
 	return;
 }
@@ -1301,6 +1479,7 @@ cef_mem_cache_mstat_remove (
 	uint16_t pay_len							/* Length of ContentObject Payload		*/
 ) {
 	CefT_Mem_Hash_Stat* mstat_p;
+	CefT_Mem_Hash_Stat* prev_p;
 	uint16_t tmp_klen;
 	uint32_t seqno;		/* work variable */
 	uint32_t hash = 0;
@@ -1315,6 +1494,8 @@ cef_mem_cache_mstat_remove (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 	
+	pthread_mutex_lock (&mstat_mutex);
+	prev_p = NULL;
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
@@ -1323,23 +1504,23 @@ cef_mem_cache_mstat_remove (
 			mstat_p->cob_num--;
 			
 			if (mstat_p->cob_num == 0) {
-				CefT_Mem_Hash_Stat*		wk_mstat_p;
-				
-				if (mstat_p->contents_name != NULL)
-					free (mstat_p->contents_name);
-				if (mstat_p != mstat_tbl[y]) {
-					wk_mstat_p = mstat_p;
-					mstat_p = mstat_p->next;
-					free (wk_mstat_p);
+				/* Unlinks the stat from the bucket list 	*/
+				if (prev_p != NULL) {
+					prev_p->next = mstat_p->next;
 				} else {
-					free (mstat_p);
-					mstat_tbl[y] = NULL;
+					mstat_tbl[y] = mstat_p->next;
 				}
+				if (mstat_p->contents_name != NULL)
+					free (mstat_p->contents_name);
+				free (mstat_p);
 			}
+			pthread_mutex_unlock (&mstat_mutex);
 			return;
 		}
+		prev_p = mstat_p;
 		mstat_p = mstat_p->next;
 	}
+	pthread_mutex_unlock (&mstat_mutex);
 	
 	return;
 }
@@ -1367,6 +1548,7 @@ cef_mem_cache_mstat_get (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 	
+	pthread_mutex_lock (&mstat_mutex);
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
@@ -1396,11 +1578,13 @@ cef_mem_cache_mstat_get (
 				info_p->ac_cnt 	= mstat_p->ac_cnt;
 			}
 #endif //-----@@@@@ CCNINFO
+			pthread_mutex_unlock (&mstat_mutex);
 			
 			return (1);
 		}
 		mstat_p = mstat_p->next;
 	}
+	pthread_mutex_unlock (&mstat_mutex);
 	
 	return (-1);
 }
@@ -1423,15 +1607,18 @@ cef_mem_cache_mstat_ac_cnt_inc (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 	
+	pthread_mutex_lock (&mstat_mutex);
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
 			memcmp (mstat_p->contents_name, key, tmp_klen) == 0) {
 			mstat_p->ac_cnt++;
+			pthread_mutex_unlock (&mstat_mutex);
 			return;
 		}
 		mstat_p = mstat_p->next;
 	}
+	pthread_mutex_unlock (&mstat_mutex);
 	
 	return;
 }
@@ -168,3 +168,133 @@ cef_rngque_read (
 
 	return (NULL);
 }
+/*--------------------------------------------------------------------------------------
+	Creates the lock-free queue with multiple producers and a single consumer
+----------------------------------------------------------------------------------------*/
+CefT_Mpsc_Que* 								/* NULL if an error occurs 					*/
+cef_mpsc_que_create (
+	int capacity							/* Capacity of the queue 					*/
+) {
+	int p;
+	int i;
+	CefT_Mpsc_Que* qp;
+	
+	/* Obtains the capacity of the queue 		*/
+	if (capacity < 32) {
+		capacity = 32;
+	}
+	if (capacity > 65536) {
+		capacity = 65536;
+	}
+	capacity--;
+	
+	for (p = 0 ; capacity != 0 ; capacity >>= 1) {
+		p = (p << 1) + 1;
+	}
+	capacity = p + 1;
+	
+	qp = (CefT_Mpsc_Que*) calloc (1, sizeof (CefT_Mpsc_Que));
+	if (qp == NULL) {
+		return (NULL);
+	}
+	qp->cells = (CefT_Mpsc_Cell*) malloc (sizeof (CefT_Mpsc_Cell) * capacity);
+	if (qp->cells == NULL) {
+		free (qp);
+		return (NULL);
+	}
+	qp->mask = (uint64_t) capacity - 1;
+	
+	/* Each cell is ready for the push at the same position 	*/
+	for (i = 0 ; i < capacity ; i++) {
+		qp->cells[i].seq  = (uint64_t) i;
+		qp->cells[i].body = NULL;
+	}
+	
+	return (qp);
+}
+/*--------------------------------------------------------------------------------------
+	Free the lock-free queue
+----------------------------------------------------------------------------------------*/
+void
+cef_mpsc_que_destroy (
+	CefT_Mpsc_Que* qp						/* the queue 								*/
+) {
+	free (qp->cells);
+	free (qp);
+}
+/*--------------------------------------------------------------------------------------
+	Inserts the item to the bottom of the queue (any thread)
+----------------------------------------------------------------------------------------*/
+int											/* 1: inserted, 0: the queue is full 		*/
+cef_mpsc_que_push (
+	CefT_Mpsc_Que* qp, 						/* the queue 								*/
+	void* item
+) {
+	CefT_Mpsc_Cell* cell;
+	uint64_t pos;
+	uint64_t seq;
+	int64_t diff;
+	
+	pos = __atomic_load_n (&qp->tail, __ATOMIC_RELAXED);
+	
+	while (1) {
+		cell = &qp->cells[pos & qp->mask];
+		seq  = __atomic_load_n (&cell->seq, __ATOMIC_ACQUIRE);
+		diff = (int64_t) seq - (int64_t) pos;
+		
+		if (diff == 0) {
+			/* Claims the cell, pos is reloaded if another producer took it 	*/
+			if (__atomic_compare_exchange_n (&qp->tail, &pos, pos + 1, 
+					1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			/* The consumer has not popped the item a lap before 	*/
+			return (0);
+		} else {
+			pos = __atomic_load_n (&qp->tail, __ATOMIC_RELAXED);
+		}
+	}
+	cell->body = item;
+	__atomic_store_n (&cell->seq, pos + 1, __ATOMIC_RELEASE);
+	
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the item from the top of the queue (the consumer thread only)
+----------------------------------------------------------------------------------------*/
+void*										/* NULL if the queue is empty 				*/
+cef_mpsc_que_pop (
+	CefT_Mpsc_Que* qp						/* the queue 								*/
+) {
+	CefT_Mpsc_Cell* cell;
+	uint64_t pos;
+	void* item;
+	
+	pos  = qp->head;
+	cell = &qp->cells[pos & qp->mask];
+	
+	/* The producer has not finished writing the item 	*/
+	if (__atomic_load_n (&cell->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+		return (NULL);
+	}
+	item = cell->body;
+	
+	/* The cell is ready for the push in the next lap 	*/
+	__atomic_store_n (&cell->seq, pos + qp->mask + 1, __ATOMIC_RELEASE);
+	__atomic_store_n (&qp->head, pos + 1, __ATOMIC_RELEASE);
+	
+	return (item);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the number of items in the queue
+----------------------------------------------------------------------------------------*/
+int
+cef_mpsc_que_num (
+	CefT_Mpsc_Que* qp						/* the queue 								*/
+) {
+	uint64_t head = __atomic_load_n (&qp->head, __ATOMIC_ACQUIRE);
+	uint64_t tail = __atomic_load_n (&qp->tail, __ATOMIC_ACQUIRE);
+	
+	return ((tail > head) ? (int)(tail - head) : 0);
+}
@@ -38,9 +38,16 @@
 
 #include <string.h>
 #include <limits.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
 #include <arpa/inet.h>
 
 #include <openssl/rsa.h>
+#include <openssl/evp.h>
+#include <openssl/ec.h>
 #include <openssl/sha.h>
 #include <openssl/objects.h>
 #include <openssl/pem.h>
@@ -56,6 +63,11 @@
  Macros
  ****************************************************************************************/
 
+#define CefC_Valid_Pubkey_Cache_Max		64		/* Maximum number of parsed public keys	*/
+												/* held in the public key cache 		*/
+#define CefC_Valid_Pool_Que_Size		4096	/* Capacity of the job queues (2^n)		*/
+#define CefC_Valid_Pool_Que_Mask		(CefC_Valid_Pool_Que_Size - 1)
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
@@ -70,16 +82,53 @@ typedef struct {
 	unsigned char* 	pub_key_bi;
 	int 			pub_key_bi_len;
 	
-	RSA*  			prv_key;
-	RSA*  			pub_key;
+	uint16_t 		alg_type;					/* CefC_T_XXX of the key pair 			*/
+	EVP_PKEY*  		prv_key;
+	EVP_PKEY*  		pub_key;
 	
 } CefT_Keys;
 
+/***** Entry of the public key cache (keyed by SHA-256 digest of the DER key) 	*****/
+typedef struct CefT_Pubkey_Cache_Entry {
+	
+	unsigned char 	keyid[SHA256_DIGEST_LENGTH];
+	EVP_PKEY*  		pub_key;
+	
+	struct CefT_Pubkey_Cache_Entry* prev;		/* toward the most recently used 	*/
+	struct CefT_Pubkey_Cache_Entry* next;		/* toward the least recently used 	*/
+	
+} CefT_Pubkey_Cache_Entry;
+
+/***** Entry of the verified result cache (keyed by SHA-256 digest of the CCN 	*****/
+/***** message and its validation TLVs) 										*****/
+typedef struct CefT_Valid_Result_Entry {
+	
+	unsigned char 	digest[SHA256_DIGEST_LENGTH];
+	uint64_t 		expire_us;					/* entry is ignored after this time 	*/
+	
+	struct CefT_Valid_Result_Entry* prev;		/* toward the most recently used 	*/
+	struct CefT_Valid_Result_Entry* next;		/* toward the least recently used 	*/
+	
+} CefT_Valid_Result_Entry;
+
+/***** Verification worker with its completion ring 							*****/
+/*       The ring is single-producer (the worker) / single-consumer 				*/
+/*       (the thread calling cef_valid_pool_pop), so it needs no lock 			*/
+typedef struct {
+	
+	CefT_Valid_Job* 	que[CefC_Valid_Pool_Que_Size];
+	uint32_t 			head;					/* written only by the worker 		*/
+	uint32_t 			tail;					/* written only by the consumer 	*/
+	pthread_t 			thread;
+	
+} CefT_Valid_Worker;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
 
 static uint32_t 			crc_table[256];
+static pthread_once_t 		crc_table_once = PTHREAD_ONCE_INIT;
 static CefT_Hash_Handle		key_table;
 static CefT_Keys* 			default_key_entry = NULL;
 static char					ccninfo_sha256_prvkey_path[PATH_MAX];
@@ -89,6 +138,40 @@ int 						ccninfo_sha256_pub_key_bi_len;
 RSA*  						ccninfo_sha256_pub_key;
 RSA*  						ccninfo_sha256_prv_key;
 
+static CefT_Hash_Handle			pubkey_cache_tbl = (CefT_Hash_Handle) NULL;
+static CefT_Pubkey_Cache_Entry*	pubkey_cache_head = NULL;
+static CefT_Pubkey_Cache_Entry*	pubkey_cache_tail = NULL;
+static int 						pubkey_cache_num = 0;
+static uint64_t 				pubkey_cache_hit = 0;
+static uint64_t 				pubkey_cache_miss = 0;
+static pthread_mutex_t 			pubkey_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static CefT_Hash_Handle			result_cache_tbl = (CefT_Hash_Handle) NULL;
+static CefT_Valid_Result_Entry*	result_cache_head = NULL;
+static CefT_Valid_Result_Entry*	result_cache_tail = NULL;
+static int 						result_cache_num = 0;
+static int 						result_cache_max = 0;	/* 0 means disabled 			*/
+static uint64_t 				result_cache_ttl_us = 0;
+static uint64_t 				result_cache_hit = 0;
+static uint64_t 				result_cache_miss = 0;
+static pthread_mutex_t 			result_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static CefT_Valid_Worker* 		valid_workers = NULL;
+static int 						valid_worker_num = 0;
+static int 						valid_worker_next = 0;
+static CefT_Valid_Job* 			valid_req_que[CefC_Valid_Pool_Que_Size];
+static uint32_t 				valid_req_head = 0;
+static uint32_t 				valid_req_tail = 0;
+static int 						valid_req_stop_f = 0;
+static pthread_mutex_t 			valid_req_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t 			valid_req_cond = PTHREAD_COND_INITIALIZER;
+static int 						valid_pool_pipe[2] = {-1, -1};
+static int 						valid_pool_armed = 0;
+static int 						valid_pool_inflight = 0;
+static uint64_t 				valid_pool_verified = 0;
+static uint64_t 				valid_pool_failed = 0;
+static uint64_t 				valid_pool_full = 0;
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -115,10 +198,39 @@ static void
 cef_valid_key_entry_free (
 	CefT_Keys* key_entry
 );
+static EVP_PKEY* 
+cef_valid_pubkey_cache_touch (
+	const unsigned char* keyid
+);
+static EVP_PKEY* 
+cef_valid_pubkey_cache_lookup (
+	const unsigned char* pub_key_bi, 
+	int pub_key_bi_len
+);
+static int
+cef_valid_pkey_alg_get (
+	EVP_PKEY* pkey
+);
+static int 									/* 1 if the digest was verified recently 	*/
+cef_valid_result_cache_lookup (
+	const unsigned char* digest
+);
+static void
+cef_valid_result_cache_insert (
+	const unsigned char* digest
+);
+static void
+cef_valid_result_cache_unlink (
+	CefT_Valid_Result_Entry* entry
+);
 static int
 cef_valid_read_conf (
 	const char* conf_path
 );
+static void* 
+cef_valid_pool_worker (
+	void* arg
+);
 static CefT_Keys* 
 cef_valid_key_entry_search (
 	const unsigned char* name, 
@@ -192,6 +304,16 @@ cef_valid_rsa_sha256_hby_verify (
 	uint16_t alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
 	uint16_t pld_offset		 		/* offset of T_VALIDATION_PAYLOAD 					*/
 );
+static int 							/* If the return value is 0 the code is equal, 		*/
+									/* otherwise the code is different. 				*/
+cef_valid_pkey_std_verify (
+	const unsigned char* msg, 
+	uint16_t pkt_len, 				/* PacketLength 									*/
+	uint16_t hdr_len, 				/* HeaderLength (offset of CCN Message)				*/
+	uint16_t alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
+	uint16_t pld_offset,	 		/* offset of T_VALIDATION_PAYLOAD 					*/
+	uint16_t alg_type 				/* CefC_T_ECDSA_P256 or CefC_T_ED25519 				*/
+);
 
 /****************************************************************************************
  ****************************************************************************************/
@@ -202,7 +324,7 @@ cef_valid_init (
 ) {
 	int res = 0;
 	
-	cef_valid_crc_init ();
+	pthread_once (&crc_table_once, cef_valid_crc_init);
 	res = cef_valid_read_conf (conf_path);
 	
 	return (res);
@@ -216,7 +338,7 @@ cef_valid_init_ccninfoUSER (
 ) {
 	int res = 0;
 	
-	cef_valid_crc_init ();
+	pthread_once (&crc_table_once, cef_valid_crc_init);
 	if (valid_type == CefC_T_RSA_SHA256) {
 		sprintf(ccninfo_sha256_prvkey_path, "%s/.ccninfo/ccninfo_user-private-key"
 				, getenv("HOME"));
@@ -263,6 +385,10 @@ cef_valid_type_get (
 		res = CefC_T_RSA_SHA256;
 	} else if (strcmp (type, "crc32") == 0) {
 		res = CefC_T_CRC32C;
+	} else if (strcmp (type, "ecdsa-p256") == 0) {
+		res = CefC_T_ECDSA_P256;
+	} else if (strcmp (type, "ed25519") == 0) {
+		res = CefC_T_ED25519;
 	}
 	
 	return (res);
@@ -276,6 +402,9 @@ cef_valid_crc32_calc (
 	uint32_t c = 0xFFFFFFFF;
 	size_t i;
 	
+	/* csmgrd calculates the checksum without cef_valid_init 	*/
+	pthread_once (&crc_table_once, cef_valid_crc_init);
+	
 	for (i = 0 ; i < len ; i++) {
 		c = crc_table[(c ^ buf[i]) & 0xFF] ^ (c >> 8);
 	}
@@ -388,6 +517,97 @@ cef_valid_get_pubkey (
 	return ((int) val_len);
 }
 
+int
+cef_valid_key_alg_get (
+	const unsigned char* name, 
+	int name_len
+) {
+	CefT_Keys* key_entry;
+	
+	key_entry = (CefT_Keys*) cef_valid_key_entry_search (name, name_len);
+	
+	if (key_entry == NULL) {
+		return (0);
+	}
+	return ((int) key_entry->alg_type);
+}
+
+int
+cef_valid_result_cache_init (
+	int max_num, 
+	int ttl_sec
+) {
+	cef_valid_result_cache_destroy ();
+	
+	if ((max_num < 1) || (ttl_sec < 1)) {
+		return (0);
+	}
+	if (max_num > CefC_Valid_Result_Cache_Max) {
+		max_num = CefC_Valid_Result_Cache_Max;
+	}
+	pthread_mutex_lock (&result_cache_mutex);
+	result_cache_tbl = cef_lhash_tbl_create ((uint32_t) max_num * 2);
+	if (result_cache_tbl == (CefT_Hash_Handle) NULL) {
+		pthread_mutex_unlock (&result_cache_mutex);
+		return (-1);
+	}
+	result_cache_ttl_us = (uint64_t) ttl_sec * 1000000;
+	result_cache_max 	= max_num;
+	pthread_mutex_unlock (&result_cache_mutex);
+	
+	return (0);
+}
+
+void
+cef_valid_result_cache_stat_get (
+	int* num, 
+	int* max_num, 
+	uint64_t* hit, 
+	uint64_t* miss
+) {
+	pthread_mutex_lock (&result_cache_mutex);
+	*num 	 = result_cache_num;
+	*max_num = result_cache_max;
+	*hit  	 = result_cache_hit;
+	*miss 	 = result_cache_miss;
+	pthread_mutex_unlock (&result_cache_mutex);
+}
+
+void
+cef_valid_result_cache_destroy (
+	void
+) {
+	CefT_Valid_Result_Entry* entry;
+	
+	pthread_mutex_lock (&result_cache_mutex);
+	while (result_cache_head) {
+		entry = result_cache_head;
+		result_cache_head = entry->next;
+		free (entry);
+	}
+	if (result_cache_tbl != (CefT_Hash_Handle) NULL) {
+		cef_lhash_tbl_destroy (result_cache_tbl);
+		result_cache_tbl = (CefT_Hash_Handle) NULL;
+	}
+	result_cache_tail 	= NULL;
+	result_cache_num 	= 0;
+	result_cache_max 	= 0;
+	pthread_mutex_unlock (&result_cache_mutex);
+}
+
+void
+cef_valid_pubkey_cache_stat_get (
+	int* num, 
+	uint64_t* hit, 
+	uint64_t* miss
+) {
+	pthread_mutex_lock (&pubkey_cache_mutex);
+	*num  = pubkey_cache_num;
+	*hit  = pubkey_cache_hit;
+	*miss = pubkey_cache_miss;
+	pthread_mutex_unlock (&pubkey_cache_mutex);
+}
+
 int
 cef_valid_dosign (
 	const unsigned char* msg, 
@@ -400,19 +620,40 @@ cef_valid_dosign (
 	unsigned char hash[SHA256_DIGEST_LENGTH];
 	int res;
 	CefT_Keys* key_entry;
+	EVP_MD_CTX* md_ctx;
+	size_t sig_len;
 	
 	key_entry = (CefT_Keys*) cef_valid_key_entry_search (name, name_len);
 	
-	if (key_entry == NULL) {
+	if ((key_entry == NULL) || (key_entry->prv_key == NULL)) {
 		return (0);
 	}
 	
-	SHA256 (msg, msg_len, hash);
-	res = RSA_sign (
-		NID_sha256, hash, SHA256_DIGEST_LENGTH, sign, sign_len, key_entry->prv_key);
+	if (key_entry->alg_type == CefC_T_RSA_SHA256) {
+		SHA256 (msg, msg_len, hash);
+		res = RSA_sign (
+			NID_sha256, hash, SHA256_DIGEST_LENGTH, sign, sign_len, 
+			(RSA*) EVP_PKEY_get0_RSA (key_entry->prv_key));
+		return (res);
+	}
 	
+	/* ECDSA P-256 signs the SHA-256 digest (DER encoded, up to 72 bytes), 	*/
+	/* Ed25519 signs the message itself (64 bytes) 							*/
+	md_ctx = EVP_MD_CTX_new ();
+	if (md_ctx == NULL) {
+		return (0);
+	}
+	res = EVP_DigestSignInit (md_ctx, NULL, 
+			(key_entry->alg_type == CefC_T_ECDSA_P256) ? EVP_sha256 () : NULL, 
+			NULL, key_entry->prv_key);
+	if (res == 1) {
+		sig_len = (size_t) EVP_PKEY_size (key_entry->prv_key);
+		res = EVP_DigestSign (md_ctx, sign, &sig_len, msg, msg_len);
+		*sign_len = (unsigned int) sig_len;
+	}
+	EVP_MD_CTX_free (md_ctx);
 	
-	return (res);
+	return ((res == 1) ? 1 : 0);
 }
 
 int 								/* If the return value is 0 the code is equal, 		*/
@@ -432,6 +673,8 @@ cef_valid_msg_verify (
 	uint16_t 	type, alg_type;
 	uint16_t 	alg_offset = 0;
 	uint16_t 	pld_offset = 0;
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	int 		cache_f = 0;
 	
 	/* Obtains header length and packet length 		*/
 	fixed_hp = (struct fixed_hdr*) msg;
@@ -481,6 +724,19 @@ cef_valid_msg_verify (
 		return (-1);
 	}
 	
+	/* The public key signature of the same message (except the fixed and 	*/
+	/* hop-by-hop headers) is not verified again while it is cached 		*/
+	if ((result_cache_max > 0) && 
+		((alg_type == CefC_T_RSA_SHA256) || 
+		 (alg_type == CefC_T_ECDSA_P256) || 
+		 (alg_type == CefC_T_ED25519))) {
+		SHA256 (&msg[hdr_len], pkt_len - hdr_len, digest);
+		if (cef_valid_result_cache_lookup (digest)) {
+			return (0);
+		}
+		cache_f = 1;
+	}
+	
 	switch (alg_type) {
 		case CefC_T_CRC32C: {
 			res = cef_valid_crc_verify (
@@ -492,13 +748,226 @@ cef_valid_msg_verify (
 					msg, pkt_len, hdr_len, alg_offset, pld_offset);
 			break;
 		}
+		case CefC_T_ECDSA_P256: 
+		case CefC_T_ED25519: {
+			res = cef_valid_pkey_std_verify (
+					msg, pkt_len, hdr_len, alg_offset, pld_offset, alg_type);
+			break;
+		}
 		default: {
 			break;
 		}
 	}
+	if ((cache_f) && (res == 0)) {
+		cef_valid_result_cache_insert (digest);
+	}
 	
 	return (res);
 }
+
+int
+cef_valid_alg_type_get (
+	const unsigned char* msg, 
+	int msg_len
+) {
+	struct fixed_hdr* 	fixed_hp;
+	struct tlv_hdr* 	tlv_ptr;
+	uint16_t 	index;
+	uint16_t 	hdr_len;
+	uint16_t 	val_len;
+	
+	fixed_hp = (struct fixed_hdr*) msg;
+	if ((msg_len < sizeof (struct fixed_hdr)) || 
+		(ntohs (fixed_hp->pkt_len) != msg_len)) {
+		return (-1);
+	}
+	hdr_len = fixed_hp->hdr_len;
+	if (hdr_len + CefC_S_TLF > msg_len) {
+		return (-1);
+	}
+	
+	/* Skips the CCN message 		*/
+	tlv_ptr = (struct tlv_hdr*) &msg[hdr_len];
+	val_len = ntohs (tlv_ptr->length);
+	index = hdr_len + CefC_S_TLF + val_len;
+	if (index == msg_len) {
+		return (0);
+	}
+	if (index + CefC_S_TLF + CefC_S_TLF > msg_len) {
+		return (-1);
+	}
+	
+	/* Obtains the Algorithm Type 	*/
+	tlv_ptr = (struct tlv_hdr*) &msg[index];
+	if (ntohs (tlv_ptr->type) != CefC_T_VALIDATION_ALG) {
+		return (-1);
+	}
+	tlv_ptr = (struct tlv_hdr*) &msg[index + CefC_S_TLF];
+	
+	return ((int) ntohs (tlv_ptr->type));
+}
+
+int
+cef_valid_pool_init (
+	int worker_num
+) {
+	int i;
+	int flag;
+	
+	if ((worker_num < 1) || (worker_num > CefC_Valid_Pool_Worker_Max) || 
+		(valid_workers != NULL)) {
+		return (-1);
+	}
+	if (pipe (valid_pool_pipe) < 0) {
+		cef_log_write (CefC_Log_Error, "%s (pipe:%s)\n", __func__, strerror (errno));
+		return (-1);
+	}
+	for (i = 0 ; i < 2 ; i++) {
+		flag = fcntl (valid_pool_pipe[i], F_GETFL, 0);
+		fcntl (valid_pool_pipe[i], F_SETFL, flag | O_NONBLOCK);
+	}
+	
+	valid_workers = (CefT_Valid_Worker*) calloc (worker_num, sizeof (CefT_Valid_Worker));
+	if (valid_workers == NULL) {
+		close (valid_pool_pipe[0]);
+		close (valid_pool_pipe[1]);
+		valid_pool_pipe[0] = valid_pool_pipe[1] = -1;
+		return (-1);
+	}
+	valid_req_head 		= 0;
+	valid_req_tail 		= 0;
+	valid_req_stop_f 	= 0;
+	valid_pool_armed 	= 1;
+	valid_pool_inflight = 0;
+	
+	for (i = 0 ; i < worker_num ; i++) {
+		if (pthread_create (&valid_workers[i].thread, NULL, 
+				cef_valid_pool_worker, &valid_workers[i]) != 0) {
+			cef_log_write (CefC_Log_Error, 
+				"Failed to create the verification worker #%d\n", i);
+			valid_worker_num = i;
+			cef_valid_pool_destroy (NULL);
+			return (-1);
+		}
+	}
+	valid_worker_num = worker_num;
+	
+	return (valid_pool_pipe[0]);
+}
+
+int
+cef_valid_pool_push (
+	CefT_Valid_Job* job
+) {
+	if (valid_worker_num < 1) {
+		return (-1);
+	}
+	if (valid_pool_inflight >= CefC_Valid_Pool_Que_Size) {
+		valid_pool_full++;
+		return (-1);
+	}
+	valid_pool_inflight++;
+	
+	pthread_mutex_lock (&valid_req_mutex);
+	valid_req_que[valid_req_tail & CefC_Valid_Pool_Que_Mask] = job;
+	valid_req_tail++;
+	pthread_cond_signal (&valid_req_cond);
+	pthread_mutex_unlock (&valid_req_mutex);
+	
+	return (0);
+}
+
+void
+cef_valid_pool_ack (
+	void
+) {
+	char buff[64];
+	
+	while (read (valid_pool_pipe[0], buff, sizeof (buff)) > 0) {
+		/* NOP */;
+	}
+	/* Re-arms the doorbell before the caller drains the completion rings, 	*/
+	/* so that a job completed after the drain always rings it again 		*/
+	__atomic_store_n (&valid_pool_armed, 1, __ATOMIC_SEQ_CST);
+}
+
+CefT_Valid_Job* 
+cef_valid_pool_pop (
+	void
+) {
+	CefT_Valid_Worker* worker;
+	CefT_Valid_Job* job;
+	int i;
+	
+	for (i = 0 ; i < valid_worker_num ; i++) {
+		worker = &valid_workers[valid_worker_next];
+		valid_worker_next = (valid_worker_next + 1) % valid_worker_num;
+		
+		if (__atomic_load_n (&worker->head, __ATOMIC_ACQUIRE) != worker->tail) {
+			job = worker->que[worker->tail & CefC_Valid_Pool_Que_Mask];
+			__atomic_store_n (&worker->tail, worker->tail + 1, __ATOMIC_RELEASE);
+			valid_pool_inflight--;
+			if (job->res == 0) {
+				valid_pool_verified++;
+			} else {
+				valid_pool_failed++;
+			}
+			return (job);
+		}
+	}
+	return (NULL);
+}
+
+void
+cef_valid_pool_stat_get (
+	int* worker_num, 
+	int* inflight, 
+	uint64_t* verified, 
+	uint64_t* failed, 
+	uint64_t* full
+) {
+	*worker_num = valid_worker_num;
+	*inflight 	= valid_pool_inflight;
+	*verified 	= valid_pool_verified;
+	*failed 	= valid_pool_failed;
+	*full 		= valid_pool_full;
+}
+
+void
+cef_valid_pool_destroy (
+	void (*release)(CefT_Valid_Job*)
+) {
+	CefT_Valid_Job* job;
+	int i;
+	
+	if (valid_workers == NULL) {
+		return;
+	}
+	
+	/* Workers finish the queued jobs before they exit 		*/
+	pthread_mutex_lock (&valid_req_mutex);
+	valid_req_stop_f = 1;
+	pthread_cond_broadcast (&valid_req_cond);
+	pthread_mutex_unlock (&valid_req_mutex);
+	
+	for (i = 0 ; i < valid_worker_num ; i++) {
+		pthread_join (valid_workers[i].thread, NULL);
+	}
+	while ((job = cef_valid_pool_pop ()) != NULL) {
+		if (release) {
+			(*release)(job);
+		}
+	}
+	
+	free (valid_workers);
+	valid_workers 		= NULL;
+	valid_worker_num 	= 0;
+	valid_worker_next 	= 0;
+	close (valid_pool_pipe[0]);
+	close (valid_pool_pipe[1]);
+	valid_pool_pipe[0] 	= -1;
+	valid_pool_pipe[1] 	= -1;
+}
 #ifdef CefC_Ccninfo
 int 
 cef_valid_keyid_create_forccninfo (
@@ -860,7 +1329,7 @@ cef_valid_rsa_sha256_std_verify (
 	int 				res;
 	unsigned char* 		pub_key_bi;
 	int 				pub_key_bi_len;
-	RSA*  				pub_key;
+	EVP_PKEY*  			pub_key;
 	
 	/* Obtains the Name 		*/
 	index = hdr_len + CefC_S_TLF;
@@ -872,7 +1341,6 @@ cef_valid_rsa_sha256_std_verify (
 	{
 		uint16_t 		pkey_offset;
 		uint16_t 		type;
-		unsigned char* 	ptr_for_free;
 
 		pkey_offset = alg_offset;
 		pkey_offset += CefC_S_TLF; 			/* Move offset by TL size of T_VALIDATION_ALG	*/
@@ -889,15 +1357,17 @@ cef_valid_rsa_sha256_std_verify (
 			return (1);
 		}
 		length = ntohs (tlv_ptr->length);
-		ptr_for_free = pub_key_bi = (unsigned char*)calloc(length, 1);
+		pub_key_bi = (unsigned char*) &msg[pkey_offset+CefC_S_TLF];
 		pub_key_bi_len = length;
-		memcpy (pub_key_bi, &msg[pkey_offset+CefC_S_TLF], pub_key_bi_len);
 
-		pub_key = d2i_RSA_PUBKEY(NULL, (const unsigned char**)&pub_key_bi, pub_key_bi_len);
-		free(ptr_for_free);
+		pub_key = cef_valid_pubkey_cache_lookup (pub_key_bi, pub_key_bi_len);
 		if (pub_key == NULL) {
 			return (1);
 		}
+		if (cef_valid_pkey_alg_get (pub_key) != CefC_T_RSA_SHA256) {
+			EVP_PKEY_free (pub_key);
+			return (1);
+		}
 	}
 	/* Obtains the Validation Payload 		*/
 	tlv_ptr = (struct tlv_hdr*) &msg[pld_offset];
@@ -908,8 +1378,9 @@ cef_valid_rsa_sha256_std_verify (
 	SHA256 (&msg[hdr_len], pld_offset - hdr_len, hash);
 	
 	res = RSA_verify (
-		NID_sha256, hash, SHA256_DIGEST_LENGTH, &msg[index], length, pub_key);
-	RSA_free (pub_key);
+		NID_sha256, hash, SHA256_DIGEST_LENGTH, &msg[index], length, 
+		(RSA*) EVP_PKEY_get0_RSA (pub_key));
+	EVP_PKEY_free (pub_key);
 	
 #ifdef CefC_Debug
 	cef_dbg_write (CefC_Dbg_Finest, 
@@ -931,6 +1402,75 @@ cef_valid_rsa_sha256_hby_verify (
 	fprintf (stderr, "cef_valid_rsa_sha256_hby_verify ()\n");
 	return (0);
 }
+static int 							/* If the return value is 0 the code is equal, 		*/
+									/* otherwise the code is different. 				*/
+cef_valid_pkey_std_verify (
+	const unsigned char* msg, 
+	uint16_t pkt_len, 				/* PacketLength 									*/
+	uint16_t hdr_len, 				/* HeaderLength (offset of CCN Message)				*/
+	uint16_t alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
+	uint16_t pld_offset,	 		/* offset of T_VALIDATION_PAYLOAD 					*/
+	uint16_t alg_type 				/* CefC_T_ECDSA_P256 or CefC_T_ED25519 				*/
+) {
+	struct tlv_hdr* 	tlv_ptr;
+	uint16_t 			index;
+	uint16_t 			length;
+	uint16_t 			pkey_offset;
+	EVP_PKEY*  			pub_key;
+	EVP_MD_CTX* 		md_ctx;
+	int 				res = 0;
+	
+	/* Obtains the Public Key, laid out in the same way as T_RSA-SHA256 	*/
+	pkey_offset = alg_offset + CefC_S_TLF + CefC_S_TLF;
+	tlv_ptr = (struct tlv_hdr*) &msg[pkey_offset];
+	length = ntohs (tlv_ptr->length);
+	pkey_offset += CefC_S_TLF + length;
+	if (pkey_offset + CefC_S_TLF > pld_offset) {
+		return (1);
+	}
+	tlv_ptr = (struct tlv_hdr*) &msg[pkey_offset];
+	length = ntohs (tlv_ptr->length);
+	if ((ntohs (tlv_ptr->type) != CefC_T_PUBLICKEY) || 
+		(pkey_offset + CefC_S_TLF + length > pld_offset)) {
+		return (1);
+	}
+	pub_key = cef_valid_pubkey_cache_lookup (
+					&msg[pkey_offset + CefC_S_TLF], length);
+	if (pub_key == NULL) {
+		return (1);
+	}
+	if (cef_valid_pkey_alg_get (pub_key) != alg_type) {
+		EVP_PKEY_free (pub_key);
+		return (1);
+	}
+	
+	/* Obtains the Validation Payload 		*/
+	tlv_ptr = (struct tlv_hdr*) &msg[pld_offset];
+	length = ntohs (tlv_ptr->length);
+	index = pld_offset + CefC_S_TLF;
+	
+	/* Verification the sign 				*/
+	md_ctx = EVP_MD_CTX_new ();
+	if (md_ctx != NULL) {
+		if (EVP_DigestVerifyInit (md_ctx, NULL, 
+				(alg_type == CefC_T_ECDSA_P256) ? EVP_sha256 () : NULL, 
+				NULL, pub_key) == 1) {
+			res = EVP_DigestVerify (md_ctx, &msg[index], length, 
+						&msg[hdr_len], pld_offset - hdr_len);
+		}
+		EVP_MD_CTX_free (md_ctx);
+	}
+	EVP_PKEY_free (pub_key);
+	
+#ifdef CefC_Debug
+	cef_dbg_write (CefC_Dbg_Finest, 
+		"[%s] validation is %s\n", 
+		(alg_type == CefC_T_ED25519) ? "ED25519" : "ECDSA-P256", 
+		(res == 1) ? "OK" : "NG");
+#endif // CefC_Debug
+	
+	return ((res == 1) ? 0 : 1);
+}
 
 static CefT_Keys* 
 cef_valid_key_entry_search (
@@ -966,6 +1506,344 @@ cef_valid_key_entry_search (
 	}
 	return (default_key_entry);
 }
+/*--------------------------------------------------------------------------------------
+	Verification worker thread
+----------------------------------------------------------------------------------------*/
+static void* 
+cef_valid_pool_worker (
+	void* arg
+) {
+	CefT_Valid_Worker* worker = (CefT_Valid_Worker*) arg;
+	CefT_Valid_Job* job;
+	uint32_t head;
+	
+	while (1) {
+		pthread_mutex_lock (&valid_req_mutex);
+		while ((valid_req_head == valid_req_tail) && (valid_req_stop_f == 0)) {
+			pthread_cond_wait (&valid_req_cond, &valid_req_mutex);
+		}
+		if (valid_req_head == valid_req_tail) {
+			pthread_mutex_unlock (&valid_req_mutex);
+			break;
+		}
+		job = valid_req_que[valid_req_head & CefC_Valid_Pool_Que_Mask];
+		valid_req_head++;
+		pthread_mutex_unlock (&valid_req_mutex);
+		
+		job->res = cef_valid_msg_verify (job->msg, job->msg_len);
+		
+		/* The number of jobs in the pool never exceeds the ring size, 	*/
+		/* so the ring cannot overflow here 								*/
+		head = worker->head;
+		worker->que[head & CefC_Valid_Pool_Que_Mask] = job;
+		__atomic_store_n (&worker->head, head + 1, __ATOMIC_RELEASE);
+		
+		if (__atomic_exchange_n (&valid_pool_armed, 0, __ATOMIC_SEQ_CST)) {
+			if (write (valid_pool_pipe[1], "v", 1) < 0) {
+				/* the pipe is already readable */;
+			}
+		}
+	}
+	
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Looks up the cached public key and moves it to the head of the LRU list, 
+	the caller holds pubkey_cache_mutex
+----------------------------------------------------------------------------------------*/
+static EVP_PKEY* 								/* referenced key, or NULL				*/
+cef_valid_pubkey_cache_touch (
+	const unsigned char* keyid					/* SHA256 of the DER encoded SPKI		*/
+) {
+	CefT_Pubkey_Cache_Entry* entry;
+	
+	entry = (CefT_Pubkey_Cache_Entry*) 
+		cef_lhash_tbl_item_get (pubkey_cache_tbl, keyid, SHA256_DIGEST_LENGTH);
+	if (entry == NULL) {
+		return (NULL);
+	}
+	if (entry != pubkey_cache_head) {
+		entry->prev->next = entry->next;
+		if (entry->next) {
+			entry->next->prev = entry->prev;
+		} else {
+			pubkey_cache_tail = entry->prev;
+		}
+		entry->prev = NULL;
+		entry->next = pubkey_cache_head;
+		pubkey_cache_head->prev = entry;
+		pubkey_cache_head = entry;
+	}
+	EVP_PKEY_up_ref (entry->pub_key);
+	
+	return (entry->pub_key);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the parsed public key from the cache, or parses and caches it. 
+	The returned key holds its own reference and must be released with EVP_PKEY_free
+----------------------------------------------------------------------------------------*/
+static EVP_PKEY* 
+cef_valid_pubkey_cache_lookup (
+	const unsigned char* pub_key_bi, 			/* DER encoded SPKI						*/
+	int pub_key_bi_len
+) {
+	CefT_Pubkey_Cache_Entry* entry;
+	unsigned char keyid[SHA256_DIGEST_LENGTH];
+	const unsigned char* wp = pub_key_bi;
+	EVP_PKEY* pub_key;
+	EVP_PKEY* cached;
+	
+	if (pub_key_bi_len < 1) {
+		return (NULL);
+	}
+	SHA256 (pub_key_bi, pub_key_bi_len, keyid);
+	
+	pthread_mutex_lock (&pubkey_cache_mutex);
+	
+	if (pubkey_cache_tbl == (CefT_Hash_Handle) NULL) {
+		pubkey_cache_tbl = cef_lhash_tbl_create (CefC_Valid_Pubkey_Cache_Max * 2);
+	}
+	cached = cef_valid_pubkey_cache_touch (keyid);
+	if (cached) {
+		pubkey_cache_hit++;
+		pthread_mutex_unlock (&pubkey_cache_mutex);
+		return (cached);
+	}
+	pubkey_cache_miss++;
+	pthread_mutex_unlock (&pubkey_cache_mutex);
+	
+	/* The key is decoded without the lock, so that the workers which miss 	*/
+	/* at the same time do not wait for each other 							*/
+	pub_key = d2i_PUBKEY (NULL, &wp, pub_key_bi_len);
+	if (pub_key == NULL) {
+		return (NULL);
+	}
+	if (EVP_PKEY_base_id (pub_key) == EVP_PKEY_RSA) {
+		/* Prepares the legacy RSA key used by RSA_verify before it is shared 	*/
+		EVP_PKEY_get0_RSA (pub_key);
+	}
+	
+	pthread_mutex_lock (&pubkey_cache_mutex);
+	
+	/* Another thread may have cached the same key meanwhile 	*/
+	cached = cef_valid_pubkey_cache_touch (keyid);
+	if (cached) {
+		pthread_mutex_unlock (&pubkey_cache_mutex);
+		EVP_PKEY_free (pub_key);
+		return (cached);
+	}
+	
+	/* Evicts the least recently used entry 		*/
+	if (pubkey_cache_num >= CefC_Valid_Pubkey_Cache_Max) {
+		entry = pubkey_cache_tail;
+		pubkey_cache_tail = entry->prev;
+		pubkey_cache_tail->next = NULL;
+		cef_lhash_tbl_item_remove (
+			pubkey_cache_tbl, entry->keyid, SHA256_DIGEST_LENGTH);
+		EVP_PKEY_free (entry->pub_key);
+		pubkey_cache_num--;
+	} else {
+		entry = (CefT_Pubkey_Cache_Entry*) malloc (sizeof (CefT_Pubkey_Cache_Entry));
+		if (entry == NULL) {
+			pthread_mutex_unlock (&pubkey_cache_mutex);
+			return (pub_key);
+		}
+	}
+	memcpy (entry->keyid, keyid, SHA256_DIGEST_LENGTH);
+	entry->pub_key = pub_key;
+	
+	if (cef_lhash_tbl_item_set (
+			pubkey_cache_tbl, keyid, SHA256_DIGEST_LENGTH, entry) < 0) {
+		free (entry);
+		pthread_mutex_unlock (&pubkey_cache_mutex);
+		return (pub_key);
+	}
+	entry->prev = NULL;
+	entry->next = pubkey_cache_head;
+	if (pubkey_cache_head) {
+		pubkey_cache_head->prev = entry;
+	} else {
+		pubkey_cache_tail = entry;
+	}
+	pubkey_cache_head = entry;
+	pubkey_cache_num++;
+	
+	EVP_PKEY_up_ref (pub_key);
+	pthread_mutex_unlock (&pubkey_cache_mutex);
+	
+	return (pub_key);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the current time (monotonic, us) used for the verified result cache
+----------------------------------------------------------------------------------------*/
+static uint64_t 
+cef_valid_result_cache_now (
+	void
+) {
+	struct timespec ts;
+	
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the entry from the LRU list and the table of the verified result cache 
+	(result_cache_mutex must be held)
+----------------------------------------------------------------------------------------*/
+static void
+cef_valid_result_cache_unlink (
+	CefT_Valid_Result_Entry* entry
+) {
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else {
+		result_cache_head = entry->next;
+	}
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	} else {
+		result_cache_tail = entry->prev;
+	}
+	cef_lhash_tbl_item_remove (
+		result_cache_tbl, entry->digest, SHA256_DIGEST_LENGTH);
+	result_cache_num--;
+}
+/*--------------------------------------------------------------------------------------
+	Looks up the verified result cache
+----------------------------------------------------------------------------------------*/
+static int 									/* 1 if the digest was verified recently 	*/
+cef_valid_result_cache_lookup (
+	const unsigned char* digest
+) {
+	CefT_Valid_Result_Entry* entry;
+	
+	pthread_mutex_lock (&result_cache_mutex);
+	if (result_cache_tbl == (CefT_Hash_Handle) NULL) {
+		pthread_mutex_unlock (&result_cache_mutex);
+		return (0);
+	}
+	entry = (CefT_Valid_Result_Entry*) 
+		cef_lhash_tbl_item_get (result_cache_tbl, digest, SHA256_DIGEST_LENGTH);
+	
+	if (entry == NULL) {
+		result_cache_miss++;
+		pthread_mutex_unlock (&result_cache_mutex);
+		return (0);
+	}
+	if (entry->expire_us < cef_valid_result_cache_now ()) {
+		cef_valid_result_cache_unlink (entry);
+		free (entry);
+		result_cache_miss++;
+		pthread_mutex_unlock (&result_cache_mutex);
+		return (0);
+	}
+	result_cache_hit++;
+	
+	/* Moves the entry to the head of the LRU list 		*/
+	if (entry != result_cache_head) {
+		entry->prev->next = entry->next;
+		if (entry->next) {
+			entry->next->prev = entry->prev;
+		} else {
+			result_cache_tail = entry->prev;
+		}
+		entry->prev = NULL;
+		entry->next = result_cache_head;
+		result_cache_head->prev = entry;
+		result_cache_head = entry;
+	}
+	pthread_mutex_unlock (&result_cache_mutex);
+	
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Records the digest of the message which passed the verification
+----------------------------------------------------------------------------------------*/
+static void
+cef_valid_result_cache_insert (
+	const unsigned char* digest
+) {
+	CefT_Valid_Result_Entry* entry;
+	uint64_t now_us = cef_valid_result_cache_now ();
+	
+	pthread_mutex_lock (&result_cache_mutex);
+	if (result_cache_tbl == (CefT_Hash_Handle) NULL) {
+		pthread_mutex_unlock (&result_cache_mutex);
+		return;
+	}
+	
+	/* Another thread may have verified the same message in the meantime 	*/
+	entry = (CefT_Valid_Result_Entry*) 
+		cef_lhash_tbl_item_get (result_cache_tbl, digest, SHA256_DIGEST_LENGTH);
+	if (entry) {
+		entry->expire_us = now_us + result_cache_ttl_us;
+		pthread_mutex_unlock (&result_cache_mutex);
+		return;
+	}
+	
+	/* Reuses the least recently used entry when the cache is full 	*/
+	if (result_cache_num >= result_cache_max) {
+		entry = result_cache_tail;
+		cef_valid_result_cache_unlink (entry);
+	} else {
+		entry = (CefT_Valid_Result_Entry*) malloc (sizeof (CefT_Valid_Result_Entry));
+		if (entry == NULL) {
+			pthread_mutex_unlock (&result_cache_mutex);
+			return;
+		}
+	}
+	memcpy (entry->digest, digest, SHA256_DIGEST_LENGTH);
+	entry->expire_us = now_us + result_cache_ttl_us;
+	
+	if (cef_lhash_tbl_item_set (
+			result_cache_tbl, entry->digest, SHA256_DIGEST_LENGTH, entry) < 0) {
+		free (entry);
+		pthread_mutex_unlock (&result_cache_mutex);
+		return;
+	}
+	entry->prev = NULL;
+	entry->next = result_cache_head;
+	if (result_cache_head) {
+		result_cache_head->prev = entry;
+	} else {
+		result_cache_tail = entry;
+	}
+	result_cache_head = entry;
+	result_cache_num++;
+	
+	pthread_mutex_unlock (&result_cache_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the validation algorithm which the specified key is used for
+----------------------------------------------------------------------------------------*/
+static int 									/* CefC_T_XXX, or CefC_T_ALG_INVALID 		*/
+cef_valid_pkey_alg_get (
+	EVP_PKEY* pkey
+) {
+	EC_KEY* ec_key;
+	
+	switch (EVP_PKEY_base_id (pkey)) {
+		case EVP_PKEY_RSA: {
+			return (CefC_T_RSA_SHA256);
+		}
+		case EVP_PKEY_ED25519: {
+			return (CefC_T_ED25519);
+		}
+		case EVP_PKEY_EC: {
+			/* The APIs available since OpenSSL 1.1.1 are used 	*/
+			ec_key = EVP_PKEY_get0_EC_KEY (pkey);
+			if ((ec_key) && 
+				(EC_GROUP_get_curve_name (EC_KEY_get0_group (ec_key)) == 
+					NID_X9_62_prime256v1)) {
+				return (CefC_T_ECDSA_P256);
+			}
+			break;
+		}
+		default: {
+			break;
+		}
+	}
+	return (CefC_T_ALG_INVALID);
+}
 #ifdef CefC_Ccninfo
 static int
 cef_valid_create_keyinfo_forccninfo (
@@ -1072,7 +1950,7 @@ cef_valid_rsa_sha256_std_verify_forccninfo (
 	int 				rtc;
 	unsigned char* 		pub_key_bi;
 	int 				pub_key_bi_len;
-	RSA*  				pub_key;
+	EVP_PKEY*  			pub_key;
 	
 	/* Obtains the Name 		*/
 	index = hdr_len + CefC_S_TLF;
@@ -1084,7 +1962,6 @@ cef_valid_rsa_sha256_std_verify_forccninfo (
 	{
 		uint16_t 		pkey_offset;
 		uint16_t 		type;
-		unsigned char* 	ptr_for_free;
 
 		pkey_offset = alg_offset;
 		pkey_offset += CefC_S_TLF; 			/* Move offset by TL size of T_VALIDATION_ALG	*/
@@ -1101,18 +1978,27 @@ cef_valid_rsa_sha256_std_verify_forccninfo (
 			return (1);
 		}
 		length = ntohs (tlv_ptr->length);
-		ptr_for_free = pub_key_bi = (unsigned char*)calloc(length, 1);
+		pub_key_bi = (unsigned char*) &msg[pkey_offset+CefC_S_TLF];
 		pub_key_bi_len = length;
-		memcpy (pub_key_bi, &msg[pkey_offset+CefC_S_TLF], pub_key_bi_len);
 		if (rcvdpub_key_bi_len_p != NULL && rcvdpub_key_bi_pp != NULL) {
 			/* Set information used in authentication & authorization */
 			*rcvdpub_key_bi_len_p = pub_key_bi_len;
 			*rcvdpub_key_bi_pp = (unsigned char*)calloc(pub_key_bi_len, 1);
 			memcpy (*rcvdpub_key_bi_pp, pub_key_bi, pub_key_bi_len);
 		}
-		pub_key = d2i_RSA_PUBKEY(NULL, (const unsigned char**)&pub_key_bi, pub_key_bi_len);
-		free(ptr_for_free);
+		pub_key = cef_valid_pubkey_cache_lookup (pub_key_bi, pub_key_bi_len);
+		if ((pub_key != NULL) && 
+			(cef_valid_pkey_alg_get (pub_key) != CefC_T_RSA_SHA256)) {
+			EVP_PKEY_free (pub_key);
+			pub_key = NULL;
+		}
 		if (pub_key == NULL) {
+			/* Clear information used in authentication & authorization */
+			if (rcvdpub_key_bi_len_p != NULL && rcvdpub_key_bi_pp != NULL) {
+				*rcvdpub_key_bi_len_p = 0;
+				free (*rcvdpub_key_bi_pp);
+				*rcvdpub_key_bi_pp = NULL;
+			}
 			return (1);
 		}
 	}
@@ -1125,8 +2011,9 @@ cef_valid_rsa_sha256_std_verify_forccninfo (
 	SHA256 (&msg[hdr_len], pld_offset - hdr_len, hash);
 	
 	res = RSA_verify (
-		NID_sha256, hash, SHA256_DIGEST_LENGTH, &msg[index], length, pub_key);
-	RSA_free (pub_key);
+		NID_sha256, hash, SHA256_DIGEST_LENGTH, &msg[index], length, 
+		(RSA*) EVP_PKEY_get0_RSA (pub_key));
+	EVP_PKEY_free (pub_key);
 	
 #ifdef CefC_Debug
 	cef_dbg_write (CefC_Dbg_Finest, 
@@ -1231,8 +2118,13 @@ cef_valid_read_conf (
 			return (-1);
 		}
 		
-		key_entry->pub_key = PEM_read_RSA_PUBKEY (key_fp, NULL, NULL, NULL);
-		if (key_entry->pub_key == NULL) {
+		key_entry->pub_key = PEM_read_PUBKEY (key_fp, NULL, NULL, NULL);
+		if (key_entry->pub_key) {
+			key_entry->alg_type = 
+				(uint16_t) cef_valid_pkey_alg_get (key_entry->pub_key);
+		}
+		if ((key_entry->pub_key == NULL) || 
+			(key_entry->alg_type == CefC_T_ALG_INVALID)) {
 			cef_log_write (CefC_Log_Error, 
 				"Invalid public key (%s) is specified in cefnetd.key\n", 
 				key_entry->pub_key_path);
@@ -1242,7 +2134,7 @@ cef_valid_read_conf (
 		}
 		
 		key_entry->pub_key_bi_len 
-			= i2d_RSA_PUBKEY (key_entry->pub_key, &key_entry->pub_key_bi);
+			= i2d_PUBKEY (key_entry->pub_key, &key_entry->pub_key_bi);
 		if (key_entry->pub_key_bi_len < 1) {
 			cef_log_write (CefC_Log_Error, 
 				"Invalid public key (%s) is specified in cefnetd.key\n", 
@@ -1263,8 +2155,9 @@ cef_valid_read_conf (
 			continue;
 		}
 		
-		key_entry->prv_key = PEM_read_RSAPrivateKey (key_fp, NULL, NULL, NULL);
-		if (key_entry->prv_key == NULL) {
+		key_entry->prv_key = PEM_read_PrivateKey (key_fp, NULL, NULL, NULL);
+		if ((key_entry->prv_key == NULL) || 
+			(cef_valid_pkey_alg_get (key_entry->prv_key) != key_entry->alg_type)) {
 			fclose (key_fp);
 			cef_valid_key_entry_free (key_entry);
 			return (-1);
@@ -1293,10 +2186,10 @@ cef_valid_key_entry_free (
 ) {
 	
 	if (key_entry->prv_key) {
-		RSA_free (key_entry->prv_key);
+		EVP_PKEY_free (key_entry->prv_key);
 	}
 	if (key_entry->pub_key) {
-		RSA_free (key_entry->pub_key);
+		EVP_PKEY_free (key_entry->pub_key);
 	}
 	if (key_entry->pub_key_bi_len > 0) {
 		free (key_entry->pub_key_bi);
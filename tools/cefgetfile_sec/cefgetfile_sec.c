@@ -292,8 +292,10 @@ int main (
 			}
 			work_arg = argv[i + 1];
 			mode_val = atoi (work_arg);
-			if ( (mode_val < 0) && (mode_val > 2) ) {
-				fprintf (stderr, "ERROR: [-m] parameter is 0 or 1 or 2.\n");
+			if ( (mode_val < 0) || (mode_val > 3) ) {
+				fprintf (stderr, "ERROR: [-m] parameter is 0 or 1 or 2 or 3.\n");
+				print_usage ();
+				return (-1);
 			}
 			mode_f++;
 			i++;
@@ -432,7 +434,7 @@ int main (
 	/*---------------------------------------------------------------------------
 		Get	Manifest
 	-----------------------------------------------------------------------------*/
-	if ( (mode_val == 1) || (mode_val == 2) ) {
+	if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 		srand((unsigned)time(NULL));
 		uint32_t rand_n = rand();
 		sprintf( man_fpath, "%s/manifest_%d", getenv("HOME"), rand_n );
@@ -463,6 +465,18 @@ printf ("Manifest URI=%s\n", man_uri);
 		man_params.chunk_num			= 0;
 		man_params.chunk_num_f			= 1;
 		
+		/* Only the Manifest is signed, the Content Objects are verified 		*/
+		/* with the hashes listed in it 										*/
+		if (mode_val == 3) {
+			unsigned char 	keyid[32];
+			unsigned char 	pubkey[CefC_Max_Length];
+			
+			cef_valid_init (conf_path);
+			cef_valid_keyid_create (man_params.name, man_params.name_len, pubkey, keyid);
+			man_params.KeyIdRest_f = 1;
+			memcpy (man_params.KeyIdRestSel, keyid, 32);
+		}
+		
 		/*---------------------------------------------------------------------------
 			Sends first Interest(s)
 		-----------------------------------------------------------------------------*/
@@ -723,7 +737,7 @@ printf( "man_rec_num:%d\n", man_rec_num );
 		params.KeyIdRest_f = 0;
 	}
 
-	if ( (mode_val == 1) || (mode_val == 2) ) {
+	if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 		/* Read Manifest */
 #ifdef __DEV_COBH__
 printf( "Manifest:%s\n", man_fpath );
@@ -774,13 +788,13 @@ printf( "man_rec.chunk:%d   man_buff_idx:%d   man_rec_ctr:%d\n", man_rec.chunk,
 			rxwnd_prev = rxwnd;
 			rxwnd_head = rxwnd;
 			rxwnd_tail = rxwnd;
-			if ( (mode_val == 1) || (mode_val == 2) ) {
+			if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 				if ( params.chunk_num == man_rec.chunk ) {
 #ifdef __DEV_COBH__
 printf( "CKP-000 params.chunk_num:%u   man_rec.chunk:%u\n", params.chunk_num, man_rec.chunk );
 #endif
 #ifdef	__DEB_GET__
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || ( mode_val == 2) || ( mode_val == 3) ) {
 	if ( params.chunk_num == man_rec.chunk ) {
 		int hidx;
 		char	hash_dbg[1024];
@@ -836,12 +850,12 @@ printf( "CKP-004 man_rec.chunk:%d   man_buff_idx:%d   man_rec_ctr:%d\n", man_rec
 			rxwnd_prev->next = rxwnd;
 			rxwnd_tail = rxwnd;
 			rxwnd_prev = rxwnd;
-			if ( (mode_val == 1) || (mode_val == 2) ) {
+			if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 #ifdef __DEV_COBH__
 printf( "CKP-005 params.chunk_num:%u   man_rec.chunk:%u\n", params.chunk_num, man_rec.chunk );
 #endif
 #ifdef	__DEV_GET__
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || ( mode_val == 2) || ( mode_val == 3) ) {
 	if ( params.chunk_num == man_rec.chunk ) {
 		int hidx;
 		char	hash_dbg[1024];
@@ -1049,12 +1063,12 @@ printf( "Content stat_recv_frames:%ld   end_chunk_num+1:%ld\n", stat_recv_frames
 						/* Sends an interest with the next chunk number 	*/
 						params.chunk_num = rxwnd_tail->seq;
 						if (params.chunk_num <= UINT32_MAX) {
-							if ( (mode_val == 1) || (mode_val == 2) ) {
+							if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 #ifdef __DEV_COBH__
 printf( "CKP-100 params.chunk_num:%u   man_rec.chunk:%u\n", params.chunk_num, man_rec.chunk );
 #endif
 #ifdef __DEB_GET__
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || ( mode_val == 2) || ( mode_val == 3) ) {
 	if ( params.chunk_num == man_rec.chunk ) {
 		int hidx;
 		char	hash_dbg[1024];
@@ -1155,7 +1169,7 @@ printf( "CKP-105 man_rec.chunk:%u   man_buff_idx:%d   man_rec_ctr:%d\n", man_rec
 printf( "CKP-200 params.chunk_num:%u\n", params.chunk_num );
 #endif
 #ifdef	__DEV_GET__
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || ( mode_val == 2) || ( mode_val == 3) ) {
 	if (rxwnd_head->CobHash_f == 1) {
 		int hidx;
 		char	hash_dbg[1024];
@@ -1169,7 +1183,7 @@ if ( (mode_val == 1) || ( mode_val == 2) ) {
 	}
 }
 #endif
-					if ( (mode_val == 1) || (mode_val == 2) ) {
+					if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 						if (rxwnd_head->CobHash_f == 1) {
 							params.CobHRest_f = 1;
 							memcpy( params.CobHash, rxwnd->cob_hash, 32 );
@@ -1207,7 +1221,11 @@ print_usage (
 ) {
 	
 	fprintf (stdout, "\nUsage: cefgetfile_sec\n\n");
-	fprintf (stdout, "  cefgetfile_sec uri -f file [-m mode] [-s pipeline] [-d config_file_dir] [-p port_num]\n\n");
+	fprintf (stdout, "  cefgetfile_sec uri -f file [-m mode] [-s pipeline] [-d config_file_dir] [-p port_num]\n");
+	fprintf (stdout, "  mode  0: KeyIdRestriction (every Content Object is signed)\n"
+					 "        1: ObjHash restriction with Manifest\n"
+					 "        2: both 0 and 1\n"
+					 "        3: ObjHash restriction with signed Manifest\n\n");
 }
 
 static void
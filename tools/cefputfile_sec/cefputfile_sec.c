@@ -332,8 +332,10 @@ int main (
 			}
 			work_arg = argv[i + 1];
 			mode_val = atoi (work_arg);
-			if ( (mode_val < 0) && (mode_val > 2) ) {
-				fprintf (stderr, "ERROR: [-m] parameter is 0 or 1 or 2.\n");
+			if ( (mode_val < 0) || (mode_val > 3) ) {
+				fprintf (stderr, "ERROR: [-m] parameter is 0 or 1 or 2 or 3.\n");
+				print_usage ();
+				return (-1);
 			}
 			mode_f++;
 			i++;
@@ -484,7 +486,7 @@ int main (
 	/*--------------------------------------------
 		For ConHash
 	--------------------------------------------*/
-	if ( (mode_val == 1) || ( mode_val == 2) ) {
+	if ( (mode_val == 1) || ( mode_val == 2) || ( mode_val == 3) ) {
 		memset (&man_params, 0, sizeof (CefT_Object_TLVs));
 		strcat( man_uri, CefC_MANIFEST_NAME );
 		res = cef_frame_conversion_uri_to_name (man_uri, man_params.name);
@@ -506,6 +508,17 @@ int main (
 		} else {
 			man_params.expiry = now_ms + 3600000;
 		}
+		
+		/* Signs only the Manifest, the Content Objects are bound to it by hash 	*/
+		if (mode_val == 3) {
+			cef_valid_init (conf_path);
+			man_params.KeyIdRest_f = 1;
+			man_params.alg.valid_type = (uint16_t) cef_valid_type_get ("sha256");
+			if (man_params.alg.valid_type == CefC_T_ALG_INVALID) {
+				fprintf (stdout, "ERROR: KeyIdRestriction not get KeyId.\n");
+				exit (1);
+			}
+		}
 	}
 	
 
@@ -575,7 +588,7 @@ printf ( "CKP-010 params.end_chunk_num_f:%d  params.end_chunk_num:%d\n", params.
 #endif
 				}
 				//0.8.3
-				if ( (mode_val == 1) || ( mode_val == 2) ) {
+				if ( (mode_val == 1) || ( mode_val == 2) || ( mode_val == 3) ) {
 					params.CobHRest_f = 1;
 					memset( params.CobHash, 0x00, 32 );
 					man_params.end_chunk_num_f = params.end_chunk_num_f;
@@ -594,13 +607,13 @@ printf ( "CKP-020 cob_len:%d\n", cob_len );
 					exit (1);
 				}
 				//0.8.3 ObjHash
-				if ( (mode_val == 1) || ( mode_val == 2) ) {
+				if ( (mode_val == 1) || ( mode_val == 2) || ( mode_val == 3) ) {
 					if ( man_buff_idx == 0 ) {
 						man_buff_idx = 4;
 					}
 #ifdef	__DEB_PUT__
 printf ( "CKP-030 man_buff_idx:%d\n", man_buff_idx );
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || ( mode_val == 2) || ( mode_val == 3) ) {
 	int hidx;
 	char	hash_dbg[1024];
 	sprintf (hash_dbg, "CobHash [");
@@ -743,7 +756,11 @@ print_usage (
 	
 	fprintf (stdout, "\nUsage: \n");
 	fprintf (stdout, "  cefputfile_sec uri -f path [-r rate] [-b block_size] [-e expiry] "
-					 "[-t cache_time] [-m mode] [-d config_file_dir] [-p port_num] \n\n");
+					 "[-t cache_time] [-m mode] [-d config_file_dir] [-p port_num] \n");
+	fprintf (stdout, "  mode  0: KeyIdRestriction (every Content Object is signed)\n"
+					 "        1: ObjHash restriction with Manifest\n"
+					 "        2: both 0 and 1\n"
+					 "        3: ObjHash restriction with signed Manifest\n\n");
 }
 
 static void
@@ -351,6 +351,7 @@ output_result (
 ) {
 	struct CefT_Csmgr_Status_Hdr stat_hdr;
 	struct CefT_Csmgr_Status_Rep stat_rep;
+	struct CefT_Csmgr_Status_Buffer stat_buf;
 	unsigned char name[65535];
 	char get_uri[65535];
 	uint32_t index = 0;
@@ -370,7 +371,7 @@ output_result (
 	fprintf (stderr, "Number of Cached Contents      : %d\n\n", stat_hdr.con_num);
 	index += sizeof (struct CefT_Csmgr_Status_Hdr);
 	
-	while (index < frame_size) {
+	while ((index < frame_size) && (con_no < stat_hdr.con_num)) {
 		if (frame_size - index < sizeof (struct CefT_Csmgr_Status_Rep)) {
 			break;
 		}
@@ -405,6 +406,27 @@ output_result (
 		}
 	}
 	
+	/* The statistics of the page buffer follow the contents if the plugin has it */
+	if (frame_size - index >= sizeof (struct CefT_Csmgr_Status_Buffer)) {
+		memcpy (&stat_buf, &frame[index], sizeof (struct CefT_Csmgr_Status_Buffer));
+		if (ntohs (stat_buf.type) == CefC_Csmgr_Stat_Buffer) {
+			stat_buf.hits 		= cef_client_ntohb (stat_buf.hits);
+			stat_buf.misses 	= cef_client_ntohb (stat_buf.misses);
+			stat_buf.readaheads = cef_client_ntohb (stat_buf.readaheads);
+			
+			fprintf (stderr, "*****   Page Buffer Status Report  *****\n");
+			fprintf (stderr, "Hits                           : %llu\n", 
+				(unsigned long long) stat_buf.hits);
+			fprintf (stderr, "Misses                         : %llu\n", 
+				(unsigned long long) stat_buf.misses);
+			fprintf (stderr, "Hit Rate                       : %.1f %%\n", 
+				(stat_buf.hits + stat_buf.misses) ? 
+					100.0 * stat_buf.hits / (stat_buf.hits + stat_buf.misses) : 0.0);
+			fprintf (stderr, "Read Ahead Pages               : %llu\n\n", 
+				(unsigned long long) stat_buf.readaheads);
+		}
+	}
+	
 	return;
 }
 /*--------------------------------------------------------------------------------------